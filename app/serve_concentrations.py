@@ -4,56 +4,18 @@
 # function.
 
 from common import *
-import io
-import json
-import pexpect
+from stream import StreamProcess
 
 
-def concentrations(parameters):
-
-    result = None
-
-    # spawn a subprocess
-    p = pexpect.spawn("concentrations", encoding="ascii")
-
-    # suppress echo
-    p.setecho(False)
-
-    # provide number of complexes
-    p.expect("Enter number of complex IDs")
-    p.sendline(str(parameters[NUM_COMPLEXES]))
-
-    # provide number of concentrations
-    p.expect("Enter number of different concentrations")
-    p.sendline(str(len(parameters[LIST_CONCENTRATIONS])))
+process = StreamProcess(["concentrations"])
 
-    # provide entries concentrations
-    for entry in range(len(parameters[LIST_CONCENTRATIONS])):
-        p.expect("Enter concentration")
-        p.sendline(parameters[LIST_CONCENTRATIONS][entry])
 
-    # provide temperature
-    p.expect("Enter temperature")
-    p.sendline(parameters[TEMP])
-
-    # provide entries ocx
-    for entry in range(len(parameters[OCX])):
-        p.expect("Enter complex ocx")
-        p.sendline(parameters[OCX][entry])
-
-    # start log the subprocess' result
-    log = io.StringIO()
-    p.logfile = log
-    p.expect("{") # starting of JSON string
-    log.seek(0)
-
-    # store the result
-    result = log.read()
-    result = result.replace("\x00", "").replace("\n", "").replace("\r", "")
-    result = json.loads(result)
-
-    log.close()
-    p.close()
+def concentrations(parameters):
 
-    return (p.exitstatus, result)
+    job = {
+        "concentrations": parameters[LIST_CONCENTRATIONS],
+        "temperature": parameters[TEMP],
+        "ocx": parameters[OCX][:int(parameters[NUM_COMPLEXES])]
+    }
 
+    return process.run(job)
@@ -0,0 +1,47 @@
+#!/usr/bin/env python3
+
+# This module keeps one long-lived NUPACK process per function, run in its
+# -stream mode: each job is a JSON line written to the process' stdin, and
+# each result is the JSON line it writes back to its stdout.
+
+import json
+import subprocess
+import threading
+
+
+STATUS = "status"
+
+
+class StreamProcess:
+
+    def __init__(self, command):
+        self.command = command
+        self.process = None
+        self.lock = threading.Lock()
+
+
+    def run(self, job):
+        """
+        Runs one job, and returns the exit status a one-shot run would have
+        returned together with the result.
+        """
+
+        with self.lock:
+            if self.process is None or self.process.poll() is not None:
+                self.process = subprocess.Popen(
+                    self.command + ["-stream"],
+                    stdin=subprocess.PIPE,
+                    stdout=subprocess.PIPE,
+                    encoding="ascii",
+                    bufsize=1)
+
+            self.process.stdin.write(json.dumps(job) + "\n")
+            self.process.stdin.flush()
+            line = self.process.stdout.readline()
+
+        if not line:
+            # the process died on this job; the next one starts a new one
+            return (self.process.wait(), None)
+
+        result = json.loads(line)
+        return (result.pop(STATUS), result)
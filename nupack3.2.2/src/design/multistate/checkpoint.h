@@ -0,0 +1,73 @@
+#pragma once
+
+#include "design_debug.h"
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <utility>
+#include <type_traits>
+
+namespace nupack {
+  /**
+   * Binary writing and reading of the values a design checkpoint is made
+   * of.  Values are stored in the layout of the machine, so a checkpoint is
+   * only meant to be read back by the same build.  Reading past the end of
+   * the stream is an error.
+   */
+  namespace Checkpoint {
+    template <class T>
+    void write(std::ostream & out, const T & val) {
+      static_assert(std::is_trivially_copyable<T>::value, "not a plain value");
+      out.write(reinterpret_cast<const char *>(&val), sizeof(T));
+    }
+
+    template <class T>
+    void read(std::istream & in, T & val) {
+      static_assert(std::is_trivially_copyable<T>::value, "not a plain value");
+      in.read(reinterpret_cast<char *>(&val), sizeof(T));
+      NUPACK_CHECK(in.good(), "Truncated checkpoint");
+    }
+
+    template <class T, class U>
+    void write(std::ostream & out, const std::pair<T, U> & val) {
+      write(out, val.first);
+      write(out, val.second);
+    }
+
+    template <class T, class U>
+    void read(std::istream & in, std::pair<T, U> & val) {
+      read(in, val.first);
+      read(in, val.second);
+    }
+
+    inline void write(std::ostream & out, const std::string & str) {
+      write(out, (long) str.size());
+      out.write(str.data(), str.size());
+    }
+
+    inline void read(std::istream & in, std::string & str) {
+      long n = 0;
+      read(in, n);
+      NUPACK_CHECK(n >= 0 && n < (1L << 20), "Corrupt checkpoint");
+      str.resize(n);
+      in.read(&str[0], n);
+      NUPACK_CHECK(in.good(), "Truncated checkpoint");
+    }
+
+    template <class T>
+    void write(std::ostream & out, const std::vector<T> & vec) {
+      write(out, (long) vec.size());
+      for (const auto & v : vec) write(out, v);
+    }
+
+    template <class T>
+    void read(std::istream & in, std::vector<T> & vec) {
+      long n = 0;
+      read(in, n);
+      NUPACK_CHECK(n >= 0, "Corrupt checkpoint");
+      vec.resize(n);
+      for (auto & v : vec) read(in, v);
+    }
+  }
+}
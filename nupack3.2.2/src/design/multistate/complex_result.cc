@@ -4,6 +4,8 @@
 
 #include "design_debug.h"
 #include "pathway_utils.h"
+#include "telemetry.h"
+#include "ensemble_memo.h"
 
 #include "algorithms.h"
 
@@ -24,11 +26,12 @@ void OrderResult::evaluate(const SequenceState & seqs, const OrderSpec & spec,
   
   DBL_TYPE start_time = get_current_time();
 
-  pfunc = pfuncFull(sequence.data(), 3, invars.material, 
-      invars.dangle_type, invars.temperature - ZERO_C_IN_KELVIN, 0,
-      invars.sodium, invars.magnesium, invars.use_long_helix) / spec.get_symmetry();
+  // a target with this ordering fills the same unbonused ensemble
+  EnsembleKey key(sequence, invars.temperature, invars);
+  pfunc = ensemble_memo().fill(key, false, invars)->pfunc / spec.get_symmetry();
 
   eval_time = get_current_time() - start_time;
+  eval_counts.orders++;
 }
 
 void OrderResult::update_sequence(const SequenceState & seqs) {
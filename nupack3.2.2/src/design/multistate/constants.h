@@ -13,3 +13,5 @@
 #define DEFAULT_STOP_CONDITION 0.01
 // default maxsize
 #define DEFAULT_MAXSIZE 0
+// memory kept for partition function fills shared between results (bytes)
+#define DEFAULT_ENSEMBLE_MEMO_BYTES (64 << 20)
@@ -8,7 +8,6 @@
 #include <vector>
 #include <array>
 #include <map>
-#include <set>
 #include <string>
 #include <iostream>
 #include <iomanip>
@@ -17,6 +16,51 @@
 
 
 namespace nupack {
+int Domains::add_variable(const std::vector<trinary> & states) {
+  int var = this->n_unset.size();
+  this->values.insert(this->values.end(), states.begin(), states.end());
+  this->offsets.push_back(this->values.size());
+  this->n_unset.push_back(0);
+  this->n_true.push_back(0);
+  this->masks.push_back(0);
+  for (auto val = 0; val < states.size(); val++) {
+    if (states[val] == NUPACK_VV_UNSET) this->n_unset[var]++;
+    if (states[val] == NUPACK_VV_TRUE) this->n_true[var]++;
+    if (states[val] != NUPACK_VV_FALSE && val < 8) this->masks[var] |= 1 << val;
+  }
+  return var;
+}
+
+void Domains::set(int var, int val, trinary state) {
+  auto & cur = this->values[this->offsets[var] + val];
+  if (cur == NUPACK_VV_UNSET) this->n_unset[var]--;
+  else if (cur == NUPACK_VV_TRUE) this->n_true[var]--;
+  if (state == NUPACK_VV_UNSET) this->n_unset[var]++;
+  else if (state == NUPACK_VV_TRUE) this->n_true[var]++;
+  cur = state;
+
+  if (val < 8) {
+    if (state == NUPACK_VV_FALSE) this->masks[var] &= ~(1 << val);
+    else this->masks[var] |= 1 << val;
+  }
+}
+
+int Domains::get_unset(int var, int i_set) const {
+  const trinary * row = (*this)[var];
+  for (auto val = 0; val < size(var); val++) {
+    if (row[val] == NUPACK_VV_UNSET && i_set-- == 0) return val;
+  }
+  NUPACK_ERROR("Attempting to find allowed variable without a possibility");
+}
+
+AllowTable Domains::to_table() const {
+  AllowTable table;
+  for (auto var = 0; var < size(); var++) {
+    table.emplace_back((*this)[var], (*this)[var] + size(var));
+  }
+  return table;
+}
+
 VariableNode::VariableNode() : 
     depth(0), cost(0), tiebreaker(genrand_real1()), parent(nullptr) {}
 
@@ -24,7 +68,7 @@ VariableNode::VariableNode(std::shared_ptr<VariableNode> parent) :
     depth(parent->get_depth() + 1), cost(0), 
     tiebreaker(genrand_real1()), parent(parent) {}
 
-bool VariableNode::add_implications(AllowTable & allow_table,
+bool VariableNode::add_implications(Domains & allow_table,
    const SolveStack & stack) {
   int n = stack.size();
   int old_n = v.size();
@@ -41,12 +85,12 @@ bool VariableNode::add_implications(AllowTable & allow_table,
     NUPACK_DEBUG_CHECK(allow_table.size() > c_var,
         "Invalid variable being set: " + to_string(c_var)
         + " >= " + to_string(allow_table.size()));
-    NUPACK_DEBUG_CHECK(allow_table[c_var].size() > c_val,
+    NUPACK_DEBUG_CHECK(allow_table.size(c_var) > c_val,
         "invalid value being set for " + to_string(c_var) + ": " + to_string(c_val) 
-        + " >= " + to_string(allow_table[c_var].size()));
+        + " >= " + to_string(allow_table.size(c_var)));
 
     if (allow_table[c_var][c_val] == NUPACK_VV_UNSET) {
-      allow_table[c_var][c_val] = c_all;
+      allow_table.set(c_var, c_val, c_all);
       v[j] = {c_var, c_val, c_all};
       j++;
     } else if (allow_table[c_var][c_val] != c_all) {
@@ -59,7 +103,7 @@ bool VariableNode::add_implications(AllowTable & allow_table,
 } 
 
 void VariableNode::change_branch(std::shared_ptr<VariableNode> from, 
-    std::shared_ptr<VariableNode> to, AllowTable & allow_table) {
+    std::shared_ptr<VariableNode> to, Domains & allow_table) {
   std::shared_ptr<VariableNode> c_from = from;
   std::shared_ptr<VariableNode> c_to = to;
   std::vector<std::shared_ptr<VariableNode> > to_stack;
@@ -121,7 +165,7 @@ void VariableNode::change_branch(std::shared_ptr<VariableNode> from,
   }
 }
 
-void VariableNode::rollback_variables(AllowTable & allow_table) {
+void VariableNode::rollback_variables(Domains & allow_table) {
   // NUPACK_DEBUG("BEFORE ROLLBACK");
   // print_table(allow_table, std::cout);
   for (auto & item : v) {
@@ -129,9 +173,9 @@ void VariableNode::rollback_variables(AllowTable & allow_table) {
     auto c_val = item.val;
     auto c_all = item.trit;
 
-    NUPACK_DEBUG_CHECK((int)allow_table[c_var].size() > c_val,
+    NUPACK_DEBUG_CHECK(allow_table.size(c_var) > c_val,
         "Size-value mismatch at " + to_string(c_var) + ": " 
-        + to_string(allow_table[c_var].size()) 
+        + to_string(allow_table.size(c_var)) 
         + " <= " + to_string(c_val));
 
     NUPACK_CHECK((int)allow_table[c_var][c_val] == c_all,
@@ -139,21 +183,21 @@ void VariableNode::rollback_variables(AllowTable & allow_table) {
         " value: " + to_string(c_val) + " allowed: " 
         + to_string((int)c_all) + "  assigned: " + to_string((int)allow_table[c_var][c_val]));
 
-    allow_table[c_var][c_val] = NUPACK_VV_UNSET;
+    allow_table.set(c_var, c_val, NUPACK_VV_UNSET);
   }
   // NUPACK_DEBUG("AFTER ROLLBACK");
   // print_table(allow_table, std::cout);
 }
 
-void VariableNode::assign_variables(AllowTable & allow_table) {
+void VariableNode::assign_variables(Domains & allow_table) {
   for (auto & item : v) {
     auto c_var = item.var;
     auto c_val = item.val;
     auto c_all = item.trit;
 
-    NUPACK_DEBUG_CHECK((int)allow_table[c_var].size() > c_val,
+    NUPACK_DEBUG_CHECK(allow_table.size(c_var) > c_val,
         "Size-value mismatch at " + to_string(c_var) + ": " 
-        + to_string(allow_table[c_var].size()) 
+        + to_string(allow_table.size(c_var)) 
         + " <= " + to_string(c_val));
 
     NUPACK_CHECK(allow_table[c_var][c_val] == NUPACK_VV_UNSET,
@@ -161,7 +205,7 @@ void VariableNode::assign_variables(AllowTable & allow_table) {
         " value: " + to_string(c_val) + " allowed: " 
         + to_string(c_all) + "  old_all: " + to_string((int)allow_table[c_var][c_val]));
 
-    allow_table[c_var][c_val] = c_all;
+    allow_table.set(c_var, c_val, c_all);
   }
 }
 
@@ -191,7 +235,6 @@ void VariableNode::update_cost(const std::vector<int> & orig) {
 bool CompConstraint::propagate_constraint(int modified, SolveStack & sstack, 
     const SolveStruc & ss ) const {
   constexpr int n_bases = 4;
-  constexpr std::array<int, n_bases> base =   {{0, 1, 2, 3}};
   constexpr std::array<int, n_bases> comp =   {{3, 2, 1, 0}};
   constexpr std::array<int, n_bases> w_comp = {{-1, -1, 3, 2}};
 
@@ -205,18 +248,19 @@ bool CompConstraint::propagate_constraint(int modified, SolveStack & sstack,
       j_var = i;
     } 
     if (j_var >= 0) {
-      std::vector<trinary> poss(n_bases, false);
+      unsigned allowed = ss.value_allowed.get_mask(i_var);
+      unsigned poss = 0;
       for (auto i = 0; i < n_bases; i++) {
-        if (ss.value_allowed[i_var][i]) {
-          poss[comp[base[i]]] = true;
-          if (strength == NUPACK_CS_WEAK && w_comp[base[i]] >= 0) {
-            poss[w_comp[base[i]]] = true;
+        if (allowed & (1 << i)) {
+          poss |= 1 << comp[i];
+          if (strength == NUPACK_CS_WEAK && w_comp[i] >= 0) {
+            poss |= 1 << w_comp[i];
           }
         }
       }
 
       for (auto i = 0; i < n_bases; i++) {
-        if (!poss[i]) {
+        if (!(poss & (1 << i))) {
           if (ss.value_allowed[j_var][i] == NUPACK_VV_UNSET) {
             sstack.push_back(j_var, i, NUPACK_VV_FALSE);
           } else if (ss.value_allowed[j_var][i] == NUPACK_VV_TRUE) {
@@ -240,13 +284,13 @@ bool IdentConstraint::propagate_constraint(int modified, SolveStack & sstack,
     j_var = i;
   } 
   if (j_var >= 0) {
-    std::vector<trinary> poss(ss.value_allowed[i_var]);
+    unsigned poss = ss.value_allowed.get_mask(i_var);
 
     constexpr int n_bases = 4;
     for (auto i = 0; i < n_bases; i++) {
-      if (ss.value_allowed[j_var][i] == NUPACK_VV_TRUE && !poss[i]) {
+      if (ss.value_allowed[j_var][i] == NUPACK_VV_TRUE && !(poss & (1 << i))) {
         success = false;
-      } else if (ss.value_allowed[j_var][i] == NUPACK_VV_UNSET && !poss[i]) {
+      } else if (ss.value_allowed[j_var][i] == NUPACK_VV_UNSET && !(poss & (1 << i))) {
         sstack.push_back(j_var, i, NUPACK_VV_FALSE);
       }
     }
@@ -275,6 +319,12 @@ PatternConstraint::PatternConstraint(const std::string & name,
   for (auto i = 0; i < nuc_ids.size(); i++) nuc_id_map[nuc_ids[i]] = i;
   
   pattern = SequenceUtils::nucs_to_bools(SequenceUtils::str_to_nuc(constraint));
+  for (auto & allowed : pattern) {
+    pattern_masks.push_back(0);
+    for (auto k = 0; k < allowed.size(); k++) {
+      if (allowed[k]) pattern_masks.back() |= 1 << k;
+    }
+  }
   
   // If pattern is longer than target, there is effectively no constraint
   if (pattern.size() > nuc_ids.size()) {
@@ -297,73 +347,88 @@ PatternConstraint::PatternConstraint(const std::string & name,
   }
 }
 
-bool PatternConstraint::propagate_constraint(int modified, SolveStack & sstack,
-    const SolveStruc & ss ) const {
-  // trivial constraint, see constructor
-  if (starts.empty()) return true;
-
-  int modified_index = nuc_id_map.find(modified)->second;
+std::pair<int, int> PatternConstraint::get_windows(int index) const {
   int max_index = nuc_ids.size() - (pattern.size() - 1);
   int min_index = 0;
 
-  int tmp_max = modified_index + pattern.size() - 1;
-  int tmp_min = modified_index - pattern.size() + 1;
+  int tmp_max = index + pattern.size() - 1;
+  int tmp_min = index - pattern.size() + 1;
   max_index = std::min(tmp_max, max_index);
   min_index = std::max(tmp_min, min_index);
 
+  if (min_index > max_index) return {0, 0};
+  // the window at min_index is checked even if it is max_index
+  return {min_index, std::max(min_index + 1, max_index)};
+}
 
-  bool success = true;
-  if (min_index > max_index) return true;
+bool PatternConstraint::check_window(int i, SolveStack & sstack,
+    const SolveStruc & ss) const {
+  if (!starts[i]) return false;
+
+  // Number of nucleotides that have 
+  // possibilities to break the match
+  auto n_nuc_choices = 0;
+  auto nuc_choice = -1;
+  for (auto j = 0; j < pattern.size(); j++) {
+    // value allowed, but not in pattern
+    if (ss.value_allowed.get_mask(nuc_ids[i + j]) & ~pattern_masks[j] & 0xF) {
+      nuc_choice = j;
+      n_nuc_choices++;
+      if (n_nuc_choices >= 2) break;
+    }
+  }
   
-  for (auto i = min_index; i == min_index || i < max_index; i++) {
-    if (starts[i]) {
-      // Number of nucleotides that have 
-      // possibilities to break the match
-      auto n_nuc_choices = 0;
-      auto nuc_choice = -1;
-      for (auto j = 0; j < pattern.size(); j++) {
-        auto c_nuc = nuc_ids[i + j];
-        auto c_nuc_choices = false;
-        for (auto k = 0; k < pattern[j].size(); k++) {
-          if (ss.value_allowed[c_nuc][k] && !pattern[j][k]) {
-            // value allowed, but not in pattern
-            if (!c_nuc_choices) {
-              // mark the current
-              c_nuc_choices = true;
-              nuc_choice = j;
-              n_nuc_choices++;
-              break;
-            }
-          }
-        }
-        
-        if (n_nuc_choices >= 2) {
-          break;
-        }
-      }
-      
-      if (n_nuc_choices == 0) {
-        success = false;
-      } else if (n_nuc_choices == 1) {
-        auto c_nuc = nuc_ids[i + nuc_choice];
-        for (auto k = 0; k < pattern[nuc_choice].size(); k++) {
-          if (ss.value_allowed[c_nuc][k] && pattern[nuc_choice][k]) {
-            NUPACK_DEBUG_CHECK(ss.value_allowed[c_nuc][k] == NUPACK_VV_UNSET,
-                "Invalid state to change to false " 
-                + to_string((int)ss.value_allowed[c_nuc][k]));
-            sstack.push_back(c_nuc, k, NUPACK_VV_FALSE);
-          }
-        }
+  if (n_nuc_choices == 0) return false;
+
+  if (n_nuc_choices == 1) {
+    auto c_nuc = nuc_ids[i + nuc_choice];
+    for (auto k = 0; k < pattern[nuc_choice].size(); k++) {
+      if (ss.value_allowed[c_nuc][k] && pattern[nuc_choice][k]) {
+        NUPACK_DEBUG_CHECK(ss.value_allowed[c_nuc][k] == NUPACK_VV_UNSET,
+            "Invalid state to change to false " 
+            + to_string((int)ss.value_allowed[c_nuc][k]));
+        sstack.push_back(c_nuc, k, NUPACK_VV_FALSE);
       }
     }
-    else {
-      success = false;
-    }
+  }
+  return true;
+}
+
+bool PatternConstraint::propagate_constraint(int modified, SolveStack & sstack,
+    const SolveStruc & ss ) const {
+  // trivial constraint, see constructor
+  if (starts.empty()) return true;
+
+  auto windows = get_windows(nuc_id_map.find(modified)->second);
+  bool success = true;
+  for (auto i = windows.first; i < windows.second; i++) {
+    if (!check_window(i, sstack, ss)) success = false;
   }
   
   return success;
 }
 
+bool PatternConstraint::propagate_vars(const std::vector<int> & modified,
+    SolveStack & sstack, const SolveStruc & ss) const {
+  if (starts.empty()) return true;
+
+  std::vector<std::pair<int, int> > windows;
+  for (auto c_var : modified) {
+    auto cur = get_windows(nuc_id_map.find(c_var)->second);
+    if (cur.first < cur.second) windows.push_back(cur);
+  }
+  std::sort(windows.begin(), windows.end());
+
+  bool success = true;
+  int i = 0;
+  for (auto & w : windows) {
+    for (i = std::max(i, w.first); i < w.second; i++) {
+      if (!check_window(i, sstack, ss)) success = false;
+    }
+  }
+  return success;
+}
+
 WordConstraint::WordConstraint(const std::vector<int> & vars, 
     const std::vector<std::string> & constraint, int supp_var) : 
     supp_var(supp_var), nuc_ids(vars) {
@@ -407,12 +472,12 @@ WordConstraint::WordConstraint(const std::vector<int> & vars,
 bool WordConstraint::propagate_constraint(int modified, 
     SolveStack & sstack, const SolveStruc & ss ) const {
   bool satisfied = true;
-  const std::vector<trinary> & lookup = ss.value_allowed[supp_var];
+  const trinary * lookup = ss.value_allowed[supp_var];
   if (modified == supp_var) {
     // Need to std::map down to nucleotide variables
     for (auto i_var = 0; satisfied && i_var < nuc_ids.size(); i_var++) {
       auto c_var = nuc_ids[i_var];
-      for (auto i_val = 0; satisfied && i_val < ss.value_allowed[c_var].size(); i_val++) {
+      for (auto i_val = 0; satisfied && i_val < ss.value_allowed.size(c_var); i_val++) {
         if (ss.value_allowed[c_var][i_val]) {
           const std::vector<int> & tmpvec = varval_to_ids[i_var][i_val];
           bool cursat = false;
@@ -433,13 +498,15 @@ bool WordConstraint::propagate_constraint(int modified,
       }
     }
   } else {
-    int i_var = 0, c_var;
+    int i_var = 0, c_var = -1;
     for (i_var = 0; i_var < nuc_ids.size(); i_var++) {
       c_var = nuc_ids[i_var];
       if (c_var == modified) break;
     }
+    NUPACK_CHECK(c_var == modified && c_var >= 0,
+        "Modified variable is not in the word constraint");
     // Need to map down to supplementary variable
-    for (auto i_supp = 0; satisfied && i_supp < ss.value_allowed[supp_var].size(); i_supp++) {
+    for (auto i_supp = 0; satisfied && i_supp < ss.value_allowed.size(supp_var); i_supp++) {
       if (ss.value_allowed[supp_var][i_supp]) {
         bool cur_match = false;
         if (allowed_ind[i_supp][i_var] == -2) {
@@ -514,6 +581,10 @@ MatchConstraint::MatchConstraint(const std::vector<int> & vars,
     for ( ; var_it != vars.end(); ++var_it, ++word_it) {
       nuc_ids.push_back(*var_it);
       match_nucs.push_back(SequenceUtils::nuc_to_bool(*word_it));
+      match_masks.push_back(0);
+      for (auto k = 0; k < match_nucs.back().size(); k++) {
+        if (match_nucs.back()[k]) match_masks.back() |= 1 << k;
+      }
     }
 
   } catch (NupackException & e) {
@@ -533,25 +604,10 @@ bool MatchConstraint::propagate_constraint(int modified,
 
   int n_tot = nuc_ids.size();
   for (auto i = 0; i < n_tot; ++i) {
-    auto c_var = nuc_ids[i];
-    auto can_match = false;
-    auto must_match = true;
-
-    auto cur_size = match_nucs[i].size();
-    for (auto c_val = 0; c_val < cur_size; c_val++) {
-      if (ss.value_allowed[c_var][c_val] && match_nucs[i][c_val]) {
-        can_match = true;
-      }
-    }
-
-    for (auto c_val = 0; c_val < cur_size; c_val++) {
-      if (ss.value_allowed[c_var][c_val] && !match_nucs[i][c_val]) {
-        must_match = false;
-      }
-    }
-
-    if (must_match) min_matched++;
-    if (can_match)  max_matched++;
+    auto allowed = ss.value_allowed.get_mask(nuc_ids[i]);
+    // must match if no allowed value is outside the word
+    if (!(allowed & ~match_masks[i] & 0xF)) min_matched++;
+    if (allowed & match_masks[i])  max_matched++;
   }
 
   double min_frac_matched = ((double) min_matched) / n_tot;
@@ -574,17 +630,10 @@ bool MatchConstraint::propagate_constraint(int modified,
   if (can_match_tot && !can_sub_match) {
     for (auto i = 0; i < n_tot; i++) {
       auto c_var = nuc_ids[i];
-      auto cur_match_nuc = match_nucs[i];
-      auto can_match = false;
-      for (auto c_val = 0; c_val < cur_match_nuc.size(); c_val++) {
-        if (ss.value_allowed[c_var][c_val] && cur_match_nuc[c_val]) {
-          can_match = true;
-        }
-      }
-
-      if (can_match) {
-        for (auto c_val = 0; c_val < cur_match_nuc.size(); c_val++) {
-          if (ss.value_allowed[c_var][c_val] && !cur_match_nuc[c_val]) {
+      auto allowed = ss.value_allowed.get_mask(c_var);
+      if (allowed & match_masks[i]) {
+        for (auto c_val = 0; c_val < match_nucs[i].size(); c_val++) {
+          if ((allowed & ~match_masks[i]) & (1 << c_val)) {
             sstack.push_back(c_var, c_val, NUPACK_VV_FALSE);
           }
         }
@@ -595,17 +644,10 @@ bool MatchConstraint::propagate_constraint(int modified,
   if (can_match_tot && !can_add_match) {
     for (auto i = 0; i < n_tot; i++) {
       auto c_var = nuc_ids[i];
-      auto cur_match_nuc = match_nucs[i];
-      auto must_match = true;
-      for (auto c_val = 0; c_val < cur_match_nuc.size(); c_val++) {
-        if (ss.value_allowed[c_var][c_val] && !cur_match_nuc[c_val]) {
-          must_match = false;
-        }
-      }
-
-      if (!must_match) {
-        for (auto c_val = 0; c_val < cur_match_nuc.size(); c_val++) {
-          if (ss.value_allowed[c_var][c_val] && cur_match_nuc[c_val]) {
+      auto allowed = ss.value_allowed.get_mask(c_var);
+      if (allowed & ~match_masks[i] & 0xF) {
+        for (auto c_val = 0; c_val < match_nucs[i].size(); c_val++) {
+          if ((allowed & match_masks[i]) & (1 << c_val)) {
             sstack.push_back(c_var, c_val, NUPACK_VV_FALSE);
           }
         }
@@ -616,10 +658,25 @@ bool MatchConstraint::propagate_constraint(int modified,
   return can_match_tot;
 }
 
+bool MatchConstraint::propagate_vars(const std::vector<int> & modified, 
+    SolveStack & sstack, const SolveStruc & ss) const {
+  if (modified.empty()) return true;
+  return propagate_constraint(modified[0], sstack, ss);
+}
+
 std::vector<int> MatchConstraint::get_constrained_vars() const {
   return nuc_ids;
 }
 
+bool Constraint::propagate_vars(const std::vector<int> & modified, 
+    SolveStack & sstack, const SolveStruc & ss) const {
+  bool success = true;
+  for (auto c_var : modified) {
+    success = propagate_constraint(c_var, sstack, ss) && success;
+  }
+  return success;
+}
+
 int ConstraintHandler::add_nucleotide_variable(int nuc_con) {
   std::vector<trinary> cons = SequenceUtils::nuc_to_bool(nuc_con);
 
@@ -635,10 +692,9 @@ int ConstraintHandler::add_variable(std::vector<trinary> allowed) {
     }
   }
   
-  value_allowed.push_back(allowed);
   std::vector<int> tmp;
   var_constraint_map.push_back(tmp);
-  return value_allowed.size() - 1;
+  return value_allowed.add_variable(allowed);
 }
 
 void ConstraintHandler::add_constraint(const Constraint & con) {
@@ -646,6 +702,7 @@ void ConstraintHandler::add_constraint(const Constraint & con) {
   int c_con = constraints.size();
 
   constraints.push_back(con.clone());
+  constraint_vars.push_back(cur_vars);
   for (auto & c_var : cur_vars) {
     NUPACK_CHECK(c_var < value_allowed.size(),
         to_string(c_var) + " is not in the current variable set");
@@ -681,7 +738,7 @@ std::vector<int> ConstraintHandler::make_mutation(std::vector<int> mut_vars, std
       "start / allowed size mismatch");
 
   for (auto j = 0; j < ret.size(); j++) {
-    if (value_allowed[j].size() == 4) {
+    if (value_allowed.size(j) == 4) {
       NUPACK_CHECK(ret[j] >= 0 && ret[j] <= 3,
           "Invalid nucleotide code at start: " + to_string(j) + " : " + to_string(ret[j]));
     }
@@ -690,15 +747,13 @@ std::vector<int> ConstraintHandler::make_mutation(std::vector<int> mut_vars, std
   for (auto & c_var : mut_vars) {
     NUPACK_CHECK(c_var < value_allowed.size(), "attempting to mutate invalid variable");
 
-    AllowTable allowed = value_allowed;
-    int n_allowed = get_n_allowed(allowed[c_var]);
+    int n_allowed = value_allowed.get_n_unset(c_var) + value_allowed.get_n_true(c_var);
 
     if (n_allowed > 1) {
       int old_val = newstart[c_var];
 
-      if (newstart[c_var] >= 0) allowed[c_var][newstart[c_var]] = false;
       newstart[c_var] = -1;
-      ret = find_closest(newstart, allowed);
+      ret = find_closest(newstart, c_var, old_val);
 
       if (ret[0] >= 0) {
         newstart = ret;
@@ -708,7 +763,7 @@ std::vector<int> ConstraintHandler::make_mutation(std::vector<int> mut_vars, std
       }
 
       for (auto j = 0; j < ret.size(); j++) {
-        if (allowed[j].size() == 4) {
+        if (value_allowed.size(j) == 4) {
           NUPACK_CHECK(ret[j] >= 0 && ret[j] <= 3,
             "Invalid nucleotide code[" + to_string(j) + "]: " + to_string(ret[j]));
         }
@@ -722,29 +777,31 @@ std::vector<int> ConstraintHandler::make_mutation(std::vector<int> mut_vars, std
 std::vector<int> ConstraintHandler::get_possible_nucleotides() const {
   SolveStruc solver;
 
-  solver.value_allowed = value_allowed;
+  init_solver(solver);
   solver.start.assign(value_allowed.size(), -1);
-  solver.weight.assign(solver.value_allowed.size(), 1.0);
 
   auto root = std::make_shared<VariableNode>();
   bool success = propagate_all(root, solver);
 
   NUPACK_CHECK(success, "No nucleotides found satisfy these constraints");
-  return SequenceUtils::bool_to_nuc(solver.value_allowed);
+  return SequenceUtils::bool_to_nuc(solver.value_allowed.to_table());
+}
+
+void ConstraintHandler::init_solver(SolveStruc & ss) const {
+  ss.value_allowed = value_allowed;
+  ss.weight.assign(value_allowed.size(), 1.0);
+  ss.var_changed.assign(value_allowed.size(), false);
+  ss.con_vars.resize(constraints.size());
 }
 
 bool ConstraintHandler::propagate_all(std::shared_ptr<VariableNode> node,
     SolveStruc & ss) const {
-  std::vector<int> vars;
   SolveStack sstack;
 
   bool success = true;
   for (auto i = 0; i < constraints.size(); i++) {
-    vars = constraints[i]->get_constrained_vars();
-    for (auto j = 0; j < vars.size(); j++) {
-      bool cur = constraints[i]->propagate_constraint(vars[j], sstack, ss);
-      success = cur && success;
-    }
+    bool cur = constraints[i]->propagate_vars(constraint_vars[i], sstack, ss);
+    success = cur && success;
   }
 
   success = success && node->add_implications(ss.value_allowed, sstack);
@@ -756,45 +813,59 @@ bool ConstraintHandler::propagate_all(std::shared_ptr<VariableNode> node,
 bool ConstraintHandler::propagate(std::shared_ptr<VariableNode> node,
     SolveStruc & ss) const {
   SolveStack sstack(node->get_v());
-  std::set<int> cur_vars_changed_unique;
+  std::vector<int> vars_changed;
+  std::vector<int> cons_changed;
+  auto & domains = ss.value_allowed;
 
   bool success = true;
   while (sstack.size() > 0 && success) {
-    cur_vars_changed_unique.clear();
-    for (auto & item : sstack.v) cur_vars_changed_unique.insert(item.var);
+    // every check of a round sees the same state, so the variables
+    // changed are gathered by constraint and each constraint runs once
+    vars_changed.clear();
+    for (auto & item : sstack.v) {
+      if (!ss.var_changed[item.var]) {
+        ss.var_changed[item.var] = true;
+        vars_changed.push_back(item.var);
+      }
+    }
+    for (auto c_var : vars_changed) ss.var_changed[c_var] = false;
     sstack.clear();
 
-    for (auto c_var : cur_vars_changed_unique) {
-      auto n_unset = get_n_unset(ss.value_allowed[c_var]);
-      auto n_true = get_n_true(ss.value_allowed[c_var]);
+    for (auto c_var : vars_changed) {
+      auto n_unset = domains.get_n_unset(c_var);
+      auto n_true = domains.get_n_true(c_var);
       
       if (n_true > 1) {
         success = false;
         break;
       } else if (n_true > 0) {
         if (n_unset > 0) {
-          for (auto i = 0; i < ss.value_allowed[c_var].size(); i++) {
-            if (ss.value_allowed[c_var][i] == NUPACK_VV_UNSET) {
+          for (auto i = 0; i < domains.size(c_var); i++) {
+            if (domains[c_var][i] == NUPACK_VV_UNSET) {
               sstack.push_back(c_var, i, NUPACK_VV_FALSE);
             }
           }
         }
       } else if (n_unset == 0) {
-        n_true = get_n_true(ss.value_allowed[c_var]);
-        if (n_true != 1) {
-          success = false;
-          break;
-        }
+        success = false;
+        break;
       } else if (n_unset == 1) {
-        sstack.push_back(c_var, get_first_allowed(ss.value_allowed[c_var]), NUPACK_VV_TRUE);
+        sstack.push_back(c_var, domains.get_unset(c_var), NUPACK_VV_TRUE);
       } 
 
       for (auto c_con : var_constraint_map[c_var]) {
-        success = success && constraints[c_con]->propagate_constraint(
-            c_var, sstack, ss);
+        if (ss.con_vars[c_con].empty()) cons_changed.push_back(c_con);
+        ss.con_vars[c_con].push_back(c_var);
       }
     }
 
+    for (auto c_con : cons_changed) {
+      success = success && constraints[c_con]->propagate_vars(
+          ss.con_vars[c_con], sstack, ss);
+      ss.con_vars[c_con].clear();
+    }
+    cons_changed.clear();
+
     if (!success) break;
     success = success && node->add_implications(ss.value_allowed, sstack);
   }
@@ -806,11 +877,7 @@ bool ConstraintHandler::propagate(std::shared_ptr<VariableNode> node,
 
 int ConstraintHandler::get_n_possibilities() const {
   int res = 0;
-  for (auto i = 0; i < value_allowed.size(); i++) {
-    for (auto j = 0; j < value_allowed[i].size(); j++) {
-      if (value_allowed[i][j] == NUPACK_VV_UNSET) res++;
-    }
-  }
+  for (auto i = 0; i < value_allowed.size(); i++) res += value_allowed.get_n_unset(i);
   return res;
 }
 
@@ -825,7 +892,7 @@ int ConstraintHandler::select_random(const std::vector<trinary> & allowed) {
 }
 
 std::vector<int> ConstraintHandler::init_random() const {
-  return find_closest(std::vector<int>(get_n_variables(), -1), value_allowed);
+  return find_closest(std::vector<int>(get_n_variables(), -1));
 }
 
 void ConstraintHandler::create_new_branches(std::shared_ptr<VariableNode> parent,
@@ -834,7 +901,7 @@ void ConstraintHandler::create_new_branches(std::shared_ptr<VariableNode> parent
   double cur_weight = 0.0;
     
   for (auto i = 0; i < n_vars; i++) {
-    auto n_unset = get_n_unset(solver.value_allowed[i]);
+    auto n_unset = solver.value_allowed.get_n_unset(i);
     if (n_unset > 0) {
       cur_weight += solver.weight[i]; // * n_unset; 
     }
@@ -845,7 +912,7 @@ void ConstraintHandler::create_new_branches(std::shared_ptr<VariableNode> parent
 
   cur_weight = 0;
   for (auto i = 0; i < n_vars; i++) {
-    auto n_unset = get_n_unset(solver.value_allowed[i]);
+    auto n_unset = solver.value_allowed.get_n_unset(i);
     if (n_unset > 0) {
       cur_weight += solver.weight[i];  // * n_unset;
       last_unset = i;
@@ -856,7 +923,7 @@ void ConstraintHandler::create_new_branches(std::shared_ptr<VariableNode> parent
   if (last_unset >= 0) {
     int min_dist = solver.value_allowed.size();
     int dist_start = parent->get_cost();
-    for (auto i = 0; i < solver.value_allowed[last_unset].size(); i++) {
+    for (auto i = 0; i < solver.value_allowed.size(last_unset); i++) {
       if (solver.value_allowed[last_unset][i] == NUPACK_VV_UNSET) {
         auto curptr = std::make_shared<VariableNode>(parent);
         SolveStack ss;
@@ -885,14 +952,13 @@ void ConstraintHandler::create_new_branches(std::shared_ptr<VariableNode> parent
 }
 
 std::vector<int> ConstraintHandler::find_closest(const std::vector<int> & start,
-    const AllowTable & value_allowed_in) const {
+    int restrict_var, int restrict_val) const {
   SolveStruc solver;
 
   auto root = std::make_shared<VariableNode>();
 
-  solver.value_allowed = value_allowed_in;
+  init_solver(solver);
   solver.start = start;
-  solver.weight.assign(solver.value_allowed.size(), 1.0);
 
   SolveStack stack;
   solver.min_dist = 1e100;
@@ -900,53 +966,24 @@ std::vector<int> ConstraintHandler::find_closest(const std::vector<int> & start,
 
   int n_poss = get_n_possibilities();
   auto n_vars = value_allowed.size();
-  NUPACK_CHECK(n_vars == (int)solver.value_allowed.size(),
-      "Number of variables is inconsistent " + to_string(n_vars) + " != "
-      + to_string(solver.value_allowed.size()));
 
+  // the root assigns the restriction and what it implies directly
   for (auto i = 0; i < n_vars; i++) {
-    NUPACK_CHECK(
-        solver.value_allowed[i].size() == value_allowed[i].size(),
-        "Invalid value allowed size");
-
-    int n_allowed = 0;
-    int n_true = 0;
-    int n_false = 0;
-    for (auto j = 0; j < solver.value_allowed[i].size(); j++) {
-      auto sav = solver.value_allowed[i][j];
-      auto tav = value_allowed[i][j];
-
-      NUPACK_CHECK(
-          tav == NUPACK_VV_UNSET || (tav == NUPACK_VV_TRUE && sav == NUPACK_VV_TRUE)
-          || (tav == NUPACK_VV_FALSE && sav == NUPACK_VV_FALSE),
-          "Value allowed must be a restriction of base allowed");
-
-      if (sav != tav) {
-        stack.push_back(i, j, sav);
-      }
-
-      if (sav == NUPACK_VV_UNSET) {
-        n_allowed++;
-      } else if (sav == NUPACK_VV_FALSE) {
-        n_false++;
-      } else if (sav == NUPACK_VV_TRUE) {
-        n_true++;
-      }
+    int n_allowed = value_allowed.get_n_unset(i);
+    int n_true = value_allowed.get_n_true(i);
+    bool restricted = i == restrict_var && restrict_val >= 0
+      && value_allowed[i][restrict_val] == NUPACK_VV_UNSET;
+    if (restricted) {
+      stack.push_back(i, restrict_val, NUPACK_VV_FALSE);
+      n_allowed--;
     }
 
     NUPACK_CHECK(n_true <= 1, "Only one value allowed per variable");
-    if (n_true == 1) {
-      for (auto j = 0; j < solver.value_allowed[i].size(); j++) {
-        if (solver.value_allowed[i][j] == NUPACK_VV_UNSET &&
-            value_allowed[i][j] == NUPACK_VV_UNSET) {
-          stack.push_back(i, j, NUPACK_VV_FALSE);
-        }
-      }
-    } else if (n_allowed == 1) {
+    if (n_true == 0 && n_allowed == 1) {
       auto j = 0;
-      for ( ; j < solver.value_allowed[i].size(); j++) {
-        if (solver.value_allowed[i][j] == NUPACK_VV_UNSET 
-            && value_allowed[i][j] == NUPACK_VV_UNSET) {
+      for ( ; j < value_allowed.size(i); j++) {
+        if (value_allowed[i][j] == NUPACK_VV_UNSET 
+            && !(restricted && j == restrict_val)) {
           break;
         }
       }
@@ -955,7 +992,6 @@ std::vector<int> ConstraintHandler::find_closest(const std::vector<int> & start,
     }
   }
 
-  solver.value_allowed = value_allowed;
   bool success = root->add_implications(solver.value_allowed, stack);
 
   // Propagate all
@@ -987,7 +1023,7 @@ std::vector<int> ConstraintHandler::find_closest(const std::vector<int> & start,
         solver.min_dist = cur_branch->get_cost();
 
         for (auto i = 0; i < solver.value_allowed.size(); i++) {
-          for (auto j = 0; j < solver.value_allowed[i].size(); j++) {
+          for (auto j = 0; j < solver.value_allowed.size(i); j++) {
             NUPACK_CHECK(solver.value_allowed[i][j] != NUPACK_VV_UNSET,
                 "unset variable " + to_string(i) + ":" + to_string(j) + 
                 "when all " + to_string(n_poss) + " variables are assigned");
@@ -29,6 +29,39 @@ namespace nupack {
     out << std::endl;
   }
 
+  /*
+   * The domains of all variables in flat storage: the state of every value
+   * of every variable, the number of unset and true values of each variable
+   * and, for the values below 8 (all of them for nucleotides), a mask of
+   * the values that are not ruled out.  domains[var][val] reads a state;
+   * states are only changed through set() to keep the counts.
+   */
+  class Domains {
+    public:
+      int add_variable(const std::vector<trinary> & states);
+
+      int size() const { return n_unset.size(); }
+      int size(int var) const { return offsets[var + 1] - offsets[var]; }
+      const trinary * operator[](int var) const { return values.data() + offsets[var]; }
+
+      void set(int var, int val, trinary state);
+
+      int get_n_unset(int var) const { return n_unset[var]; }
+      int get_n_true(int var) const { return n_true[var]; }
+      unsigned get_mask(int var) const { return masks[var]; }
+      /* the (i_set + 1)th unset value of var */
+      int get_unset(int var, int i_set = 0) const;
+
+      AllowTable to_table() const;
+
+    private:
+      std::vector<int> offsets {0};
+      std::vector<trinary> values;
+      std::vector<int> n_unset;
+      std::vector<int> n_true;
+      std::vector<uint8_t> masks;
+  };
+
   struct VariableTuple {
     VariableTuple() : VariableTuple(-1, -1, NUPACK_VV_UNSET) {};
     VariableTuple(int var, int val, trinary trit) : var(var), val(val), trit(trit) {}
@@ -63,7 +96,7 @@ namespace nupack {
        * @values: values to set
        * @allowed: value to set it to
        */
-      bool add_implications(AllowTable & allow_table, const SolveStack & stack);
+      bool add_implications(Domains & allow_table, const SolveStack & stack);
 
       /*
        * @allowed: the current allowed matrix, will be rolled back from 
@@ -76,7 +109,7 @@ namespace nupack {
        * 
        */
       static void change_branch(std::shared_ptr<VariableNode> from, std::shared_ptr<VariableNode> to, 
-          AllowTable & allow_table);
+          Domains & allow_table);
 
       /*
        * @allow_table: the current allowed matrix, will be cleared based
@@ -85,7 +118,7 @@ namespace nupack {
        * Throws an exception if the variables aren't assigned according to
        * the current node
        */
-      void rollback_variables(AllowTable & allow_table);
+      void rollback_variables(Domains & allow_table);
 
       /*
        * @allow_table: the current allowed matrix, will be assigned to based
@@ -94,7 +127,7 @@ namespace nupack {
        * Throws an exception if the variables assigned in the current node are
        * already set.
        */ 
-      void assign_variables(AllowTable & allow_table);
+      void assign_variables(Domains & allow_table);
 
 
       /* get the number of children for the node */
@@ -149,12 +182,16 @@ namespace nupack {
 
     public:
       std::vector<int> start;
-      AllowTable value_allowed;
+      Domains value_allowed;
       std::vector<double> weight;
       CVarQueue sorter;
 
       double min_dist;
       bool min_dist_set;
+
+      // scratch space of ConstraintHandler::propagate
+      std::vector<char> var_changed;
+      std::vector<std::vector<int> > con_vars;
   };
 
   class Constraint {
@@ -172,6 +209,14 @@ namespace nupack {
        */
       virtual bool propagate_constraint(int modified, SolveStack & sstack, const SolveStruc & ss) const = 0;
 
+      /*
+       * Propagate based on several variables modified at once.  All of
+       * them see the same state, so this is one propagate_constraint per
+       * variable unless a constraint can share the work.
+       */
+      virtual bool propagate_vars(const std::vector<int> & modified, SolveStack & sstack, 
+          const SolveStruc & ss) const;
+
       /*
        * Get the variables that can change the status of the constraint
        *
@@ -242,11 +287,18 @@ namespace nupack {
 
       /* * propagate the constraints for the current pattern constraint */
       bool propagate_constraint(int modified, SolveStack & sstack, const SolveStruc & ss) const;
+      /* checks each window overlapping the modified variables once */
+      bool propagate_vars(const std::vector<int> & modified, SolveStack & sstack, 
+          const SolveStruc & ss) const;
 
       /* get the variables modified by this constraint */
       std::vector<int> get_constrained_vars() const { return this->nuc_ids; }
 
     private:
+      /* the windows checked when the nucleotide at index changes */
+      std::pair<int, int> get_windows(int index) const;
+      bool check_window(int i, SolveStack & sstack, const SolveStruc & ss) const;
+
       std::string name;
       std::string constraint;
       
@@ -257,6 +309,7 @@ namespace nupack {
       // map from nucleotide ids to position in nuc_ids
       std::map<int, int> nuc_id_map;
       AllowTable pattern;
+      std::vector<uint8_t> pattern_masks;
   };
 
   class WordConstraint : public Constraint_CRTP<WordConstraint> {
@@ -318,6 +371,9 @@ namespace nupack {
           std::vector<double> min_match, std::vector<double> max_match);
 
       bool propagate_constraint(int modified, SolveStack & sstack, const SolveStruc & ss) const;
+      /* the propagation does not depend on the modified variable */
+      bool propagate_vars(const std::vector<int> & modified, SolveStack & sstack, 
+          const SolveStruc & ss) const;
 
       std::vector<int> get_constrained_vars() const;
       ~MatchConstraint() {}
@@ -327,6 +383,7 @@ namespace nupack {
       std::vector<std::pair<double, double>> ranges;
       std::vector<int> nuc_ids;
       AllowTable match_nucs;
+      std::vector<uint8_t> match_masks;
   };
 
 inline int pick_random_int(int from, int to) { return ((int) (genrand_real1() * (to - from))) + from; }
@@ -342,8 +399,12 @@ inline int pick_random_int(int from, int to) { return ((int) (genrand_real1() *
       std::vector<int> init_random() const;
 
 
+      /*
+       * closest assignment to start; value restrict_val of variable 
+       * restrict_var (if >= 0) is ruled out
+       */
       std::vector<int> find_closest(const std::vector<int> & start, 
-          const AllowTable & value_allowed) const;
+          int restrict_var = -1, int restrict_val = -1) const;
 
       int get_n_variables() const { return this->value_allowed.size(); }
 
@@ -373,8 +434,11 @@ inline int pick_random_int(int from, int to) { return ((int) (genrand_real1() *
       bool propagate(std::shared_ptr<VariableNode> cur, SolveStruc & ss) const;
       bool propagate_all(std::shared_ptr<VariableNode> node, SolveStruc & ss) const;
       
+      void init_solver(SolveStruc & ss) const;
+
       std::vector<std::shared_ptr<Constraint>> constraints;
-      AllowTable value_allowed;
+      std::vector<std::vector<int> > constraint_vars;
+      Domains value_allowed;
 
       // Map from variables to constraints that they take part in 
       // (constraints to check when the range of the variable changes)
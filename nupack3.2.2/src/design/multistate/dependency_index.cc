@@ -0,0 +1,99 @@
+#include "dependency_index.h"
+#include "physical_spec.h"
+#include "sequence_state.h"
+
+#include "design_debug.h"
+
+#include <algorithm>
+
+namespace nupack {
+
+DependencyIndex::DependencyIndex(const SingleParamSpec & spec,
+    const SequenceState & seqs, const NupackInvariants & invars) :
+    nuc_leaves(seqs.get_nucleotides().size()),
+    nuc_orders(seqs.get_nucleotides().size()),
+    ord_struc_map(spec.get_ord_struc_map()),
+    off_targets(spec.eval_off_targets()) {
+  const auto & strucs = spec.get_strucs();
+  for (auto i_struc = 0; i_struc < strucs.size(); i_struc++) {
+    const auto & struc = strucs[i_struc];
+    const auto & nuc_ids = struc.get_nuc_ids();
+    std::vector<bool> covered(nuc_ids.size(), false);
+    int k = 0;
+    add_leaves(struc.get_tree(), struc, i_struc, invars, k, covered);
+
+    for (auto pos = 0; pos < nuc_ids.size(); pos++) {
+      if (!covered[pos]) this->nuc_leaves[nuc_ids[pos]].emplace_back(i_struc, -1);
+    }
+    this->revisions.push_back(struc.get_revision());
+  }
+
+  const auto & strands = seqs.get_strands();
+  const auto & orders = spec.get_orders();
+  for (auto i_ord = 0; i_ord < orders.size(); i_ord++) {
+    const auto & ord_strands = orders[i_ord].get_strands();
+    for (auto c_str : ord_strands) {
+      for (auto nuc : strands[c_str].get_nuc_ids()) {
+        auto & cur = this->nuc_orders[nuc];
+        if (cur.empty() || cur.back() != i_ord) cur.push_back(i_ord);
+      }
+    }
+    this->order_strands.push_back(ord_strands);
+  }
+
+  for (auto & tube : spec.get_tubes()) {
+    std::vector<int> cur_orders;
+    for (auto & comp : tube.get_complexes()) cur_orders.push_back(comp.order_ind);
+    this->tube_orders.push_back(cur_orders);
+  }
+}
+
+// numbers the leaves of node from k on
+void DependencyIndex::add_leaves(const NodeSpec & node,
+    const StructureSpec & struc, int i_struc, const NupackInvariants & invars,
+    int & k, std::vector<bool> & covered) {
+  int n_children = node.get_n_children();
+  if (n_children > 0) {
+    for (auto i = 0; i < n_children; i++) {
+      add_leaves(node.get_child(i), struc, i_struc, invars, k, covered);
+    }
+    return;
+  }
+
+  for (auto pos : node.get_native_map(struc, invars)) covered[pos] = true;
+  for (auto nuc : node.get_nuc_ids(struc, invars)) {
+    auto & leaves = this->nuc_leaves[nuc];
+    // a nucleotide may appear twice in a leaf of a homodimer
+    if (leaves.empty() || leaves.back() != std::make_pair(i_struc, k)) {
+      leaves.emplace_back(i_struc, k);
+    }
+  }
+  k++;
+}
+
+bool DependencyIndex::matches(const SingleParamSpec & spec) const {
+  const auto & strucs = spec.get_strucs();
+  const auto & orders = spec.get_orders();
+  const auto & tubes = spec.get_tubes();
+  if (strucs.size() != this->revisions.size() ||
+      orders.size() != this->order_strands.size() ||
+      tubes.size() != this->tube_orders.size() ||
+      spec.eval_off_targets() != this->off_targets ||
+      spec.get_ord_struc_map() != this->ord_struc_map) return false;
+
+  for (auto i = 0; i < strucs.size(); i++) {
+    if (strucs[i].get_revision() != this->revisions[i]) return false;
+  }
+  for (auto i = 0; i < orders.size(); i++) {
+    if (orders[i].get_strands() != this->order_strands[i]) return false;
+  }
+  for (auto i = 0; i < tubes.size(); i++) {
+    const auto & comps = tubes[i].get_complexes();
+    if (comps.size() != this->tube_orders[i].size()) return false;
+    for (auto j = 0; j < comps.size(); j++) {
+      if (comps[j].order_ind != this->tube_orders[i][j]) return false;
+    }
+  }
+  return true;
+}
+}
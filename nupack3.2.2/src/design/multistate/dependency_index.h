@@ -0,0 +1,51 @@
+#pragma once
+
+#include <vector>
+#include <utility>
+
+namespace nupack {
+  class SingleParamSpec;
+  class StructureSpec;
+  class NodeSpec;
+  class SequenceState;
+  class NupackInvariants;
+
+    /**
+      * This class maps each nucleotide to the evaluations that read it:
+      * the (structure, leaf) pairs of the decomposition trees and the
+      * off-target orderings.  A leaf of -1 marks a nucleotide of a structure
+      * that no leaf holds, so that the whole structure has to be
+      * re-evaluated when it changes.  The index is built for one spec and
+      * matches() tells whether it still describes another one.
+      */
+  class DependencyIndex {
+    public:
+      DependencyIndex(const SingleParamSpec & spec, const SequenceState & seqs,
+          const NupackInvariants & invars);
+
+      bool matches(const SingleParamSpec & spec) const;
+
+      const std::vector<std::pair<int, int> > & get_leaves(int nuc) const {
+        return this->nuc_leaves[nuc];
+      }
+      const std::vector<int> & get_orders(int nuc) const {
+        return this->nuc_orders[nuc];
+      }
+      int n_nucs() const { return this->nuc_leaves.size(); }
+
+    private:
+      void add_leaves(const NodeSpec & node, const StructureSpec & struc,
+          int i_struc, const NupackInvariants & invars, int & k,
+          std::vector<bool> & covered);
+
+      std::vector<std::vector<std::pair<int, int> > > nuc_leaves;
+      std::vector<std::vector<int> > nuc_orders;
+
+      // what the index was built from
+      std::vector<unsigned long> revisions;
+      std::vector<std::vector<int> > order_strands;
+      std::vector<int> ord_struc_map;
+      std::vector<std::vector<int> > tube_orders;
+      bool off_targets;
+  };
+}
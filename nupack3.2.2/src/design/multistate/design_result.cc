@@ -1,6 +1,7 @@
 #include "design_result.h"
 #include "design_debug.h"
 #include "design_spec.h"
+#include "checkpoint.h"
 
 #include "algorithms.h"
 
@@ -16,12 +17,35 @@ void DesignResult::init_random(const DesignSpec & spec) {
 
 bool DesignResult::is_tabu(const std::vector<int> & vars) {
   auto mutations = this->get_mutations(vars);
-  return mutations.empty() || lin_contains(mutations, tabu);
+  return mutations.empty() || (tabu && lin_contains(mutations, *tabu));
 }
 
 void DesignResult::add_tabu(const std::vector<int> & vars) {
   std::vector<std::pair<int, int> > mutations = this->get_mutations(vars);
-  this->tabu.push_back(mutations);
+  if (!this->tabu) {
+    this->tabu = std::make_shared<Tabu>();
+  } else if (this->tabu.use_count() > 1) {
+    this->tabu = std::make_shared<Tabu>(*this->tabu);
+  }
+  this->tabu->push_back(mutations);
+}
+
+void DesignResult::save(std::ostream & out) const {
+  Checkpoint::write(out, this->eval.sequences.get_variables());
+  Checkpoint::write(out, this->tabu ? *this->tabu : Tabu());
+}
+
+void DesignResult::load(std::istream & in, const DesignSpec & spec) {
+  std::vector<int> vars;
+  Tabu saved_tabu;
+  Checkpoint::read(in, vars);
+  Checkpoint::read(in, saved_tabu);
+  NUPACK_CHECK(vars.size() == spec.constraints.get_n_variables(),
+      "Checkpoint does not match the design specification");
+
+  *this = DesignResult();
+  this->eval.sequences.set_variables(vars, spec.eval.sequences);
+  if (!saved_tabu.empty()) this->tabu = std::make_shared<Tabu>(saved_tabu);
 }
 
 std::vector<std::pair<int, int> > DesignResult::get_mutations(const std::vector<int> & vars) {
@@ -3,6 +3,8 @@
 #include "eval_result.h"
 
 #include <vector>
+#include <memory>
+#include <iostream>
 
 namespace nupack {
   class DesignSpec;
@@ -15,16 +17,23 @@ namespace nupack {
 
       bool is_tabu(const std::vector<int> & vars);
       void add_tabu(const std::vector<int> & vars);
-      void clear_tabu() { this->tabu.clear(); }
+      void clear_tabu() { this->tabu.reset(); }
 
       std::vector<std::pair<int, int> > get_mutations(const std::vector<int> & vars);
 
+      // the sequence and tabu list only; load() leaves the result to be
+      // evaluated again
+      void save(std::ostream & out) const;
+      void load(std::istream & in, const DesignSpec & spec);
+
       EvalResult eval;
       std::vector<DBL_TYPE> objectives;
       std::vector<bool> satisfied;
 
     private:
-      Tabu tabu;
+      // copy on write: offspring share their parent's list until they add
+      // to it, and an empty list is null
+      std::shared_ptr<Tabu> tabu;
   };
 }
 
@@ -1,5 +1,6 @@
 #include "designer.h"
 #include "algorithms.h"
+#include "checkpoint.h"
 
 #include <fstream>
 #include <sstream>
@@ -10,6 +11,7 @@
 
 #include <cfloat>
 #include <cmath>
+#include <cstdio>
 
 namespace nupack {
 // Code copied from optimize() and optimize_tubes(). Need to refactor.
@@ -27,53 +29,216 @@ void Designer::evaluate_defect() {
 }
   
 void Designer::optimize() {
+  const auto & opts = spec.eval.options;
+  if (!opts.telemetry_file.empty()) {
+    telemetry.open(opts.telemetry_file, "multitubedesign", opts.start_time);
+  }
+
   // Initialize population of results
   results.clear();
   for (auto i = 0; i < spec.eval.options.N_population; i++) 
     results.emplace_back();
   
   optimize_tubes();
+
+  if (opts.stop_requested()) {
+    telemetry.stop("stop file");
+  } else if (opts.opt_time_elapsed()) {
+    telemetry.stop("time limit");
+  } else {
+    telemetry.stop("satisfied");
+  }
+  telemetry.finish();
 }
 
 void Designer::optimize_tubes() {
   auto temp_results = results;
-  auto tmp = spec.constraints.init_random(); // unused, but advances RNG
-  
   PhysicalSpec tubespec = spec.eval.physical.get_depth(0, true);
-  int ref_ind = 0;
-
-  // init random
-  for (auto & tr : temp_results) tr.init_random(spec);
+  Results tube_res;
+
+  int i_gen = 0;
+  bool resumed_forest = false;
+
+  if (spec.eval.options.resume) {
+    load_checkpoint(temp_results);
+    Telemetry::Phase phase(telemetry, "tube_eval");
+    if (stage != FIRST_FOREST) evaluate(tubespec, results);
+    if (stage == AT_REFOCUS) {
+      tube_res = temp_results;
+      evaluate(tubespec, tube_res);
+    }
+    resumed_forest = stage == LATER_FOREST;
+  } else {
+    auto tmp = spec.constraints.init_random(); // unused, but advances RNG
 
-  spec.eval.physical.decompose(spec.eval.options);
+    // init random
+    for (auto & tr : temp_results) tr.init_random(spec);
 
-  // optimize trees
-  optimize_forest(spec.eval.physical, temp_results);
+    spec.eval.physical.decompose(spec.eval.options);
+    stage = FIRST_FOREST;
+  }
 
-  // Evaluate at tube level
-  auto tube_res = temp_results;
-  evaluate(tubespec, tube_res);
-  results = tube_res;
+  if (stage == FIRST_FOREST) {
+    // optimize trees
+    optimize_forest(spec.eval.physical, temp_results);
 
-  while (!tubes_satisfied(tubespec, tube_res, temp_results) && !spec.eval.options.opt_time_elapsed()) {
-    // Add worst offenders
-    NUPACK_DEBUG("Refocusing");
-    if (spec.eval.options.print_steps >= PRINT_REFOCUS) {
-      print_leaf_root(tubespec, tube_res, "refocus", ref_ind);
-      ref_ind++;
+    // Evaluate at tube level
+    {
+      Telemetry::Phase phase(telemetry, "tube_eval");
+      tube_res = temp_results;
+      evaluate(tubespec, tube_res);
+    }
+    results = tube_res;
+    stage = AT_REFOCUS;
+    checkpoint(temp_results);
+  }
+  record_generation("optimize_tubes", i_gen++, results);
+
+  while (resumed_forest || (!tubes_satisfied(tubespec, tube_res, temp_results)
+        && !spec.eval.options.should_stop())) {
+    // Add worst offenders, unless resuming inside the forest optimization
+    // that followed them
+    if (!resumed_forest) {
+      NUPACK_DEBUG("Refocusing");
+      if (spec.eval.options.print_steps >= PRINT_REFOCUS) {
+        print_leaf_root(tubespec, tube_res, "refocus", ref_ind);
+        ref_ind++;
+      }
+      Telemetry::Phase phase(telemetry, "refocus");
+      add_off_targets(spec.eval.physical, tube_res, temp_results);
     }
-    add_off_targets(spec.eval.physical, tube_res, temp_results);
+    resumed_forest = false;
 
+    stage = LATER_FOREST;
     optimize_forest(spec.eval.physical, temp_results);
+    stage = AT_REFOCUS;
     
-    tube_res = temp_results;
-    evaluate(tubespec, tube_res);
+    {
+      Telemetry::Phase phase(telemetry, "tube_eval");
+      tube_res = temp_results;
+      evaluate(tubespec, tube_res);
+    }
     append(results, tube_res);
 
     pick_best_par(results);
+    record_generation("optimize_tubes", i_gen++, results);
+    checkpoint(temp_results);
   }
 }
 
+std::string Designer::checkpoint_filename() const {
+  return spec.eval.options.file_prefix + ".checkpoint";
+}
+
+/*
+ * Saves the state if the interval has passed.  Called at the refocusing
+ * steps with the tree-level population, and inside optimize_forest() with
+ * the population being optimized there, from which a resumed run restarts
+ * the forest optimization.
+ */
+void Designer::checkpoint(const Results & tree_res) {
+  const auto & opts = spec.eval.options;
+  if (opts.checkpoint_interval < 0) return;
+
+  DBL_TYPE now = opts.opt_time();
+  if (now - last_checkpoint < opts.checkpoint_interval) return;
+
+  save_checkpoint(tree_res);
+  last_checkpoint = now;
+}
+
+const std::string CHECKPOINT_MAGIC = "multitubedesign checkpoint 2";
+
+/*
+ * The checkpoint holds what optimize_tubes() carries from one refocusing
+ * step to the next: the stage, the RNG, the off-targets and decompositions
+ * added to the specification, and the sequences and tabu lists of both
+ * populations.  There are no tube-level results yet during the first
+ * forest optimization.
+ * The evaluations are redone on loading.  The file is written aside and
+ * renamed so that a run killed while writing keeps the previous one.
+ */
+void Designer::save_checkpoint(const Results & tree_res) {
+  const auto & opts = spec.eval.options;
+  std::string filename = checkpoint_filename();
+  std::string tmp_filename = filename + ".tmp";
+  {
+    std::ofstream out(tmp_filename, std::ios::binary | std::ios::trunc);
+    NUPACK_CHECK(out.good(), "Unable to write " + tmp_filename);
+
+    Checkpoint::write(out, CHECKPOINT_MAGIC);
+    Checkpoint::write(out, opts.seed);
+    Checkpoint::write(out, spec.constraints.get_n_variables());
+
+    std::vector<unsigned long> rng(genrand_state_length());
+    genrand_save_state(rng.data());
+    Checkpoint::write(out, rng);
+    Checkpoint::write(out, opts.opt_time());
+    Checkpoint::write(out, ref_ind);
+    Checkpoint::write(out, red_ind);
+    Checkpoint::write(out, i_opt);
+    Checkpoint::write(out, stage);
+
+    spec.eval.physical.save_state(out);
+
+    long n_res = stage == FIRST_FOREST ? 0 : results.size();
+    Checkpoint::write(out, n_res);
+    for (auto i = 0; i < n_res; i++) results[i].save(out);
+    Checkpoint::write(out, (long) tree_res.size());
+    for (auto & r : tree_res) r.save(out);
+
+    out.flush();
+    NUPACK_CHECK(out.good(), "Unable to write " + tmp_filename);
+  }
+  NUPACK_CHECK(std::rename(tmp_filename.c_str(), filename.c_str()) == 0,
+      "Unable to write " + filename);
+}
+
+void Designer::load_checkpoint(Results & tree_res) {
+  auto & opts = spec.eval.options;
+  std::string filename = checkpoint_filename();
+  std::ifstream in(filename, std::ios::binary);
+  NUPACK_CHECK(in.good(), "Unable to read " + filename);
+
+  std::string magic;
+  unsigned int seed = 0;
+  int n_variables = 0;
+  Checkpoint::read(in, magic);
+  Checkpoint::read(in, seed);
+  Checkpoint::read(in, n_variables);
+  NUPACK_CHECK(magic == CHECKPOINT_MAGIC, filename + " is not a checkpoint");
+  NUPACK_CHECK(seed == opts.seed && n_variables == spec.constraints.get_n_variables(),
+      "Checkpoint does not match the design specification");
+
+  std::vector<unsigned long> rng;
+  DBL_TYPE elapsed = 0;
+  Checkpoint::read(in, rng);
+  Checkpoint::read(in, elapsed);
+  Checkpoint::read(in, ref_ind);
+  Checkpoint::read(in, red_ind);
+  Checkpoint::read(in, i_opt);
+  Checkpoint::read(in, stage);
+  NUPACK_CHECK(rng.size() == genrand_state_length(), "Corrupt checkpoint");
+
+  spec.eval.physical.load_state(in, spec.eval.sequences);
+
+  long n_res = 0;
+  Checkpoint::read(in, n_res);
+  results.resize(n_res);
+  for (auto & r : results) r.load(in, spec);
+  Checkpoint::read(in, n_res);
+  tree_res.resize(n_res);
+  for (auto & r : tree_res) r.load(in, spec);
+
+  PhysicalSpec rootspec = spec.eval.physical.get_depth(0);
+  evaluate(rootspec, tree_res);
+
+  genrand_init_state(rng.data());
+  opts.start_time -= elapsed;
+  resumed_time = elapsed;
+  last_checkpoint = elapsed;
+}
+
 void Designer::copy_sequences(Results & a, Results & b) {
   NUPACK_DEBUG("a.size() " + to_string(a.size()) + " b.size() " + to_string(b.size()));
   for (auto it_a = a.begin(), it_b = b.begin(); it_a != a.end(); ++it_a, ++it_b)
@@ -81,6 +246,7 @@ void Designer::copy_sequences(Results & a, Results & b) {
 }
 
 void Designer::optimize_forest(PhysicalSpec & phys_spec, Results & res) {
+  Telemetry::Phase forest_phase(telemetry, "optimize_forest");
   std::vector<PhysicalSpec> specs;
   std::vector<Results> results;
 
@@ -97,26 +263,29 @@ void Designer::optimize_forest(PhysicalSpec & phys_spec, Results & res) {
   }
 
   bool root_accepted = false;
-  static int red_ind = 0;
   while (!root_accepted) {
     root_accepted = true;
 
     optimize_leaves(specs[n_levels-1], results[n_levels-1]);
 
     for (auto i = n_levels - 2; i >= 0 && root_accepted; i--) {
-      // Merge sequences
       Results tmp_result = results[i];
-      tmp_result.resize(results[i + 1].size());      
-      copy_sequences(tmp_result, results[i + 1]);
+      {
+        Telemetry::Phase phase(telemetry, "merge");
+        // Merge sequences
+        tmp_result.resize(results[i + 1].size());      
+        copy_sequences(tmp_result, results[i + 1]);
 
-      evaluate(specs[i], tmp_result);
+        evaluate(specs[i], tmp_result);
 
-      append(results[i], tmp_result);
+        append(results[i], tmp_result);
 
-      pick_best_par(results[i]);
-      copy_sequences(results[i + 1], results[i]);
+        pick_best_par(results[i]);
+        copy_sequences(results[i + 1], results[i]);
 
-      evaluate(specs[i + 1], results[i + 1]);
+        evaluate(specs[i + 1], results[i + 1]);
+      }
+      checkpoint(results[i]);
 
 #ifndef NDEBUG
       std::stringstream ss;
@@ -125,8 +294,9 @@ void Designer::optimize_forest(PhysicalSpec & phys_spec, Results & res) {
 #endif // NDEBUG
 
       if (!parent_satisfied(specs[i], tmp_result, results[i + 1])
-          && !spec.eval.options.opt_time_elapsed()) {
+          && !spec.eval.options.should_stop()) {
         NUPACK_DEBUG("Redecomposing");
+        Telemetry::Phase phase(telemetry, "redecompose");
         root_accepted = false;
         
         if (spec.eval.options.print_steps >= PRINT_REDECOMPOSE) {
@@ -169,12 +339,14 @@ void Designer::print_leaf_root(PhysicalSpec & phys_spec, Results & res, std::str
 }
 
 void Designer::optimize_leaves(PhysicalSpec & phys_spec, Results & res) {
+  Telemetry::Phase phase(telemetry, "optimize_leaves");
   auto & opts = spec.eval.options;
   mutate_leaves(phys_spec, res);
+  int i_gen = 0;
+  record_generation("optimize_leaves", i_gen++, res);
 
   bool all_sat = all_satisfied(phys_spec, res);
   int m = 0;
-  static int i_opt = 0;
   int cur_reopt = 0;
 
   // std::stringstream sufss;
@@ -194,7 +366,7 @@ void Designer::optimize_leaves(PhysicalSpec & phys_spec, Results & res) {
     cur_reopt++;
   }
 
-  while (!all_sat && m < opts.M_reopt && !opts.opt_time_elapsed()) {
+  while (!all_sat && m < opts.M_reopt && !opts.should_stop()) {
     NUPACK_DEBUG("Reoptimizing leaves");
     Results new_gen = res;
     make_offspring(phys_spec, new_gen, opts.M_reseed);
@@ -234,6 +406,8 @@ void Designer::optimize_leaves(PhysicalSpec & phys_spec, Results & res) {
 //       serialize_defects(std::cout, phys_spec, res, 0, ss.str());
 // #endif // NDEBUG
     }
+    record_generation("optimize_leaves", i_gen++, res);
+    checkpoint(res);
   }
   i_opt++;
 }
@@ -476,14 +650,16 @@ void Designer::redecompose(PhysicalSpec & phys_spec, Results & parent,
 
 void Designer::mutate_leaves(PhysicalSpec & phys_spec, Results & res) {
   NUPACK_DEBUG("Mutating leaves");
+  Telemetry::Phase phase(telemetry, "mutate_leaves");
   
   auto & opts = spec.eval.options;
   int m = 0;
+  int i_gen = 0;
   evaluate(phys_spec, res);
   bool all_sat = all_satisfied(phys_spec, res);
   for (auto & r : res) r.clear_tabu();
 
-  while (!all_sat && m < opts.M_bad && !opts.opt_time_elapsed()) {
+  while (!all_sat && m < opts.M_bad && !opts.should_stop()) {
     auto new_gen = res;
     make_offspring(phys_spec, new_gen);
     update_tabu(res, new_gen);
@@ -503,6 +679,8 @@ void Designer::mutate_leaves(PhysicalSpec & phys_spec, Results & res) {
     } else {
       m++;
     }
+    record_generation("mutate_leaves", i_gen++, res);
+    checkpoint(res);
   }
   for (auto & r : res) r.clear_tabu();
 }
@@ -565,21 +743,7 @@ bool Designer::pick_best_par(Results & res) {
   auto stops = spec.objectives.get_stops(spec.eval, res.begin()->eval);
   std::vector<DBL_TYPE> summaries;
 
-  for (auto & r : res) {
-    const auto & def = r.objectives;
-    const auto & sat = r.satisfied;
-    DBL_TYPE summary = 0;
-    for (auto i = 0; i < def.size(); i++) {
-      if (sat[i]) {
-        summary += 1.0;
-      } else {
-        NUPACK_DEBUG_CHECK(!(def[i] < stops[i]), 
-            "def / stop < 1.0 in unsatisfied objective");
-        summary += def[i] / stops[i];
-      }
-    }
-    summaries.push_back(summary);
-  }
+  for (auto & r : res) summaries.push_back(score(r, stops));
   auto unsorted_summaries = summaries;
   std::sort(summaries.begin(), summaries.end());
 
@@ -613,6 +777,41 @@ bool Designer::pick_best_par(Results & res) {
 }
 
 
+// objectives count 1 when satisfied and their defect over the stop otherwise
+DBL_TYPE Designer::score(const DesignResult & r, 
+    const std::vector<DBL_TYPE> & stops) const {
+  const auto & def = r.objectives;
+  const auto & sat = r.satisfied;
+  DBL_TYPE summary = 0;
+  for (auto i = 0; i < def.size(); i++) {
+    if (sat[i]) {
+      summary += 1.0;
+    } else {
+      NUPACK_DEBUG_CHECK(!(def[i] < stops[i]), 
+          "def / stop < 1.0 in unsatisfied objective");
+      summary += def[i] / stops[i];
+    }
+  }
+  return summary;
+}
+
+void Designer::record_generation(const std::string & phase, int i_gen,
+    const Results & res) {
+  if (!telemetry.enabled() || res.empty()) return;
+
+  auto stops = spec.objectives.get_stops(spec.eval, res.begin()->eval);
+  auto best = res.begin();
+  DBL_TYPE best_score = score(*best, stops);
+  for (auto it = res.begin() + 1; it != res.end(); ++it) {
+    DBL_TYPE cur = score(*it, stops);
+    if (cur < best_score) {
+      best_score = cur;
+      best = it;
+    }
+  }
+  telemetry.generation(phase, i_gen, best_score, best->objectives);
+}
+
 void Designer::serialize_defects(std::ostream & out, PhysicalSpec & phys_spec, 
     Results & res, int indent, std::string prefix) {
   EvalSpec tmp = spec.eval;
@@ -634,6 +833,16 @@ void Designer::evaluate(PhysicalSpec & phys_spec, Results & res) {
     r.eval.physical.evaluate(r.eval.sequences, phys_spec, tmp.options);
     r.eval.symmetries.evaluate(r.eval.sequences, tmp.symmetries);
 
+    eval_counts.designs++;
+    for (const auto & single : r.eval.physical.get_results()) {
+      for (const auto & struc : single.get_strucs()) {
+        eval_counts.leaf_lookups += struc.get_n_leaves();
+      }
+      for (const auto & ord : single.get_orders()) {
+        if (ord.get_evaluated()) eval_counts.order_lookups++;
+      }
+    }
+
     r.objectives = spec.objectives.get_defects(tmp, r.eval);
     r.satisfied = spec.objectives.satisfied(tmp, r.eval);
   }
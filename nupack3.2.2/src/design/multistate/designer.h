@@ -2,6 +2,7 @@
 
 #include "design_spec.h"
 #include "design_result.h"
+#include "telemetry.h"
 
 #include <vector>
 #include <string>
@@ -34,6 +35,8 @@ namespace nupack {
       void add_off_targets(PhysicalSpec & curspec, Results & tuberes, Results & treeres);
 
       const Results & get_results() {return this->results; }
+      // optimization time spent before a resumed run started
+      DBL_TYPE get_resumed_time() const { return this->resumed_time; }
       
       void print_leaf_root(PhysicalSpec & spec, Results & res, std::string type, int index);
       void serialize_defects(std::ostream & out, PhysicalSpec & spec, 
@@ -44,5 +47,30 @@ namespace nupack {
       Results results;
       
       void copy_sequences(Results & a, Results & b);
+
+      DBL_TYPE score(const DesignResult & res, 
+          const std::vector<DBL_TYPE> & stops) const;
+      void record_generation(const std::string & phase, int i_gen, 
+          const Results & res);
+
+      void checkpoint(const Results & tree_res);
+      void save_checkpoint(const Results & tree_res);
+      void load_checkpoint(Results & tree_res);
+      std::string checkpoint_filename() const;
+
+      // indices of the files written for print_steps
+      int ref_ind {0};
+      int red_ind {0};
+      int i_opt {0};
+
+      DBL_TYPE resumed_time {0};
+      DBL_TYPE last_checkpoint {0};
+
+      // where optimize_tubes() stands, kept in the checkpoint so that a
+      // run killed inside the forest optimization resumes there
+      enum Stage { AT_REFOCUS, FIRST_FOREST, LATER_FOREST };
+      int stage {AT_REFOCUS};
+
+      Telemetry telemetry;
   };
 }
@@ -0,0 +1,98 @@
+#include "ensemble_memo.h"
+#include "nupack_invariants.h"
+#include "telemetry.h"
+#include "constants.h"
+
+#include <algorithm>
+
+namespace nupack {
+
+EnsembleKey::EnsembleKey(const std::vector<int> & sequence,
+    DBL_TYPE temperature, const NupackInvariants & invars) :
+    sequence(sequence),
+    conditions({temperature, (DBL_TYPE) invars.material,
+        (DBL_TYPE) invars.dangle_type, invars.sodium, invars.magnesium,
+        (DBL_TYPE) invars.use_long_helix,
+        std::min<DBL_TYPE>(invars.min_ppair, NUM_PRECISION)}) {}
+
+bool EnsembleKey::operator<(const EnsembleKey & other) const {
+  if (sequence != other.sequence) return sequence < other.sequence;
+  if (bonus_pairs != other.bonus_pairs) return bonus_pairs < other.bonus_pairs;
+  if (bonuses != other.bonuses) return bonuses < other.bonuses;
+  return conditions < other.conditions;
+}
+
+EnsembleFill::EnsembleFill(const EnsembleKey & key, bool calc_pairs,
+    const NupackInvariants & invars) : pfunc(1), root_q(1), has_pairs(calc_pairs) {
+  const auto & cond = key.conditions;
+  InitSparsePairPr(&this->pairs, cond.back());
+
+  // global passing mechanism using these variable names
+  pairPr = NULL;
+  pairPrSparse = calc_pairs ? &this->pairs : NULL;
+
+  std::vector<int> seq = key.sequence;
+  this->pfunc = pfuncFullWithPairBonuses(seq.data(), 3, invars.material,
+      invars.dangle_type, cond[0] - ZERO_C_IN_KELVIN, calc_pairs ? 1 : 0, 1,
+      invars.sodium, invars.magnesium, invars.use_long_helix,
+      key.bonuses.size(), key.bonus_pairs.data(), key.bonuses.data(),
+      &this->root_q);
+
+  pairPrSparse = NULL;
+}
+
+EnsembleFill::~EnsembleFill() {
+  ClearSparsePairPr(&this->pairs);
+}
+
+size_t EnsembleFill::n_bytes() const {
+  size_t n = sizeof(EnsembleFill);
+  if (this->has_pairs) {
+    n += (this->pairs.seqlength + 1) * sizeof(int) +
+      this->pairs.nAlloc * (sizeof(int) + sizeof(DBL_TYPE));
+  }
+  return n;
+}
+
+// the key is held by both the list and the index
+static size_t entry_bytes(const EnsembleKey & key, const EnsembleFill & fill) {
+  return fill.n_bytes() + 2 * key.sequence.size() * sizeof(int);
+}
+
+std::shared_ptr<const EnsembleFill> EnsembleMemo::fill(const EnsembleKey & key,
+    bool calc_pairs, const NupackInvariants & invars) {
+  auto it = this->index.find(key);
+  if (it != this->index.end()) {
+    auto entry = it->second;
+    if (!calc_pairs || entry->second->has_pairs) {
+      this->lru.splice(this->lru.begin(), this->lru, entry);
+      eval_counts.shared_fills++;
+      return entry->second;
+    }
+    this->n_bytes -= entry_bytes(entry->first, *entry->second);
+    this->lru.erase(entry);
+    this->index.erase(it);
+  }
+
+  auto res = std::make_shared<const EnsembleFill>(key, calc_pairs, invars);
+  size_t n = entry_bytes(key, *res);
+  if (n > this->max_bytes) return res;
+
+  while (!this->lru.empty() && this->n_bytes + n > this->max_bytes) {
+    const auto & last = this->lru.back();
+    this->n_bytes -= entry_bytes(last.first, *last.second);
+    this->index.erase(last.first);
+    this->lru.pop_back();
+  }
+
+  this->lru.emplace_front(key, res);
+  this->index.emplace(key, this->lru.begin());
+  this->n_bytes += n;
+  return res;
+}
+
+EnsembleMemo & ensemble_memo() {
+  static EnsembleMemo memo(DEFAULT_ENSEMBLE_MEMO_BYTES);
+  return memo;
+}
+}
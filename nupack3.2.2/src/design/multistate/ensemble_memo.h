@@ -0,0 +1,76 @@
+#pragma once
+
+#include <thermo.h>
+
+#include <list>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace nupack {
+  class NupackInvariants;
+
+  /**
+   * What a fill depends on: the sequence with its strand breaks, the pair
+   * bonuses and the physical conditions.
+   */
+  struct EnsembleKey {
+    std::vector<int> sequence;          // STRAND_PLUS between strands, -1 ended
+    std::vector<int> bonus_pairs;       // i0, j0, i1, j1, ...
+    std::vector<DBL_TYPE> bonuses;
+    std::vector<DBL_TYPE> conditions;
+
+    EnsembleKey(const std::vector<int> & sequence, DBL_TYPE temperature,
+        const NupackInvariants & invars);
+
+    bool operator<(const EnsembleKey & other) const;
+  };
+
+  /**
+   * The partition function of one ensemble as pfuncFullWithPairBonuses
+   * returns it (pfunc) and before the strand association penalty
+   * (root_q), with the pair probabilities if they were computed.
+   */
+  class EnsembleFill {
+    public:
+      EnsembleFill(const EnsembleKey & key, bool calc_pairs,
+          const NupackInvariants & invars);
+      ~EnsembleFill();
+      EnsembleFill(const EnsembleFill &) = delete;
+      EnsembleFill & operator=(const EnsembleFill &) = delete;
+
+      DBL_TYPE pfunc;
+      DBL_TYPE root_q;
+      bool has_pairs;
+      sparsePairPr pairs;
+
+      size_t n_bytes() const;
+  };
+
+  /**
+   * Fills shared by all the results of a run.  Several results hold the
+   * same sequences (offspring, the levels of optimize_forest, the tube
+   * level copies) and an off-target ordering refocused into a target is
+   * filled again as the unbonused root of its tree; all of these are
+   * served by the one fill.  Fills asked for without pairs are served by
+   * fills with pairs.  The least recently used fills are dropped beyond
+   * max_bytes.
+   */
+  class EnsembleMemo {
+    public:
+      EnsembleMemo(size_t max_bytes) : max_bytes(max_bytes) {}
+
+      std::shared_ptr<const EnsembleFill> fill(const EnsembleKey & key,
+          bool calc_pairs, const NupackInvariants & invars);
+
+    private:
+      using Entry = std::pair<EnsembleKey, std::shared_ptr<const EnsembleFill> >;
+
+      size_t max_bytes;
+      size_t n_bytes {0};
+      std::list<Entry> lru;   // most recently used first
+      std::map<EnsembleKey, std::list<Entry>::iterator> index;
+  };
+
+  EnsembleMemo & ensemble_memo();
+}
@@ -27,6 +27,10 @@ int main(int argc, char ** argv) {
       bool _default_stops = false;
       bool _ppairsopt = false;
       bool _jsonopt = false;
+      bool _resume = false;
+      double _checkpoint = -1;
+      std::string _telemetry;
+      std::string _stopfile;
 
       try {
         TCLAP::CmdLine cmds(
@@ -46,6 +50,21 @@ int main(int argc, char ** argv) {
             "Automatically set default stop conditions for"
             " structures and tubes without a stop condition. "
             "(typically 1%)", false);
+        TCLAP::SwitchArg resume("", "resume",
+            "Continue the design from the checkpoint file "
+            "(prefix.checkpoint) of an earlier run", false);
+        TCLAP::ValueArg<double> checkpoint("", "checkpoint",
+            "Save the optimizer state to prefix.checkpoint at most every "
+            "given number of seconds, at the refocusing steps and between "
+            "the generations of the forest optimization", false, -1,
+            "seconds");
+        TCLAP::ValueArg<std::string> telemetry("", "telemetry",
+            "Write a JSON-lines record of the optimizer progress (phase "
+            "times, evaluation counts, best defects, memory) to the file",
+            false, "", "file");
+        TCLAP::ValueArg<std::string> stopfile("", "stopfile",
+            "End the optimization with the best design so far once the "
+            "file exists", false, "", "file");
         TCLAP::UnlabeledValueArg<std::string> file_arg("input", "script input file (.np)",
             true, "", 
             "input script");
@@ -64,6 +83,10 @@ int main(int argc, char ** argv) {
         cmds.add(nodesign);
         cmds.add(file_arg);
         cmds.add(default_stops);
+        cmds.add(resume);
+        cmds.add(checkpoint);
+        cmds.add(telemetry);
+        cmds.add(stopfile);
 
         cmds.parse(argc, argv);
 
@@ -75,6 +98,10 @@ int main(int argc, char ** argv) {
         _prettyjson = prettyjson.getValue();
 #endif
         _default_stops = default_stops.getValue();
+        _resume = resume.getValue();
+        _checkpoint = checkpoint.getValue();
+        _telemetry = telemetry.getValue();
+        _stopfile = stopfile.getValue();
         filename = file_arg.getValue();
       } catch (TCLAP::ArgException &e) {
         NUPACK_ERROR(e.error() + " " + e.argId());
@@ -86,6 +113,10 @@ int main(int argc, char ** argv) {
       invars.add_global_stop = _default_stops;
       invars.print_json = _jsonopt;
       invars.print_ppairs = _ppairsopt;
+      invars.resume = _resume;
+      invars.checkpoint_interval = _checkpoint;
+      invars.telemetry_file = _telemetry;
+      invars.stop_file = _stopfile;
 
       nupack::ScriptProcessor(filename, fullspec).parse_design();
 
@@ -114,7 +145,7 @@ int main(int argc, char ** argv) {
         gettimeofday(&endtime, NULL);
         DBL_TYPE elapsed = (DBL_TYPE) (endtime.tv_sec - starttime.tv_sec);
         elapsed += 1e-6 * (endtime.tv_usec - starttime.tv_usec);
-        invars.elapsed_time = elapsed;
+        invars.elapsed_time = elapsed + maindes.get_resumed_time();
 
         auto it = res.begin();
         for ( ; it != res.end(); ++it) {
@@ -1,5 +1,7 @@
 #include "node_result.h"
 #include "sequence_state.h"
+#include "telemetry.h"
+#include "ensemble_memo.h"
 
 #include "design_debug.h"
 #include "algorithms.h"
@@ -10,8 +12,10 @@ namespace nupack {
 
 int NodeResult::get_max_depth() const {
   if (children.size() == 0) return 0;
+  using child = typename decltype(children)::value_type;
   return (*std::max_element(children.begin(), children.end(), 
-      smaller_depth<NodeResult>)).get_max_depth() + 1;
+      [](const child & a, const child & b) { return smaller_depth(*a, *b); })
+      )->get_max_depth() + 1;
 }
 
 DBL_TYPE NodeResult::merge_pfuncs(const NodeResult & left,
@@ -46,12 +50,12 @@ void NodeResult::replace_node(const NodeResult & other, int k,
     NUPACK_CHECK(other_num_children == num_children, 
         "Alternate decomposition must be sourced from the same tree");
     for (auto i = 0; i < other_num_children; ++i) {
-      auto child_n_leaves = other.children[i].get_n_leaves();
-      child_n_leaves = std::min(child_n_leaves, children[i].get_n_leaves());
+      auto child_n_leaves = other.children[i]->get_n_leaves();
+      child_n_leaves = std::min(child_n_leaves, children[i]->get_n_leaves());
       if (c_k >= child_n_leaves) {
         c_k -= child_n_leaves;
       } else {
-        children[i].replace_node(other.children[i], c_k, params, invars);
+        mutable_child(i).replace_node(*other.children[i], c_k, params, invars);
         c_k = -1;
         break;
       }
@@ -59,21 +63,21 @@ void NodeResult::replace_node(const NodeResult & other, int k,
 
     pfunc_corrected = 0;
     for (auto it = children.begin(); it != children.end(); it += 2) {
-      pfunc_corrected += merge_pfuncs(*(it), *(it + 1), params, invars);
+      pfunc_corrected += merge_pfuncs(**it, **(it + 1), params, invars);
       NUPACK_CHECK(it != children.end(), "children incorrectly formatted.");
     }
     if (c_k < 0) {
       NUPACK_DEBUG("Merged 1: " << -kB * params.temperature * LOG_FUNC(pfunc_corrected))
     }
+
+    n_leaves = 0;
+    for (auto & c : children) n_leaves += c->get_n_leaves();
   }
 }
 
 int NodeResult::get_n_leaves() const {
   if (children.size() == 0) return 1;
-  using child = typename decltype(children)::value_type;
-  return accumulate(children, 0, [](const int a, const child & b) {
-      return a + b.get_n_leaves();
-  });
+  return n_leaves;
 }
 
 int NodeResult::native_index(int i) const {
@@ -86,10 +90,12 @@ int NodeResult::native_index(int i) const {
 // TODO make NodeSpec::get_children() public
 void NodeResult::init(const NodeSpec & spec) {
   clear();
+  n_leaves = 0;
   for (auto i = 0; i < spec.get_n_children(); ++i) {
-    auto tmp = NodeResult();
-    tmp.init(spec.get_child(i));
-    children.emplace_back(tmp);
+    auto tmp = std::make_shared<NodeResult>();
+    tmp->init(spec.get_child(i));
+    n_leaves += tmp->get_n_leaves();
+    children.push_back(tmp);
   }
 }
 
@@ -204,72 +210,81 @@ void NodeResult::evaluate_leaf(const NodeSpec & spec, const SequenceState& seqs,
       "Fullseq size: " + to_string(fullseq.size()) + " evalseq size: " 
       + to_string(eval_sequence.size()) + " n breaks: " + to_string(n_brs));
 
-  std::vector<DBL_TYPE> pp((n_nucs + 1) * n_nucs, 0.0);
-  std::vector<DBL_TYPE> q(n_nucs * n_nucs, 0.0);
-  // global passing mechanism using these variable names
-  pairPr = pp.data();
-  EXTERN_Q = q.data();
-
+  // the split pairs get a bonus, listed rather than as an n x n matrix
   const auto & assumed = spec.get_assume();
-  DBL_TYPE pfunc = 1;
-  if (invars.include_dummies) {
-    pfuncFull(fullseq.data(), 3, invars.material, invars.dangle_type,
-      params.temperature - ZERO_C_IN_KELVIN, 1, invars.sodium,
-      invars.magnesium, invars.use_long_helix);
-    pfunc = q[pf_index(0, n_nucs - 1, n_nucs)];
-  } else {
-    std::vector<DBL_TYPE> bonuses(n_nucs * n_nucs, 1);
+  EnsembleKey key(fullseq, params.temperature, invars);
+  DBL_TYPE total_bonus = 1.0;
+  if (!invars.include_dummies) {
     DBL_TYPE bonus_per = bonus;
-    DBL_TYPE total_bonus = 1.0;
     for (auto & a : assumed) {
       i_nuc = to_node[a.first];
       auto j_nuc = to_node[a.second];
       if (!(i_nuc < j_nuc)) std::swap(i_nuc, j_nuc); 
-      bonuses[i_nuc * n_nucs + j_nuc] *= EXP_FUNC(-bonus_per / (kB * params.temperature));
+      key.bonus_pairs.push_back(i_nuc);
+      key.bonus_pairs.push_back(j_nuc);
+      key.bonuses.push_back(EXP_FUNC(-bonus_per / (kB * params.temperature)));
       total_bonus *= EXP_FUNC(-bonus_per / (kB * params.temperature));
     }
-    pfuncFullWithBonuses(fullseq.data(), 3, invars.material, 
-        invars.dangle_type, params.temperature - ZERO_C_IN_KELVIN, 1, 1,
-        invars.sodium, invars.magnesium, invars.use_long_helix, bonuses.data());
-    pfunc = q[pf_index(0, n_nucs - 1, n_nucs)];
-    pfunc /= total_bonus;
   }
 
-  this->ppairs.clear();
+  // only pairs above min_ppair (or in a target structure) are read back,
+  // so the fill keeps the pair probabilities in sparse form.  Leaves and
+  // orderings of any result with the same sequence and bonuses share it.
+  auto fill = ensemble_memo().fill(key, true, invars);
+  const sparsePairPr & pp = fill->pairs;
+
+  DBL_TYPE pfunc = fill->root_q;
+  pfunc /= total_bonus;
+
+  auto ppairs = std::make_shared<PairProbs>();
   for (i_nuc = 0; i_nuc < n_nucs; ++i_nuc) {
     if (this->native[i_nuc]) {
-      std::vector<bool> saved_inds(n_nucs + 1, false);
+      std::vector<int> saved_inds;
+      bool saved_unpaired = false;
       for (auto i_str = 0; i_str < strucs.size(); ++i_str) {
         auto m_j_nuc = strucs[i_str][to_full[i_nuc]];
         if (m_j_nuc >= 0) {
           j_nuc = to_node[m_j_nuc];
-          if (j_nuc >= 0) saved_inds[j_nuc] = true; 
+          if (j_nuc >= 0) saved_inds.push_back(j_nuc); 
         } else {
-          saved_inds[n_nucs] = true;
+          saved_unpaired = true;
         }
       }
-      for (j_nuc = 0; j_nuc < n_nucs; ++j_nuc) {
-        if (this->native[j_nuc]) {
-          if (pp[i_nuc * (n_nucs + 1) + j_nuc] > invars.min_ppair 
-              || saved_inds[j_nuc]) {
-            this->ppairs.push_back(to_full[i_nuc], to_full[j_nuc], 
-                pp[i_nuc * (n_nucs + 1) + j_nuc]);
-          }
+      std::sort(saved_inds.begin(), saved_inds.end());
+
+      // merge the stored row entries with the target pairs, in column order
+      auto k = pp.rowStart[i_nuc];
+      auto k_end = pp.rowStart[i_nuc + 1] - 1; // last entry is unpaired
+      auto s_it = saved_inds.begin();
+      while (k < k_end || s_it != saved_inds.end()) {
+        j_nuc = n_nucs;
+        if (k < k_end) j_nuc = pp.col[k];
+        if (s_it != saved_inds.end()) j_nuc = std::min(j_nuc, *s_it);
+
+        DBL_TYPE ppair = 0.0;
+        if (k < k_end && pp.col[k] == j_nuc) ppair = pp.prob[k++];
+        bool saved = false;
+        while (s_it != saved_inds.end() && *s_it == j_nuc) {
+          saved = true;
+          ++s_it;
+        }
+
+        if (this->native[j_nuc] && (ppair > invars.min_ppair || saved)) {
+          ppairs->push_back(to_full[i_nuc], to_full[j_nuc], ppair);
         }
       }
-      if (pp[i_nuc * (n_nucs + 1) + n_nucs] > invars.min_ppair
-          || saved_inds[n_nucs]) {
-        this->ppairs.push_back(to_full[i_nuc], -1, 
-            pp[i_nuc * (n_nucs + 1) + j_nuc]);
+      if (pp.prob[k_end] > invars.min_ppair || saved_unpaired) {
+        ppairs->push_back(to_full[i_nuc], -1, pp.prob[k_end]);
       }
     }
   }
+  this->ppairs = ppairs;
 
   DBL_TYPE min_ppair = 1.0;
   for (auto & a : assumed) {
     auto i_nuc = to_node[a.first];
     auto j_nuc = to_node[a.second];
-    auto ppair = pp[i_nuc * (n_nucs + 1) + j_nuc];
+    auto ppair = GetSparsePairPr(&pp, i_nuc, j_nuc);
     min_ppair = std::min(min_ppair, ppair);
   }
   min_ppair = std::max<DBL_TYPE>(min_ppair, 0.0001);
@@ -289,10 +304,8 @@ void NodeResult::evaluate_leaf(const NodeSpec & spec, const SequenceState& seqs,
 
   DBL_TYPE end_time = get_current_time();
   this->eval_time = end_time - start_time;
+  eval_counts.leaves++;
 
-  //needed because global garbage 
-  EXTERN_Q = NULL;
-  pairPr = NULL;
 }
 
 void NodeResult::evaluate(const NodeSpec & spec, const SequenceState & seqs,
@@ -317,13 +330,16 @@ void NodeResult::evaluate(const NodeSpec & spec, const SequenceState & seqs,
   } else {
     this->eval_time = 0;
     for (auto i = 0; i < n_children; ++i) {
-      this->children[i].evaluate(spec.get_child(i), seqs, struc,
+      // children shared with other results are left alone when current
+      if (this->children[i].use_count() > 1 && this->children[i]->is_current(
+            spec.get_child(i), seqs, strucspec, invars)) continue;
+      mutable_child(i).evaluate(spec.get_child(i), seqs, struc,
           strucspec, params, invars);
     }
     this->pfunc_corrected = 0;
     for (auto i = 0; i < n_children; i+=2) {
-      this->pfunc_corrected += merge_pfuncs((this->children[i]),
-          (this->children[i + 1]), params, invars);
+      this->pfunc_corrected += merge_pfuncs(*this->children[i],
+          *this->children[i + 1], params, invars);
     }
   }
 
@@ -333,6 +349,61 @@ void NodeResult::evaluate(const NodeSpec & spec, const SequenceState & seqs,
   this->eval_sequence = seqs.get_sequence(nuc_ids);
 }
 
+void NodeResult::update_leaves(std::vector<int>::const_iterator first,
+    std::vector<int>::const_iterator last, int offset,
+    const NodeSpec & spec, const SequenceState & seqs,
+    const StructureResult & struc, const StructureSpec & strucspec,
+    const PhysicalParams & params, const NupackInvariants & invars) {
+  int n_children = this->children.size();
+  if (n_children == 0) {
+    if (seqs.get_sequence(this->nuc_ids) != this->eval_sequence) {
+      this->evaluate_leaf(spec, seqs, strucspec, struc, params, invars);
+    }
+    return;
+  }
+
+  for (auto i = 0; i < n_children && first != last; ++i) {
+    int end = offset + this->children[i]->get_n_leaves();
+    auto mid = std::lower_bound(first, last, end);
+    if (mid != first) {
+      mutable_child(i).update_leaves(first, mid, offset, spec.get_child(i),
+          seqs, struc, strucspec, params, invars);
+    }
+    first = mid;
+    offset = end;
+  }
+
+  this->pfunc_corrected = 0;
+  for (auto i = 0; i < n_children; i+=2) {
+    this->pfunc_corrected += merge_pfuncs(*this->children[i],
+        *this->children[i + 1], params, invars);
+  }
+  this->eval_sequence = seqs.get_sequence(this->nuc_ids);
+}
+
+bool NodeResult::is_current(const NodeSpec & spec, const SequenceState & seqs,
+    const StructureSpec & strucspec, const NupackInvariants & invars) const {
+  int n_children = this->children.size();
+  if (n_children != spec.get_n_children()) return false;
+
+  std::vector<int> nuc_ids = spec.get_nuc_ids(strucspec, invars);
+  if (nuc_ids != this->nuc_ids || seqs.get_sequence(nuc_ids) != this->eval_sequence
+      || spec.get_breaks(strucspec, invars) != this->breaks
+      || spec.get_native_map(strucspec, invars) != this->to_full) return false;
+
+  for (auto i = 0; i < n_children; ++i) {
+    if (!this->children[i]->is_current(spec.get_child(i), seqs, strucspec, invars))
+      return false;
+  }
+  return true;
+}
+
+NodeResult & NodeResult::mutable_child(int i) {
+  auto & child = this->children[i];
+  if (child.use_count() > 1) child = std::make_shared<NodeResult>(*child);
+  return *child;
+}
+
 void NodeResult::serialize(std::ostream & out, int indent, const std::string & prefix, int & id) const {
   std::string ind_str(indent, ' ');
   ind_str = prefix + ind_str;
@@ -345,7 +416,7 @@ void NodeResult::serialize(std::ostream & out, int indent, const std::string & p
   
   ++id;
   if (this->children.size() > 0) {
-    for (auto & c : children) c.serialize(out, indent, prefix, id);
+    for (auto & c : children) c->serialize(out, indent, prefix, id);
   } 
 }
 
@@ -353,22 +424,25 @@ DBL_TYPE NodeResult::collect_eval_times() const {
   if (this->children.size() == 0) return this->eval_time;
    
   DBL_TYPE ret = 0.0;
-  for (auto & c : children) ret += c.collect_eval_times();
+  for (auto & c : children) ret += c->collect_eval_times();
   return ret;
 }
 
 PairProbs NodeResult::collect_pair_probs(const PhysicalParams & params,
     const NupackInvariants & invars) const {
-  if (this->children.size() == 0) return this->ppairs;
+  if (this->children.size() == 0) {
+    if (this->ppairs) return *this->ppairs;
+    return PairProbs();
+  }
   
   PairProbs ppairs_tot;
   DBL_TYPE pfunc = 0;
   for (auto i = 0; i < this->children.size(); i += 2) {
-    DBL_TYPE cur_pfunc = merge_pfuncs((this->children[i]),
-        (this->children[i + 1]), params, invars);
+    DBL_TYPE cur_pfunc = merge_pfuncs(*this->children[i],
+        *this->children[i + 1], params, invars);
     if (cur_pfunc > 0) {
-      PairProbs ppairs1 = this->children[i].collect_pair_probs(params, invars);
-      PairProbs ppairs2 = this->children[i + 1].collect_pair_probs(params, invars);
+      PairProbs ppairs1 = this->children[i]->collect_pair_probs(params, invars);
+      PairProbs ppairs2 = this->children[i + 1]->collect_pair_probs(params, invars);
       ppairs1.merge(ppairs2, 1.0, 1.0);
       ppairs_tot.merge(ppairs1, cur_pfunc / (cur_pfunc + pfunc), pfunc / (cur_pfunc + pfunc));
       pfunc += cur_pfunc;
@@ -386,7 +460,7 @@ void NodeResult::clear() {
   this->to_full.clear();
   this->breaks.clear();
   this->nuc_defects.clear();
-  this->ppairs.clear();
+  this->ppairs.reset();
   this->pfunc_corrected = 0;
 }  
 
@@ -17,12 +17,16 @@ namespace nupack {
       * the leaf nodes are used to perform the pair probability and partition
       * function evaluations. Parental nodes recursively merge the resulting
       * leaf properties to estimate the root-node properties.
+      *
+      * Children are held through shared pointers, so copying a result (as
+      * the designer does for every offspring) shares the whole tree.  A
+      * shared child is only cloned when evaluate() finds it out of date.
       */
       
   using ChildPair = std::pair<NodeResult, NodeResult>;
   class NodeResult {
     public:
-      NodeResult() {}
+      NodeResult() : n_leaves(1) {}
 
       DBL_TYPE get_pfunc() const { return pfunc_corrected; }
 
@@ -43,10 +47,20 @@ namespace nupack {
           const StructureSpec & strucspec, const PhysicalParams & params, 
           const NupackInvariants & invars);
       void init(const NodeSpec & spec);
+
+      /* Re-evaluates the leaves numbered in [first, last) (sorted, counted
+       * from offset at this node) and the merges on their paths.  The tree
+       * must have been evaluated against the same decomposition. */
+      void update_leaves(std::vector<int>::const_iterator first,
+          std::vector<int>::const_iterator last, int offset,
+          const NodeSpec & spec, const SequenceState & seqs,
+          const StructureResult & struc, const StructureSpec & strucspec,
+          const PhysicalParams & params, const NupackInvariants & invars);
       void serialize(std::ostream & out, int indent, const std::string & prefix, int & id) const;
 
       int get_n_leaves() const;
       int get_n_children() const { return children.size(); }
+      const NodeResult & get_child(int i) const { return *children[i]; }
 
       void replace_node(const NodeResult & other, int k, 
           const PhysicalParams & params, const NupackInvariants & invars);
@@ -58,14 +72,19 @@ namespace nupack {
 
       int get_max_depth() const;
 
+      /* true if evaluating against spec and seqs would change nothing */
+      bool is_current(const NodeSpec & spec, const SequenceState & seqs,
+          const StructureSpec & strucspec, const NupackInvariants & invars) const;
+
       friend class NodeSpec;
 
     protected:
-      std::vector<NodeResult> children;
+      std::vector<std::shared_ptr<NodeResult>> children;
       std::vector<ChildPair> paired_children;
       int native_index(int i) const;
       void clear();
       void clear_children();
+      NodeResult & mutable_child(int i);
 
     private:
       void copy(const NodeResult & other);
@@ -76,7 +95,8 @@ namespace nupack {
       std::vector<bool> native;
       std::vector<DBL_TYPE> nuc_defects;
 
-      PairProbs ppairs;
+      std::shared_ptr<const PairProbs> ppairs;
+      int n_leaves;
       DBL_TYPE pfunc_corrected;
       DBL_TYPE eval_time;
   };
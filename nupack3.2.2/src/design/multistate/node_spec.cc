@@ -8,6 +8,7 @@
 #include "structure_utils.h"
 #include "pathway_utils.h"
 #include "design_debug.h"
+#include "checkpoint.h"
 
 #include <iostream>
 #include <algorithm>
@@ -31,6 +32,26 @@ NodeSpec NodeSpec::get_depth(int depth) const {
   return rval;
 }
 
+void NodeSpec::save(std::ostream & out) const {
+  Checkpoint::write(out, lims);
+  Checkpoint::write(out, assume);
+  Checkpoint::write(out, (int) children.size());
+  for (const auto & c : children) c.save(out);
+}
+
+NodeSpec NodeSpec::load(std::istream & in) {
+  std::vector<Limits> lims;
+  std::vector<Assume> assume;
+  int n_children = 0;
+  Checkpoint::read(in, lims);
+  Checkpoint::read(in, assume);
+  Checkpoint::read(in, n_children);
+
+  NodeSpec rval(lims, assume);
+  for (auto i = 0; i < n_children; i++) rval.children.push_back(load(in));
+  return rval;
+}
+
 void NodeSpec::print_leaves() const {
   if (children.empty()) {
     print_node_decomp();
@@ -76,11 +97,11 @@ void NodeSpec::decompose_ppair_at(int k,
         to_string(get_n_children()));
     int n_c = res.get_n_children();
     for (auto i_c = 0; i_c < n_c; i_c++) {
-      auto cur_n_leaves = res.children[i_c].get_n_leaves();
+      auto cur_n_leaves = res.get_child(i_c).get_n_leaves();
       if (c_k >= cur_n_leaves) {
         c_k -= cur_n_leaves;
       } else {
-        children[i_c].decompose_ppair_at(c_k, res.children[i_c],
+        children[i_c].decompose_ppair_at(c_k, res.get_child(i_c),
             seqs, strucspec, strucres, params, invars);
         break;
       }
@@ -94,7 +115,6 @@ void NodeSpec::decompose_ppair(const NodeResult & res, const SequenceState & seq
   forbid_children(strucspec, res, params, invars);
 
   auto strucs = get_structures(strucspec, invars);
-  auto splits = StructureUtils::get_consistent_splits(strucs, invars);
   auto to_full = get_native_map(strucspec, invars);
   auto to_node = get_to_node(strucspec, invars, to_full);
 
@@ -103,7 +123,7 @@ void NodeSpec::decompose_ppair(const NodeResult & res, const SequenceState & seq
   raw_ppairs.clear_forbidden(strucspec);
   PairProbs mapped_probs(raw_ppairs, to_node);
 
-  auto minsplit = StructureUtils::get_minimal_splits(strucspec, splits, 
+  auto minsplit = StructureUtils::get_minimal_splits(strucspec, strucs, 
       mapped_probs, to_full.size(), invars);
 
   SplitSet native_minsplit(minsplit, to_full);
@@ -121,7 +141,6 @@ void NodeSpec::decompose(const StructureSpec & strucspec, const NupackInvariants
   clear_children();
 
   auto strucs = get_structures(strucspec, invars);
-  auto splits = StructureUtils::get_consistent_splits(strucs, invars);
   auto to_full = get_native_map(strucspec, invars);
   auto to_node = get_to_node(strucspec, invars, to_full);
 
@@ -143,7 +162,7 @@ void NodeSpec::decompose(const StructureSpec & strucspec, const NupackInvariants
   raw_ppairs.clear_forbidden(strucspec);
   PairProbs mapped_probs(raw_ppairs, to_node);
 
-  auto minsplit = StructureUtils::get_minimal_splits(strucspec, splits, 
+  auto minsplit = StructureUtils::get_minimal_splits(strucspec, strucs, 
       mapped_probs, to_full.size(), invars);
 
   SplitSet native_minsplit(minsplit, to_full);
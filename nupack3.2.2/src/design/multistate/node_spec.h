@@ -63,6 +63,10 @@ namespace nupack {
       void print_leaves() const;
       void print_decomposition() const;
 
+      // binary copy of the node and its descendants, see checkpoint.h
+      void save(std::ostream & out) const;
+      static NodeSpec load(std::istream & in);
+
     protected:
       std::vector<NodeSpec> & get_children() { return children; }
       void print_node_decomp(std::ostream & out=std::cerr) const;
@@ -3,6 +3,7 @@
 #include "physical_spec.h"
 
 #include <sys/time.h>
+#include <sys/stat.h>
 
 namespace nupack {
 NupackInvariants::NupackInvariants() {
@@ -28,13 +29,23 @@ void NupackInvariants::deduce_h_split() {
 }
 
 
-bool NupackInvariants::opt_time_elapsed() const {
+DBL_TYPE NupackInvariants::opt_time() const {
   timeval curtimestruct;
   gettimeofday(&curtimestruct, NULL);
 
   DBL_TYPE curtime = curtimestruct.tv_sec + 1e-6 * curtimestruct.tv_usec;
 
-  return (curtime - this->start_time > this->allowed_opt_time);
+  return curtime - this->start_time;
+}
+
+bool NupackInvariants::opt_time_elapsed() const {
+  return (this->opt_time() > this->allowed_opt_time);
+}
+
+bool NupackInvariants::stop_requested() const {
+  if (this->stop_file.empty()) return false;
+  struct stat st;
+  return stat(this->stop_file.c_str(), &st) == 0;
 }
 
 std::string NupackInvariants::mat_str() const {
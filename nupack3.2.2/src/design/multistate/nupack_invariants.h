@@ -55,6 +55,10 @@ namespace nupack {
       std::string file_prefix {""};
       DBL_TYPE elapsed_time {0};
       DBL_TYPE allowed_opt_time {86000000};
+      DBL_TYPE checkpoint_interval {-1};                                // seconds between checkpoints, -1 == never
+      bool resume {false};                                              // continue from the checkpoint file
+      std::string telemetry_file {""};                                  // JSON-lines progress stream, empty == none
+      std::string stop_file {""};                                       // optimization ends once this file exists
 
       std::string material_string;
       std::string start_timestamp;
@@ -68,7 +72,10 @@ namespace nupack {
       std::string dangle_str() const;
       void serialize(std::ostream & out, int indent = 0, std::string prefix = "") const;
 
+      DBL_TYPE opt_time() const;
       bool opt_time_elapsed() const;
+      bool stop_requested() const;
+      bool should_stop() const { return opt_time_elapsed() || stop_requested(); }
 #ifdef JSONCPP_FOUND
       Json::Value make_json_value() const;
 #endif
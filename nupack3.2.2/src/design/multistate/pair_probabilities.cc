@@ -165,6 +165,44 @@ std::vector<DBL_TYPE> PairProbs::get_nuc_defects(const PairProbs & target) const
 }
 
 
+PairProbIndex::PairProbIndex(const PairProbs & ppairs, int n) : n(n),
+    row_start(n + 1, 0) {
+  const auto & probs = ppairs.get_probs();
+  for (auto & p : probs) {
+    NUPACK_DEBUG_CHECK(p.i >= 0 && p.i < n && p.j < n,
+        "Invalid indices: (" + to_string(p.i) + ", " + to_string(p.j) 
+        + ") out of seq length: " + to_string(n));
+    row_start[p.i + 1]++;
+  }
+  for (auto i = 0; i < n; i++) row_start[i + 1] += row_start[i];
+
+  entries.resize(probs.size());
+  std::vector<int> fill(row_start.begin(), row_start.end() - 1);
+  for (auto & p : probs) {
+    entries[fill[p.i]++] = std::make_pair((p.j < 0) ? n : p.j, p.prob);
+  }
+
+  using el = decltype(entries)::value_type;
+  for (auto i = 0; i < n; i++) {
+    std::stable_sort(entries.begin() + row_start[i], 
+        entries.begin() + row_start[i + 1], [](const el & a, const el & b) {
+          return a.first < b.first;
+        });
+  }
+}
+
+DBL_TYPE PairProbIndex::get(int i, int j) const {
+  using el = decltype(entries)::value_type;
+  if (j < 0) j = n;
+  auto first = entries.begin() + row_start[i];
+  auto last = entries.begin() + row_start[i + 1];
+  auto it = std::upper_bound(first, last, j, [](int j, const el & e) {
+    return j < e.first;
+  });
+  if (it == first || (it - 1)->first != j) return 0;
+  return (it - 1)->second;
+}
+
 void PairProbs::serialize(std::ostream & out, int n) const {
   for (auto & p : probs) {
     int j = (p.j == -1) ? n : p.j;
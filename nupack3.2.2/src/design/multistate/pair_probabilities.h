@@ -64,8 +64,29 @@ namespace nupack {
       void serialize(std::ostream & out, int n) const;
       
       void clear_forbidden(const StructureSpec & spec);
+
+      const std::vector<PairProbTriple> & get_probs() const { return probs; }
       
     private:
       mutable std::vector<PairProbTriple> probs;
   };
+
+  /**
+   * Row index over the entries of a PairProbs, so single probabilities
+   * can be looked up without building the dense (n + 1) x n matrix.
+   * Entries missing from the list read as 0 and, as in get_mat, the last
+   * of repeated entries wins.
+   */
+  class PairProbIndex {
+    public:
+      PairProbIndex(const PairProbs & ppairs, int n);
+
+      // j == -1 for the unpaired probability
+      DBL_TYPE get(int i, int j) const;
+
+    private:
+      int n;
+      std::vector<int> row_start;
+      std::vector<std::pair<int, DBL_TYPE> > entries;
+  };
 }
@@ -13,7 +13,8 @@
 #include "sequence_utils.h"
 
 #include "design_debug.h"
-#include "utils.h"
+#include "constants.h"
+#include "thermo/concentrations/equilibrium_utils.h"
 #include "algorithms.h"
 #include "types.h"
 
@@ -108,6 +108,14 @@ void SingleParamResult::evaluate(const SequenceState & seqs,
   int n_orders = orders.size();
   int n_tubes = tubes.size();
 
+  if (this->deps && this->deps->matches(spec) &&
+      this->nucleotides.size() == seqs.get_nucleotides().size() &&
+      this->strucs.size() == n_strucs && this->orders.size() == n_orders &&
+      this->tubes.size() == n_tubes) {
+    evaluate_changed(seqs, spec, invars);
+    return;
+  }
+
   this->params = spec.get_params();
   this->strucs.resize(n_strucs);
   this->orders.resize(n_orders);
@@ -130,6 +138,78 @@ void SingleParamResult::evaluate(const SequenceState & seqs,
     this->tubes[i_tube].evaluate(this->strucs, this->orders,
         order_to_struc, tubes[i_tube], spec.get_params(), invars);
   }
+
+  this->nucleotides = seqs.get_nucleotides();
+  if (!this->deps || !this->deps->matches(spec)) {
+    this->deps = std::make_shared<DependencyIndex>(spec, seqs, invars);
+  }
+}
+
+void SingleParamResult::evaluate_changed(const SequenceState & seqs,
+    const SingleParamSpec & spec, const NupackInvariants & invars) {
+  const auto & strucs = spec.get_strucs();
+  const auto & tubes = spec.get_tubes();
+  const auto & orders = spec.get_orders();
+  const auto & order_to_struc = spec.get_ord_struc_map();
+  const auto & nucs = seqs.get_nucleotides();
+
+  int n_strucs = strucs.size();
+  int n_orders = orders.size();
+  int n_tubes = tubes.size();
+  
+  std::vector<std::vector<int> > struc_leaves(n_strucs);
+  std::vector<bool> struc_changed(n_strucs, false);
+  std::vector<bool> order_changed(n_orders, false);
+
+  for (auto i_nuc = 0; i_nuc < nucs.size(); i_nuc++) {
+    if (nucs[i_nuc] == this->nucleotides[i_nuc]) continue;
+    for (auto & leaf : this->deps->get_leaves(i_nuc)) {
+      if (leaf.second < 0) {
+        struc_changed[leaf.first] = true;
+      } else {
+        struc_leaves[leaf.first].push_back(leaf.second);
+      }
+    }
+    for (auto i_ord : this->deps->get_orders(i_nuc)) order_changed[i_ord] = true;
+  }
+  this->nucleotides = nucs;
+
+  for (auto i_struc = 0; i_struc < n_strucs; i_struc++) {
+    auto & leaves = struc_leaves[i_struc];
+    auto & struc = this->strucs[i_struc];
+    if (struc_changed[i_struc] || !struc.is_evaluated(strucs[i_struc])) {
+      struc.evaluate(seqs, strucs[i_struc], spec.get_params(), invars);
+      struc_changed[i_struc] = true;
+    } else if (!leaves.empty()) {
+      std::sort(leaves.begin(), leaves.end());
+      leaves.erase(std::unique(leaves.begin(), leaves.end()), leaves.end());
+      struc.update_leaves(leaves, seqs, strucs[i_struc], spec.get_params(), invars);
+      struc_changed[i_struc] = true;
+    }
+  }
+
+  bool eval_off_targets = spec.eval_off_targets();
+  for (auto i_ord = 0; i_ord < n_orders; i_ord++) {
+    if (eval_off_targets && -1 == order_to_struc[i_ord]) {
+      if (order_changed[i_ord] || !this->orders[i_ord].get_evaluated()) {
+        this->orders[i_ord].evaluate(seqs, orders[i_ord], spec.get_params(), invars);
+        order_changed[i_ord] = true;
+      }
+    } else {
+      order_changed[i_ord] = order_to_struc[i_ord] >= 0 && 
+        struc_changed[order_to_struc[i_ord]];
+    }
+  }
+
+  for (auto i_tube = 0; i_tube < n_tubes; i_tube++) {
+    const auto & comps = tubes[i_tube].get_complexes();
+    bool changed = std::any_of(comps.begin(), comps.end(), 
+        [&order_changed](const TubeComplex & c) { return order_changed[c.order_ind]; });
+    if (changed) {
+      this->tubes[i_tube].evaluate(this->strucs, this->orders,
+          order_to_struc, tubes[i_tube], spec.get_params(), invars);
+    }
+  }
 }
 
 int SingleParamResult::get_max_depth() const {
@@ -4,6 +4,7 @@
 #include "structure_result.h"
 #include "complex_result.h"
 #include "tube_result.h"
+#include "dependency_index.h"
 
 #include "physical_spec.h"
 #include "pair_probabilities.h"
@@ -12,6 +13,7 @@
 
 #include <vector>
 #include <string>
+#include <memory>
 
 namespace nupack {
   
@@ -61,7 +63,15 @@ namespace nupack {
       std::vector<TubeResult> tubes;
 
     private:
+      void evaluate_changed(const SequenceState & seqs,
+          const SingleParamSpec & spec, const NupackInvariants & invars);
+
       PhysicalParams params;
+      // the nucleotides of the last evaluation and which evaluations read
+      // them, so that the next one only redoes what a mutation touched
+      std::vector<int> nucleotides;
+      std::shared_ptr<const DependencyIndex> deps;
+
       std::vector<DBL_TYPE> order_pfuncs;
       std::vector<bool> order_included;
 
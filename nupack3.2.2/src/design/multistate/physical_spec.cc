@@ -5,7 +5,9 @@
 
 #include "physical_result.h"
 #include "design_debug.h"
-#include "utils.h"
+#include "checkpoint.h"
+#include "constants.h"
+#include "thermo/concentrations/equilibrium_utils.h"
 #include "algorithms.h"
 
 #include <json/json.h>
@@ -165,6 +167,27 @@ void SingleParamSpec::add_off_target(int i_ord, const SequenceSpec & seqs) {
   this->ord_struc_map[i_ord] = this->strucs.size() - 1;
 }
 
+void SingleParamSpec::save_state(std::ostream & out) const {
+  Checkpoint::write(out, this->struc_ord_map);
+  for (auto & s : this->strucs) s.save_decomposition(out);
+}
+
+void SingleParamSpec::load_state(std::istream & in, const SequenceSpec & seqs) {
+  std::vector<int> saved_ord_map;
+  Checkpoint::read(in, saved_ord_map);
+  NUPACK_CHECK(saved_ord_map.size() >= this->strucs.size(),
+      "Checkpoint does not match the design specification");
+  for (auto i = 0; i < saved_ord_map.size(); i++) {
+    if (i < this->struc_ord_map.size()) {
+      NUPACK_CHECK(saved_ord_map[i] == this->struc_ord_map[i],
+          "Checkpoint does not match the design specification");
+    } else {
+      add_off_target(saved_ord_map[i], seqs);
+    }
+  }
+  for (auto & s : this->strucs) s.load_decomposition(in);
+}
+
 int PhysicalSpec::get_max_depth() const {
   using spec = typename decltype(specifications)::value_type;
   return std::max_element(specifications.begin(), specifications.end(), 
@@ -193,6 +216,19 @@ void PhysicalSpec::decompose_ppair(int s, int i, int k, const PhysicalResult & r
   specifications[s].decompose_ppair(i, k, res.results[s], seqs, invars);
 }
 
+void PhysicalSpec::save_state(std::ostream & out) const {
+  Checkpoint::write(out, (int) specifications.size());
+  for (auto & s : specifications) s.save_state(out);
+}
+
+void PhysicalSpec::load_state(std::istream & in, const SequenceSpec & seqs) {
+  int n_specs = 0;
+  Checkpoint::read(in, n_specs);
+  NUPACK_CHECK(n_specs == specifications.size(),
+      "Checkpoint does not match the design specification");
+  for (auto & s : specifications) s.load_state(in, seqs);
+}
+
 #ifdef JSONCPP_FOUND
 Json::Value PhysicalSpec::make_json_structures(const SequenceSpec & seqs,
     const NupackInvariants & invars) const {
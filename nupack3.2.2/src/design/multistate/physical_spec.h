@@ -65,6 +65,10 @@ namespace nupack {
           const SequenceState & seqs, const NupackInvariants & invars);
       void add_off_target(int i, const SequenceSpec & seqs);
 
+      // the off-targets added and the decompositions, see checkpoint.h
+      void save_state(std::ostream & out) const;
+      void load_state(std::istream & in, const SequenceSpec & seqs);
+
       SingleParamSpec get_depth(int depth, bool off_targets=false) const;
       bool eval_off_targets() const { return this->off_targets; }
 
@@ -104,6 +108,9 @@ namespace nupack {
       PhysicalSpec get_depth(int depth, bool off_targets=false) const;
       int get_max_depth() const;
 
+      void save_state(std::ostream & out) const;
+      void load_state(std::istream & in, const SequenceSpec & seqs);
+
 #ifdef JSONCPP_FOUND
       Json::Value make_json_structures(const SequenceSpec & seqs,
           const NupackInvariants & invars) const;
@@ -54,6 +54,7 @@ namespace nupack {
       const std::vector<SingleSequenceState> & get_strands() const { return this->strands; }
 
       std::vector<int> get_sequence(const std::vector<int> & nuc_ids) const;
+      const std::vector<int> & get_nucleotides() const { return this->nucleotides; }
 
       int n_nucs() const;
 
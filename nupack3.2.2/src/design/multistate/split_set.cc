@@ -3,6 +3,8 @@
 #include "nupack_invariants.h"
 #include "design_debug.h"
 
+#include <algorithm>
+
 namespace nupack {
 bool SplitSet::allowed(int i, int j, int n, const NupackInvariants & invars) {
   bool allow = true;
@@ -60,7 +62,7 @@ void SplitSet::push_back(int i, int j, DBL_TYPE prob) {
   }
 }
 
-DBL_TYPE SplitSet::get_cost(int n) {
+DBL_TYPE SplitSet::get_cost(int n) const {
   DBL_TYPE cost = 0;
   for (auto & point : points) {
     auto l1 = n - point.right + point.left - 1;
@@ -71,15 +73,150 @@ DBL_TYPE SplitSet::get_cost(int n) {
 }
 
 bool SplitSet::crosses_all(int i, int j) const {
-  if (i > j) std::swap(i, j);
   for (auto & point : points) {
-    auto d = point.left;
-    auto e = point.right;
-    if (d > e) std::swap(d, e);
-    if (d == i && e == j) return false; // redundant
-    if ((d > i && d < j) && (e > i && e < j)) return false; // inside
-    if ((d < i || d > j) && (e < i || e > j)) return false; // outside
+    if (!crosses(i, j, point.left, point.right)) return false;
   }
   return true;
 }
+
+bool SplitSet::crosses(int i, int j, int d, int e) {
+  if (i > j) std::swap(i, j);
+  if (d > e) std::swap(d, e);
+  if (d == i && e == j) return false; // redundant
+  if ((d > i && d < j) && (e > i && e < j)) return false; // inside
+  if ((d < i || d > j) && (e < i || e > j)) return false; // outside
+  return true;
+}
+
+ConsistentSplits::ConsistentSplits(const std::vector<vec_structure> & strucs,
+    const NupackInvariants & invars) : cands(strucs.size()), 
+    costs(strucs.size()), weights(strucs.size()), 
+    min_cost_before(strucs.size(), 0), max_weight_before(strucs.size(), 0),
+    crossing(strucs.size()) {
+  int n_strucs = strucs.size();
+  for (auto s = 0; s < n_strucs; s++) {
+    const auto & struc = strucs[s];
+    int n = struc.size();
+    DBL_TYPE min_cost = DBL_MAX;
+    for (auto i_nuc = 0; i_nuc < n; i_nuc++) {
+      auto j_nuc = struc[i_nuc];
+      if (j_nuc > i_nuc && SplitSet::allowed(i_nuc, j_nuc, n, invars)) {
+        SplitSet single;
+        single.push_back(i_nuc, j_nuc, 0);
+        cands[s].emplace_back(i_nuc, j_nuc);
+        costs[s].push_back(single.get_cost(n));
+        min_cost = std::min(min_cost, costs[s].back());
+      }
+    }
+    weights[s].assign(cands[s].size(), 0);
+    if (s + 1 < n_strucs) {
+      min_cost_before[s + 1] = min_cost_before[s] + 
+        (cands[s].empty() ? 0 : min_cost);
+    }
+  }
+
+  for (auto s = 0; s < n_strucs; s++) {
+    crossing[s].resize(cands[s].size());
+    for (auto c = 0; c < cands[s].size(); c++) {
+      auto & rows = crossing[s][c];
+      rows.resize(s);
+      for (auto t = 0; t < s; t++) {
+        rows[t].assign((cands[t].size() + 63) / 64, 0);
+        for (auto k = 0; k < cands[t].size(); k++) {
+          if (SplitSet::crosses(cands[t][k].left, cands[t][k].right, 
+                cands[s][c].left, cands[s][c].right)) {
+            rows[t][k / 64] |= uint64_t(1) << (k % 64);
+          }
+        }
+      }
+    }
+  }
+}
+
+void ConsistentSplits::set_weights(
+    const std::function<DBL_TYPE(int, int)> & weight) {
+  int n_strucs = cands.size();
+  for (auto s = 0; s < n_strucs; s++) {
+    DBL_TYPE max_weight = 0;
+    for (auto c = 0; c < cands[s].size(); c++) {
+      weights[s][c] = weight(cands[s][c].left, cands[s][c].right);
+      max_weight = std::max(max_weight, weights[s][c]);
+    }
+    if (s + 1 < n_strucs) {
+      max_weight_before[s + 1] = max_weight_before[s] + max_weight;
+    }
+  }
+}
+
+void ConsistentSplits::visit(const std::function<DBL_TYPE()> & max_cost,
+    DBL_TYPE min_weight, 
+    const std::function<void(const SplitSet &)> & fn) const {
+  int n_strucs = cands.size();
+  if (n_strucs == 0) {
+    fn(SplitSet());
+    return;
+  }
+
+  // masks[s][t], t <= s: the pairs of t still allowed when s is chosen
+  std::vector<std::vector<bits> > masks(n_strucs);
+  for (auto s = 0; s < n_strucs; s++) {
+    masks[s].resize(s + 1);
+    for (auto t = 0; t <= s; t++) {
+      masks[s][t].assign((cands[t].size() + 63) / 64, 0);
+    }
+  }
+  auto & all = masks[n_strucs - 1];
+  for (auto t = 0; t < n_strucs; t++) {
+    for (auto k = 0; k < cands[t].size(); k++) {
+      all[t][k / 64] |= uint64_t(1) << (k % 64);
+    }
+  }
+
+  std::vector<int> chosen(n_strucs, -1);
+  visit_struc(n_strucs - 1, 0, 0, chosen, masks, max_cost, min_weight, fn);
+}
+
+void ConsistentSplits::visit_struc(int s, DBL_TYPE cost, DBL_TYPE weight,
+    std::vector<int> & chosen, std::vector<std::vector<bits> > & masks,
+    const std::function<DBL_TYPE()> & max_cost, DBL_TYPE min_weight,
+    const std::function<void(const SplitSet &)> & fn) const {
+  // the weights are probabilities summed in another order by the caller
+  const DBL_TYPE weight_tol = 1e-9;
+  const auto & mask = masks[s][s];
+  for (auto w = 0; w < mask.size(); w++) {
+    for (auto word = mask[w]; word; word &= word - 1) {
+      int c = w * 64 + __builtin_ctzll(word);
+      // costs are sums of integer cubes, so exact in any order
+      if (cost + costs[s][c] + min_cost_before[s] >= max_cost()) continue;
+      if (weight + weights[s][c] + max_weight_before[s] + weight_tol 
+          <= min_weight) continue;
+
+      chosen[s] = c;
+      if (s == 0) {
+        SplitSet set;
+        for (auto t = 0; t < chosen.size(); t++) {
+          set.push_back(cands[t][chosen[t]].left, cands[t][chosen[t]].right, 0);
+        }
+        fn(set);
+        continue;
+      }
+
+      bool empty = false;
+      for (auto t = 0; t < s; t++) {
+        auto & next = masks[s - 1][t];
+        const auto & rows = crossing[s][c][t];
+        uint64_t any = 0;
+        for (auto k = 0; k < next.size(); k++) {
+          next[k] = masks[s][t][k] & rows[k];
+          any |= next[k];
+        }
+        if (!any) empty = true;
+      }
+      if (empty) continue;
+
+      visit_struc(s - 1, cost + costs[s][c], weight + weights[s][c], chosen, 
+          masks, max_cost, min_weight, fn);
+    }
+  }
+}
 }
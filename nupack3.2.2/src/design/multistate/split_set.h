@@ -1,10 +1,14 @@
 #pragma once
 
+#include "types.h"
+
 #include <thermo.h>
 
 #include <iostream>
 #include <vector>
 #include <utility>
+#include <functional>
+#include <cstdint>
 
 namespace nupack {
   class NupackInvariants;
@@ -24,6 +28,7 @@ namespace nupack {
 
       void push_back(int i, int j, DBL_TYPE prob);
       bool crosses_all(int i, int j) const;
+      static bool crosses(int i, int j, int d, int e);
 
       void add_prob(DBL_TYPE prob) { this->prob += prob; }
       void set_prob(DBL_TYPE prob) { this->prob = prob; }
@@ -31,7 +36,7 @@ namespace nupack {
 
       const std::vector<Split> & get_points() const { return this->points; }
 
-      DBL_TYPE get_cost(int n);
+      DBL_TYPE get_cost(int n) const;
 
       static bool allowed(int i, int j, int n, const NupackInvariants & invars);
 
@@ -43,4 +48,45 @@ namespace nupack {
       std::vector<Split> points;
       DBL_TYPE prob {0};
   };
+
+  /**
+   * Enumerates the split sets made of one base pair of each structure, all
+   * crossing each other, in the order get_consistent_splits lists them.
+   * The pairs are chosen structure by structure, the last structure first,
+   * and the pairs of the remaining structures that still cross every chosen
+   * one are kept as bitsets, so a partial choice is dropped as soon as a
+   * structure has no pair left or no completion can beat the bounds.
+   */
+  class ConsistentSplits {
+    public:
+      ConsistentSplits(const std::vector<vec_structure> & strucs,
+          const NupackInvariants & invars);
+
+      // weight of every candidate pair, used to skip in visit the sets whose
+      // summed weight cannot exceed min_weight
+      void set_weights(const std::function<DBL_TYPE(int, int)> & weight);
+
+      // calls fn on each set whose cost is below max_cost(), which is read
+      // again before every choice
+      void visit(const std::function<DBL_TYPE()> & max_cost, 
+          DBL_TYPE min_weight, 
+          const std::function<void(const SplitSet &)> & fn) const;
+
+    private:
+      using bits = std::vector<uint64_t>;
+
+      void visit_struc(int s, DBL_TYPE cost, DBL_TYPE weight, 
+          std::vector<int> & chosen, std::vector<std::vector<bits> > & masks,
+          const std::function<DBL_TYPE()> & max_cost, DBL_TYPE min_weight,
+          const std::function<void(const SplitSet &)> & fn) const;
+
+      std::vector<std::vector<Split> > cands;
+      std::vector<std::vector<DBL_TYPE> > costs;
+      std::vector<std::vector<DBL_TYPE> > weights;
+      // bounds over the structures before s
+      std::vector<DBL_TYPE> min_cost_before;
+      std::vector<DBL_TYPE> max_weight_before;
+      // crossing[s][t][c], t < s: the pairs of t crossing pair c of s
+      std::vector<std::vector<std::vector<bits> > > crossing;
+  };
 }
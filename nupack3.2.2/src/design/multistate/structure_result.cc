@@ -112,7 +112,7 @@ void StructureResult::print_strucfiles(const StructureSpec & spec,
       ppair_file << std::endl;
       ppair_file << this->size() << std::endl;
       
-      this->ppairs.serialize(ppair_file, this->size());
+      this->ppairs->serialize(ppair_file, this->size());
       ppair_file.close();
     }
 
@@ -179,15 +179,12 @@ void StructureResult::print_strucfiles(const StructureSpec & spec,
   }
 }
 
-void StructureResult::evaluate(const SequenceState & seqs, 
-    const StructureSpec & spec,
-    const PhysicalParams & params, const NupackInvariants & invars) {
-  
+void StructureResult::set_sequence(const SequenceState & seqs,
+    const StructureSpec & spec, std::vector<int> & fullseq,
+    std::vector<int> & nuc_ids, std::vector<int> & breaks) const {
   const auto & strands = seqs.get_strands();
   const auto & strand_ids = spec.get_strands();
 
-  std::vector<int> fullseq;
-  this->breaks.clear();
   for (auto c_str : strand_ids) {
     NUPACK_CHECK(c_str >= 0 && c_str < strands.size(), "Invalid strand id " + to_string(c_str) + ", negative or greater than " + to_string(strands.size()));
     
@@ -195,35 +192,68 @@ void StructureResult::evaluate(const SequenceState & seqs,
     const auto & cur_nuc_ids = strands[c_str].get_nuc_ids();
     append(fullseq, curseq);
     append(nuc_ids, cur_nuc_ids);
-    this->breaks.push_back(fullseq.size());
+    breaks.push_back(fullseq.size());
   }
-  this->breaks.pop_back();
+  breaks.pop_back();
 
   int n_nucs = spec.size();
   NUPACK_CHECK(fullseq.size() == n_nucs, "structure and sequence lengths don't agree. " + to_string(fullseq.size()) + " != " + to_string(n_nucs));
+}
+
+void StructureResult::evaluate(const SequenceState & seqs, 
+    const StructureSpec & spec,
+    const PhysicalParams & params, const NupackInvariants & invars) {
+  std::vector<int> fullseq;
+  std::vector<int> nuc_ids;
+  std::vector<int> breaks;
+  set_sequence(seqs, spec, fullseq, nuc_ids, breaks);
+
+  // A copy of an evaluated result whose sequence and tree did not change
+  // is already up to date
+  if (this->ppairs && fullseq == this->sequence && breaks == this->breaks &&
+      this->tree.is_current(spec.get_tree(), seqs, spec, invars)) {
+    this->revision = spec.get_revision();
+    return;
+  }
 
-  // Compare old and new sequences. Mark any changed nodes
-  // If the sequence length changed, mark all nodes as changed
+  this->nuc_ids = nuc_ids;
+  this->breaks = breaks;
   this->sequence = fullseq;
   this->f_sequence = fullseq;
   this->structures = spec.get_structures();
-  this->target = spec.get_target();
+  this->target = std::make_shared<PairProbs>(spec.get_target());
   this->strands = spec.get_strands();
   this->domain_map = spec.get_domain_map();
   this->strand_map = spec.get_strand_map();
   this->struc_ids = spec.get_struc_ids();
   this->symmetry = spec.get_symmetry();
 
-  this->pfunc = 0;
-  this->ppairs.clear();
-  this->eval_time = 0;
-  this->nuc_defects.clear();
-
-  // if (nullptr == &this->tree) this->tree = NodeResult();
   this->tree.evaluate(spec.get_tree(), seqs, *this, spec, params, invars);
+  this->revision = spec.get_revision();
+  this->collect(params, invars);
+}
+
+void StructureResult::update_leaves(const std::vector<int> & leaves,
+    const SequenceState & seqs, const StructureSpec & spec,
+    const PhysicalParams & params, const NupackInvariants & invars) {
+  NUPACK_CHECK(is_evaluated(spec), "Updating leaves of a stale structure");
+
+  std::vector<int> fullseq;
+  std::vector<int> nuc_ids;
+  std::vector<int> breaks;
+  set_sequence(seqs, spec, fullseq, nuc_ids, breaks);
+  this->sequence = fullseq;
+  this->f_sequence = fullseq;
+
+  this->tree.update_leaves(leaves.begin(), leaves.end(), 0, spec.get_tree(),
+      seqs, *this, spec, params, invars);
+  this->collect(params, invars);
+}
 
+void StructureResult::collect(const PhysicalParams & params,
+    const NupackInvariants & invars) {
   this->pfunc = this->get_pfunc(params);
-  this->ppairs = this->tree.collect_pair_probs(params, invars);
+  this->ppairs = std::make_shared<PairProbs>(this->tree.collect_pair_probs(params, invars));
   this->eval_time = this->tree.collect_eval_times();
   this->update_defects();
 
@@ -236,7 +266,7 @@ void StructureResult::evaluate(const SequenceState & seqs,
 const Map & StructureResult::get_nuc_defects(int i_target) const {
   NUPACK_DEBUG_CHECK(i_target < this->nuc_defects.size(),
       "Invalid target specified in StructureResult::get_nuc_defects");
-  return this->nuc_defects[i_target];
+  return (*this->nuc_defects)[i_target];
 }
 
 DBL_TYPE StructureResult::get_normalized_defect(int i_target) const {
@@ -285,14 +315,14 @@ DBL_TYPE StructureResult::get_energy(const std::vector<int> & struc,
 
 void StructureResult::update_defects() {
   this->pos_defects.resize(this->structures.size());
-  this->nuc_defects.resize(this->structures.size());
+  auto nuc_defects = std::make_shared<std::vector<Map>>(this->structures.size());
   this->defects.resize(this->structures.size());
 
   for (auto i_tar = 0; i_tar < this->structures.size(); i_tar++) {
     auto struc_id = this->struc_ids[i_tar];
 
     this->defects[i_tar] = 0;
-    this->pos_defects[i_tar] = this->ppairs.get_nuc_defects(target);
+    this->pos_defects[i_tar] = this->ppairs->get_nuc_defects(*this->target);
 
     int n_nucs = this->structures[0].size();
     for (auto i_nuc = 0; i_nuc < n_nucs; i_nuc++) {
@@ -300,16 +330,18 @@ void StructureResult::update_defects() {
 
       // this->nuc_defects[i_tar][ind] = 0;
       this->defects[i_tar] += this->pos_defects[i_tar][i_nuc];
-      this->nuc_defects[i_tar][ind] = this->pos_defects[i_tar][i_nuc];
+      (*nuc_defects)[i_tar][ind] = this->pos_defects[i_tar][i_nuc];
     }
   }
+  this->nuc_defects = nuc_defects;
 }
 
 void StructureResult::replace_node(const StructureResult & other, int k,
     const PhysicalParams & params, const NupackInvariants & invars) {
   this->tree.replace_node(other.tree, k, params, invars);
+  this->revision = 0; // the tree now mixes decompositions
   this->pfunc = this->get_pfunc(params);
-  this->ppairs = this->tree.collect_pair_probs(params, invars);
+  this->ppairs = std::make_shared<PairProbs>(this->tree.collect_pair_probs(params, invars));
   this->update_defects();
 }
 }
@@ -14,16 +14,29 @@ namespace nupack {
   class NodeResult;
     /**
       * This class holds the evaluation results for a single complex that
-      * may have a decomposition tree.
+      * may have a decomposition tree.  The pair probabilities and defect
+      * maps are immutable once built and shared between copies.
       */
   class StructureResult {
     public:
-      StructureResult() : defect(DBL_MAX) {}
+      StructureResult() : revision(0), defect(DBL_MAX) {}
 
       void evaluate(const SequenceState & seqs, 
           const StructureSpec & spec,
           const PhysicalParams & params, const NupackInvariants & invars);
 
+      /* Re-evaluates only the given leaves (sorted, numbered as in the
+       * decomposition tree) after a change of sequence.  Only valid while
+       * is_evaluated(spec) holds. */
+      void update_leaves(const std::vector<int> & leaves,
+          const SequenceState & seqs, const StructureSpec & spec,
+          const PhysicalParams & params, const NupackInvariants & invars);
+
+      /* true if the last evaluation used this revision of spec */
+      bool is_evaluated(const StructureSpec & spec) const { 
+        return this->revision != 0 && this->revision == spec.get_revision();
+      }
+
       int get_n_leaves() const { return this->tree.get_n_leaves(); }
       const Map & get_nuc_defects(int i_target) const;
 
@@ -67,6 +80,12 @@ namespace nupack {
 
     private:
       void copy(const StructureResult & other);
+      void set_sequence(const SequenceState & seqs, const StructureSpec & spec,
+          std::vector<int> & sequence, std::vector<int> & nuc_ids,
+          std::vector<int> & breaks) const;
+      void collect(const PhysicalParams & params, const NupackInvariants & invars);
+
+      unsigned long revision;
       std::vector<int> sequence;
       std::vector<int> f_sequence;
       std::vector<int> nuc_ids;
@@ -80,12 +99,12 @@ namespace nupack {
       DBL_TYPE defect;
       std::vector<DBL_TYPE> defects;
       std::vector<std::vector<DBL_TYPE> > pos_defects;
-      std::vector<Map> nuc_defects;
+      std::shared_ptr<const std::vector<Map>> nuc_defects;
 
       std::vector<DBL_TYPE> struc_energies;
       DBL_TYPE pfunc;
-      PairProbs ppairs;
-      PairProbs target;
+      std::shared_ptr<const PairProbs> ppairs;
+      std::shared_ptr<const PairProbs> target;
       int symmetry;
       
       DBL_TYPE eval_time;
@@ -5,6 +5,7 @@
 #include "structure_utils.h"
 #include "pathway_utils.h"
 #include "design_debug.h"
+#include "checkpoint.h"
 
 #include "algorithms.h"
 
@@ -24,6 +25,7 @@ StructureSpec::StructureSpec(const std::string & name,
   std::vector<Limits> lims;
   lims.emplace_back(0, struc.size());
   tree = std::make_shared<NodeSpec>(lims);
+  touch();
 }
 
 StructureSpec::StructureSpec(const StructureSpec & other) : tree(nullptr) {
@@ -39,6 +41,7 @@ void StructureSpec::decompose_ppair(int k, const StructureResult & res,
     const SequenceState & seqs, const PhysicalParams & params, 
     const NupackInvariants & invars) {
   tree->decompose_ppair_at(k, res.tree, seqs, *this, res, params, invars);
+  touch();
 #ifndef NDEBUG
   NUPACK_DEBUG("Decomposition of " + name);
   for (auto & str : strucs) 
@@ -50,9 +53,26 @@ void StructureSpec::decompose_ppair(int k, const StructureResult & res,
 #endif
 }
 
+void StructureSpec::save_decomposition(std::ostream & out) const {
+  tree->save(out);
+  Checkpoint::write(out, forbidden);
+}
+
+void StructureSpec::load_decomposition(std::istream & in) {
+  tree = std::make_shared<NodeSpec>(NodeSpec::load(in));
+  Checkpoint::read(in, forbidden);
+  touch();
+}
+
 void StructureSpec::set_id(int id) {
     this->id = id;
     this->struc_ids[0] = id;
+    touch();
+}
+
+void StructureSpec::touch() {
+  static unsigned long last_revision = 0;
+  this->revision = ++last_revision;
 }
 
 // right rotation
@@ -101,6 +121,7 @@ void StructureSpec::rotate() {
     breaks = new_breaks;
 
     forbidden.clear();
+    touch();
   }
 }
 
@@ -121,6 +142,7 @@ void StructureSpec::merge(const StructureSpec & other) {
   append(strucs, other.strucs);
   append(struc_names, other.struc_names);
   append(struc_ids, other.struc_ids);
+  touch();
 }
 
 void StructureSpec::compute_target_matrix() {
@@ -129,6 +151,7 @@ void StructureSpec::compute_target_matrix() {
     PairProbs curprobs(struc);
     target_matrix.merge(curprobs, 1.0 / num_strucs, 1.0);
   }
+  touch();
 }
 
 bool StructureSpec::is_forbidden(int i, int j) const {
@@ -151,6 +174,7 @@ void StructureSpec::set_strands(const std::vector<int> & strand_ids) {
 
   strands = strand_ids;
   symmetry = temporder.get_symmetry();
+  touch();
 }
 
 void StructureSpec::resolve_strand_names(const std::map<std::string, int> & name_map) {
@@ -159,6 +183,7 @@ void StructureSpec::resolve_strand_names(const std::map<std::string, int> & name
     NUPACK_CHECK(contains(s, name_map), "Unmapped strand name " + s);
     this->strands.push_back(name_map.find(s)->second);
   }
+  touch();
 }
 
 /**
@@ -204,11 +229,13 @@ void StructureSpec::resolve_nuc_ids(const SequenceSpec & seqs) {
   NUPACK_CHECK(domain_map.size() == i_nuc,
           "Nuc count: " + to_string(i_nuc)
           + " Strand map size: " + to_string(strand_map.size()));
+  touch();
 }
 
 StructureSpec StructureSpec::get_depth(int depth) const {
   StructureSpec res(*this);
   res.tree = std::make_shared<NodeSpec>(this->tree->get_depth(depth));
+  res.touch();
   return res;
 }
 
@@ -233,6 +260,7 @@ void StructureSpec::clone(const StructureSpec & other) {
     this->breaks = other.breaks;
     this->forbidden = other.forbidden;
     this->symmetry = other.symmetry;
+    this->revision = other.revision;
     this->tree = std::make_shared<NodeSpec>(*(other.tree));
   }
 }
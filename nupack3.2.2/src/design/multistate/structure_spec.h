@@ -39,16 +39,19 @@ namespace nupack {
       void set_strand_names(const std::vector<std::string> & strand_names) { 
         this->strand_names = strand_names;
       }
-      void set_no_target() { strucs.clear(); }
+      void set_no_target() { strucs.clear(); touch(); }
 
       void resolve_strand_names(const std::map<std::string, int> & namemap);
       void resolve_nuc_ids(const SequenceSpec & seqs);
 
       void set_strands(const std::vector<int> & strand_ids);
   
-      void decompose(const NupackInvariants & invars) { tree->decompose(*this, invars); }
+      void decompose(const NupackInvariants & invars) { tree->decompose(*this, invars); touch(); }
       void decompose_ppair(int k, const StructureResult & res, const SequenceState & seqs,
           const PhysicalParams & params, const NupackInvariants & invars);
+      // the decomposition and the pairs it forbids, see checkpoint.h
+      void save_decomposition(std::ostream & out) const;
+      void load_decomposition(std::istream & in);
 
       void merge(const StructureSpec & other);
       void compute_target_matrix();
@@ -83,12 +86,17 @@ namespace nupack {
       const std::vector<int> & get_domain_map() const { return domain_map; }
       const std::vector<int> & get_strand_map() const { return strand_map; }
       const std::vector<int> & get_struc_ids() const { return struc_ids; }
+
+      // changes whenever the structures or their decomposition do; copies
+      // keep it, so a result evaluated against one copy is current for all
+      unsigned long get_revision() const { return revision; }
       
 
   
     private:
       void clone(const StructureSpec & other);
       void rotate();
+      void touch();
 
       // Used in pre-resolved phase
       std::vector<std::string> strand_names;
@@ -108,6 +116,7 @@ namespace nupack {
       std::vector<std::pair<int, int> > forbidden;
 
       int symmetry;
+      unsigned long revision;
 
       std::shared_ptr<NodeSpec> tree;
   };
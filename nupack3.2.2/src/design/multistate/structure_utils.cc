@@ -9,6 +9,9 @@
 
 #include <thermo.h>
 
+#include <algorithm>
+#include <cstdint>
+
 namespace nupack { namespace StructureUtils {
 structure_pair dpp_to_pairs(const std::string & struc) {
   std::vector<int> breaks;
@@ -95,84 +98,80 @@ void get_strand_lengths(const vec_structure & pairs,
 std::vector<SplitSet> get_consistent_splits(
     const std::vector<vec_structure> & strucs, const NupackInvariants & invars) {
   std::vector<SplitSet> splits;
-  splits.emplace_back();
-  std::vector<SplitSet> newsplits;
-
-  for (auto struc : strucs) {
-    newsplits.clear();
-    for (auto i_nuc = 0; i_nuc < struc.size(); i_nuc++) {
-      auto j_nuc = struc.at(i_nuc);
-      if (j_nuc > i_nuc) {
-        for (auto s : splits) {
-          if (s.crosses_all(i_nuc, j_nuc) && 
-              SplitSet::allowed(i_nuc, j_nuc, struc.size(), invars)) {
-            SplitSet newset = s;
-            newset.push_back(i_nuc, j_nuc, 0);
-            newsplits.push_back(newset);
-          }
-        }
-      }
-    }
-    splits = newsplits;
-  }
+  ConsistentSplits consistent(strucs, invars);
+  consistent.visit([]() { return DBL_MAX; }, -DBL_MAX, 
+      [&](const SplitSet & s) { splits.push_back(s); });
   return splits;
 }
 
 SplitSet get_minimal_splits(const StructureSpec & spec, 
-    const std::vector<SplitSet> & set, const PairProbs & ppairs, int n,
+    const std::vector<vec_structure> & strucs, const PairProbs & ppairs, int n,
     const NupackInvariants & invars) {
-  auto ppair = ppairs.get_mat(n);
-  auto tmp_inds = ppairs.get_inds();
+  // pair and helix probabilities are only held for the listed pairs
+  PairProbIndex ppair(ppairs, n);
+  const auto & tmp_inds = ppairs.get_probs();
 
-  std::vector<DBL_TYPE> helix_probs(n * n, 0.0);
+  PairProbs helix_list;
   std::vector<std::pair<int, int>> poss;
   std::vector<DBL_TYPE> poss_pp;
 
   DBL_TYPE cur_ppair;
   DBL_TYPE min_ppair;
   for (auto & t : tmp_inds) {
-    auto i_nuc = t.first;
-    auto j_nuc = t.second;
+    auto i_nuc = t.i;
+    auto j_nuc = t.j;
     if (i_nuc >= invars.H_split && i_nuc < n - invars.H_split
         && j_nuc >= invars.H_split && j_nuc < n - invars.H_split) {
       min_ppair = 1.0;
       for (auto i = -invars.H_split; i < invars.H_split; i++) {
         auto d_nuc = i_nuc + i;
         auto e_nuc = j_nuc - i;
-        cur_ppair = ppair[d_nuc * (n + 1) + e_nuc];
+        cur_ppair = ppair.get(d_nuc, e_nuc);
         if (cur_ppair < min_ppair) min_ppair = cur_ppair;
       }
-      helix_probs[i_nuc * n + j_nuc] = min_ppair;
+      helix_list.push_back(i_nuc, j_nuc, min_ppair);
     }
   }
+  PairProbIndex helix_probs(helix_list, n);
 
   for (auto & t : tmp_inds) {
-    auto i_nuc = t.first;
-    auto j_nuc = t.second;
+    auto i_nuc = t.i;
+    auto j_nuc = t.j;
     if (i_nuc >= 0 && j_nuc >= 0) {
-      if (helix_probs[i_nuc * n + j_nuc] > 0 && SplitSet::allowed(i_nuc, j_nuc, n, invars)) {
+      if (helix_probs.get(i_nuc, j_nuc) > 0 && SplitSet::allowed(i_nuc, j_nuc, n, invars)) {
         poss.emplace_back(i_nuc, j_nuc);
-        poss_pp.push_back(helix_probs[i_nuc * n + j_nuc]);
+        poss_pp.push_back(helix_probs.get(i_nuc, j_nuc));
       }
     }
   }
 
-  std::vector<SplitSet> pset = set;
   DBL_TYPE best_cost = DBL_MAX;
   SplitSet best_split;
-  for (auto & ss : pset) {
+
+  // the consistent sets are enumerated twice, each time skipping those
+  // that cannot get below the best cost so far
+  ConsistentSplits consistent(strucs, invars);
+  consistent.set_weights([&](int i, int j) { return helix_probs.get(i, j); });
+  auto best_bound = [&]() { return best_cost; };
+  auto with_prob = [&](const SplitSet & set) {
+    SplitSet ss = set;
     const auto & points = ss.get_points();
     ss.set_prob(0.0);
     for (const auto & point : points) {
       auto i_nuc = point.left;
       auto j_nuc = point.right;
-      ss.add_prob(helix_probs[i_nuc * n + j_nuc]);
+      ss.add_prob(helix_probs.get(i_nuc, j_nuc));
     }
+    return ss;
+  };
+
+  consistent.visit(best_bound, invars.f_split, [&](const SplitSet & set) {
+    auto ss = with_prob(set);
     if (ss.get_prob() > invars.f_split && ss.get_cost(n) < best_cost) {
       best_cost = ss.get_cost(n);
       best_split = ss;
     }
-  }
+  });
 
   std::vector<DBL_TYPE> new_costs(poss.size(), 0);
   std::vector<DBL_TYPE> split_prob(poss.size(), 0);
@@ -181,33 +180,43 @@ SplitSet get_minimal_splits(const StructureSpec & spec,
     SplitSet tmp;
     tmp.push_back(poss[i].first, poss[i].second, 0);
     new_costs[i] = tmp.get_cost(n);
-    split_prob[i] = helix_probs[poss[i].first * n + poss[i].second];
+    split_prob[i] = poss_pp[i];
   }
 
-  for (auto & ss : pset) {
-    int i_stack = 0;
-
-    std::vector<bool> split_allowed(poss.size(), false);
+  // depth first search for additional splits; the possible splits still
+  // allowed at each depth are bitsets, allocated once
+  const int max_depth = 6;
+  int n_words = (poss.size() + 63) / 64;
+  std::vector<std::vector<uint64_t> > split_allowed_stack(max_depth, 
+      std::vector<uint64_t>(n_words, 0));
+  std::vector<SplitSet> split_stack(max_depth);
+  std::vector<DBL_TYPE> cost_stack(max_depth, 0);
 
+  consistent.visit(best_bound, -DBL_MAX, [&](const SplitSet & set) {
+    auto & split_allowed = split_allowed_stack[0];
+    std::fill(split_allowed.begin(), split_allowed.end(), 0);
+    // poss only holds allowed splits
     for (auto i = 0; i < poss.size(); i++) {
-      split_allowed[i] = ss.crosses_all(poss[i].first, poss[i].second)
-        && SplitSet::allowed(poss[i].first, poss[i].second, n, invars);
+      if (set.crosses_all(poss[i].first, poss[i].second)) {
+        split_allowed[i / 64] |= uint64_t(1) << (i % 64);
+      }
     }
 
-    std::vector<SplitSet> split_stack(1, ss);
-    std::vector<DBL_TYPE> cost_stack(1, ss.get_cost(n));;
-    std::vector<std::vector<bool> > split_allowed_stack;
-    split_allowed_stack.push_back(split_allowed);
-    int max_depth = 6;
+    int i_stack = 0;
+    split_stack[0] = with_prob(set);
+    cost_stack[0] = split_stack[0].get_cost(n);
     while (i_stack >= 0) {
-      NUPACK_CHECK(i_stack == cost_stack.size() - 1, "Out of sync i_stack");
+      auto & cur_allowed = split_allowed_stack[i_stack];
       DBL_TYPE max_ppair = 0;
       int j_pos = -1;
-      for (auto i = 0; i < poss.size(); i++) {
-        if (split_allowed_stack[i_stack][i] && max_ppair < split_prob[i] &&
-            new_costs[i] + cost_stack[i_stack] < best_cost) {
-          j_pos = i;
-          max_ppair = split_prob[i];
+      for (auto w = 0; w < n_words; w++) {
+        for (auto word = cur_allowed[w]; word; word &= word - 1) {
+          int i = w * 64 + __builtin_ctzll(word);
+          if (max_ppair < split_prob[i] &&
+              new_costs[i] + cost_stack[i_stack] < best_cost) {
+            j_pos = i;
+            max_ppair = split_prob[i];
+          }
         }
       }
 
@@ -217,7 +226,7 @@ SplitSet get_minimal_splits(const StructureSpec & spec,
 
         SplitSet tmpsplit = split_stack[i_stack];
         tmpsplit.push_back(i_nuc, j_nuc, max_ppair);
-        split_allowed_stack[i_stack][j_pos] = false;
+        cur_allowed[j_pos / 64] &= ~(uint64_t(1) << (j_pos % 64));
 
         if (tmpsplit.get_prob() > invars.f_split) {
           // Satisfy probability condition
@@ -227,31 +236,31 @@ SplitSet get_minimal_splits(const StructureSpec & spec,
           best_cost = tmpsplit.get_cost(n);
           best_split = tmpsplit;
         } else if (i_stack < max_depth - 1) {
-          split_stack.push_back(tmpsplit);
-          cost_stack.push_back(tmpsplit.get_cost(n));
-          split_allowed_stack.push_back(split_allowed_stack[i_stack]);
-          for (auto i = 0; i < poss.size(); i++) {
-            split_allowed_stack[i_stack+1][i] = split_allowed_stack[i_stack][i] &&
-              tmpsplit.crosses_all(poss[i].first, poss[i].second);
+          // the allowed splits already cross all of split_stack[i_stack]
+          auto & next_allowed = split_allowed_stack[i_stack + 1];
+          for (auto w = 0; w < n_words; w++) {
+            next_allowed[w] = 0;
+            for (auto word = cur_allowed[w]; word; word &= word - 1) {
+              int b = __builtin_ctzll(word);
+              int i = w * 64 + b;
+              if (SplitSet::crosses(poss[i].first, poss[i].second, 
+                    i_nuc, j_nuc)) {
+                next_allowed[w] |= uint64_t(1) << b;
+              }
+            }
           }
+          split_stack[i_stack + 1] = tmpsplit;
+          cost_stack[i_stack + 1] = tmpsplit.get_cost(n);
           
           i_stack++;
         } else {
-          split_stack.pop_back();
-          cost_stack.pop_back();
-          split_allowed_stack.pop_back();
-
           i_stack --;
         }
       } else {
-        split_stack.pop_back();
-        cost_stack.pop_back();
-        split_allowed_stack.pop_back();
-
         i_stack --;
       }
     }
-  }
+  });
 
   return best_split;
 }
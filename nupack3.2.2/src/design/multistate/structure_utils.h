@@ -26,7 +26,8 @@ namespace nupack {
         const std::vector<std::vector<int> > & strucs, 
         const NupackInvariants & invars);
     SplitSet get_minimal_splits(const StructureSpec & struc,
-        const std::vector<SplitSet> & set, const PairProbs & ppairs, int n, 
+        const std::vector<std::vector<int> > & strucs, 
+        const PairProbs & ppairs, int n, 
         const NupackInvariants & invars);
   };
 }
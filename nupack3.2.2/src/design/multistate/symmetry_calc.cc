@@ -4,6 +4,8 @@
 #include "weight_spec.h"
 #include "design_debug.h"
 
+#include <algorithm>
+
 namespace nupack {
 const DBL_TYPE SingleSymmetrySpec::default_weight = 5;
 
@@ -28,6 +30,9 @@ void SingleSymmetrySpec::set_word_len(std::vector<int> len) {
   for (i = 0; i < this->word_len.size(); i++) {
     NUPACK_CHECK(this->word_len[i] > 0,
         "Word lengths in SSM objective must be > 0");
+    NUPACK_CHECK(this->word_len[i] <= NUPACK_MAX_WORD_LEN,
+        "Word lengths in SSM objective must be <= " 
+        + to_string(NUPACK_MAX_WORD_LEN));
     int wl = this->word_len[i];
     this->weights.push_back(pow(this->weightscale, wl - this->word_len[0]));
   }
@@ -49,139 +54,203 @@ void SingleSymmetrySpec::set_weights(DBL_TYPE weight) {
   }
 }
 
-void SingleSymmetryResult::evaluate(
-    const SequenceState & seqs,
-    const SingleSymmetrySpec & spec
-    ) {
-  const std::vector<std::vector<int> > & nuc_ids = spec.get_nuc_ids();
+// 2^61 - 1; base^20 < modulus, so words of up to 20 nt never collide
+// (NUPACK_MAX_WORD_LEN, enforced by set_word_len)
+const uint64_t WordCounts::modulus = (uint64_t(1) << 61) - 1;
+const uint64_t WordCounts::base = 8;
 
-  DBL_TYPE total = 0;
-  DBL_TYPE total_poss = 0;
-  const std::vector<int> & word_len = spec.get_word_len();
-  const std::vector<DBL_TYPE> & weights = spec.get_weights();
-  int j;
+uint64_t WordCounts::mul_mod(uint64_t a, uint64_t b) {
+  unsigned __int128 prod = (unsigned __int128) a * b;
+  uint64_t res = (uint64_t) (prod & modulus) + (uint64_t) (prod >> 61);
+  res = (res & modulus) + (res >> 61);
+  return (res >= modulus) ? res - modulus : res;
+}
+
+void WordCounts::add(uint64_t hash) {
+  auto & count = this->counts[hash];
+  this->n_pairs += count;
+  count++;
+}
+
+void WordCounts::remove(uint64_t hash) {
+  auto it = this->counts.find(hash);
+  NUPACK_DEBUG_CHECK(it != this->counts.end() && it->second > 0, 
+      "Removing a word that was not counted");
+  it->second--;
+  this->n_pairs -= it->second;
+  if (it->second == 0) this->counts.erase(it);
+}
+
+void WordCounts::init(const std::vector<std::vector<int> > & seqs) {
+  this->hashes.clear();
+  this->counts.clear();
+  this->n_pairs = 0;
+  for (auto i_dom = 0; i_dom < seqs.size(); i_dom++) {
+    int n_words = seqs[i_dom].size() - this->len + 1;
+    this->hashes.emplace_back(std::max(n_words, 0), 0);
+    if (n_words > 0) add_words(seqs[i_dom], i_dom, 0, n_words - 1);
+  }
+}
 
-  if (nuc_ids.size() != this->last_seqs.size()) {
-    last_seqs.resize(nuc_ids.size());
+void WordCounts::update(const std::vector<int> & seq, int i_dom, int first,
+    int last) {
+  for (auto start = first; start <= last; start++) {
+    remove(this->hashes[i_dom][start]);
   }
+  add_words(seq, i_dom, first, last);
+}
 
-  std::vector<bool> eval(nuc_ids.size(), false);
+void WordCounts::add_words(const std::vector<int> & seq, int i_dom, 
+    int first, int last) {
+  auto & cur = this->hashes[i_dom];
+  uint64_t lead = 1;
+  for (auto i = 1; i < this->len; i++) lead = mul_mod(lead, base);
 
-  int i;
-  for (i = 0; i < nuc_ids.size(); i++) {
-    std::vector<int> curseq = seqs.get_sequence(nuc_ids[i]);
-    if (curseq != last_seqs[i]) {
-      eval[i] = true;
+  uint64_t hash = 0;
+  for (auto i = first; i < first + this->len; i++) {
+    hash = (mul_mod(hash, base) + seq[i]) % modulus;
+  }
+  for (auto start = first; start <= last; start++) {
+    if (start > first) {
+      // roll: drop seq[start - 1], append seq[start + len - 1]
+      hash = (hash + modulus - mul_mod(seq[start - 1], lead)) % modulus;
+      hash = (mul_mod(hash, base) + seq[start + this->len - 1]) % modulus;
     }
+    cur[start] = hash;
+    add(hash);
   }
+}
 
-  this->nuc_defects.clear();
+int WordCounts::get_count(int i_dom, int start) const {
+  auto it = this->counts.find(this->hashes[i_dom][start]);
+  return (it == this->counts.end()) ? 0 : it->second;
+}
+
+void SingleSymmetryResult::init(const SequenceState & seqs, 
+    const SingleSymmetrySpec & spec) {
+  const auto & nuc_ids = spec.get_nuc_ids();
+  this->word_len = spec.get_word_len();
+  this->weights = spec.get_weights();
+
+  this->last_seqs.clear();
+  this->nucs.clear();
+  for (auto & ids : nuc_ids) {
+    this->last_seqs.push_back(seqs.get_sequence(ids));
+    this->nucs.insert(this->nucs.end(), ids.begin(), ids.end());
+  }
 
-  for (i = 0; i < nuc_ids.size(); i++) {
-    for (j = 0; j < nuc_ids[i].size(); j++) {
-      this->nuc_defects[nuc_ids[i][j]] = 0;
+  // a word of word_len[i] is only counted where the words of the lengths
+  // before it in the list also match
+  this->words.clear();
+  this->word_index.clear();
+  int len = 0;
+  for (auto wl : this->word_len) {
+    len = std::max(len, wl);
+    if (this->words.empty() || this->words.back().get_len() != len) {
+      this->words.emplace_back(len);
+      this->words.back().init(this->last_seqs);
     }
+    this->word_index.push_back(this->words.size() - 1);
   }
 
-  this->symmetries.resize(nuc_ids.size());
-
-  NupackInvariants tmp_opts;
-  
-  for (i = 0; i < nuc_ids.size(); i++) {
-    this->symmetries[i].resize(i + 1);
-    for (j = 0; j <= i; j++) {
-      std::vector<int> seq1 = seqs.get_sequence(nuc_ids[i]);
-      std::vector<int> seq2 = seqs.get_sequence(nuc_ids[j]);
-
-      std::vector<int> match_length(nuc_ids[j].size() + 1, 0);
-      std::vector<int> old_match_length(nuc_ids[j].size() + 1, 0);
-      int k, l, d;
-      int cur_len;
-      DBL_TYPE defect = 0;
-
-      if (i != j) {
-        for (k = 0; k < seq1.size(); k++) {
-          for (l = 0; l < seq2.size(); l++) {
-            if (seq1[k] == seq2[l]) {
-              cur_len = old_match_length[l] + 1;
-              match_length[l + 1] = cur_len;
-              int i_wl;
-              for (i_wl = 0; i_wl < word_len.size(); i_wl++) {
-                int wl = word_len[i_wl];
-                DBL_TYPE weight = weights[i_wl];
-                if (cur_len >= wl) {
-                  for (d = 0; d < wl; d++) {
-                    this->nuc_defects[nuc_ids[i][k - d]] += weight / wl;
-                    this->nuc_defects[nuc_ids[j][l - d]] += weight / wl;
-                  }
-                  defect += weight;
-                }  else {
-                  break;
-                }
-              }
-            } else {
-              match_length[l + 1] = 0;
-            }
-          }
-
-          swap(match_length, old_match_length);
+  this->total_poss = 0;
+  for (auto i = 0; i < nuc_ids.size(); i++) {
+    for (auto j = 0; j <= i; j++) {
+      for (auto i_wl = 0; i_wl < this->word_len.size(); i_wl++) {
+        int wl = this->word_len[i_wl];
+        DBL_TYPE weight = this->weights[i_wl];
+        if (i != j) {
+          int n_words1 = nuc_ids[i].size() - wl + 1;
+          int n_words2 = nuc_ids[j].size() - wl + 1;
+          this->total_poss += weight * n_words1 * n_words2;
+        } else {
+          int n_words = nuc_ids[i].size() - wl + 1;
+          this->total_poss += weight * n_words * (n_words - 1) / 2;
         }
+      }
+    }
+  }
+}
 
-        int i_wl, wl;
-        for (i_wl = 0; i_wl < word_len.size(); i_wl++) {
-          wl = word_len[i_wl];
-          DBL_TYPE weight = weights[i_wl];
-          int n_words1 = seq1.size() - wl + 1;
-          int n_words2 = seq2.size() - wl + 1;
-          total_poss += weight * n_words1 * n_words2;
+void SingleSymmetryResult::evaluate(
+    const SequenceState & seqs,
+    const SingleSymmetrySpec & spec
+    ) {
+  const std::vector<std::vector<int> > & nuc_ids = spec.get_nuc_ids();
+
+  bool same_spec = nuc_ids.size() == this->last_seqs.size() && 
+    spec.get_word_len() == this->word_len && 
+    spec.get_weights() == this->weights;
+  for (auto i = 0; same_spec && i < nuc_ids.size(); i++) {
+    same_spec = nuc_ids[i].size() == this->last_seqs[i].size();
+  }
+
+  if (!same_spec) {
+    init(seqs, spec);
+  } else {
+    const auto & cur_nucs = seqs.get_nucleotides();
+    for (auto i = 0; i < nuc_ids.size(); i++) {
+      auto & last = this->last_seqs[i];
+      int n = last.size();
+      int pos = 0;
+      while (pos < n) {
+        if (cur_nucs[nuc_ids[i][pos]] == last[pos]) {
+          pos++;
+          continue;
         }
-      } else {
-        for (k = 0; k < seq1.size(); k++) {
-          for (l = k + 1; l < seq2.size(); l++) {
-            if (seq1[k] == seq2[l]) {
-              cur_len = old_match_length[l] + 1;
-              match_length[l + 1] = cur_len;
-              int i_wl;
-              for (i_wl = 0; i_wl < word_len.size(); i_wl++) {
-                int wl = word_len[i_wl];
-                DBL_TYPE weight = weights[i_wl];
-                if (cur_len >= wl) {
-                  for (d = 0; d < wl; d++) {
-                    this->nuc_defects[nuc_ids[i][k - d]] += weight / wl;
-                    this->nuc_defects[nuc_ids[j][l - d]] += weight / wl;
-                  }
-                  defect += weight;
-                }  else {
-                  break;
-                }
-              }
-            } else {
-              match_length[l + 1] = 0;
-            }
-          }
-          swap(match_length, old_match_length);
+        // a run of changes [pos, end)
+        int end = pos;
+        while (end < n && cur_nucs[nuc_ids[i][end]] != last[end]) {
+          last[end] = cur_nucs[nuc_ids[i][end]];
+          end++;
         }
-        int i_wl, wl;
-        for (i_wl = 0; i_wl < word_len.size(); i_wl++) {
-          wl = word_len[i_wl];
-          DBL_TYPE weight = weights[i_wl];
-          int n_words = seq1.size() - wl + 1;
-          total_poss += weight * n_words * (n_words - 1) / 2;
+        for (auto & w : this->words) {
+          int first = std::max(pos - w.get_len() + 1, 0);
+          int last_start = std::min(end - 1, n - w.get_len());
+          if (first <= last_start) w.update(last, i, first, last_start);
         }
+        pos = end;
       }
-
-
-      this->symmetries[i][j] = defect;
-      total += defect;
     }
   }
 
-  std::map<int, DBL_TYPE>::iterator it;
-  for (it = this->nuc_defects.begin(); it != this->nuc_defects.end(); it++) {
-    it->second /= total_poss;
+  DBL_TYPE total = 0;
+  for (auto i_wl = 0; i_wl < this->word_len.size(); i_wl++) {
+    total += this->weights[i_wl] * 
+      this->words[this->word_index[i_wl]].get_n_pairs();
+  }
+  this->defect = total / this->total_poss;
+  this->nuc_defects_current = false;
+}
+
+const std::vector<DBL_TYPE> & SingleSymmetryResult::get_nuc_defects() const {
+  if (this->nuc_defects_current) return this->nuc_defects;
+
+  // each occurrence of a word in c places is in c - 1 of the counted pairs
+  // and charges the last word_len[i_wl] nucleotides of the word
+  this->nuc_defects.assign(this->nucs.size(), 0);
+  int offset = 0;
+  for (auto i_dom = 0; i_dom < this->last_seqs.size(); i_dom++) {
+    int n = this->last_seqs[i_dom].size();
+    for (auto i_wl = 0; i_wl < this->word_len.size(); i_wl++) {
+      const auto & w = this->words[this->word_index[i_wl]];
+      int wl = this->word_len[i_wl];
+      DBL_TYPE per_nuc = this->weights[i_wl] / wl;
+      for (auto start = 0; start + w.get_len() <= n; start++) {
+        int count = w.get_count(i_dom, start);
+        if (count < 2) continue;
+        int end = start + w.get_len();
+        for (auto pos = end - wl; pos < end; pos++) {
+          this->nuc_defects[offset + pos] += (count - 1) * per_nuc;
+        }
+      }
+    }
+    offset += n;
   }
 
-  this->defect = total / total_poss;
+  for (auto & d : this->nuc_defects) d /= this->total_poss;
+  this->nuc_defects_current = true;
+  return this->nuc_defects;
 }
 
 void SymmetryResult::evaluate(
@@ -225,16 +294,15 @@ void SymmetryObjective::get_variable_mut_weights(const EvalSpec & spec,
     const EvalResult & res, WeightSpec & weightspec, std::vector<DBL_TYPE> & weights) {
   if (! this->satisfied(spec, res, weightspec)) {
     const std::vector<SingleSymmetryResult> & results = res.symmetries.get_results();
-    const std::map<int, DBL_TYPE> & tmp = results[this->id].get_nuc_defects();
-
-    std::map<int, DBL_TYPE>::const_iterator it;
-    for (it = tmp.begin(); it != tmp.end(); it++) {
-      NUPACK_CHECK(it->first >= 0 && it->first < weights.size(),
-          "Invalid nucleotide id " + to_string(it->first));
-      NUPACK_CHECK(!(it->second < 0),  
-          "Invalid negative defect " + to_string(it->second));
-      // NUPACK_DEBUG(it->first << " " << it->second);
-      weights[it->first] += it->second;
+    const std::vector<int> & nucs = results[this->id].get_defect_nucs();
+    const std::vector<DBL_TYPE> & tmp = results[this->id].get_nuc_defects();
+
+    for (auto i = 0; i < nucs.size(); i++) {
+      NUPACK_CHECK(nucs[i] >= 0 && nucs[i] < weights.size(),
+          "Invalid nucleotide id " + to_string(nucs[i]));
+      NUPACK_CHECK(!(tmp[i] < 0),  
+          "Invalid negative defect " + to_string(tmp[i]));
+      weights[nucs[i]] += tmp[i];
     }
   }
 
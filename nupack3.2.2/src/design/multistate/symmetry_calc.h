@@ -6,7 +6,8 @@
 
 #include <string>
 #include <vector>
-#include <map>
+#include <unordered_map>
+#include <cstdint>
 
 namespace nupack {
   class SequenceSpec;
@@ -37,19 +38,73 @@ namespace nupack {
       const static DBL_TYPE default_weight;
   };
 
+  /**
+   * Multiset of the words of one length in the domains of an SSM objective,
+   * keyed by a rolling Rabin-Karp hash (exact for words of up to 20 nt).
+   * n_pairs is the number of pairs of positions holding the same word,
+   * which is what the objective counts for that length.
+   */
+  class WordCounts {
+    public:
+      WordCounts(int len) : len(len) {}
+
+      void init(const std::vector<std::vector<int> > & seqs);
+      // re-hashes the words of domain i_dom starting in [first, last]
+      void update(const std::vector<int> & seq, int i_dom, int first, 
+          int last);
+
+      int get_len() const { return this->len; }
+      unsigned long get_n_pairs() const { return this->n_pairs; }
+      // number of occurrences of the word of domain i_dom starting at start
+      int get_count(int i_dom, int start) const;
+
+    private:
+      static uint64_t mul_mod(uint64_t a, uint64_t b);
+      void add(uint64_t hash);
+      void remove(uint64_t hash);
+      void add_words(const std::vector<int> & seq, int i_dom, int first,
+          int last);
+
+      int len;
+      std::vector<std::vector<uint64_t> > hashes;
+      std::unordered_map<uint64_t, int> counts;
+      unsigned long n_pairs {0};
+
+      const static uint64_t modulus;
+      const static uint64_t base;
+  };
+
+  /**
+   * Counts the pairs of equal words between and within the domains of an
+   * SSM objective.  The word multisets are kept between evaluations, so
+   * only the words around the nucleotides that changed are re-hashed, and
+   * the nucleotide defects are only computed when asked for.
+   */
   class SingleSymmetryResult {
     public:
       void evaluate(const SequenceState & seqs, 
           const SingleSymmetrySpec & spec);
 
       DBL_TYPE get_defect() const { return this->defect; }
-      std::map<int, DBL_TYPE> get_nuc_defects() const { return this->nuc_defects; }
+      // defects of the nucleotides listed by get_defect_nucs
+      const std::vector<DBL_TYPE> & get_nuc_defects() const;
+      const std::vector<int> & get_defect_nucs() const { return this->nucs; }
 
     private:
-      std::vector<std::vector<DBL_TYPE> > symmetries;
+      void init(const SequenceState & seqs, const SingleSymmetrySpec & spec);
+
       std::vector<std::vector<int> > last_seqs;
-      std::map<int, DBL_TYPE> nuc_defects;
+      std::vector<int> word_len;
+      std::vector<DBL_TYPE> weights;
+      // words[word_index[i_wl]] holds the words counted for word_len[i_wl]
+      std::vector<WordCounts> words;
+      std::vector<int> word_index;
+      std::vector<int> nucs;
+      DBL_TYPE total_poss;
       DBL_TYPE defect;
+
+      mutable std::vector<DBL_TYPE> nuc_defects;
+      mutable bool nuc_defects_current {false};
   };
 
   class SymmetrySpec {
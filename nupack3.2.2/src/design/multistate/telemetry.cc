@@ -0,0 +1,127 @@
+#include "telemetry.h"
+#include "design_debug.h"
+
+#include <cmath>
+#include <limits>
+
+#include <sys/resource.h>
+
+namespace nupack {
+
+EvalCounts eval_counts;
+
+long max_rss_kb() {
+  rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) return -1;
+#ifdef __APPLE__
+  return usage.ru_maxrss / 1024;
+#else
+  return usage.ru_maxrss;
+#endif
+}
+
+void Telemetry::open(const std::string & filename, const std::string & engine,
+    DBL_TYPE start_time) {
+  this->out.open(filename, std::ios::out | std::ios::trunc);
+  NUPACK_CHECK(this->out.good(), "Unable to write " + filename);
+  this->out.precision(std::numeric_limits<double>::digits10);
+  this->start_time = start_time;
+
+  begin_line("start");
+  this->out << ",\"engine\":\"" << engine << "\"";
+  end_line();
+}
+
+DBL_TYPE Telemetry::now() const {
+  return get_current_time() - this->start_time;
+}
+
+void Telemetry::write_number(DBL_TYPE val) {
+  // JSON has no infinities, the unset best defect is written as null
+  if (std::isfinite((double) val)) {
+    this->out << (double) val;
+  } else {
+    this->out << "null";
+  }
+}
+
+void Telemetry::begin_line(const std::string & event) {
+  this->out << "{\"event\":\"" << event << "\",\"time\":";
+  write_number(now());
+}
+
+void Telemetry::write_counts() {
+  const auto & c = eval_counts;
+  this->out << ",\"designs_evaluated\":" << c.designs
+      << ",\"leaf_evals\":" << c.leaves
+      << ",\"leaf_lookups\":" << c.leaf_lookups
+      << ",\"offtarget_evals\":" << c.orders
+      << ",\"offtarget_lookups\":" << c.order_lookups
+      << ",\"shared_fills\":" << c.shared_fills
+      << ",\"max_rss_kb\":" << max_rss_kb();
+}
+
+void Telemetry::end_line() {
+  this->out << "}" << std::endl;
+}
+
+void Telemetry::generation(const std::string & phase, int i_gen,
+    DBL_TYPE score, const std::vector<DBL_TYPE> & defects) {
+  if (!enabled()) return;
+  begin_line("generation");
+  this->out << ",\"phase\":\"" << phase << "\",\"generation\":" << i_gen
+      << ",\"best_score\":";
+  write_number(score);
+  this->out << ",\"best_defects\":[";
+  for (auto i = 0; i < defects.size(); i++) {
+    if (i > 0) this->out << ",";
+    write_number(defects[i]);
+  }
+  this->out << "]";
+  write_counts();
+  end_line();
+}
+
+void Telemetry::stop(const std::string & reason) {
+  if (!enabled()) return;
+  begin_line("stop");
+  this->out << ",\"reason\":\"" << reason << "\"";
+  end_line();
+}
+
+void Telemetry::finish() {
+  if (!enabled()) return;
+  begin_line("end");
+  this->out << ",\"phases\":{";
+  bool first = true;
+  for (const auto & ph : this->phases) {
+    if (!first) this->out << ",";
+    first = false;
+    this->out << "\"" << ph.first << "\":{\"seconds\":";
+    write_number(ph.second.seconds);
+    this->out << ",\"count\":" << ph.second.count << "}";
+  }
+  this->out << "}";
+  write_counts();
+  end_line();
+  this->out.close();
+}
+
+Telemetry::Phase::Phase(Telemetry & telemetry, const std::string & name) :
+    telemetry(telemetry), name(name), start(get_current_time()) {}
+
+Telemetry::Phase::~Phase() {
+  if (!telemetry.enabled()) return;
+  DBL_TYPE seconds = get_current_time() - this->start;
+  auto & total = telemetry.phases[this->name];
+  total.seconds += seconds;
+  total.count++;
+
+  telemetry.begin_line("phase");
+  telemetry.out << ",\"phase\":\"" << this->name << "\",\"seconds\":";
+  telemetry.write_number(seconds);
+  telemetry.out << ",\"total_seconds\":";
+  telemetry.write_number(total.seconds);
+  telemetry.end_line();
+}
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <thermo.h>
+
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace nupack {
+  /**
+   * Counts of the partition functions computed since the program started.
+   * Lookups count every leaf and off-target ordering a design evaluation
+   * asked for, whether it was computed again or found current and kept.
+   * Shared fills count the leaves and orderings computed again whose fill
+   * was found in the ensemble memo.
+   */
+  struct EvalCounts {
+    unsigned long designs {0};
+    unsigned long leaves {0};
+    unsigned long leaf_lookups {0};
+    unsigned long orders {0};
+    unsigned long order_lookups {0};
+    unsigned long shared_fills {0};
+  };
+
+  extern EvalCounts eval_counts;
+
+  // resident set high-water mark of the process in kB
+  long max_rss_kb();
+
+  /**
+   * Optional JSON-lines progress stream of the optimizer.  Every line is
+   * one object with an "event" field: "start", "generation" (best score
+   * and defects of the population after a generation of a phase), "phase"
+   * (time spent in one pass of a phase), "stop" and "end" (totals per
+   * phase).  Times are seconds since the optimization started.  Nothing is
+   * written unless open() was called.
+   */
+  class Telemetry {
+    public:
+      void open(const std::string & filename, const std::string & engine,
+          DBL_TYPE start_time);
+      bool enabled() const { return this->out.is_open(); }
+
+      void generation(const std::string & phase, int i_gen, DBL_TYPE score,
+          const std::vector<DBL_TYPE> & defects);
+      void stop(const std::string & reason);
+      void finish();
+
+      /**
+       * Times one pass of a phase from construction to destruction.
+       * Nested phases are each timed in full.
+       */
+      class Phase {
+        public:
+          Phase(Telemetry & telemetry, const std::string & name);
+          ~Phase();
+        private:
+          Telemetry & telemetry;
+          std::string name;
+          DBL_TYPE start;
+      };
+
+    private:
+      struct PhaseTotal {
+        DBL_TYPE seconds {0};
+        unsigned long count {0};
+      };
+
+      DBL_TYPE now() const;
+      void begin_line(const std::string & event);
+      void write_counts();
+      void end_line();
+      void write_number(DBL_TYPE val);
+
+      std::ofstream out;
+      DBL_TYPE start_time {0};
+      std::map<std::string, PhaseTotal> phases;
+  };
+}
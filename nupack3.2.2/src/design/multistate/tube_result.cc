@@ -6,7 +6,7 @@
 #include "design_debug.h"
 #include "pathway_utils.h"
 
-#include "equilibrium_concentrations.h"
+#include "thermo/concentrations/equilibrium_concentrations.h"
 
 #include <fstream>
 
@@ -115,8 +115,13 @@ void TubeResult::evaluate(const std::vector<StructureResult> & strucs,
 
   x.resize(m_strucs);
 
-  calc_conc_from_free_energies(x.data(), A.data(), dG.data(), x0.data(), 
-        m_strands, m_strucs, sp::n_points, sp::max_iters, sp::tol, sp::delta_bar,
+  // One solver workspace, grown on demand, serves every tube evaluation
+  static eq_workspace_t * conc_ws = new_eq_workspace(m_strands, m_strucs);
+  NUPACK_CHECK(conc_ws != NULL, "unable to allocate concentrations workspace");
+
+  calc_conc_from_free_energies_ws(conc_ws, x.data(), A.data(), dG.data(), 
+        x0.data(), m_strands, m_strucs, sp::n_points, sp::max_iters, sp::tol, 
+        sp::delta_bar,
         sp::eta, sp::min_delta, sp::max_trial, sp::perturb_scale, sp::quiet,
         sp::write_log_file, sp::log_file, sp::seed, NULL);
   
@@ -132,6 +137,7 @@ void TubeResult::evaluate(const std::vector<StructureResult> & strucs,
   
 
   // Calculate nodal and nucleotide defects
+  auto nucleotide_defects = std::make_shared<Map>();
   for (auto i_ord = 0; i_ord < n_strucs; i_ord++) {
     auto & comp = complexes[i_ord];
     for (auto i_tar = 0; i_tar < comp.target_concs.size(); i_tar++) {
@@ -158,16 +164,22 @@ void TubeResult::evaluate(const std::vector<StructureResult> & strucs,
       for (auto & nd : nuc_defects) {
         std::vector<int> ind(1, tube_id);
         append(ind, nd.first);
-        this->nucleotide_defects[ind] += (x_act * nd.second + x_defect);
+        (*nucleotide_defects)[ind] += (x_act * nd.second + x_defect);
       }
     }
   }
+  this->nucleotide_defects = nucleotide_defects;
+}
+
+const Map & TubeResult::get_nuc_defects() const {
+  static const Map none;
+  return this->nucleotide_defects ? *this->nucleotide_defects : none;
 }
 
 void TubeResult::clear_state() {
   defect = 0.0;
   nuc_conc = 0.0;
-  nucleotide_defects.clear();
+  nucleotide_defects.reset();
 }
 
 void TubeResult::serialize(const TubeSpec & tube, const std::vector<StructureSpec> & strucspecs,
@@ -2,7 +2,7 @@
 
 #include "physical_spec.h"
 
-#include "equilibrium_concentrations.h"
+#include "thermo/concentrations/equilibrium_concentrations.h"
 
 #include "types.h"
 
@@ -44,9 +44,7 @@ namespace nupack {
           const NupackInvariants & invars);
       const std::vector<DBL_TYPE> & get_concentrations() const { return this->x; }
 
-      const Map get_nuc_defects() const { 
-        return this->nucleotide_defects;
-      }
+      const Map & get_nuc_defects() const;
       DBL_TYPE get_nuc_conc() const { return this->nuc_conc; }
 
       void serialize(const TubeSpec & spec, 
@@ -63,7 +61,7 @@ namespace nupack {
     private:
       std::vector<std::vector<DBL_TYPE> > target_x;
       std::vector<DBL_TYPE> x;
-      Map nucleotide_defects;
+      std::shared_ptr<const Map> nucleotide_defects; // shared between copies
       DBL_TYPE defect;
       DBL_TYPE nuc_conc;
   };
@@ -19,3 +19,7 @@
 #define DEFAULT_STOP_CONDITION 0.01
 // default maxsize
 #define DEFAULT_MAXSIZE 0
+// kcal/mol per nucleotide below its mfe that the ensemble free energy of
+// an off-target ordering is estimated to lie for --prune.  A heuristic
+// (about twice the gap seen in practice), not a bound
+#define PRUNE_MFE_MARGIN 0.1
@@ -15,16 +15,57 @@ int main (int argc, char** argv) {
   FILE * outf;
   FILE * leafoutf;
   char * input_prefix = NULL;
+  char * design_prefix = NULL;
+  int resume = 0;
+  DBL_TYPE checkpoint_interval = -1;
+  char * telemetry_fn = NULL;
+  char * stop_fn = NULL;
+  int n_jobs = 0;
+  DBL_TYPE prune_tol = -1;
   int rank = 0;
+  int i_arg;
+
+  for (i_arg = 1; i_arg < argc; i_arg++) {
+    if (strcmp(argv[i_arg], "--resume") == 0) {
+      resume = 1;
+    } else if (strcmp(argv[i_arg], "--checkpoint") == 0 && i_arg + 1 < argc) {
+      i_arg++;
+      checkpoint_interval = strtod(argv[i_arg], NULL);
+    } else if (strcmp(argv[i_arg], "--telemetry") == 0 && i_arg + 1 < argc) {
+      i_arg++;
+      telemetry_fn = argv[i_arg];
+    } else if (strcmp(argv[i_arg], "--stopfile") == 0 && i_arg + 1 < argc) {
+      i_arg++;
+      stop_fn = argv[i_arg];
+    } else if (strcmp(argv[i_arg], "--jobs") == 0 && i_arg + 1 < argc) {
+      i_arg++;
+      n_jobs = atoi(argv[i_arg]);
+    } else if (strcmp(argv[i_arg], "--prune") == 0 && i_arg + 1 < argc) {
+      i_arg++;
+      prune_tol = strtod(argv[i_arg], NULL);
+    } else if (!design_prefix) {
+      design_prefix = argv[i_arg];
+    } else {
+      design_prefix = NULL;
+      break;
+    }
+  }
 
-  if (argc != 2) {
-    fprintf(stderr, "Expected 1 argument. Received %i\n", argc - 1);
-    fprintf(stderr, "Usage: %s <design_prefix>\n", argv[0]);
+  if (!design_prefix) {
+    fprintf(stderr, "Usage: %s [--resume] [--checkpoint <seconds>] "
+        "[--telemetry <file>] [--stopfile <file>] [--jobs <n>] "
+        "[--prune <tolerance>] <design_prefix>\n"
+        "  --checkpoint: save the design at the refocusing steps, at most\n"
+        "  once per interval; a design stopped inside a forest optimization\n"
+        "  is resumed from the refocusing step before it, redoing that work\n"
+        "  --prune: approximate off-targets whose estimated share of a tube\n"
+        "  defect is below tolerance by their mfe during the optimization;\n"
+        "  the final design is evaluated exactly\n", argv[0]);
     goto error;
   }
   
   if (rank == 0) {
-    input_len = strlen(argv[1]);
+    input_len = strlen(design_prefix);
 
     input_prefix = (char *) malloc((input_len + 2) * sizeof(char));
     input_fn = (char *) malloc((input_len + 6) * sizeof(char));
@@ -33,9 +74,9 @@ int main (int argc, char** argv) {
     check_mem(input_prefix);
     check_mem(input_fn);
     check_mem(output_fn);
-    strncpy(input_prefix, argv[1], input_len + 2);
-    strncpy(input_fn, argv[1], input_len + 2);
-    strncpy(output_fn, argv[1], input_len + 2);
+    strncpy(input_prefix, design_prefix, input_len + 2);
+    strncpy(input_fn, design_prefix, input_len + 2);
+    strncpy(output_fn, design_prefix, input_len + 2);
 
     input_prefix[input_len] = '\0';
 
@@ -55,6 +96,11 @@ int main (int argc, char** argv) {
     }
 
     spec.opts.file_prefix = input_prefix;
+    spec.opts.resume = resume;
+    spec.opts.checkpoint_interval = checkpoint_interval;
+    spec.opts.stop_file = stop_fn;
+    spec.opts.n_jobs = n_jobs;
+    spec.opts.prune_tol = prune_tol;
 
     debug("Seed: %u\n", spec.opts.seed);
 
@@ -62,6 +108,11 @@ int main (int argc, char** argv) {
     check(ERR_OK == init_result(&result, &spec),
         "Error initializing result structure");
 
+    if (telemetry_fn) {
+      check(ERR_OK == open_telemetry(telemetry_fn, spec.opts.start_time),
+          "Error opening telemetry file");
+    }
+
     init_decomposition(&spec);
     init_seqstate(&seqs, &spec);
 
@@ -70,6 +121,7 @@ int main (int argc, char** argv) {
 
     // Actually do the design and record the time it takes
     check(ERR_OK == optimize_tubes(&result, &seqs, &spec), "Error optimizing sequences");
+    close_telemetry();
 
     outf = fopen(output_fn, "w");
     print_design_result(outf, &result, &seqs, 0, &spec, "tubedesign");
@@ -78,7 +130,7 @@ int main (int argc, char** argv) {
 
     if (spec.opts.print_leaves) {
       output_fn_leaves = (char *) malloc((input_len + 16) * sizeof(char));
-      strncpy(output_fn_leaves, argv[1], input_len + 1);
+      strncpy(output_fn_leaves, design_prefix, input_len + 1);
       strncat(output_fn_leaves, "_leaves.out", 16);
 
       leafoutf = fopen(output_fn_leaves, "w");
@@ -110,6 +162,7 @@ int main (int argc, char** argv) {
   return 0;
 error:
   log_err("Error occurred in %s. Exiting", argv[0]);
+  close_telemetry();
   free(input_prefix);
   free(input_fn);
   free(output_fn);
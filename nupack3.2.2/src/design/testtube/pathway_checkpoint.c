@@ -0,0 +1,646 @@
+#include "pathway_design.h"
+
+/*
+ * Binary checkpoints of the design state.  Values are written in the
+ * layout of the machine, so a checkpoint is only meant to be read back by
+ * the same build.  Every array is preceded by its length.
+ */
+
+/***********************************************************/
+static int write_vals(FILE * f, const void * vals, size_t size, int n) {
+  check(n == 0 || fwrite(vals, size, n, f) == (size_t) n,
+      "Error writing checkpoint");
+  return ERR_OK;
+error:
+  return ERR_INVALID_STATE;
+}
+
+static int read_vals(FILE * f, void * vals, size_t size, int n) {
+  check(n == 0 || fread(vals, size, n, f) == (size_t) n,
+      "Truncated checkpoint");
+  return ERR_OK;
+error:
+  return ERR_INVALID_STATE;
+}
+
+static int write_array(FILE * f, const void * vals, size_t size, int n) {
+  check(ERR_OK == write_vals(f, &n, sizeof(int), 1)
+      && ERR_OK == write_vals(f, vals, size, n), "Error writing array");
+  return ERR_OK;
+error:
+  return ERR_INVALID_STATE;
+}
+
+// reads an array written by write_array into newly allocated memory
+static int read_array(FILE * f, void ** vals, size_t size, int * n) {
+  *vals = NULL;
+  check(ERR_OK == read_vals(f, n, sizeof(int), 1), "Error reading array");
+  check(*n >= 0, "Corrupt checkpoint");
+  *vals = malloc(size * (*n > 0 ? *n : 1));
+  check_mem(*vals);
+  check(ERR_OK == read_vals(f, *vals, size, *n), "Error reading array");
+  return ERR_OK;
+error:
+  free(*vals);
+  *vals = NULL;
+  return ERR_INVALID_STATE;
+}
+
+// reads an array of known length into existing memory
+static int read_array_into(FILE * f, void * vals, size_t size, int n) {
+  int n_saved;
+  check(ERR_OK == read_vals(f, &n_saved, sizeof(int), 1),
+      "Error reading array");
+  check(n_saved == n, "Checkpoint does not match the design");
+  check(ERR_OK == read_vals(f, vals, size, n), "Error reading array");
+  return ERR_OK;
+error:
+  return ERR_INVALID_STATE;
+}
+/***********************************************************/
+
+/***********************************************************/
+static int write_sequence_list(FILE * f, sequence_list_t * seqs) {
+  int i;
+  check(ERR_OK == write_vals(f, &(seqs->n), sizeof(int), 1),
+      "Error writing sequences");
+  for (i = 0; i < seqs->n; i++) {
+    check(ERR_OK == write_array(f, seqs->seqs[i].nucs, sizeof(int),
+          seqs->seqs[i].n), "Error writing sequences");
+  }
+  return ERR_OK;
+error:
+  return ERR_INVALID_STATE;
+}
+
+static int read_sequence_list(FILE * f, sequence_list_t * seqs) {
+  int i, n;
+  check(ERR_OK == read_vals(f, &n, sizeof(int), 1) && n == seqs->n,
+      "Checkpoint does not match the design");
+  for (i = 0; i < seqs->n; i++) {
+    check(ERR_OK == read_array_into(f, seqs->seqs[i].nucs, sizeof(int),
+          seqs->seqs[i].n), "Error reading sequences");
+  }
+  return ERR_OK;
+error:
+  return ERR_INVALID_STATE;
+}
+
+int write_seqstate(FILE * f, seqstate_t * seqs) {
+  check(ERR_OK == write_array(f, seqs->nucspec.nucs, sizeof(int),
+        seqs->nucspec.n)
+      && ERR_OK == write_array(f, seqs->dumspec.nucs, sizeof(int),
+        seqs->dumspec.n)
+      && ERR_OK == write_sequence_list(f, &(seqs->strands))
+      && ERR_OK == write_sequence_list(f, &(seqs->domains)),
+      "Error writing sequence state");
+  return ERR_OK;
+error:
+  return ERR_INVALID_STATE;
+}
+
+// seqs must be initialized for the design being resumed
+int read_seqstate(FILE * f, seqstate_t * seqs) {
+  check(ERR_OK == read_array_into(f, seqs->nucspec.nucs, sizeof(int),
+        seqs->nucspec.n)
+      && ERR_OK == read_array_into(f, seqs->dumspec.nucs, sizeof(int),
+        seqs->dumspec.n)
+      && ERR_OK == read_sequence_list(f, &(seqs->strands))
+      && ERR_OK == read_sequence_list(f, &(seqs->domains)),
+      "Error reading sequence state");
+  return ERR_OK;
+error:
+  return ERR_INVALID_STATE;
+}
+/***********************************************************/
+
+/***********************************************************/
+static int write_result_tree(FILE * f, result_tree_t * tree) {
+  int i_ch;
+  check(ERR_OK == write_array(f, tree->sequence, sizeof(int), tree->n_nucs)
+      && ERR_OK == write_array(f, tree->native_map, sizeof(int), tree->n_nucs)
+      && ERR_OK == write_array(f, tree->dummy_flag, sizeof(int), tree->n_nucs)
+      && ERR_OK == write_array(f, tree->nuc_defects, sizeof(DBL_TYPE),
+        tree->n_nucs)
+      && ERR_OK == write_vals(f, &(tree->pfunc), sizeof(DBL_TYPE), 1)
+      && ERR_OK == write_vals(f, &(tree->eval_time), sizeof(DBL_TYPE), 1)
+      && ERR_OK == write_array(f, tree->ppairs, sizeof(DBL_TYPE),
+        tree->ppairs_n)
+      && ERR_OK == write_array(f, tree->ppairs_i, sizeof(int), tree->ppairs_n)
+      && ERR_OK == write_array(f, tree->ppairs_j, sizeof(int), tree->ppairs_n)
+      && ERR_OK == write_vals(f, &(tree->n_children), sizeof(int), 1),
+      "Error writing result tree");
+  for (i_ch = 0; i_ch < tree->n_children; i_ch++) {
+    check(ERR_OK == write_result_tree(f, tree->children[i_ch]),
+        "Error writing result tree");
+  }
+  return ERR_OK;
+error:
+  return ERR_INVALID_STATE;
+}
+
+static result_tree_t * read_result_tree(FILE * f) {
+  result_tree_t * tree = alloc_empty_result_tree();
+  int i_ch, n;
+  check_mem(tree);
+  check(ERR_OK == read_array(f, (void **) &(tree->sequence), sizeof(int),
+        &(tree->n_nucs))
+      && ERR_OK == read_array(f, (void **) &(tree->native_map), sizeof(int), &n)
+      && ERR_OK == read_array(f, (void **) &(tree->dummy_flag), sizeof(int), &n)
+      && ERR_OK == read_array(f, (void **) &(tree->nuc_defects),
+        sizeof(DBL_TYPE), &n)
+      && ERR_OK == read_vals(f, &(tree->pfunc), sizeof(DBL_TYPE), 1)
+      && ERR_OK == read_vals(f, &(tree->eval_time), sizeof(DBL_TYPE), 1)
+      && ERR_OK == read_array(f, (void **) &(tree->ppairs), sizeof(DBL_TYPE),
+        &(tree->ppairs_n))
+      && ERR_OK == read_array(f, (void **) &(tree->ppairs_i), sizeof(int), &n)
+      && ERR_OK == read_array(f, (void **) &(tree->ppairs_j), sizeof(int), &n)
+      && ERR_OK == read_vals(f, &n, sizeof(int), 1),
+      "Error reading result tree");
+  tree->ppairs_cap = tree->ppairs_n;
+
+  tree->children = (result_tree_t **) malloc(sizeof(result_tree_t *) *
+      (n > 0 ? n : 1));
+  check_mem(tree->children);
+  for (i_ch = 0; i_ch < n; i_ch++) {
+    tree->children[i_ch] = read_result_tree(f);
+    check(tree->children[i_ch], "Error reading result tree");
+    tree->n_children++;
+  }
+  return tree;
+error:
+  if (tree) destroy_result_tree(tree);
+  return NULL;
+}
+/***********************************************************/
+
+/***********************************************************/
+static int write_result_struc(FILE * f, result_struc_t * res) {
+  int n = res->n_nucs;
+  int has_tree = res->tree != NULL;
+  check(ERR_OK == write_vals(f, &n, sizeof(int), 1)
+      && ERR_OK == write_vals(f, res->sequence, sizeof(int), n)
+      && ERR_OK == write_vals(f, res->f_sequence, sizeof(int), n)
+      && ERR_OK == write_vals(f, res->nuc_ids, sizeof(int), n)
+      && ERR_OK == write_vals(f, res->structure, sizeof(int), n)
+      && ERR_OK == write_vals(f, res->modifiable, sizeof(int), n)
+      && ERR_OK == write_vals(f, res->defects, sizeof(DBL_TYPE), n)
+      && ERR_OK == write_vals(f, res->f_defects, sizeof(DBL_TYPE), n)
+      && ERR_OK == write_array(f, res->breaks, sizeof(int), res->n_breaks)
+      && ERR_OK == write_vals(f, &(res->pfunc), sizeof(DBL_TYPE), 1)
+      && ERR_OK == write_vals(f, &(res->time), sizeof(DBL_TYPE), 1)
+      && ERR_OK == write_array(f, res->ppairs, sizeof(DBL_TYPE), res->ppairs_n)
+      && ERR_OK == write_array(f, res->ppairs_i, sizeof(int), res->ppairs_n)
+      && ERR_OK == write_array(f, res->ppairs_j, sizeof(int), res->ppairs_n)
+      && ERR_OK == write_vals(f, &(res->defect), sizeof(DBL_TYPE), 1)
+      && ERR_OK == write_vals(f, &has_tree, sizeof(int), 1),
+      "Error writing structure result");
+  if (has_tree) {
+    check(ERR_OK == write_result_tree(f, res->tree),
+        "Error writing structure result");
+  }
+  return ERR_OK;
+error:
+  return ERR_INVALID_STATE;
+}
+
+// res must be freshly initialized
+static int read_result_struc(FILE * f, result_struc_t * res) {
+  int n, n_breaks, n_ppairs, has_tree;
+  check(ERR_OK == read_vals(f, &n, sizeof(int), 1) && n >= 0,
+      "Error reading structure result");
+  // a structure that was never evaluated has nothing allocated
+  if (n > 0) {
+    check(ERR_OK == ensure_capacity_vals(res, n, 1),
+        "Error allocating structure result");
+    free(res->breaks);
+    res->breaks = NULL;
+    res->n_breaks = 0;
+  }
+
+  check(ERR_OK == read_vals(f, res->sequence, sizeof(int), n)
+      && ERR_OK == read_vals(f, res->f_sequence, sizeof(int), n)
+      && ERR_OK == read_vals(f, res->nuc_ids, sizeof(int), n)
+      && ERR_OK == read_vals(f, res->structure, sizeof(int), n)
+      && ERR_OK == read_vals(f, res->modifiable, sizeof(int), n)
+      && ERR_OK == read_vals(f, res->defects, sizeof(DBL_TYPE), n)
+      && ERR_OK == read_vals(f, res->f_defects, sizeof(DBL_TYPE), n)
+      && ERR_OK == read_array(f, (void **) &(res->breaks), sizeof(int),
+        &n_breaks)
+      && ERR_OK == read_vals(f, &(res->pfunc), sizeof(DBL_TYPE), 1)
+      && ERR_OK == read_vals(f, &(res->time), sizeof(DBL_TYPE), 1)
+      && ERR_OK == read_array(f, (void **) &(res->ppairs), sizeof(DBL_TYPE),
+        &n_ppairs)
+      && ERR_OK == read_array(f, (void **) &(res->ppairs_i), sizeof(int),
+        &n_ppairs)
+      && ERR_OK == read_array(f, (void **) &(res->ppairs_j), sizeof(int),
+        &n_ppairs)
+      && ERR_OK == read_vals(f, &(res->defect), sizeof(DBL_TYPE), 1)
+      && ERR_OK == read_vals(f, &has_tree, sizeof(int), 1),
+      "Error reading structure result");
+  res->n_breaks = n_breaks;
+  res->ppairs_n = n_ppairs;
+  res->ppairs_cap = n_ppairs;
+
+  if (has_tree) {
+    res->tree = read_result_tree(f);
+    check(res->tree, "Error reading structure result");
+  }
+  return ERR_OK;
+error:
+  return ERR_INVALID_STATE;
+}
+/***********************************************************/
+
+/***********************************************************/
+static int write_result_tube(FILE * f, result_tube_t * tube) {
+  int n = tube->n_strucs;
+  check(ERR_OK == write_vals(f, &n, sizeof(int), 1)
+      && ERR_OK == write_vals(f, tube->x, sizeof(DBL_TYPE), n)
+      && ERR_OK == write_vals(f, tube->target_x, sizeof(DBL_TYPE), n)
+      && ERR_OK == write_vals(f, tube->target, sizeof(int), n)
+      && ERR_OK == write_vals(f, tube->included, sizeof(int), n)
+      && ERR_OK == write_vals(f, tube->included_ind, sizeof(int), n)
+      && ERR_OK == write_vals(f, tube->generated_ind, sizeof(int), n)
+      && ERR_OK == write_vals(f, &(tube->defect), sizeof(DBL_TYPE), 1),
+      "Error writing tube result");
+  return ERR_OK;
+error:
+  return ERR_INVALID_STATE;
+}
+
+static int read_result_tube(FILE * f, result_tube_t * tube) {
+  int n;
+  check(ERR_OK == read_vals(f, &n, sizeof(int), 1) && n >= 0,
+      "Error reading tube result");
+  tube->n_strucs = n;
+  tube->cap_strucs = n;
+  if (n == 0) n = 1;
+  tube->x = (DBL_TYPE *) malloc(n * sizeof(DBL_TYPE));
+  tube->target_x = (DBL_TYPE *) malloc(n * sizeof(DBL_TYPE));
+  tube->target = (int *) malloc(n * sizeof(int));
+  tube->included = (int *) malloc(n * sizeof(int));
+  tube->included_ind = (int *) malloc(n * sizeof(int));
+  tube->generated_ind = (int *) malloc(n * sizeof(int));
+  check_mem(tube->x);
+  check_mem(tube->target_x);
+  check_mem(tube->target);
+  check_mem(tube->included);
+  check_mem(tube->included_ind);
+  check_mem(tube->generated_ind);
+
+  n = tube->n_strucs;
+  check(ERR_OK == read_vals(f, tube->x, sizeof(DBL_TYPE), n)
+      && ERR_OK == read_vals(f, tube->target_x, sizeof(DBL_TYPE), n)
+      && ERR_OK == read_vals(f, tube->target, sizeof(int), n)
+      && ERR_OK == read_vals(f, tube->included, sizeof(int), n)
+      && ERR_OK == read_vals(f, tube->included_ind, sizeof(int), n)
+      && ERR_OK == read_vals(f, tube->generated_ind, sizeof(int), n)
+      && ERR_OK == read_vals(f, &(tube->defect), sizeof(DBL_TYPE), 1),
+      "Error reading tube result");
+  return ERR_OK;
+error:
+  return ERR_INVALID_STATE;
+}
+/***********************************************************/
+
+/***********************************************************/
+int write_result(FILE * f, result_t * res) {
+  int i;
+  int n_ords = res->n_orderings;
+  int has_offtarget = res->offtarget_seqs != NULL;
+
+  check(ERR_OK == write_vals(f, &(res->n_strucs), sizeof(int), 1),
+      "Error writing result");
+  for (i = 0; i < res->n_strucs; i++) {
+    check(ERR_OK == write_result_struc(f, res->strucs + i),
+        "Error writing result");
+  }
+  check(ERR_OK == write_vals(f, &(res->n_tubes), sizeof(int), 1),
+      "Error writing result");
+  for (i = 0; i < res->n_tubes; i++) {
+    check(ERR_OK == write_result_tube(f, res->tubes + i),
+        "Error writing result");
+  }
+
+  check(ERR_OK == write_vals(f, &n_ords, sizeof(int), 1),
+      "Error writing result");
+  for (i = 0; i < n_ords; i++) {
+    check(ERR_OK == write_array(f, res->orderings[i], sizeof(int),
+          res->n_strands[i]), "Error writing result");
+  }
+  check(ERR_OK == write_vals(f, res->dG, sizeof(DBL_TYPE), n_ords)
+      && ERR_OK == write_vals(f, res->eval_time, sizeof(DBL_TYPE), n_ords)
+      && ERR_OK == write_vals(f, res->included, sizeof(int), n_ords)
+      && ERR_OK == write_vals(f, res->pruned, sizeof(int), n_ords)
+      && ERR_OK == write_vals(f, res->order_len, sizeof(int), n_ords)
+      && ERR_OK == write_vals(f, res->struc_map, sizeof(int), n_ords)
+      && ERR_OK == write_vals(f, &(res->total_defect), sizeof(DBL_TYPE), 1)
+      && ERR_OK == write_vals(f, &(res->elapsed_time), sizeof(DBL_TYPE), 1)
+      && ERR_OK == write_vals(f, &(res->root_time), sizeof(DBL_TYPE), 1)
+      && ERR_OK == write_vals(f, &(res->tot_n_strands), sizeof(int), 1)
+      && ERR_OK == write_vals(f, &(res->id), sizeof(int), 1)
+      && ERR_OK == write_vals(f, &has_offtarget, sizeof(int), 1),
+      "Error writing result");
+  // evaluate_undesired() skips the orderings whose strands match these
+  if (has_offtarget) {
+    check(ERR_OK == write_seqstate(f, res->offtarget_seqs),
+        "Error writing result");
+  }
+  return ERR_OK;
+error:
+  return ERR_INVALID_STATE;
+}
+
+// replaces res, which must have been initialized, by the saved result
+int read_result(FILE * f, result_t * res, design_spec_t * spec) {
+  int i, n, n_ords, has_offtarget;
+
+  free_result(res);
+  res->offtarget_seqs = NULL;
+
+  check(ERR_OK == read_vals(f, &n, sizeof(int), 1) && n >= 0,
+      "Error reading result");
+  res->strucs = (result_struc_t *) malloc(sizeof(result_struc_t) *
+      (n > 0 ? n : 1));
+  check_mem(res->strucs);
+  res->cap_strucs = n;
+  for (i = 0; i < n; i++) {
+    init_result_struc(res->strucs + i);
+    res->n_strucs = i + 1;
+    check(ERR_OK == read_result_struc(f, res->strucs + i),
+        "Error reading result");
+  }
+
+  check(ERR_OK == read_vals(f, &n, sizeof(int), 1) && n > 0,
+      "Error reading result");
+  res->tubes = (result_tube_t *) malloc(sizeof(result_tube_t) * n);
+  check_mem(res->tubes);
+  res->cap_tubes = n;
+  for (i = 0; i < n; i++) {
+    init_result_tube(res->tubes + i);
+    res->n_tubes = i + 1;
+    check(ERR_OK == read_result_tube(f, res->tubes + i),
+        "Error reading result");
+  }
+
+  check(ERR_OK == read_vals(f, &n_ords, sizeof(int), 1)
+      && n_ords == spec->n_orderings, "Checkpoint does not match the design");
+  res->orderings = (int **) calloc(n_ords, sizeof(int *));
+  res->n_strands = (int *) malloc(n_ords * sizeof(int));
+  res->dG = (DBL_TYPE *) malloc(n_ords * sizeof(DBL_TYPE));
+  res->eval_time = (DBL_TYPE *) malloc(n_ords * sizeof(DBL_TYPE));
+  res->included = (int *) malloc(n_ords * sizeof(int));
+  res->pruned = (int *) malloc(n_ords * sizeof(int));
+  res->order_len = (int *) malloc(n_ords * sizeof(int));
+  res->struc_map = (int *) malloc(n_ords * sizeof(int));
+  check_mem(res->orderings);
+  check_mem(res->n_strands);
+  check_mem(res->dG);
+  check_mem(res->eval_time);
+  check_mem(res->included);
+  check_mem(res->pruned);
+  check_mem(res->order_len);
+  check_mem(res->struc_map);
+  res->n_orderings = n_ords;
+  res->cap_orderings = n_ords;
+
+  for (i = 0; i < n_ords; i++) {
+    check(ERR_OK == read_array(f, (void **) (res->orderings + i), sizeof(int),
+          res->n_strands + i), "Error reading result");
+  }
+  check(ERR_OK == read_vals(f, res->dG, sizeof(DBL_TYPE), n_ords)
+      && ERR_OK == read_vals(f, res->eval_time, sizeof(DBL_TYPE), n_ords)
+      && ERR_OK == read_vals(f, res->included, sizeof(int), n_ords)
+      && ERR_OK == read_vals(f, res->pruned, sizeof(int), n_ords)
+      && ERR_OK == read_vals(f, res->order_len, sizeof(int), n_ords)
+      && ERR_OK == read_vals(f, res->struc_map, sizeof(int), n_ords)
+      && ERR_OK == read_vals(f, &(res->total_defect), sizeof(DBL_TYPE), 1)
+      && ERR_OK == read_vals(f, &(res->elapsed_time), sizeof(DBL_TYPE), 1)
+      && ERR_OK == read_vals(f, &(res->root_time), sizeof(DBL_TYPE), 1)
+      && ERR_OK == read_vals(f, &(res->tot_n_strands), sizeof(int), 1)
+      && ERR_OK == read_vals(f, &(res->id), sizeof(int), 1)
+      && ERR_OK == read_vals(f, &has_offtarget, sizeof(int), 1),
+      "Error reading result");
+
+  if (has_offtarget) {
+    res->offtarget_seqs = (seqstate_t *) malloc(sizeof(seqstate_t));
+    check_mem(res->offtarget_seqs);
+    init_seqstate(res->offtarget_seqs, spec);
+    check(ERR_OK == read_seqstate(f, res->offtarget_seqs),
+        "Error reading result");
+  }
+  return ERR_OK;
+error:
+  return ERR_INVALID_STATE;
+}
+/***********************************************************/
+
+/***********************************************************/
+static int write_struc_tree(FILE * f, struc_tree_t * tree) {
+  int i_ch, n_els;
+  split_list_t * l;
+  split_el_t * el;
+
+  check(ERR_OK == write_array(f, tree->seg_start, sizeof(int),
+        tree->n_segments)
+      && ERR_OK == write_array(f, tree->seg_stop, sizeof(int),
+        tree->n_segments)
+      && ERR_OK == write_array(f, tree->assumed_i, sizeof(int),
+        tree->n_assumed)
+      && ERR_OK == write_array(f, tree->assumed_j, sizeof(int),
+        tree->n_assumed)
+      && ERR_OK == write_vals(f, &(tree->forbidden->n), sizeof(int), 1),
+      "Error writing decomposition");
+
+  for (l = tree->forbidden->head; l; l = l->next) {
+    n_els = 0;
+    for (el = l->head; el; el = el->next) n_els++;
+    check(ERR_OK == write_vals(f, &(l->cost), sizeof(double), 1)
+        && ERR_OK == write_vals(f, &(l->ppair), sizeof(double), 1)
+        && ERR_OK == write_vals(f, &n_els, sizeof(int), 1),
+        "Error writing decomposition");
+    for (el = l->head; el; el = el->next) {
+      check(ERR_OK == write_vals(f, &(el->lsplit), sizeof(int), 1)
+          && ERR_OK == write_vals(f, &(el->rsplit), sizeof(int), 1),
+          "Error writing decomposition");
+    }
+  }
+
+  check(ERR_OK == write_vals(f, &(tree->n_children), sizeof(int), 1),
+      "Error writing decomposition");
+  for (i_ch = 0; i_ch < tree->n_children; i_ch++) {
+    check(ERR_OK == write_struc_tree(f, tree->children[i_ch]),
+        "Error writing decomposition");
+  }
+  return ERR_OK;
+error:
+  return ERR_INVALID_STATE;
+}
+
+static struc_tree_t * read_struc_tree(FILE * f) {
+  struc_tree_t * tree = NULL;
+  int * seg_start = NULL;
+  int * seg_stop = NULL;
+  int * assumed_i = NULL;
+  int * assumed_j = NULL;
+  int n_segs, n_assumed, n_lists, n_els, n, i, j;
+  split_list_t l;
+  split_el_t el;
+
+  init_split_list(&l);
+  check(ERR_OK == read_array(f, (void **) &seg_start, sizeof(int), &n_segs)
+      && ERR_OK == read_array(f, (void **) &seg_stop, sizeof(int), &n)
+      && n == n_segs && n_segs > 0
+      && ERR_OK == read_array(f, (void **) &assumed_i, sizeof(int), &n_assumed)
+      && ERR_OK == read_array(f, (void **) &assumed_j, sizeof(int), &n)
+      && n == n_assumed,
+      "Error reading decomposition");
+
+  tree = alloc_struc_tree(n_segs, seg_start, seg_stop,
+      n_assumed, assumed_i, assumed_j);
+  check(tree, "Error reading decomposition");
+
+  check(ERR_OK == read_vals(f, &n_lists, sizeof(int), 1),
+      "Error reading decomposition");
+  for (i = 0; i < n_lists; i++) {
+    check(ERR_OK == read_vals(f, &(l.cost), sizeof(double), 1)
+        && ERR_OK == read_vals(f, &(l.ppair), sizeof(double), 1)
+        && ERR_OK == read_vals(f, &n_els, sizeof(int), 1),
+        "Error reading decomposition");
+    for (j = 0; j < n_els; j++) {
+      check(ERR_OK == read_vals(f, &(el.lsplit), sizeof(int), 1)
+          && ERR_OK == read_vals(f, &(el.rsplit), sizeof(int), 1)
+          && ERR_OK == append_split_list(&l, &el),
+          "Error reading decomposition");
+    }
+    check(ERR_OK == append_split_tracker(tree->forbidden, &l, NULL),
+        "Error reading decomposition");
+    free_split_list(&l);
+    init_split_list(&l);
+  }
+
+  check(ERR_OK == read_vals(f, &n, sizeof(int), 1),
+      "Error reading decomposition");
+  tree->children = (struc_tree_t **) malloc(sizeof(struc_tree_t *) *
+      (n > 0 ? n : 1));
+  check_mem(tree->children);
+  for (i = 0; i < n; i++) {
+    tree->children[i] = read_struc_tree(f);
+    check(tree->children[i], "Error reading decomposition");
+    tree->n_children++;
+  }
+
+  free(seg_start);
+  free(seg_stop);
+  free(assumed_i);
+  free(assumed_j);
+  return tree;
+error:
+  free_split_list(&l);
+  free(seg_start);
+  free(seg_stop);
+  free(assumed_i);
+  free(assumed_j);
+  free_struc_tree(tree);
+  return NULL;
+}
+
+/*
+ * The spec changes during the design by the off-target orderings that are
+ * added as structures and by the decompositions of all the structures.
+ */
+int write_spec_state(FILE * f, design_spec_t * spec) {
+  int i_struc, i_ord, c_ord;
+
+  check(ERR_OK == write_vals(f, &(spec->n_strucs), sizeof(int), 1),
+      "Error writing design state");
+  for (i_struc = 0; i_struc < spec->n_strucs; i_struc++) {
+    c_ord = -1;
+    for (i_ord = 0; i_ord < spec->n_orderings; i_ord++) {
+      if (spec->struc_map[i_ord] == i_struc) c_ord = i_ord;
+    }
+    check(ERR_OK == write_vals(f, &c_ord, sizeof(int), 1),
+        "Error writing design state");
+  }
+  for (i_struc = 0; i_struc < spec->n_strucs; i_struc++) {
+    check(ERR_OK == write_struc_tree(f, spec->strucs[i_struc].tree),
+        "Error writing design state");
+  }
+  return ERR_OK;
+error:
+  return ERR_INVALID_STATE;
+}
+
+int read_spec_state(FILE * f, design_spec_t * spec) {
+  int n_strucs, i_struc, i_ord, c_ord;
+  struc_tree_t * tree;
+
+  check(ERR_OK == read_vals(f, &n_strucs, sizeof(int), 1)
+      && n_strucs >= spec->n_strucs,
+      "Checkpoint does not match the design");
+  for (i_struc = 0; i_struc < n_strucs; i_struc++) {
+    check(ERR_OK == read_vals(f, &c_ord, sizeof(int), 1),
+        "Error reading design state");
+    if (i_struc < spec->n_strucs) {
+      for (i_ord = 0; i_ord < spec->n_orderings; i_ord++) {
+        check((spec->struc_map[i_ord] == i_struc) == (i_ord == c_ord),
+            "Checkpoint does not match the design");
+      }
+    } else {
+      check(c_ord >= 0 && c_ord < spec->n_orderings
+          && spec->struc_map[c_ord] == -1,
+          "Checkpoint does not match the design");
+      check(ERR_OK == add_offtarget_structure(spec, c_ord),
+          "Error adding ordering %i", c_ord);
+    }
+  }
+  for (i_struc = 0; i_struc < n_strucs; i_struc++) {
+    tree = read_struc_tree(f);
+    check(tree, "Error reading design state");
+    free_struc_tree(spec->strucs[i_struc].tree);
+    spec->strucs[i_struc].tree = tree;
+  }
+  return ERR_OK;
+error:
+  return ERR_INVALID_STATE;
+}
+/***********************************************************/
+
+/***********************************************************/
+int write_rng_state(FILE * f) {
+  int n = (int) genrand_state_length();
+  unsigned long * state = (unsigned long *) malloc(n * sizeof(unsigned long));
+  check_mem(state);
+  genrand_save_state(state);
+  check(ERR_OK == write_array(f, state, sizeof(unsigned long), n),
+      "Error writing random state");
+  free(state);
+  return ERR_OK;
+error:
+  free(state);
+  return ERR_INVALID_STATE;
+}
+
+int read_rng_state(FILE * f) {
+  int n = (int) genrand_state_length();
+  unsigned long * state = (unsigned long *) malloc(n * sizeof(unsigned long));
+  check_mem(state);
+  check(ERR_OK == read_array_into(f, state, sizeof(unsigned long), n),
+      "Error reading random state");
+  genrand_init_state(state);
+  free(state);
+  return ERR_OK;
+error:
+  free(state);
+  return ERR_INVALID_STATE;
+}
+
+int write_checkpoint_vals(FILE * f, const void * vals, size_t size, int n) {
+  return write_vals(f, vals, size, n);
+}
+
+int read_checkpoint_vals(FILE * f, void * vals, size_t size, int n) {
+  return read_vals(f, vals, size, n);
+}
+/***********************************************************/
@@ -1,5 +1,12 @@
+/* fork, pipe, waitpid, sysconf (the build uses -std=c99) */
+#define _XOPEN_SOURCE 700
+
 #include "pathway_design.h"
 
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
 static int perturb_sequences(
       seqstate_t * seqs,
       result_t * res,
@@ -587,6 +594,256 @@ error:
   return ERR_OOM;
 }
 
+/***********************************************************/
+// One off-target ordering evaluated by evaluate_ordering(), far smaller
+// than PIPE_BUF so that concurrent workers can share one pipe
+typedef struct OFFTARGET_RECORD_T_ {
+  int i_comp;
+  int pruned;
+  DBL_TYPE dG;
+  DBL_TYPE eval_time;
+} offtarget_record_t;
+
+static void fill_ordering_seq(int * cur_seq, int i_comp, result_t * res,
+    seqstate_t * seqs) {
+  int m_strs = res->n_strands[i_comp];
+  int i_str, c_str, i_nuc, n_nucs;
+  int j_nuc = 0;
+
+  for (i_str = 0; i_str < m_strs; i_str++) {
+    c_str = res->orderings[i_comp][i_str];
+    n_nucs = seqs->strands.seqs[c_str].n;
+    for (i_nuc = 0; i_nuc < n_nucs; i_nuc++) {
+      cur_seq[i_nuc + j_nuc] = seqs->strands.seqs[c_str].nucs[i_nuc];
+    }
+    cur_seq[i_nuc + j_nuc] = STRAND_PLUS;
+    j_nuc += n_nucs + 1;
+  }
+  cur_seq[j_nuc - 1] = -1;
+}
+
+/*
+ * get_offtarget_weights
+ * The concentration of an ordering is at most exp(-dG) times the product
+ * of the total concentrations of its strands.  To first order each strand
+ * it takes from a tube costs one copy of the largest target holding that
+ * strand, so weights[i_comp] * exp(-dG) bounds the share of any tube
+ * defect the ordering can take, weights[i_comp] being the largest
+ * sum(target_nucs) * prod(x_strand) / nuc_conc over the tubes holding it.
+ */
+static int get_offtarget_weights(DBL_TYPE * weights, result_t * res,
+    design_spec_t * spec) {
+  int n_strs = spec->seqs.strands.n;
+  int i_tube, i_struc, g_struc, i_str, c_str;
+  DBL_TYPE nuc_conc, conc, n_lost;
+  DBL_TYPE * strand_x = (DBL_TYPE *) malloc(n_strs * sizeof(DBL_TYPE));
+  int * target_nucs = (int *) malloc(n_strs * sizeof(int));
+  check_mem(strand_x);
+  check_mem(target_nucs);
+
+  for (g_struc = 0; g_struc < res->n_orderings; g_struc++) {
+    weights[g_struc] = 0;
+  }
+
+  for (i_tube = 0; i_tube < res->n_tubes; i_tube++) {
+    result_tube_t * tube = res->tubes + i_tube;
+    for (i_str = 0; i_str < n_strs; i_str++) {
+      strand_x[i_str] = 0;
+      target_nucs[i_str] = 0;
+    }
+    nuc_conc = 0;
+    for (i_struc = 0; i_struc < tube->n_strucs; i_struc++) {
+      if (tube->target_x[i_struc] <= 0) {
+        continue;
+      }
+      g_struc = tube->generated_ind[i_struc];
+      nuc_conc += res->order_len[g_struc] * tube->target_x[i_struc];
+      for (i_str = 0; i_str < res->n_strands[g_struc]; i_str++) {
+        c_str = res->orderings[g_struc][i_str];
+        strand_x[c_str] += tube->target_x[i_struc];
+        if (res->order_len[g_struc] > target_nucs[c_str]) {
+          target_nucs[c_str] = res->order_len[g_struc];
+        }
+      }
+    }
+    if (nuc_conc <= 0) {
+      continue;
+    }
+
+    for (i_struc = 0; i_struc < tube->n_strucs; i_struc++) {
+      g_struc = tube->generated_ind[i_struc];
+      conc = 1;
+      n_lost = 0;
+      for (i_str = 0; i_str < res->n_strands[g_struc]; i_str++) {
+        c_str = res->orderings[g_struc][i_str];
+        conc *= strand_x[c_str];
+        n_lost += target_nucs[c_str];
+      }
+      if (conc * n_lost / nuc_conc > weights[g_struc]) {
+        weights[g_struc] = conc * n_lost / nuc_conc;
+      }
+    }
+  }
+
+  free(target_nucs);
+  free(strand_x);
+  return ERR_OK;
+error:
+  free(target_nucs);
+  free(strand_x);
+  return ERR_OOM;
+}
+
+/*
+ * evaluate_ordering
+ * With pruning on, the mfe of the ordering less PRUNE_MFE_MARGIN per
+ * nucleotide stands in for its free energy whenever the concentration that
+ * implies cannot move a tube defect by prune_tol; otherwise the partition
+ * function is computed.  The margin is a heuristic, so the estimate is no
+ * bound: pruned orderings are marked, evaluated again by the next
+ * evaluate_undesired, and exactly by reevaluate_pruned at the end.
+ */
+static void evaluate_ordering(offtarget_record_t * rec, int i_comp,
+    int * cur_seq, DBL_TYPE weight, result_t * res, seqstate_t * seqs,
+    design_spec_t * spec) {
+  struct timeval starttime;
+  struct timeval endtime;
+  dnaStructures mfe_structs = {NULL, 0, 0, 0, NAD_INFINITY};
+  DBL_TYPE kT = kB * spec->opts.temperature;
+  DBL_TYPE mfe;
+  DBL_TYPE cur_pfunc;
+
+  gettimeofday(&starttime, NULL);
+  fill_ordering_seq(cur_seq, i_comp, res, seqs);
+
+  rec->i_comp = i_comp;
+  rec->pruned = 0;
+  if (spec->opts.prune_tol >= 0) {
+    mfe = mfeFullWithSym(cur_seq, res->order_len[i_comp], &mfe_structs, 3,
+        spec->opts.material, spec->opts.dangle_type,
+        spec->opts.temperature - ZERO_C_IN_KELVIN, spec->symmetry[i_comp], 1,
+        spec->opts.sodium, spec->opts.magnesium, spec->opts.use_long_helix);
+    clearDnaStructures(&mfe_structs);
+
+    rec->dG = (mfe - PRUNE_MFE_MARGIN * res->order_len[i_comp]) / kT;
+    rec->pruned = weight * EXP_FUNC(-rec->dG) < spec->opts.prune_tol;
+  }
+
+  if (!rec->pruned) {
+    cur_pfunc = pfuncFull(cur_seq, 3, spec->opts.material, 
+        spec->opts.dangle_type, 
+        spec->opts.temperature - ZERO_C_IN_KELVIN, 0, 
+        spec->opts.sodium, 
+        spec->opts.magnesium, spec->opts.use_long_helix);
+    cur_pfunc /= spec->symmetry[i_comp];
+    rec->dG = - LOG_FUNC(cur_pfunc);
+  }
+
+  gettimeofday(&endtime, NULL);
+  rec->eval_time = (endtime.tv_sec - starttime.tv_sec) 
+    + 1e-6 * (endtime.tv_usec - starttime.tv_usec);
+}
+
+static void store_ordering(result_t * res, offtarget_record_t * rec) {
+  res->eval_time[rec->i_comp] = rec->eval_time;
+  res->dG[rec->i_comp] = rec->dG;
+  res->included[rec->i_comp] = 1;
+  res->pruned[rec->i_comp] = rec->pruned;
+}
+
+/*
+ * evaluate_orderings
+ * Evaluate the n_todo orderings in todo.  The partition function code
+ * keeps its state in globals, so the orderings are split round-robin over
+ * forked workers (n_jobs, 0 for one per cpu) that send back one record
+ * per ordering.  Returns the number of orderings pruned in *n_pruned.
+ */
+static int evaluate_orderings(int * todo, int n_todo, int * cur_seq,
+    DBL_TYPE * weights, int * n_pruned, result_t * res, seqstate_t * seqs,
+    design_spec_t * spec) {
+  int fds[2] = {-1, -1};
+  int n_jobs = spec->opts.n_jobs;
+  int w, k, status;
+  int n_done = 0;
+  pid_t * workers = NULL;
+  offtarget_record_t rec;
+
+  *n_pruned = 0;
+  if (n_jobs <= 0) {
+    n_jobs = (int) sysconf(_SC_NPROCESSORS_ONLN);
+  }
+  if (n_jobs > n_todo) {
+    n_jobs = n_todo;
+  }
+
+  if (n_jobs <= 1) {
+    for (k = 0; k < n_todo; k++) {
+      evaluate_ordering(&rec, todo[k], cur_seq, 
+          weights ? weights[todo[k]] : 0, res, seqs, spec);
+      store_ordering(res, &rec);
+      *n_pruned += rec.pruned;
+    }
+    return ERR_OK;
+  }
+
+  check(pipe(fds) == 0, "Unable to create off-target pipe");
+  workers = (pid_t *) malloc(n_jobs * sizeof(pid_t));
+  check_mem(workers);
+  fflush(NULL);
+
+  for (w = 0; w < n_jobs; w++) {
+    workers[w] = fork();
+    check(workers[w] >= 0, "Unable to start off-target worker %i", w);
+    if (workers[w] == 0) {
+      close(fds[0]);
+      for (k = w; k < n_todo; k += n_jobs) {
+        evaluate_ordering(&rec, todo[k], cur_seq, 
+            weights ? weights[todo[k]] : 0, res, seqs, spec);
+        if (write(fds[1], &rec, sizeof(rec)) != (ssize_t) sizeof(rec)) {
+          _exit(1);
+        }
+      }
+      close(fds[1]);
+      _exit(0);
+    }
+  }
+
+  close(fds[1]);
+  fds[1] = -1;
+  while (read(fds[0], &rec, sizeof(rec)) == (ssize_t) sizeof(rec)) {
+    store_ordering(res, &rec);
+    *n_pruned += rec.pruned;
+    n_done++;
+  }
+  close(fds[0]);
+  fds[0] = -1;
+
+  for (w = 0; w < n_jobs; w++) {
+    waitpid(workers[w], &status, 0);
+  }
+  free(workers);
+  workers = NULL;
+
+  check(n_done == n_todo, "Only %i of %i off-target orderings completed",
+      n_done, n_todo);
+  return ERR_OK;
+error:
+  // closing the read end first stops any worker already started
+  if (fds[0] >= 0) {
+    close(fds[0]);
+  }
+  if (fds[1] >= 0) {
+    close(fds[1]);
+  }
+  if (workers) {
+    for (k = 0; k < w; k++) {
+      waitpid(workers[k], &status, 0);
+    }
+  }
+  free(workers);
+  return ERR_INVALID_STATE;
+}
+
 int evaluate_undesired(
     result_t * res, 
     seqstate_t * seqs,
@@ -598,9 +855,10 @@ int evaluate_undesired(
   int i_str;
   int c_str;
   int * cur_seq = NULL;
+  int * todo = NULL;
+  DBL_TYPE * weights = NULL;
   int n_nucs;
   int i_nuc;
-  int j_nuc;
   int strs_eq;
 
   int n_comps = res->n_orderings;
@@ -608,10 +866,8 @@ int evaluate_undesired(
   int maxsize = 0;
   int cursize = 0;
   int n_eval = 0;
+  int n_pruned = 0;
 
-  struct timeval starttime;
-  struct timeval endtime;
-  DBL_TYPE cur_pfunc = 0;
   design_state_t state;
   seqstate_t * old_seqs = res->offtarget_seqs;
 
@@ -659,53 +915,50 @@ int evaluate_undesired(
     if (cursize > maxsize) {
       maxsize = cursize;
     }
+    res->order_len[i_comp] = cursize - m_strs;
   }
   check(maxsize > 0, "maxsize is invalid %i", maxsize);
   cur_seq = (int*) malloc(maxsize * sizeof(int));
-
+  todo = (int*) malloc(n_comps * sizeof(int));
+  check_mem(cur_seq);
+  check_mem(todo);
 
   for (i_comp = 0; i_comp < n_comps; i_comp++) {
     // For each undesired complex (ordering in struc_map == -1)
     m_strs = res->n_strands[i_comp];
-    j_nuc = 0;
     strs_eq = 1;
-    // Construct the full sequence
     for (i_str = 0; i_str < m_strs; i_str++) {
       c_str = res->orderings[i_comp][i_str];
-      n_nucs = seqs->strands.seqs[c_str].n;
-      for (i_nuc = 0; i_nuc < n_nucs; i_nuc++) {
-        cur_seq[i_nuc + j_nuc] = seqs->strands.seqs[c_str].nucs[i_nuc];
-      }
-
       strs_eq = strs_eq && old_seqs_same[c_str];
-
-      cur_seq[i_nuc + j_nuc] = STRAND_PLUS;
-      j_nuc += n_nucs + 1;
     }
-    cur_seq[j_nuc - 1] = -1;
-    res->order_len[i_comp] = j_nuc - m_strs;
 
+    // an estimate from pruning is never kept as current
+    strs_eq = strs_eq && !res->pruned[i_comp];
+
+    if (res->struc_map[i_comp] < 0) {
+      count_offtarget_eval(!strs_eq);
+    }
     if ((!strs_eq) && res->struc_map[i_comp] < 0) {
-      // Evaluate the partition function
-      gettimeofday(&starttime,NULL);
-
-      cur_pfunc = pfuncFull(cur_seq, 3, spec->opts.material, 
-          spec->opts.dangle_type, 
-          spec->opts.temperature - ZERO_C_IN_KELVIN, 0, 
-          spec->opts.sodium, 
-          spec->opts.magnesium, spec->opts.use_long_helix);
+      todo[n_eval] = i_comp;
       n_eval ++;
-      cur_pfunc /= spec->symmetry[i_comp];
-
-      gettimeofday(&endtime,NULL);
+    }
+  }
 
-      res->eval_time[i_comp] = (endtime.tv_sec - starttime.tv_sec) 
-        + 1e-6 * (endtime.tv_usec - starttime.tv_usec);
+  if (n_eval > 0 && spec->opts.prune_tol >= 0) {
+    weights = (DBL_TYPE *) malloc(n_comps * sizeof(DBL_TYPE));
+    check_mem(weights);
+    check(ERR_OK == get_offtarget_weights(weights, res, spec),
+        "Error bounding off-target concentrations");
+  }
 
-      // Set included = 1
-      res->dG[i_comp] = - LOG_FUNC(cur_pfunc);
-      res->included[i_comp] = 1;
-    }
+  if (n_eval > 0) {
+    check(ERR_OK == evaluate_orderings(todo, n_eval, cur_seq, weights,
+          &n_pruned, res, seqs, spec),
+        "Error evaluating off-target orderings");
+  }
+  if (n_pruned > 0) {
+    count_offtarget_pruned(n_pruned);
+    debug("Pruned %i of %i undesired orderings", n_pruned, n_eval);
   }
 
   if (!res->offtarget_seqs) {
@@ -722,15 +975,55 @@ int evaluate_undesired(
 
   free_states(&state);
 
+  free(weights);
+  free(todo);
   free(cur_seq);
   free(old_seqs_same);
   return ERR_OK;
 error:
+  free_states(&state);
+  free(weights);
+  free(todo);
   free(cur_seq);
   free(old_seqs_same);
   return ERR_INVALID_STATE;
 }
 
+/*
+ * reevaluate_pruned
+ * Replace the estimates left by --prune with partition functions, so that
+ * the reported design is evaluated exactly.
+ */
+static int reevaluate_pruned(
+    result_t * res,
+    seqstate_t * seqs,
+    design_spec_t * spec) {
+  design_state_t tempstate;
+  DBL_TYPE prune_tol = spec->opts.prune_tol;
+  int i_comp;
+  int n_pruned = 0;
+
+  for (i_comp = 0; i_comp < res->n_orderings; i_comp++) {
+    n_pruned += res->pruned[i_comp];
+  }
+  if (n_pruned == 0) return ERR_OK;
+  debug("Re-evaluating %i pruned orderings", n_pruned);
+
+  spec->opts.prune_tol = -1;
+  init_states(&tempstate, spec);
+  check(ERR_OK == evaluate_undesired(res, seqs, spec),
+      "Error evaluating undesired complexes");
+  check(ERR_OK == update_result(res, &tempstate, seqs, spec),
+      "Error updating result");
+  free_states(&tempstate);
+  spec->opts.prune_tol = prune_tol;
+  return ERR_OK;
+error:
+  free_states(&tempstate);
+  spec->opts.prune_tol = prune_tol;
+  return ERR_INVALID_STATE;
+}
+
 static int get_tubes_satisfied(
     result_t * res, 
     result_t * res_deflated,
@@ -755,34 +1048,13 @@ static int add_undesired_ordering(
       seqstate_t * seqs,
       int i_comp
     ) {
-  int n_strs = spec->n_strands[i_comp];
-  int i_str;
-  int c_str;
-  int n_doms = 0;
-
-  int * cur_strs = spec->orderings[i_comp];
-  int * dom_struc = NULL;
   struc_state_t state;
   int i_struc = spec->n_strucs;
-  int i_dom;
   result_struc_t res_struc;
   init_result_struc(&res_struc);
 
-  for (i_str = 0; i_str < n_strs; i_str++) {
-    c_str = cur_strs[i_str];
-    n_doms += spec->seqs.strands.specs[c_str].n;
-  }
-  check(n_doms > 0, "N doms must be > 0 %i", n_doms);
-
-  dom_struc = (int*) malloc(n_doms * sizeof(int));
-
-  for (i_dom = 0; i_dom < n_doms; i_dom++) {
-    dom_struc[i_dom] = -1;
-  }
-
-  add_structure(spec, "::gen", spec->orderings[i_comp],
-      spec->n_strands[i_comp], dom_struc, n_doms);
-  spec->strucs[i_struc].modifiable = 1;
+  check(ERR_OK == add_offtarget_structure(spec, i_comp),
+      "Error adding ordering %i", i_comp);
   init_struc_state(&state, spec->strucs + i_struc);
   debug("Evaluating structure");
   // Update the structure result
@@ -797,12 +1069,10 @@ static int add_undesired_ordering(
 
   free_struc_state(&state);
   free_result_struc(&res_struc);
-  free(dom_struc);
 
   return ERR_OK;
 error:
   free_result_struc(&res_struc);
-  free(dom_struc);
   return ERR_OOM;
 }
 
@@ -969,6 +1239,151 @@ static DBL_TYPE get_tube_defects(
   return cur_defect;
 }
 
+static const char checkpoint_magic[] = "tubedesign checkpoint 4";
+
+static char * get_checkpoint_fn(design_spec_t * spec, const char * suffix) {
+  const char * prefix = spec->opts.file_prefix ? spec->opts.file_prefix : "";
+  int fn_len = strlen(prefix) + strlen(".checkpoint") + strlen(suffix) + 1;
+  char * fn = (char *) malloc(fn_len * sizeof(char));
+  if (fn) snprintf(fn, fn_len, "%s.checkpoint%s", prefix, suffix);
+  return fn;
+}
+
+/*
+ * Saves what optimize_tubes carries from one refocusing step to the next.
+ * The file is written aside and renamed over the previous checkpoint, so
+ * that a design killed while writing keeps the previous one.
+ */
+static int save_tube_checkpoint(
+      design_spec_t * spec,
+      result_t ** results, int n_results,
+      seqstate_t ** seqs, int n_seqs,
+      DBL_TYPE * vals, int n_vals
+    ) {
+  char * fn = get_checkpoint_fn(spec, "");
+  char * tmp_fn = get_checkpoint_fn(spec, ".tmp");
+  FILE * f = NULL;
+  int n_nucs = spec->seqs.nucs.n;
+  int i;
+
+  check_mem(fn);
+  check_mem(tmp_fn);
+  f = fopen(tmp_fn, "wb");
+  check(f, "Unable to write %s", tmp_fn);
+
+  check(ERR_OK == write_checkpoint_vals(f, checkpoint_magic,
+        sizeof(checkpoint_magic), 1)
+      && ERR_OK == write_checkpoint_vals(f, &(spec->opts.seed),
+        sizeof(unsigned int), 1)
+      && ERR_OK == write_checkpoint_vals(f, &n_nucs, sizeof(int), 1)
+      && ERR_OK == write_rng_state(f)
+      && ERR_OK == write_checkpoint_vals(f, vals, sizeof(DBL_TYPE), n_vals)
+      && ERR_OK == write_spec_state(f, spec),
+      "Error writing %s", tmp_fn);
+  for (i = 0; i < n_results; i++) {
+    check(ERR_OK == write_result(f, results[i]), "Error writing %s", tmp_fn);
+  }
+  for (i = 0; i < n_seqs; i++) {
+    check(ERR_OK == write_seqstate(f, seqs[i]), "Error writing %s", tmp_fn);
+  }
+  check(0 == fclose(f), "Error writing %s", tmp_fn);
+  f = NULL;
+  check(0 == rename(tmp_fn, fn), "Unable to write %s", fn);
+
+  free(fn);
+  free(tmp_fn);
+  return ERR_OK;
+error:
+  if (f) fclose(f);
+  free(fn);
+  free(tmp_fn);
+  return ERR_INVALID_STATE;
+}
+
+static int load_tube_checkpoint(
+      design_spec_t * spec,
+      result_t ** results, int n_results,
+      seqstate_t ** seqs, int n_seqs,
+      DBL_TYPE * vals, int n_vals
+    ) {
+  char * fn = get_checkpoint_fn(spec, "");
+  FILE * f = NULL;
+  char magic[sizeof(checkpoint_magic)];
+  unsigned int seed;
+  int n_nucs;
+  int i;
+
+  check_mem(fn);
+  f = fopen(fn, "rb");
+  check(f, "Unable to read %s", fn);
+
+  check(ERR_OK == read_checkpoint_vals(f, magic, sizeof(magic), 1)
+      && 0 == memcmp(magic, checkpoint_magic, sizeof(magic)),
+      "%s is not a checkpoint", fn);
+  check(ERR_OK == read_checkpoint_vals(f, &seed, sizeof(unsigned int), 1)
+      && ERR_OK == read_checkpoint_vals(f, &n_nucs, sizeof(int), 1)
+      && seed == spec->opts.seed && n_nucs == spec->seqs.nucs.n,
+      "Checkpoint does not match the design");
+  check(ERR_OK == read_rng_state(f)
+      && ERR_OK == read_checkpoint_vals(f, vals, sizeof(DBL_TYPE), n_vals)
+      && ERR_OK == read_spec_state(f, spec),
+      "Error reading %s", fn);
+  for (i = 0; i < n_results; i++) {
+    check(ERR_OK == read_result(f, results[i], spec),
+        "Error reading %s", fn);
+  }
+  for (i = 0; i < n_seqs; i++) {
+    check(ERR_OK == read_seqstate(f, seqs[i]), "Error reading %s", fn);
+  }
+
+  fclose(f);
+  free(fn);
+  return ERR_OK;
+error:
+  if (f) fclose(f);
+  free(fn);
+  return ERR_INVALID_STATE;
+}
+
+// the values optimize_tubes keeps in a checkpoint
+enum {
+  CK_BEST_DEFECT,
+  CK_TUBE_TIME,
+  CK_ADD_TIME,
+  CK_ELAPSED,
+  CK_OPT_ELAPSED,
+  CK_N_VALS
+};
+
+// writes a checkpoint if the interval has passed since the last one
+static int checkpoint_tubes(
+      design_spec_t * spec,
+      result_t ** results,
+      seqstate_t ** seqs,
+      DBL_TYPE * vals,
+      DBL_TYPE * last_checkpoint
+    ) {
+  struct timeval curtime;
+  DBL_TYPE opt_elapsed;
+
+  if (spec->opts.checkpoint_interval < 0) return ERR_OK;
+
+  gettimeofday(&curtime, NULL);
+  opt_elapsed = curtime.tv_sec + (1e-6 * curtime.tv_usec)
+    - spec->opts.start_time;
+  if (opt_elapsed - *last_checkpoint < spec->opts.checkpoint_interval) {
+    return ERR_OK;
+  }
+
+  vals[CK_OPT_ELAPSED] = opt_elapsed;
+  check(ERR_OK == save_tube_checkpoint(spec, results, 4, seqs, 3,
+        vals, CK_N_VALS), "Error saving checkpoint");
+  *last_checkpoint = opt_elapsed;
+  return ERR_OK;
+error:
+  return ERR_INVALID_STATE;
+}
+
 int optimize_tubes(
       result_t * res,
       seqstate_t * res_seqs,
@@ -997,6 +1412,13 @@ int optimize_tubes(
   struct timeval curtime;
   DBL_TYPE dbltime;
 
+  result_t * ck_results[4] = {res, &current_res, &active_res, &temp_res};
+  seqstate_t * ck_seqs[3] = {&best_seqs, &active_seqs, &current_seqs};
+  DBL_TYPE ck_vals[CK_N_VALS];
+  DBL_TYPE resumed_elapsed = 0;
+  DBL_TYPE last_checkpoint = 0;
+  int i_gen = 0;
+
   gettimeofday(&starttime, NULL);
   init_seqstate(&best_seqs, spec);
   check(ERR_OK == copy_seqstate(&best_seqs, res_seqs),
@@ -1008,59 +1430,90 @@ int optimize_tubes(
 
   init_seqstate(&current_seqs, spec);
 
-  if (spec->opts.print_steps) {
-    print_leafplot(NP_STEP_NOOPT, &best_seqs, spec);
-  }
-
   init_result(&active_res, spec);
   init_result(&current_res, spec);
   init_result(&temp_res, spec);
 
-  // Decompose and optimize forest
-  check(ERR_OK == optimize_forest(&active_res, &active_seqs, spec),
-        "Error optimizing trees");
-  check(ERR_OK == copy_result(res, &active_res),
-      "Error copying result");
+  if (spec->opts.resume) {
+    check(ERR_OK == load_tube_checkpoint(spec, ck_results, 4, ck_seqs, 3,
+          ck_vals, CK_N_VALS), "Error resuming from checkpoint");
+    best_defect = ck_vals[CK_BEST_DEFECT];
+    tube_time = ck_vals[CK_TUBE_TIME];
+    add_time = ck_vals[CK_ADD_TIME];
+    resumed_elapsed = ck_vals[CK_ELAPSED];
+    spec->opts.start_time -= ck_vals[CK_OPT_ELAPSED];
+    last_checkpoint = ck_vals[CK_OPT_ELAPSED];
+    debug("Resumed with best defect %Lf", best_defect);
+  } else {
+    if (spec->opts.print_steps) {
+      print_leafplot(NP_STEP_NOOPT, &best_seqs, spec);
+    }
 
-  gettimeofday(&curtime, NULL);
-  dbltime = curtime.tv_sec + (1e-6 * curtime.tv_usec);
-  init_states(&tempstate, spec);
+    // Decompose and optimize forest
+    check(ERR_OK == optimize_forest(&active_res, &active_seqs, spec),
+          "Error optimizing trees");
+    check(ERR_OK == copy_result(res, &active_res),
+        "Error copying result");
 
-  // Evaluate tube defect
-  check(ERR_OK == evaluate_undesired(res, &active_seqs, spec), 
-    "Error evaluating undesired complexes");
-  check(ERR_OK == update_result(res, &tempstate, &active_seqs, spec),
-      "Error updating result");
+    gettimeofday(&curtime, NULL);
+    dbltime = curtime.tv_sec + (1e-6 * curtime.tv_usec);
+    init_states(&tempstate, spec);
 
-  free_states(&tempstate);
+    // Evaluate tube defect
+    check(ERR_OK == evaluate_undesired(res, &active_seqs, spec), 
+      "Error evaluating undesired complexes");
+    check(ERR_OK == update_result(res, &tempstate, &active_seqs, spec),
+        "Error updating result");
 
-  best_defect = get_tube_defects(res, spec);
+    free_states(&tempstate);
 
-  gettimeofday(&curtime, NULL);
-  dbltime -= curtime.tv_sec + (1e-6 * curtime.tv_usec);
-  tube_time -= dbltime;
-  debug("Setting best defect %Lf", best_defect);
-  // Accept as best defect
-  check(ERR_OK == copy_seqstate(&best_seqs, &active_seqs),
-      "Error copying sequences");
+    best_defect = get_tube_defects(res, spec);
 
-  // Set the current sequences/result
-  check(ERR_OK == copy_result(&current_res, res),
-      "Error copying result");
+    gettimeofday(&curtime, NULL);
+    dbltime -= curtime.tv_sec + (1e-6 * curtime.tv_usec);
+    tube_time -= dbltime;
+    telemetry_phase(NP_PHASE_TUBE_EVAL, -dbltime);
+    debug("Setting best defect %Lf", best_defect);
+    // Accept as best defect
+    check(ERR_OK == copy_seqstate(&best_seqs, &active_seqs),
+        "Error copying sequences");
 
-  check(ERR_OK == copy_seqstate(&current_seqs, &active_seqs),
-      "Error copying sequences");
+    // Set the current sequences/result
+    check(ERR_OK == copy_result(&current_res, res),
+        "Error copying result");
 
-  if (spec->opts.print_steps) {
-    print_leafplot(NP_STEP_TREEOPT, &best_seqs, spec);
+    check(ERR_OK == copy_seqstate(&current_seqs, &active_seqs),
+        "Error copying sequences");
+
+    if (spec->opts.print_steps) {
+      print_leafplot(NP_STEP_TREEOPT, &best_seqs, spec);
+    }
   }
 
-  gettimeofday(&curtime, NULL);
-  dbltime = curtime.tv_sec + (1e-6 * curtime.tv_usec);
+  while (1) {
+    telemetry_generation("optimize_tubes", i_gen, best_defect);
+    i_gen++;
+
+    gettimeofday(&curtime, NULL);
+    dbltime = curtime.tv_sec + (1e-6 * curtime.tv_usec);
 
-  while (!get_tubes_satisfied(&current_res, &active_res, spec)
-          && (dbltime - spec->opts.start_time) < spec->opts.allowed_opt_time
-      ) {
+    // Checkpoint at the refocusing steps
+    ck_vals[CK_BEST_DEFECT] = best_defect;
+    ck_vals[CK_TUBE_TIME] = tube_time;
+    ck_vals[CK_ADD_TIME] = add_time;
+    ck_vals[CK_ELAPSED] = resumed_elapsed + dbltime
+      - (starttime.tv_sec + 1e-6 * starttime.tv_usec);
+    check(ERR_OK == checkpoint_tubes(spec, ck_results, ck_seqs, ck_vals,
+          &last_checkpoint), "Error writing checkpoint");
+
+    if (get_tubes_satisfied(&current_res, &active_res, spec)) {
+      telemetry_stop("satisfied");
+      break;
+    }
+    if (stop_optimizing(&spec->opts, dbltime)) {
+      telemetry_stop(stop_requested(&spec->opts) ? "stop file" : "time limit");
+      break;
+    }
 
     gettimeofday(&curtime, NULL);
     dbltime = curtime.tv_sec + (1e-6 * curtime.tv_usec);
@@ -1073,6 +1526,7 @@ int optimize_tubes(
     gettimeofday(&curtime, NULL);
     dbltime -= curtime.tv_sec + (1e-6 * curtime.tv_usec);
     add_time -= dbltime;
+    telemetry_phase(NP_PHASE_REFOCUS, -dbltime);
 
     check(ERR_OK == optimize_forest(&active_res, &active_seqs, spec), 
       "Error optimizing trees");
@@ -1096,6 +1550,7 @@ int optimize_tubes(
     gettimeofday(&curtime, NULL);
     dbltime -= curtime.tv_sec + (1e-6 * curtime.tv_usec);
     tube_time -= dbltime;
+    telemetry_phase(NP_PHASE_TUBE_EVAL, -dbltime);
 
     temp_defect = get_tube_defects(&temp_res, spec);
     check(ERR_OK == copy_result(&current_res, &temp_res),
@@ -1115,9 +1570,6 @@ int optimize_tubes(
     if (spec->opts.print_steps) {
       print_leafplot(NP_STEP_TREEOPT, &best_seqs, spec);
     }
-
-    gettimeofday(&curtime, NULL);
-    dbltime = curtime.tv_sec + (1e-6 * curtime.tv_usec);
   }
 
 
@@ -1128,6 +1580,8 @@ int optimize_tubes(
 
   check(ERR_OK == copy_seqstate(res_seqs, &best_seqs),
       "Error copying sequences");
+  check(ERR_OK == reevaluate_pruned(res, res_seqs, spec),
+      "Error re-evaluating pruned orderings");
 
   free_result(&current_res);
   free_result(&temp_res);
@@ -1141,7 +1595,7 @@ int optimize_tubes(
 
   elapsed = endtime.tv_sec - starttime.tv_sec 
     + 1e-6 * (endtime.tv_usec - starttime.tv_usec);
-  res->elapsed_time = elapsed;
+  res->elapsed_time = elapsed + resumed_elapsed;
   refresh_seqstate(res_seqs, spec);
 
   debug("Add time: %Lf", add_time);
@@ -1289,6 +1743,7 @@ int optimize_forest(
     gettimeofday(&curtime,NULL);
     elapsetime -= curtime.tv_sec + (1e-6 * curtime.tv_usec);
     leaftime -= elapsetime;
+    telemetry_phase(NP_PHASE_LEAFOPT, -elapsetime);
 
     elapsetime = curtime.tv_sec + (1e-6 * curtime.tv_usec);
 
@@ -1334,12 +1789,13 @@ int optimize_forest(
       if (cur_defect * spec->opts.f_stringent > 
             best_defects[i_level + 1]
           && cur_defect > stop_conditions[i_level]
-          && (dbltime - spec->opts.start_time) < spec->opts.allowed_opt_time
+          && !stop_optimizing(&spec->opts, dbltime)
           ) {
 
         gettimeofday(&curtime,NULL);
         elapsetime -= curtime.tv_sec + (1e-6 * curtime.tv_usec);
         mergetime -= elapsetime;
+        telemetry_phase(NP_PHASE_MERGE, -elapsetime);
 
         elapsetime = curtime.tv_sec + (1e-6 * curtime.tv_usec);
 
@@ -1375,6 +1831,7 @@ int optimize_forest(
         gettimeofday(&curtime,NULL);
         elapsetime -= curtime.tv_sec + (1e-6 * curtime.tv_usec);
         redecomptime -= elapsetime;
+        telemetry_phase(NP_PHASE_REDECOMPOSE, -elapsetime);
 
         break;
       }
@@ -1384,6 +1841,7 @@ int optimize_forest(
   gettimeofday(&curtime,NULL);
   elapsetime -= curtime.tv_sec + (1e-6 * curtime.tv_usec);
   mergetime -= elapsetime;
+  telemetry_phase(NP_PHASE_MERGE, -elapsetime);
   debug("Leaf time : %Lf", leaftime);
   debug("Merge time: %Lf", mergetime);
   debug("Decom time: %Lf", redecomptime);
@@ -1446,6 +1904,7 @@ int optimize_leaves(
   DBL_TYPE best_defect;
   DBL_TYPE cur_defect;
   int fail_count = 0;
+  int i_gen = 0;
   struct timeval curtime;
   DBL_TYPE dbltime;
 
@@ -1468,12 +1927,14 @@ int optimize_leaves(
       get_defect(res));
 
   debug("defect fraction: %Lf / %Lf", best_defect, goal_frac);
+  telemetry_generation("optimize_leaves", i_gen, best_defect);
+  i_gen++;
 
   gettimeofday(&curtime, NULL);
   dbltime = curtime.tv_sec + (1e-6 * curtime.tv_usec);
 
   while (fail_count < spec->opts.M_leafopt && best_defect > goal_frac
-      && dbltime - spec->opts.start_time < spec->opts.allowed_opt_time) {
+      && !stop_optimizing(&spec->opts, dbltime)) {
     // Reseed
     check(ERR_OK == copy_seqstate(&temp_seqs, seqs),
         "Error copying sequences");
@@ -1508,6 +1969,8 @@ int optimize_leaves(
       copy_result(&temp_res, res);
       fail_count += 1;
     }
+    telemetry_generation("optimize_leaves", i_gen, best_defect);
+    i_gen++;
 
     gettimeofday(&curtime, NULL);
     dbltime = curtime.tv_sec + (1e-6 * curtime.tv_usec);
@@ -1863,13 +2326,18 @@ int mutate_leaves(
   DBL_TYPE best_defect ;
   DBL_TYPE cur_defect = 0;
   DBL_TYPE dbltime;
+  DBL_TYPE mutate_start;
   struct timeval curtime;
   int mut_failed = 0;
   int n_mutable_nucs = 0;
   int n_failed = 0;
+  int i_gen = 0;
   mutation_t mut;             // xi
   mutation_list_t muts_tried; // gamma
 
+  gettimeofday(&curtime, NULL);
+  mutate_start = curtime.tv_sec + (1e-6 * curtime.tv_usec);
+
   init_seqstate(&temp_seqs, spec);
   check(ERR_OK == copy_seqstate(&temp_seqs, seqs),
       "Error copying sequences");
@@ -1894,7 +2362,7 @@ int mutate_leaves(
   dbltime = curtime.tv_sec + (1e-6 * curtime.tv_usec);
   while (n_failed < spec->opts.M_unfavorable 
       && best_defect > goal_frac 
-      && dbltime - spec->opts.start_time < spec->opts.allowed_opt_time) {
+      && !stop_optimizing(&spec->opts, dbltime)) {
     mut_failed = 0;
 
     check(ERR_OK == pick_mutation(&mut, res, &temp_seqs, spec),
@@ -1941,9 +2409,13 @@ int mutate_leaves(
     } else {
       n_failed = 0;
     }
+    telemetry_generation("mutate_leaves", i_gen, best_defect);
+    i_gen++;
+
     gettimeofday(&curtime, NULL);
     dbltime = curtime.tv_sec + (1e-6 * curtime.tv_usec);
   }
+  telemetry_phase(NP_PHASE_MUTATE, dbltime - mutate_start);
 
   free_mutation(&mut);
   free_mutation_list(&muts_tried);
@@ -15,6 +15,6 @@
 #include "pathway_debug.h"
 #include "pathway_utils.h"
 #include "constants.h"
-#include "equilibrium_concentrations.h"
+#include "thermo/concentrations/equilibrium_concentrations.h"
 
 #endif
@@ -0,0 +1,191 @@
+#include "pathway_design.h"
+
+#include <sys/resource.h>
+#include <sys/stat.h>
+
+/*
+ * JSON-lines telemetry of the optimizer.  Every line is one object with an
+ * "event" field: "start", "generation" (best defect after a generation of
+ * a phase), "phase" (time spent in one pass of a phase), "stop" and "end"
+ * (totals per phase).  Times are seconds since the optimization started.
+ * The counters are kept whether or not a stream is open.
+ */
+
+static FILE * telemetry_f = NULL;
+static DBL_TYPE telemetry_start = 0;
+
+static unsigned long n_leaf_evals = 0;
+static unsigned long n_leaf_lookups = 0;
+static unsigned long n_offtarget_evals = 0;
+static unsigned long n_offtarget_lookups = 0;
+static unsigned long n_offtarget_pruned = 0;
+
+static DBL_TYPE phase_seconds[NP_N_PHASES];
+static unsigned long phase_count[NP_N_PHASES];
+static const char * phase_names[NP_N_PHASES] = {
+  "leaf_opt",
+  "mutate_leaves",
+  "merge",
+  "redecompose",
+  "refocus",
+  "tube_eval"
+};
+
+/***********************************************************/
+static DBL_TYPE telemetry_now(void) {
+  struct timeval curtime;
+  gettimeofday(&curtime, NULL);
+  return curtime.tv_sec + (1e-6 * curtime.tv_usec) - telemetry_start;
+}
+
+static long max_rss_kb(void) {
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) {
+    return -1;
+  }
+#ifdef __APPLE__
+  return usage.ru_maxrss / 1024;
+#else
+  return usage.ru_maxrss;
+#endif
+}
+
+// JSON has no infinities, the unset best defect is written as null
+static void write_number(DBL_TYPE val) {
+  if (isfinite((double) val)) {
+    fprintf(telemetry_f, "%.15g", (double) val);
+  } else {
+    fprintf(telemetry_f, "null");
+  }
+}
+
+static void begin_line(const char * event) {
+  fprintf(telemetry_f, "{\"event\":\"%s\",\"time\":", event);
+  write_number(telemetry_now());
+}
+
+static void write_counts(void) {
+  fprintf(telemetry_f, ",\"leaf_evals\":%lu,\"leaf_lookups\":%lu"
+      ",\"offtarget_evals\":%lu,\"offtarget_lookups\":%lu"
+      ",\"offtarget_pruned\":%lu,\"max_rss_kb\":%ld", n_leaf_evals,
+      n_leaf_lookups, n_offtarget_evals, n_offtarget_lookups,
+      n_offtarget_pruned, max_rss_kb());
+}
+
+static void end_line(void) {
+  fprintf(telemetry_f, "}\n");
+  fflush(telemetry_f);
+}
+
+/***********************************************************/
+int open_telemetry(const char * filename, DBL_TYPE start_time) {
+  int i_phase;
+  telemetry_f = fopen(filename, "w");
+  check(telemetry_f != NULL, "Unable to write %s", filename);
+  telemetry_start = start_time;
+
+  for (i_phase = 0; i_phase < NP_N_PHASES; i_phase++) {
+    phase_seconds[i_phase] = 0;
+    phase_count[i_phase] = 0;
+  }
+
+  begin_line("start");
+  fprintf(telemetry_f, ",\"engine\":\"tubedesign\"");
+  end_line();
+  return ERR_OK;
+error:
+  return ERR_INVALID_STATE;
+}
+
+void close_telemetry(void) {
+  int i_phase;
+  if (!telemetry_f) {
+    return;
+  }
+
+  begin_line("end");
+  fprintf(telemetry_f, ",\"phases\":{");
+  for (i_phase = 0; i_phase < NP_N_PHASES; i_phase++) {
+    fprintf(telemetry_f, "%s\"%s\":{\"seconds\":", i_phase > 0 ? "," : "",
+        phase_names[i_phase]);
+    write_number(phase_seconds[i_phase]);
+    fprintf(telemetry_f, ",\"count\":%lu}", phase_count[i_phase]);
+  }
+  fprintf(telemetry_f, "}");
+  write_counts();
+  end_line();
+
+  fclose(telemetry_f);
+  telemetry_f = NULL;
+}
+
+/***********************************************************/
+void count_leaf_eval(int computed) {
+  n_leaf_lookups++;
+  if (computed) {
+    n_leaf_evals++;
+  }
+}
+
+void count_offtarget_eval(int computed) {
+  n_offtarget_lookups++;
+  if (computed) {
+    n_offtarget_evals++;
+  }
+}
+
+// pruned orderings are also counted as evaluated, their estimate was computed
+void count_offtarget_pruned(int n_pruned) {
+  n_offtarget_pruned += n_pruned;
+}
+
+void telemetry_phase(enum NUPACK_TELEMETRY_PHASE phase, DBL_TYPE seconds) {
+  phase_seconds[phase] += seconds;
+  phase_count[phase]++;
+  if (!telemetry_f) {
+    return;
+  }
+
+  begin_line("phase");
+  fprintf(telemetry_f, ",\"phase\":\"%s\",\"seconds\":", phase_names[phase]);
+  write_number(seconds);
+  fprintf(telemetry_f, ",\"total_seconds\":");
+  write_number(phase_seconds[phase]);
+  end_line();
+}
+
+void telemetry_generation(const char * phase, int i_gen,
+    DBL_TYPE best_defect) {
+  if (!telemetry_f) {
+    return;
+  }
+
+  begin_line("generation");
+  fprintf(telemetry_f, ",\"phase\":\"%s\",\"generation\":%i"
+      ",\"best_defect\":", phase, i_gen);
+  write_number(best_defect);
+  write_counts();
+  end_line();
+}
+
+void telemetry_stop(const char * reason) {
+  if (!telemetry_f) {
+    return;
+  }
+
+  begin_line("stop");
+  fprintf(telemetry_f, ",\"reason\":\"%s\"", reason);
+  end_line();
+}
+
+/***********************************************************/
+int stop_requested(options_t * opts) {
+  struct stat st;
+  return opts->stop_file && stat(opts->stop_file, &st) == 0;
+}
+
+// now is the current time of day in seconds
+int stop_optimizing(options_t * opts, DBL_TYPE now) {
+  return now - opts->start_time >= opts->allowed_opt_time
+    || stop_requested(opts);
+}
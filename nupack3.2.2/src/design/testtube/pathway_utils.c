@@ -50,6 +50,11 @@ int init_opts(options_t * opts) {
 
   opts->allowed_opt_time = 31536000; 
   // Approximate seconds in a year. Doubtful anyone will exceed this.
+  opts->checkpoint_interval = -1;
+  opts->resume = 0;
+  opts->stop_file = NULL;
+  opts->n_jobs = 0;
+  opts->prune_tol = -1;
 
   gettimeofday(&curtime, NULL);
   opts->start_time = curtime.tv_sec + (1e-6 * curtime.tv_usec);
@@ -950,6 +955,7 @@ int init_result(
   res->struc_map = (int*) malloc(sizeof(int) * n_ords);
   res->order_len = (int*) malloc(sizeof(int) * n_ords);
   res->included = (int*) malloc(sizeof(int) * n_ords);
+  res->pruned = (int*) malloc(sizeof(int) * n_ords);
   res->dG = (DBL_TYPE*) malloc(sizeof(DBL_TYPE) * n_ords);
   res->eval_time = (DBL_TYPE*) malloc(sizeof(DBL_TYPE) * n_ords);
   res->offtarget_seqs = NULL;
@@ -970,6 +976,7 @@ int init_result(
     res->struc_map[i_ord] = spec->struc_map[i_ord];
     res->order_len[i_ord] = 0;
     res->included[i_ord] = spec->struc_map[i_ord] == -1 ? 0 : 1;
+    res->pruned[i_ord] = 0;
     res->dG[i_ord] = 100;
     res->eval_time[i_ord] = 0;
   }
@@ -1098,6 +1105,10 @@ int copy_result(
     check_mem(temp_strucs);
     dest->included = temp_strucs;
 
+    temp_strucs = (int*) realloc(dest->pruned, sizeof(int) * n_ords);
+    check_mem(temp_strucs);
+    dest->pruned = temp_strucs;
+
     temp_strucs = (int*) realloc(dest->order_len, sizeof(int) * n_ords);
     check_mem(temp_strucs);
     dest->order_len = temp_strucs;
@@ -1119,6 +1130,7 @@ int copy_result(
     dest->n_strands[i_ord] = 0;
     dest->struc_map[i_ord] = 0;
     dest->included[i_ord] = 0;
+    dest->pruned[i_ord] = 0;
     dest->order_len[i_ord] = 0;
   }
 
@@ -1135,6 +1147,7 @@ int copy_result(
     dest->struc_map[i_ord] = src->struc_map[i_ord];
     dest->order_len[i_ord] = src->order_len[i_ord];
     dest->included[i_ord] = src->included[i_ord];
+    dest->pruned[i_ord] = src->pruned[i_ord];
   }
 
   for (i_ord = 0; i_ord < n_ords; i_ord++) {
@@ -1198,6 +1211,7 @@ int free_result(
   free(res->struc_map);
   free(res->order_len);
   free(res->included);
+  free(res->pruned);
   free(res->dG);
   free(res->eval_time);
 
@@ -1215,6 +1229,7 @@ int free_result(
   res->struc_map = NULL;
   res->order_len = NULL;
   res->included = NULL;
+  res->pruned = NULL;
   res->dG = NULL;
   res->eval_time = NULL;
   res->n_orderings = 0;
@@ -2154,6 +2169,43 @@ error:
   return ERR_OOM;
 }
 
+/*
+ * Adds the unstructured, modifiable structure that stands for the
+ * off-target ordering i_ord once it is designed against
+ */
+int add_offtarget_structure(
+      design_spec_t * spec,
+      int i_ord
+    ) {
+  int n_strs = spec->n_strands[i_ord];
+  int i_str;
+  int n_nucs = 0;
+  int i_nuc;
+  int i_struc = spec->n_strucs;
+  int * nuc_struc = NULL;
+
+  for (i_str = 0; i_str < n_strs; i_str++) {
+    n_nucs += spec->seqs.strands.specs[spec->orderings[i_ord][i_str]].n;
+  }
+  check(n_nucs > 0, "N nucs must be > 0 %i", n_nucs);
+
+  nuc_struc = (int*) malloc(n_nucs * sizeof(int));
+  check_mem(nuc_struc);
+  for (i_nuc = 0; i_nuc < n_nucs; i_nuc++) {
+    nuc_struc[i_nuc] = -1;
+  }
+
+  check(ERR_OK == add_structure(spec, "::gen", spec->orderings[i_ord],
+      n_strs, nuc_struc, n_nucs), "Error adding structure");
+  spec->strucs[i_struc].modifiable = 1;
+
+  free(nuc_struc);
+  return ERR_OK;
+error:
+  free(nuc_struc);
+  return ERR_OOM;
+}
+
 int add_tube_str(
       design_spec_t * spec,
       char * name, 
@@ -3827,9 +3879,15 @@ int eval_leaf(result_tree_t * res, result_struc_t * struc,
   DBL_TYPE total_bonus = 1;
   int n_bonuses = 0;
   int * rev_map = NULL;
+  int k_pair;
+  sparsePairPr pp_sparse;
   struct timeval start_time;
   struct timeval end_time;
 
+  // only pairs above min_ppair_saved are kept, so the pair probabilities
+  // are stored sparsely instead of in a dense n^2 matrix
+  InitSparsePairPr(&pp_sparse, spec->opts.min_ppair_saved < NUM_PRECISION ?
+      spec->opts.min_ppair_saved : NUM_PRECISION);
 
   // Get updated sequence
   n_nucs = res->n_nucs;
@@ -3860,6 +3918,7 @@ int eval_leaf(result_tree_t * res, result_struc_t * struc,
   DBL_TYPE * bonuses = NULL; 
   int i_seg = 0;
 
+  count_leaf_eval(changed);
   // If sequence has changed
   if (changed) {
     gettimeofday(&start_time, NULL);
@@ -3895,10 +3954,10 @@ int eval_leaf(result_tree_t * res, result_struc_t * struc,
 
     // evaluate pfunc and pair probs
     EXTERN_Q = (DBL_TYPE*) calloc(res->n_nucs * res->n_nucs, sizeof(DBL_TYPE));
-    pairPr = (DBL_TYPE*) calloc(res->n_nucs * (res->n_nucs + 1), sizeof(DBL_TYPE));
+    pairPr = NULL;
+    pairPrSparse = &pp_sparse;
 
     check_mem(EXTERN_Q);
-    check_mem(pairPr);
 
     TEMP_K = spec->opts.temperature;
     SODIUM_CONC = spec->opts.sodium;
@@ -3970,7 +4029,7 @@ int eval_leaf(result_tree_t * res, result_struc_t * struc,
       check(j_nuc >= 0 && j_nuc <= res->n_nucs,
           "Invalid nucleotide after reverse map: %i", j_nuc); 
 
-      cur_defect = 1.0 - pairPr[k_nuc * (res->n_nucs + 1) + j_nuc];
+      cur_defect = 1.0 - GetSparsePairPr(&pp_sparse, k_nuc, j_nuc);
 
       res->nuc_defects[i_nuc] = cur_defect;
     }
@@ -3998,10 +4057,12 @@ int eval_leaf(result_tree_t * res, result_struc_t * struc,
           res->ppairs_j = tmp_int;
         }
         m_i_nuc = res->native_map[i_nuc];
-        for (j_nuc = i_nuc; j_nuc < res->n_nucs; j_nuc++) {
-          if (!res->dummy_flag[j_nuc]) {
+        for (k_pair = pp_sparse.rowStart[i_nuc]; 
+            k_pair < pp_sparse.rowStart[i_nuc + 1] - 1; k_pair++) {
+          j_nuc = pp_sparse.col[k_pair];
+          if (j_nuc >= i_nuc && !res->dummy_flag[j_nuc]) {
             m_j_nuc = res->native_map[j_nuc];
-            cur_prob = pairPr[i_nuc * (res->n_nucs + 1) + j_nuc];
+            cur_prob = pp_sparse.prob[k_pair];
             if (cur_prob > spec->opts.min_ppair_saved) { 
               res->ppairs_i[res->ppairs_n] = m_i_nuc;
               res->ppairs_j[res->ppairs_n] = m_j_nuc;
@@ -4010,7 +4071,7 @@ int eval_leaf(result_tree_t * res, result_struc_t * struc,
             }
           }
         }
-        cur_prob = pairPr[i_nuc * (res->n_nucs + 1) + res->n_nucs];
+        cur_prob = pp_sparse.prob[pp_sparse.rowStart[i_nuc + 1] - 1];
         if (cur_prob > spec->opts.min_ppair_saved) {
           res->ppairs_i[res->ppairs_n] = m_i_nuc;
           res->ppairs_j[res->ppairs_n] = -1;
@@ -4042,13 +4103,14 @@ int eval_leaf(result_tree_t * res, result_struc_t * struc,
         check(!res->dummy_flag[i_nuc], "Dummy flag set for assumed nuc %i", i_nuc);
         check(!res->dummy_flag[j_nuc], "Dummy flag set for assumed nuc %i", j_nuc);
 
-        // if (pairPr[i_nuc * (res->n_nucs + 1) + j_nuc] < 0.99) {
+        cur_prob = GetSparsePairPr(&pp_sparse, i_nuc, j_nuc);
+        // if (cur_prob < 0.99) {
         //   debug("Nuc pair %i %i -> %i %i pair %Lf", m_i_nuc, m_j_nuc, i_nuc, j_nuc, 
-        //       pairPr[i_nuc * (res->n_nucs + 1) + j_nuc]);
+        //       cur_prob);
         // }
 
-        if (pairPr[i_nuc * (res->n_nucs + 1) + j_nuc] < min_ppair) {
-          min_ppair = pairPr[i_nuc * (res->n_nucs + 1) + j_nuc];
+        if (cur_prob < min_ppair) {
+          min_ppair = cur_prob;
         }
       }
       min_ppair = 1.0;
@@ -4067,9 +4129,9 @@ int eval_leaf(result_tree_t * res, result_struc_t * struc,
 
     free(rev_map);
     free(EXTERN_Q);
-    free(pairPr);
+    ClearSparsePairPr(&pp_sparse);
     EXTERN_Q = NULL;
-    pairPr = NULL;
+    pairPrSparse = NULL;
 
 
     res->pfunc = pfunc_corrected;
@@ -4084,6 +4146,8 @@ int eval_leaf(result_tree_t * res, result_struc_t * struc,
 error:
   free(tempseq);
   free(rev_map);
+  ClearSparsePairPr(&pp_sparse);
+  pairPrSparse = NULL;
   return ERR_INVALID_STATE;
 }
 
@@ -6030,6 +6094,13 @@ int calculate_concentrations(
 
   DBL_TYPE pfunc = 0;
 
+  // One solver workspace, grown on demand, serves every tube evaluation
+  static eq_workspace_t * conc_ws = NULL;
+  if (conc_ws == NULL) {
+    conc_ws = new_eq_workspace(n_strands, n_strands);
+    check(conc_ws != NULL, "Unable to allocate concentrations workspace");
+  }
+
   for (i_tube = 0; i_tube < n_tubes; i_tube++) {
 
     n_strucs = res->tubes[i_tube].n_strucs;
@@ -6126,8 +6197,8 @@ int calculate_concentrations(
     }
   
     // Calculate the latest concentrations
-    check(ERR_OK == calc_conc_from_free_energies(x, A_pruned, dG, x0, 
-          n_strands, m_strucs_pruned, 
+    check(ERR_OK == calc_conc_from_free_energies_ws(conc_ws, x, A_pruned, 
+          dG, x0, n_strands, m_strucs_pruned, 
         n_points, max_iters, tol, delta_bar, eta, min_delta, max_trial,
         perturb_scale, quiet, write_log_file, log_file, seed, NULL), 
         "Concentrations did not converge");
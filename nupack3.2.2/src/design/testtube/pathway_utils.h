@@ -144,6 +144,7 @@ int add_tube_str(design_spec_t * spec, char * name, char ** strucs,
 int add_tube(design_spec_t * spec, char * name, int * strucs,
     DBL_TYPE * concs, int n_strucs, DBL_TYPE stop, int maxsize);
 int make_off_targets(design_spec_t * spec);
+int add_offtarget_structure(design_spec_t * spec, int i_ord);
 int init_struc(design_struc_t* struc, sequence_spec_t * seqs, 
     int * strands, int n_strands,
     int * dom_struc, int n_domains);
@@ -505,6 +506,49 @@ int free_design_spec(design_spec_t * spec);
 int free_result(result_t * res);
 
 
+/*******************************************************************
+ * pathway_checkpoint.c
+ * Binary saving and loading of the design state, so that a design
+ * that was stopped can be resumed where it was checkpointed.
+ ******************************************************************/
+int write_seqstate(FILE * f, seqstate_t * seqs);
+int read_seqstate(FILE * f, seqstate_t * seqs);
+int write_result(FILE * f, result_t * res);
+int read_result(FILE * f, result_t * res, design_spec_t * spec);
+int write_spec_state(FILE * f, design_spec_t * spec);
+int read_spec_state(FILE * f, design_spec_t * spec);
+int write_rng_state(FILE * f);
+int read_rng_state(FILE * f);
+int write_checkpoint_vals(FILE * f, const void * vals, size_t size, int n);
+int read_checkpoint_vals(FILE * f, void * vals, size_t size, int n);
+
+/*******************************************************************
+ * pathway_telemetry.c
+ * Optional JSON-lines stream of the optimizer progress and the stop
+ * file that ends optimization early with the best design so far.
+ ******************************************************************/
+enum NUPACK_TELEMETRY_PHASE {
+  NP_PHASE_LEAFOPT,
+  NP_PHASE_MUTATE,
+  NP_PHASE_MERGE,
+  NP_PHASE_REDECOMPOSE,
+  NP_PHASE_REFOCUS,
+  NP_PHASE_TUBE_EVAL,
+  NP_N_PHASES
+};
+
+int open_telemetry(const char * filename, DBL_TYPE start_time);
+void close_telemetry(void);
+void count_leaf_eval(int computed);
+void count_offtarget_eval(int computed);
+void count_offtarget_pruned(int n_pruned);
+void telemetry_phase(enum NUPACK_TELEMETRY_PHASE phase, DBL_TYPE seconds);
+void telemetry_generation(const char * phase, int i_gen, 
+    DBL_TYPE best_defect);
+void telemetry_stop(const char * reason);
+int stop_requested(options_t * opts);
+int stop_optimizing(options_t * opts, DBL_TYPE now);
+
 /*
  * Unused junk
  */
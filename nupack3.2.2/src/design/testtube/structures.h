@@ -46,6 +46,12 @@ typedef struct OPTIONS_T_ {
 
   DBL_TYPE start_time;
   DBL_TYPE allowed_opt_time;
+  DBL_TYPE checkpoint_interval; // seconds between checkpoints, < 0 for none
+  int resume;                   // continue from the checkpoint file
+  char * stop_file;             // optimization ends once this exists, or NULL
+  int n_jobs;                   // off-target worker processes, 0 for one per cpu
+  DBL_TYPE prune_tol;           // defect share below which off-targets are estimated
+                                //  instead of evaluated, < 0 for no pruning
 } options_t;
 /*****************************************************************************
  * Sequence properties
@@ -289,6 +295,7 @@ typedef struct RESULT_T_ {
   DBL_TYPE * dG;
   DBL_TYPE * eval_time;
   int * included;
+  int * pruned;       // dG is the --prune estimate, not the pfunc
   int * order_len;
   int * struc_map;    // index of current ordering in strucs
   int n_orderings;
@@ -17,6 +17,7 @@
 #include "shared/functions.h"
 #include "shared/hash.h"
 #include "shared/mt19937ar.h"
+#include "shared/streamjob.h"
 #include "shared/structs.h"
 
 #endif /* NUPACK_SHARED_H__ */
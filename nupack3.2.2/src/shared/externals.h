@@ -12,6 +12,7 @@
 
 #include <stddef.h>
 #include "constants.h"
+#include "structs.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -47,7 +48,10 @@ extern DBL_TYPE asymmetry_penalty[4]; // Asymmetric loop penalties
 extern DBL_TYPE max_asymmetry;
 extern long int maxGapIndex;
 extern DBL_TYPE *sizeTerm;
+extern int *pairPartners; // see MakePairPartners
+extern int *pairPartnerStart;
 extern DBL_TYPE *pairPr;
+extern sparsePairPr *pairPrSparse;
 extern DBL_TYPE *EXTERN_Q;
 extern DBL_TYPE *EXTERN_QB;
 extern DBL_TYPE BIMOLECULAR;
@@ -76,6 +80,7 @@ extern int DO_PSEUDOKNOTS;
 extern int ONLY_ONE_MFE;
 extern int USE_MFE;
 extern char PARAM_FILE[MAX_FILENAME_LEN];
+extern char GAP_SPILL_DIR[MAX_FILENAME_LEN]; // mmap gap matrices here if set
 
 extern unsigned int seqHash;
 
@@ -102,7 +102,7 @@ void init_by_array(unsigned long init_key[], int key_length)
 }
 
 unsigned long genrand_state_length() {
-  return N;
+  return N + 1;
 }
 
 void genrand_save_state(unsigned long * state_copy) {
@@ -110,6 +110,7 @@ void genrand_save_state(unsigned long * state_copy) {
   for(i = 0; i < N ; i ++) {
     state_copy[i] = mt[i];
   }
+  state_copy[N] = mti;
 }
 
 void genrand_init_state(unsigned long * state_copy) {
@@ -117,6 +118,7 @@ void genrand_init_state(unsigned long * state_copy) {
   for(i = 0; i < N ; i++) {
     mt[i] = state_copy[i];
   }
+  mti = state_copy[N];
 }
 
 /* generates a random number on [0,0xffffffff]-interval */
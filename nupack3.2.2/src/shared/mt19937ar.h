@@ -60,10 +60,10 @@ void init_genrand(unsigned long s);
 /* slight change for C++, 2004/2/26 */
 void init_by_array(unsigned long init_key[], int key_length);
 
-/* get the length of the state vector */
-unsigned long getrand_state_length(void);
+/* get the length of the state vector (the array and the position in it) */
+unsigned long genrand_state_length(void);
 
-/* save the state */
+/* save the state, genrand_state_length() values */
 void genrand_save_state(unsigned long * state_copy);
 
 /* initialize the state exactly from the vector */
@@ -31,6 +31,8 @@
 #define NUPACK_DEF_FORBID_SPLITS            true
 #define NUPACK_DEF_REDECOMPOSE              false
 #define NUPACK_DEF_WORD_LEN                 4
+// longest SSM word the word hash tells apart exactly
+#define NUPACK_MAX_WORD_LEN                 20
 #define NUPACK_DEF_STOP                     0.01
 #define NUPACK_DEF_BONUS_PER_SPLIT          -25
 
@@ -0,0 +1,380 @@
+/*
+  streamjob.c is part of the NUPACK software suite
+  Copyright (c) 2007 Caltech. All rights reserved.
+
+  Reads the JSON jobs of a -stream run and writes their result lines (see
+  streamjob.h).  The reader handles the JSON the jobs need, i.e. one flat
+  object per line; nested objects are rejected.
+*/
+
+/* getline (the build uses -std=c99) */
+#define _DEFAULT_SOURCE
+
+#include "streamjob.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+
+static void FreeJsonValue(jsonValue *value) {
+
+  int i;
+
+  free(value->text);
+  for (i = 0; i < value->nItems; i++) {
+    FreeJsonValue(&value->items[i]);
+  }
+  free(value->items);
+}
+
+
+static const char *SkipSpace(const char *p) {
+  while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') p++;
+  return p;
+}
+
+
+/* Appends the UTF-8 encoding of the code point c to s */
+static char *PutUtf8(char *s, unsigned c) {
+
+  if (c < 0x80) {
+    *s++ = (char) c;
+  }
+  else if (c < 0x800) {
+    *s++ = (char) (0xc0 | (c >> 6));
+    *s++ = (char) (0x80 | (c & 0x3f));
+  }
+  else {
+    *s++ = (char) (0xe0 | (c >> 12));
+    *s++ = (char) (0x80 | ((c >> 6) & 0x3f));
+    *s++ = (char) (0x80 | (c & 0x3f));
+  }
+  return s;
+}
+
+
+/* Reads the string starting at the quote p points to.  Returns the
+   position after the closing quote, NULL on error */
+static const char *ParseString(const char *p, char **text, char *error) {
+
+  const char *end;
+  char *s;
+  unsigned c;
+
+  // the unescaped string is never longer than the quoted one
+  for (end = p + 1; *end != '"'; end++) {
+    if (*end == '\0') {
+      strcpy(error, "unterminated string");
+      return NULL;
+    }
+    if (*end == '\\' && end[1] != '\0') end++;
+  }
+  *text = s = (char *) malloc(end - p);
+
+  for (p++; *p != '"'; p++) {
+    if (*p != '\\') {
+      *s++ = *p;
+      continue;
+    }
+    switch (*++p) {
+    case '"': case '\\': case '/': *s++ = *p; break;
+    case 'b': *s++ = '\b'; break;
+    case 'f': *s++ = '\f'; break;
+    case 'n': *s++ = '\n'; break;
+    case 'r': *s++ = '\r'; break;
+    case 't': *s++ = '\t'; break;
+    case 'u':
+      if (sscanf(p + 1, "%4x", &c) != 1 || strspn(p + 1,
+          "0123456789abcdefABCDEF") < 4) {
+        strcpy(error, "bad \\u escape in string");
+        free(*text);
+        *text = NULL;
+        return NULL;
+      }
+      s = PutUtf8(s, c);
+      p += 4;
+      break;
+    default:
+      strcpy(error, "bad escape in string");
+      free(*text);
+      *text = NULL;
+      return NULL;
+    }
+  }
+  *s = '\0';
+  return p + 1;
+}
+
+
+static const char *ParseValue(const char *p, jsonValue *value, char *error) {
+
+  const char *start;
+  char *end;
+  int cap = 0;
+
+  memset(value, 0, sizeof(jsonValue));
+  p = SkipSpace(p);
+
+  if (*p == '"') {
+    value->type = JSON_STRING;
+    return ParseString(p, &value->text, error);
+  }
+
+  if (*p == '[') {
+    value->type = JSON_ARRAY;
+    p = SkipSpace(p + 1);
+    if (*p == ']') return p + 1;
+    while (1) {
+      if (value->nItems == cap) {
+        cap = cap ? 2*cap : 4;
+        value->items = (jsonValue *) realloc(value->items,
+                                             cap * sizeof(jsonValue));
+      }
+      p = ParseValue(p, &value->items[value->nItems], error);
+      if (p == NULL) {
+        FreeJsonValue(&value->items[value->nItems]);
+        return NULL;
+      }
+      value->nItems++;
+      p = SkipSpace(p);
+      if (*p == ']') return p + 1;
+      if (*p != ',') {
+        strcpy(error, "expected , or ] in array");
+        return NULL;
+      }
+      p++;
+    }
+  }
+
+  if (*p == '{') {
+    strcpy(error, "nested objects are not supported");
+    return NULL;
+  }
+
+  start = p;
+  if (strncmp(p, "true", 4) == 0 || strncmp(p, "false", 5) == 0) {
+    value->type = JSON_BOOL;
+    p += (*p == 't') ? 4 : 5;
+  }
+  else if (strncmp(p, "null", 4) == 0) {
+    value->type = JSON_NULL;
+    p += 4;
+  }
+  else {
+    value->type = JSON_NUMBER;
+    strtod(p, &end);
+    if (end == p) {
+      strcpy(error, "unexpected character in value");
+      return NULL;
+    }
+    p = end;
+  }
+  value->text = (char *) malloc(p - start + 1);
+  memcpy(value->text, start, p - start);
+  value->text[p - start] = '\0';
+  return p;
+}
+
+
+static int ParseJob(streamJob *job, char *error) {
+
+  const char *p = SkipSpace(job->line);
+  const char *start;
+  char *key;
+  int cap = 0;
+
+  if (*p != '{') {
+    strcpy(error, "a job must be a JSON object");
+    return 0;
+  }
+  p = SkipSpace(p + 1);
+
+  while (*p != '}') {
+    if (*p != '"') {
+      strcpy(error, "expected a field name");
+      return 0;
+    }
+    if ((p = ParseString(p, &key, error)) == NULL) return 0;
+    if (job->nFields == cap) {
+      cap = cap ? 2*cap : 8;
+      job->keys = (char **) realloc(job->keys, cap * sizeof(char *));
+      job->values = (jsonValue *) realloc(job->values,
+                                          cap * sizeof(jsonValue));
+    }
+    job->keys[job->nFields] = key;
+    memset(&job->values[job->nFields], 0, sizeof(jsonValue));
+    job->nFields++;
+
+    p = SkipSpace(p);
+    if (*p != ':') {
+      strcpy(error, "expected : after a field name");
+      return 0;
+    }
+    start = SkipSpace(p + 1);
+    p = ParseValue(start, &job->values[job->nFields - 1], error);
+    if (p == NULL) return 0;
+    if (strcmp(key, "id") == 0) {
+      job->id = start;
+      job->idLen = (int) (p - start);
+    }
+
+    p = SkipSpace(p);
+    if (*p == ',') {
+      p = SkipSpace(p + 1);
+    }
+    else if (*p != '}') {
+      strcpy(error, "expected , or } in object");
+      return 0;
+    }
+  }
+
+  if (*SkipSpace(p + 1) != '\0') {
+    strcpy(error, "trailing characters after the job");
+    return 0;
+  }
+  return 1;
+}
+
+
+int ReadStreamJob(FILE *in, streamJob *job, char *error) {
+
+  size_t cap = 0;
+
+  memset(job, 0, sizeof(streamJob));
+  while (1) {
+    if (getline(&job->line, &cap, in) == -1) {
+      free(job->line);
+      job->line = NULL;
+      return 0;
+    }
+    if (*SkipSpace(job->line) != '\0') break;
+  }
+
+  if (!ParseJob(job, error)) {
+    FreeStreamJob(job);
+    return -1;
+  }
+  return 1;
+}
+
+
+void FreeStreamJob(streamJob *job) {
+
+  int i;
+
+  for (i = 0; i < job->nFields; i++) {
+    free(job->keys[i]);
+    FreeJsonValue(&job->values[i]);
+  }
+  free(job->keys);
+  free(job->values);
+  free(job->line);
+  memset(job, 0, sizeof(streamJob));
+}
+
+
+jsonValue *StreamJobField(const streamJob *job, const char *key) {
+
+  int i;
+
+  for (i = 0; i < job->nFields; i++) {
+    if (strcmp(job->keys[i], key) == 0) return &job->values[i];
+  }
+  return NULL;
+}
+
+
+int JsonInt(const jsonValue *value, int *x) {
+
+  char *end;
+  long l;
+
+  if (value == NULL || value->text == NULL ||
+      (value->type != JSON_NUMBER && value->type != JSON_STRING)) {
+    return 0;
+  }
+  l = strtol(value->text, &end, 10);
+  if (end == value->text || *end != '\0' || l != (int) l) return 0;
+  *x = (int) l;
+  return 1;
+}
+
+
+int JsonDouble(const jsonValue *value, double *x) {
+
+  char *end;
+
+  if (value == NULL || value->text == NULL ||
+      (value->type != JSON_NUMBER && value->type != JSON_STRING)) {
+    return 0;
+  }
+  *x = strtod(value->text, &end);
+  return end != value->text && *end == '\0';
+}
+
+
+/* Opens the result object with the fields every line carries */
+static void WriteStreamFields(FILE *out, const streamJob *job, int status) {
+
+  fputs("{ ", out);
+  if (job != NULL && job->id != NULL) {
+    fputs("\"id\": ", out);
+    fwrite(job->id, 1, job->idLen, out);
+    fputs(", ", out);
+  }
+  fprintf(out, "\"status\": %d, ", status);
+}
+
+
+void WriteStreamResult(FILE *out, const streamJob *job, int status,
+                       const char *result, size_t len) {
+
+  size_t i = 0;
+
+  // the provenance opens with "{ "
+  while (i < len && (result[i] == '\0' || result[i] == ' ' ||
+         result[i] == '{')) {
+    i++;
+  }
+  // and closes with " }\n"
+  while (len > i && (result[len-1] == '\0' || result[len-1] == '\n' ||
+         result[len-1] == '\r')) {
+    len--;
+  }
+
+  if (i == len) {
+    WriteStreamError(out, job, status, "the calculation gave no result");
+    return;
+  }
+
+  WriteStreamFields(out, job, status);
+  for (; i < len; i++) {
+    if (result[i] == '\n' || result[i] == '\r') {
+      putc(' ', out);
+    }
+    else if (result[i] != '\0') {
+      putc(result[i], out);
+    }
+  }
+  putc('\n', out);
+  fflush(out);
+}
+
+
+void WriteStreamError(FILE *out, const streamJob *job, int status,
+                      const char *error) {
+
+  WriteStreamFields(out, job, status);
+  fputs("\"error\": \"", out);
+  for (; *error != '\0'; error++) {
+    if (*error == '"' || *error == '\\') putc('\\', out);
+    if (*error == '\n') {
+      fputs("\\n", out);
+    }
+    else {
+      putc(*error, out);
+    }
+  }
+  fputs("\" }\n", out);
+  fflush(out);
+}
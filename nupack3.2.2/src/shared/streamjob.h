@@ -0,0 +1,70 @@
+#ifndef NUPACK_SHARED_STREAMJOB_H__
+#define NUPACK_SHARED_STREAMJOB_H__
+
+/*
+  streamjob.h is part of the NUPACK software suite
+  Copyright (c) 2007 Caltech. All rights reserved.
+
+  Jobs of the -stream mode of mfe, complexes and concentrations.  Each
+  line of standard input holds one job, a JSON object whose values are
+  strings, numbers or arrays of those (arrays may nest, e.g. permutations
+  given as [[1, 2], [1, 3]]).  Scalars are kept as text, so "3" and 3 are
+  read alike.  Each job gets exactly one line on standard output: the
+  result object of the calculation, or an object holding an "error".
+  Both carry the exit status the one-shot run would have returned and
+  the "id" of the job, if it gave one.
+*/
+
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#define STREAM_ERROR_LEN 256
+
+enum { JSON_NULL, JSON_BOOL, JSON_NUMBER, JSON_STRING, JSON_ARRAY };
+
+typedef struct jsonValue {
+  int type;
+  char *text;               // scalars (strings unescaped)
+  int nItems;               // arrays
+  struct jsonValue *items;
+} jsonValue;
+
+typedef struct {
+  char *line;      // the raw job; id points into it
+  int nFields;
+  char **keys;
+  jsonValue *values;
+  const char *id;  // raw JSON text of the "id" field, NULL if none
+  int idLen;
+} streamJob;
+
+/* Reads the next non-blank line of in into job.  Returns 1 on success,
+   0 at the end of the input and -1 if the line is not a JSON object (the
+   reason is in error, and job holds nothing to free). */
+int ReadStreamJob(FILE *in, streamJob *job, char *error);
+
+void FreeStreamJob(streamJob *job);
+
+/* The value of a field of the job, NULL if it is absent */
+jsonValue *StreamJobField(const streamJob *job, const char *key);
+
+/* Scalar conversions; return 0 if the value is missing or malformed */
+int JsonInt(const jsonValue *value, int *x);
+int JsonDouble(const jsonValue *value, double *x);
+
+/* Writes the result of a job as one line: the provenance blocks the
+   one-shot run prints, with their NULs dropped and newlines joined */
+void WriteStreamResult(FILE *out, const streamJob *job, int status,
+                       const char *result, size_t len);
+
+void WriteStreamError(FILE *out, const streamJob *job, int status,
+                      const char *error);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* NUPACK_SHARED_STREAMJOB_H__ */
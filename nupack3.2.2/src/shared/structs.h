@@ -58,6 +58,21 @@ typedef struct {
 } dnaStructures;
 
 
+//sparsePairPr stores the pair probability matrix in compressed sparse row
+//(CSR) form.  Row i holds the entries (i,j) with probability at or above
+//cutoff, sorted by j, and always ends with the entry (i,seqlength): the
+//probability that base i is unpaired (same convention as pairPr).
+typedef struct {
+  int seqlength;
+  int nnz; //number of stored entries
+  int nAlloc; //allocated size of col and prob
+  int *rowStart; //row i is stored in [rowStart[i], rowStart[i+1])
+  int *col;
+  DBL_TYPE *prob;
+  DBL_TYPE cutoff; //entries below cutoff are not stored
+} sparsePairPr;
+
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -241,9 +241,11 @@ int main( int argc, char *argv[] ) {
       }
     }
     else{
-      // Allocate memory for storing pair probabilities
-      pairPrPbg = (DBL_TYPE*) calloc( (seqlength+1)*(seqlength+1), sizeof(DBL_TYPE));
-      pairPrPb = (DBL_TYPE*) calloc( (seqlength+1)*(seqlength+1), sizeof(DBL_TYPE));
+      // The Pb/Pbg split is only filled for pseudoknots
+      if( DO_PSEUDOKNOTS) {
+        pairPrPbg = (DBL_TYPE*) calloc( (seqlength+1)*(seqlength+1), sizeof(DBL_TYPE));
+        pairPrPb = (DBL_TYPE*) calloc( (seqlength+1)*(seqlength+1), sizeof(DBL_TYPE));
+      }
 
       if( !DO_PSEUDOKNOTS ) {
         complexity = 3;
@@ -260,6 +262,7 @@ int main( int argc, char *argv[] ) {
 
       free( pairPrPbg);
       free( pairPrPb);
+      pairPrPbg = pairPrPb = NULL;
     }
   }
   else { // Tell the user we used an existing file for the probs
@@ -11,6 +11,9 @@
     with regard to space and time.
 */
 
+/* open_memstream (the build uses -std=c99) */
+#define _DEFAULT_SOURCE
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
@@ -19,10 +22,14 @@
 
 #include <thermo/core.h>
 
+extern int SweepJobs;
+extern int StreamInput;
 
-int main(int argc, char *argv[]) {
 
-  char seq[MAXSEQLENGTH];
+/* Computes the mfe structure(s) of seq and writes the provenance blocks
+   to out.  Returns the exit status of the run */
+static int RunMfe(FILE *out, int argc, char *argv[], char *seq, int vs) {
+
   int seqNum[MAXSEQLENGTH+1];
   int isNicked[MAXSEQLENGTH];
   int nNicks = 0;
@@ -37,9 +44,6 @@ int main(int argc, char *argv[]) {
   int length;
   int tmpLength;
   DBL_TYPE mfe;
-  int vs;
-  char inputFile[MAXLINE];
-  int inputFileSpecified;
 
   // provenance blocks
   int len_header = 1000;
@@ -50,22 +54,6 @@ int main(int argc, char *argv[]) {
   dnaStructures mfeStructs = {NULL, 0, 0, 0, NAD_INFINITY};
 
 
-  strcpy(inputFile, "");
-
-  inputFileSpecified = ReadCommandLineNPK( argc, argv, inputFile);
-  if(NupackShowHelp){
-    printf("Usage: mfe [OPTIONS] PREFIX\n");
-    printf("Compute and store the minimum free energy and the MFE\n");
-    printf("secondary structure(s) of the input sequence.\n");
-    printf("Example: mfe -multi -T 25 -material dna example\n");
-    PrintNupackThermoHelp();
-    PrintNupackUtilitiesHelp();
-    exit(1);
-  }
-
-  getUserInput(seq, &vs, NULL, NULL);
-
-
   /* echo provenance header
    */
 
@@ -80,9 +68,7 @@ int main(int argc, char *argv[]) {
 
   // fill provenance block
   len_provenance = header2provenance(header, argc, argv);
-  for(int y=0 ; y<len_provenance ; ++y){
-    printf("%c", header[y]);
-  }
+  fwrite(header, sizeof(char), len_provenance, out);
 
   // free provenance block
   free(header);
@@ -104,9 +90,7 @@ int main(int argc, char *argv[]) {
   // fill provenance block
   len_provenance = parameters2provenance(parameters, argc, argv, seq,
     NULL, NULL);
-  for(int y=0 ; y<len_provenance ; ++y){
-    printf("%c", parameters[y]);
-  }
+  fwrite(parameters, sizeof(char), len_provenance, out);
 
   // free provenance block
   free(parameters);
@@ -123,6 +107,16 @@ int main(int argc, char *argv[]) {
   tmpLength = strlen(seq);
   convertSeq(seq, seqNum, tmpLength);
 
+  if(SweepRequested()){
+    sweepCondition *conds;
+    int nConds = MakeSweepConditions(&conds);
+
+    RunSweep(seqNum, tmpLength, complexity, vs, conds, nConds, SweepJobs);
+    PrintSweepProvenance(out, conds, nConds);
+    free(conds);
+    return 0;
+  }
+
   mfe = mfeFullWithSym(seqNum, tmpLength, &mfeStructs, complexity,
     DNARNACOUNT, DANGLETYPE, TEMP_K - ZERO_C_IN_KELVIN, vs, ONLY_ONE_MFE,
     SODIUM_CONC, MAGNESIUM_CONC, USE_LONG_HELIX_FOR_SALT_CORRECTION);
@@ -173,9 +167,7 @@ int main(int argc, char *argv[]) {
   // fill provenance block
   len_provenance = dnastructures2provenance(structures, &mfeStructs, etaN,
     nicks, vs);
-  for(int y=0 ; y<len_provenance ; ++y){
-    printf("%c", structures[y]);
-  }
+  fwrite(structures, sizeof(char), len_provenance, out);
 
   // free provenance block
   free(structures);
@@ -195,3 +187,119 @@ int main(int argc, char *argv[]) {
   return 0;
 }
 
+
+
+/* Sets the conditions of a -stream job: those of the command line unless
+   the job gives a "temperature" (C), "sodium" or "magnesium" (M).
+   Returns 0 (and a message) if they are not valid */
+static int SetJobConditions(const streamJob *job, DBL_TYPE T, DBL_TYPE Na,
+      DBL_TYPE Mg, char *error){
+
+  double x;
+
+  TEMP_K = T;
+  SODIUM_CONC = Na;
+  MAGNESIUM_CONC = Mg;
+
+  if(StreamJobField(job, "temperature") != NULL){
+    if(!JsonDouble(StreamJobField(job, "temperature"), &x)){
+      strcpy(error, "invalid temperature");
+      return 0;
+    }
+    TEMP_K = x + ZERO_C_IN_KELVIN;
+  }
+  if(StreamJobField(job, "sodium") != NULL){
+    if(!JsonDouble(StreamJobField(job, "sodium"), &x) || x <= 0){
+      strcpy(error, "invalid sodium concentration, must have [Na+] > 0");
+      return 0;
+    }
+    SODIUM_CONC = x;
+  }
+  if(StreamJobField(job, "magnesium") != NULL){
+    if(!JsonDouble(StreamJobField(job, "magnesium"), &x) || x < 0){
+      strcpy(error, "invalid magnesium concentration, must have [Mg2+] >= 0");
+      return 0;
+    }
+    MAGNESIUM_CONC = x;
+  }
+  if((SODIUM_CONC != 1.0 || MAGNESIUM_CONC != 0.0) && DNARNACOUNT != DNA){
+    strcpy(error, "no salt corrections available for RNA");
+    return 0;
+  }
+  return 1;
+}
+
+
+
+/* -stream: one result line per job of standard input. The parameter
+   tables stay loaded between jobs; the pooled dynamic programming
+   buffers are released after each one
+ */
+static void ServeJobs(int argc, char *argv[]){
+
+  char seq[MAXSEQLENGTH];
+  char error[STREAM_ERROR_LEN];
+  int vs;
+  int read;
+  int status;
+  char *result;
+  size_t len;
+  FILE *out;
+  streamJob job;
+  DBL_TYPE T = TEMP_K;
+  DBL_TYPE Na = SODIUM_CONC;
+  DBL_TYPE Mg = MAGNESIUM_CONC;
+
+  while((read = ReadStreamJob(stdin, &job, error)) != 0){
+    if(read < 0 || !SetJobConditions(&job, T, Na, Mg, error)
+       || !getJobInput(&job, seq, &vs, error)){
+      WriteStreamError(stdout, &job, 1, error);
+      FreeStreamJob(&job);
+      continue;
+    }
+
+    out = open_memstream(&result, &len);
+    status = RunMfe(out, argc, argv, seq, vs);
+    fclose(out);
+    WriteStreamResult(stdout, &job, status, result, len);
+
+    free(result);
+    FreeStreamJob(&job);
+    ClearLDoublesPool();
+  }
+}
+
+
+
+int main(int argc, char *argv[]) {
+
+  char seq[MAXSEQLENGTH];
+  int vs;
+  int status;
+  char inputFile[MAXLINE];
+
+
+  strcpy(inputFile, "");
+
+  ReadCommandLineNPK( argc, argv, inputFile);
+  if(NupackShowHelp){
+    printf("Usage: mfe [OPTIONS] PREFIX\n");
+    printf("Compute and store the minimum free energy and the MFE\n");
+    printf("secondary structure(s) of the input sequence.\n");
+    printf("Example: mfe -multi -T 25 -material dna example\n");
+    PrintNupackThermoHelp();
+    PrintNupackUtilitiesHelp();
+    exit(1);
+  }
+
+  if(StreamInput){
+    ServeJobs(argc, argv);
+    return 0;
+  }
+
+  getUserInput(seq, &vs, NULL, NULL);
+
+  status = RunMfe(stdout, argc, argv, seq, vs);
+  ClearLDoublesPool();
+  return status;
+}
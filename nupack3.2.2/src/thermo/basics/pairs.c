@@ -25,6 +25,7 @@ extern DBL_TYPE *pairPrPb;  //for pseudoknots
 
 extern double CUTOFF;
 extern int Multistranded;
+extern int SparsePairs;
 extern int perm[MAXSTRANDS];
 extern int seqlengthArray[MAXSTRANDS];
 extern int nUniqueSequences; // Number of unique sequences entered
@@ -59,6 +60,8 @@ int main( int argc, char *argv[] ) {
   int pf_qr;
   int strandId, strandPos, strandId2, strandPos2;
   int row, column;
+  int k;
+  sparsePairPr sparsePr; // used instead of pairPr with -sparse
 
   int inputFileSpecified;
   FILE *F_permPr = NULL; // ppairs file
@@ -77,6 +80,9 @@ int main( int argc, char *argv[] ) {
     printf(" -cutoff CUTOFFVALUE    only probabilities and expected values\n");
     printf("                        at or above CUTOFFVALUE are saved in the\n");
     printf("                        output file(s)\n");
+    printf(" -sparse                only keep pair probabilities at or above\n");
+    printf("                        CUTOFFVALUE in memory; with -multi the\n");
+    printf("                        .epairs values omit pairs below it\n");
     exit(1);
   }
 
@@ -115,9 +121,23 @@ int main( int argc, char *argv[] ) {
   getSequenceLength(seqChar, &ns1);
   getSequenceLengthInt(seqNum, &ns2);
 
-  pairPr = (DBL_TYPE*) calloc( (length+1)*(length+1), sizeof(DBL_TYPE));
-  pairPrPbg = (DBL_TYPE*) calloc( (length+1)*(length+1), sizeof(DBL_TYPE));
-  pairPrPb = (DBL_TYPE*) calloc( (length+1)*(length+1), sizeof(DBL_TYPE));
+  //the pseudoknot output needs the dense Pb/Pbg split, so -sparse is
+  //only honoured without -pseudo
+  if( SparsePairs && DO_PSEUDOKNOTS) {
+    SparsePairs = 0;
+  }
+  if( SparsePairs) {
+    InitSparsePairPr( &sparsePr, CUTOFF);
+    pairPrSparse = &sparsePr;
+  }
+  else {
+    pairPr = (DBL_TYPE*) calloc( (length+1)*(length+1), sizeof(DBL_TYPE));
+  }
+  //the Pb/Pbg split is only filled and printed for pseudoknots
+  if( DO_PSEUDOKNOTS) {
+    pairPrPbg = (DBL_TYPE*) calloc( (length+1)*(length+1), sizeof(DBL_TYPE));
+    pairPrPb = (DBL_TYPE*) calloc( (length+1)*(length+1), sizeof(DBL_TYPE));
+  }
 
   pf = pfuncFullWithSym(seqNum, complexity, DNARNACOUNT, DANGLETYPE, 
       TEMP_K - ZERO_C_IN_KELVIN, 1,vs,
@@ -221,6 +241,31 @@ int main( int argc, char *argv[] ) {
       //concatenation of sequences
       strandId = baseCode[2*q];
       strandPos = baseCode[2*q+1];
+      if( SparsePairs) {
+        for( k = sparsePr.rowStart[q]; k < sparsePr.rowStart[q+1]; k++) {
+          r = sparsePr.col[k];
+          if( r == length) {
+            //unpaired entry is exact, so permPr matches the dense sum
+            permPr[strandId][strandPos] += 1 - sparsePr.prob[k];
+            avgBp[strandId][strandPos] += (1 - sparsePr.prob[k])*pf;
+            continue;
+          }
+          strandId2 = baseCode[2*r];
+          strandPos2 = baseCode[2*r+1];
+
+          permAvgPairs[ indexCx[strandId][strandPos]*totalStrandsLength +
+                       indexCx[strandId2][strandPos2] ] += sparsePr.prob[k];
+
+          if(r > q) {
+            if(!NUPACK_VALIDATE) {
+              fprintf( F_permPr, "%d\t%d\t%.4Le\n", q+1, r+1, (long double)sparsePr.prob[k]);
+            } else {
+              fprintf( F_permPr, "%d\t%d\t%.14Le\n", q+1, r+1, (long double)sparsePr.prob[k]);
+            }
+          }
+        }
+        continue;
+      }
       indQ = (1 + length)*q;
       for( r = 0; r <= length-1; r++) {
         strandId2 = baseCode[2*r];
@@ -248,12 +293,18 @@ int main( int argc, char *argv[] ) {
     //add in unpaired probabilities to F_permPr (.ppairs)
     for( q = 0; q <= length-1; q++) {
       r = length;
-      pf_qr = (1+length)*q+r;
-      if(pairPr[pf_qr] >= CUTOFF) {
+      if( SparsePairs) {
+        ppf = sparsePr.prob[ sparsePr.rowStart[q+1] - 1];
+      }
+      else {
+        pf_qr = (1+length)*q+r;
+        ppf = pairPr[ pf_qr];
+      }
+      if(ppf >= CUTOFF) {
         if(!NUPACK_VALIDATE) {
-          fprintf( F_permPr, "%d\t%d\t%.4Le\n",q+1, r+1, (long double)pairPr[ pf_qr]);
+          fprintf( F_permPr, "%d\t%d\t%.4Le\n",q+1, r+1, ppf);
         } else {
-          fprintf( F_permPr, "%d\t%d\t%.14Le\n",q+1, r+1, (long double)pairPr[ pf_qr]);
+          fprintf( F_permPr, "%d\t%d\t%.14Le\n",q+1, r+1, ppf);
         }
       }
     }
@@ -291,6 +342,37 @@ int main( int argc, char *argv[] ) {
     fclose(F_permAvg);
   }
   
+  else if( SparsePairs) { // Single strand, sparse storage
+    fprintf(F_permPr,"%d\n",length);
+    for( i = 0; i < length; i++) {
+      for( k = sparsePr.rowStart[i]; k < sparsePr.rowStart[i+1] - 1; k++) {
+        j = sparsePr.col[k];
+        if( j > i) {
+          if(!NUPACK_VALIDATE) {
+            fprintf(F_permPr,"%d\t%d\t%.4Le\n",
+                  i+1, j+1, (long double) sparsePr.prob[k]);
+          } else {
+            fprintf(F_permPr,"%d\t%d\t%.14Le\n",
+                  i+1, j+1, (long double) sparsePr.prob[k]);
+          }
+        }
+      }
+    }
+    j = length;
+    for(i = 0; i < length ; i++) {
+      k = sparsePr.rowStart[i+1] - 1;
+      if (sparsePr.prob[k] >= CUTOFF) {
+        if(!NUPACK_VALIDATE) {
+          fprintf(F_permPr,"%d\t%d\t%.4Le\n",
+                i+1, j+1, (long double) sparsePr.prob[k]);
+        } else {
+          fprintf(F_permPr,"%d\t%d\t%.14Le\n",
+                i+1, j+1, (long double) sparsePr.prob[k]);
+        }
+      }
+    }
+  }
+
   else { // Single strand
     fprintf(F_permPr,"%d\n",length);
     for( i = 0; i < length; i++) {
@@ -366,6 +448,10 @@ int main( int argc, char *argv[] ) {
     free(avgBp);
   }
 
+  if( SparsePairs) {
+    ClearSparsePairPr( &sparsePr);
+    pairPrSparse = NULL;
+  }
   free( pairPr);
   free( pairPrPbg);
   free( pairPrPb);
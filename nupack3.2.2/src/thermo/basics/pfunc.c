@@ -43,6 +43,8 @@
 
 #include <thermo/core.h>
 
+extern int SweepJobs;
+
 /* ************************************************ */
 
 int main( int argc, char *argv[] ) {
@@ -92,6 +94,19 @@ int main( int argc, char *argv[] ) {
   tmpLength = strlen( seq);
   convertSeq(seq, seqNum, tmpLength);
 
+  if( SweepRequested()) {
+    sweepCondition *conds;
+    int nConds = MakeSweepConditions( &conds);
+
+    RunSweep( seqNum, tmpLength, complexity, vs, conds, nConds, SweepJobs);
+
+    printf("%s\n%s Free energy, ensemble enthalpy and entropy, and mfe per condition:\n",
+           COMMENT_STRING,COMMENT_STRING);
+    PrintSweepTable( stdout, conds, nConds);
+    free( conds);
+    return 0;
+  }
+
   pf = pfuncFullWithSym(seqNum, complexity, DNARNACOUNT, DANGLETYPE, 
 			TEMP_K - ZERO_C_IN_KELVIN, 0, vs, SODIUM_CONC,
 			MAGNESIUM_CONC, USE_LONG_HELIX_FOR_SALT_CORRECTION);
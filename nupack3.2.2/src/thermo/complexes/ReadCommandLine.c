@@ -243,6 +243,12 @@ void DisplayHelpComplexes() {
   PrintNupackThermoHelp();
   printf("Additional options:\n");
   printf(" -cutoff CUTOFF   set the minimum stored probability/expected value\n");
+  printf(" -stream          read one JSON job per line of standard input (sequences,\n");
+  printf("                  max complex size, permutations, temperature) and write\n");
+  printf("                  one JSON result per line\n");
+  printf("Environment:\n");
+  printf(" NUPACK_PFCACHE   file in which to cache partition functions across runs;\n");
+  printf("                  runs naming the same file, even at once, share it\n");
   printf("\n");
 }
 /* ******************************************************************************** */
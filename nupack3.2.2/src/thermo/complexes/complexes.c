@@ -13,6 +13,9 @@
 */
 
 
+/* open_memstream (the build uses -std=c99) */
+#define _DEFAULT_SOURCE
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <memory.h>
@@ -26,6 +29,7 @@
 #include "complexesStructs.h"
 #include "complexesUtils.h"
 #include "permBG.h"
+#include "pfCache.h"
 #include "ReadCommandLine.h"
 
 extern int nStrands;
@@ -33,9 +37,13 @@ globalArgs_t globalArgs;
 
 
 
-int main( int argc, char **argv) {
+/* Computes the partition function of every complex of up to
+   maxComplexSize strands and of the nNewPerms orderings of newPerms (one
+   line of strand indices each), and writes the provenance blocks to out.
+   Returns the exit status of the run */
+static int RunComplexes(FILE *out, int argc, char **argv, char **seqs,
+      int maxComplexSize, int nNewPerms, char **newPerms, pfCache *cache){
 
-  char **seqs; // list of all seqs
   int *seqlength; // list of all seqlengths
 
   multiset *allSets;
@@ -47,11 +55,12 @@ int main( int argc, char **argv) {
   int maxLength;
 
   int maxListComplexSize = 0;
-  int maxComplexSize = 0;
   int nNewComplexes = 0;
-  int nNewPerms = 0;
 
   long double pf;
+  char *cacheKey = NULL;
+  int cacheKeyLen = 0;
+  unsigned long long paramHash = 0;
 
   double totalOrders;
   int nTotalOrders = 0;
@@ -84,66 +93,22 @@ int main( int argc, char **argv) {
   int len_provenance;
 
 
-  // global argument defaults
-  globalArgs.T = 37.0;
-  globalArgs.dangles = 1;
-  globalArgs.dopairs = 0;
-  globalArgs.parameters = RNA;
-  globalArgs.listonly = 0;
-  globalArgs.cutoff = 0.001; // cutoff bp probability to report
-  globalArgs.onlyOneMFE = 1;
-  globalArgs.sodiumconc = 1.0;
-  globalArgs.magnesiumconc = 0.0;
-  globalArgs.uselongsalt = 0;
-  strcpy(globalArgs.inputFilePrefix, "NoInputFile");
-
-
   TEMP_K = globalArgs.T + ZERO_C_IN_KELVIN;
 
-
-  /* read number of sequences
-   */
-  char newline;
-  printf("Enter number of different sequences: ");
-  scanf("%d%c", &nStrands, &newline);
-
-  // allocate function variables
-  seqs = (char**) malloc(sizeof(char*) * nStrands);
   seqlength = (int*) malloc(sizeof(int) * nStrands);
-
   maxLength = 0;
-
-  /* read sequences
-   */
   for(int i=0 ; i<=(nStrands-1) ; ++i) {
-    printf("Enter sequence %d:\n", i+1);
-    scanf("%s", line);
-    seqlength[i] = strlen(line);
+    seqlength[i] = strlen(seqs[i]);
 
     if(seqlength[i] > maxLength){
       maxLength = seqlength[i];
     }
-
-    seqs[i] = (char*) malloc(sizeof(char) * (seqlength[i]+1));
-    strcpy(seqs[i], line);
-  }
-
-  /* read max complex size
-   */
-  char *q, r[MAXLINE];
-  while (fgets(r, MAXLINE, stdin)){
-      maxComplexSize = strtol(r, &q, 10);
-      if (q == r || *q != '\n') {
-        printf("Enter max complex size to completely enumerate: ");
-      } else break;
   }
 
 
   // read information from .list file
   maxListComplexSize = maxComplexSize;
 
-  nNewPerms = nStrands;
-
   // determine total # of distinct strand orders (lovasz, 3.23b)
   totalOrders = nNewPerms;
 
@@ -181,8 +146,7 @@ int main( int argc, char **argv) {
   /* read permutations
    */
   for(int x=1 ; x<=nNewPerms ; ++x){
-    printf("Enter permutation %d: ", x);
-    fgets(line, MAXLINE, stdin);
+    strcpy(line, newPerms[x-1]);
 
     int curStrand;
     int curStrandIndex;
@@ -198,7 +162,7 @@ int main( int argc, char **argv) {
     allPermutations[offset].nSeqs = curNumStrands;
     allPermutations[offset].code = (int *) malloc(curNumStrands * sizeof(int));
     allPermutations[offset].strand_sums = (int *) malloc(nStrands * sizeof(int));
-    allPermutations[offset].symmetryFactor = 1;
+    allPermutations[offset].symmetryFactor = 0; // set by FillSets
     for(curStrand = 0; curStrand < nStrands ; curStrand++) {
       allPermutations[offset].strand_sums[curStrand] = 0;
     }
@@ -231,9 +195,7 @@ int main( int argc, char **argv) {
 
   // fill provenance block
   len_provenance = complexes_header(header, argc, argv);
-  for(int y=0 ; y<len_provenance ; ++y){
-    printf("%c", header[y]);
-  }
+  fwrite(header, sizeof(char), len_provenance, out);
 
   // free provenance block
   free(header);
@@ -256,9 +218,7 @@ int main( int argc, char **argv) {
   // fill provenance block
   len_provenance = complexes_parameters(parameters, nStrands, seqs,
         nTotalOrders);
-  for(int y=0 ; y<len_provenance ; ++y){
-    printf("%c", parameters[y]);
-  }
+  fwrite(parameters, sizeof(char), len_provenance, out);
 
   // free provenance block
   free(parameters);
@@ -288,6 +248,17 @@ int main( int argc, char **argv) {
   // allocate memory for pfSeq;
   char* pfSeq = (char*) malloc(sizeof(char) * (maxSeqLength + 1));
 
+  if(cache != NULL){
+    cacheKey = (char*) malloc(sizeof(char) * (maxSeqLength + MAXLINE));
+    // a parameter file may be edited in place, so key on its contents
+    if(globalArgs.parameters == USE_SPECIFIED_PARAMETERS_FILE){
+      paramHash = ParameterFilesHash(PARAM_FILE);
+    }
+  }
+
+  // orderings share the blocks of the strand segments they have in common
+  SEGMENT_MEMO = NewSegmentMemo(SEGMENT_MEMO_MAX_BYTES);
+
   permPr = (long double**) malloc(sizeof(long double*) * nStrands);
 
   for(int j=0; j<nStrands ; ++j) { // calloc initialize to zero
@@ -339,10 +310,29 @@ int main( int argc, char **argv) {
       int tmpLength = strlen(pfSeq); // store current sequence length
       int seqNum[MAXSEQLENGTH + 1];  // store current sequence as ints
       convertSeq(pfSeq, seqNum, tmpLength);
-      pf = pfuncFullWithSym(seqNum, 3, globalArgs.parameters,
-            globalArgs.dangles, globalArgs.T, globalArgs.dopairs,
-            currentPerm->symmetryFactor, globalArgs.sodiumconc,
-            globalArgs.magnesiumconc, globalArgs.uselongsalt);
+      // the key holds everything the partition function depends on
+      if(cache != NULL){
+        cacheKeyLen = sprintf(cacheKey,
+              "%s|%s|%d|%d|%s|%016llx|%d|%.17Le|%.17Le|%.17Le|%d|%d|%d",
+              NUPACK_VERSION, pfSeq, 3, globalArgs.parameters,
+              globalArgs.parameters == USE_SPECIFIED_PARAMETERS_FILE ?
+              PARAM_FILE : "", paramHash, globalArgs.dangles, globalArgs.T,
+              globalArgs.sodiumconc, globalArgs.magnesiumconc,
+              globalArgs.uselongsalt, globalArgs.dopairs,
+              currentPerm->symmetryFactor);
+      }
+      if(cache == NULL || globalArgs.dopairs ||
+         !pfCacheLookup(cache, cacheKey, cacheKeyLen, &pf)){
+        SegmentMemoSetStrands(SEGMENT_MEMO, currentPerm->code,
+              allSets[i].nSeqs);
+        pf = pfuncFullWithSym(seqNum, 3, globalArgs.parameters,
+              globalArgs.dangles, globalArgs.T, globalArgs.dopairs,
+              currentPerm->symmetryFactor, globalArgs.sodiumconc,
+              globalArgs.magnesiumconc, globalArgs.uselongsalt);
+        if(cache != NULL){
+          pfCacheStore(cache, cacheKey, cacheKeyLen, pf);
+        }
+      }
 
       /* echo provenance complexes starts
        */
@@ -363,9 +353,7 @@ int main( int argc, char **argv) {
       } else{
         len_provenance = complexes_results(complexes, lastCxId, permId, nStrands, allSets, i, pf, TEMP_K, LIST_ENDS);
       }
-      for(int y=0 ; y<len_provenance ; ++y){
-        printf("%c", complexes[y]);
-      }
+      fwrite(complexes, sizeof(char), len_provenance, out);
 
       // free provenance block
       free(complexes);
@@ -388,6 +376,8 @@ int main( int argc, char **argv) {
 
   }
 
+  FreeSegmentMemo(SEGMENT_MEMO);
+
   for(int j=0 ; j<nStrands ; ++j){ // free
     free(permPr[j]);
     permPr[j] = NULL;
@@ -397,17 +387,9 @@ int main( int argc, char **argv) {
 
   free( nicks); nicks = NULL;
 
-  for(int i=0 ; i<=(nStrands-1) ; ++i){
-    free(seqs[i]);
-    seqs[i] = NULL;
-  }
-
   free(seqlength);
   seqlength = NULL;
 
-  free(seqs);
-  seqs = NULL;
-
   for(int i=setStart ; i<=(totalSets-1) ; ++i){
     free(allSets[i].code);
     allSets[i].code = NULL;
@@ -429,9 +411,260 @@ int main( int argc, char **argv) {
 
   free(pfSeq);
   pfSeq = NULL;
+
+  free(cacheKey);
   /*
    * complexes calculation ends */
 
   return 0;
 }
 
+
+
+/* Reads the input of a -stream job: "sequences", "max complex size" and
+   "permutations", the extra orderings to evaluate (e.g. ["1 2 3"] or
+   [[1, 2, 3]]), plus an optional "temperature" (C).  Sets nStrands and
+   returns the number of sequences, or 0 (and a message) if the job is
+   malformed.  seqs and newPerms are allocated and left to the caller. */
+static int ReadComplexesJob(const streamJob *job, char ***seqs,
+      int *maxComplexSize, int *nNewPerms, char ***newPerms, char *error){
+
+  const jsonValue *sequences = StreamJobField(job, "sequences");
+  const jsonValue *perms = StreamJobField(job, "permutations");
+  const jsonValue *item;
+  double T;
+  char *token;
+  int code;
+  int n;
+
+  if(sequences == NULL || sequences->type != JSON_ARRAY
+     || sequences->nItems == 0 || sequences->nItems > MAXSTRANDS){
+    sprintf(error, "expected \"sequences\", a list of 1 to %d strands",
+          MAXSTRANDS);
+    return 0;
+  }
+  for(int i=0 ; i<sequences->nItems ; ++i){
+    item = &sequences->items[i];
+    if(item->type != JSON_STRING || !isStreamSequence(item->text)){
+      sprintf(error, "sequence %d is not made of A, C, G, T or U", i+1);
+      return 0;
+    }
+  }
+  nStrands = sequences->nItems;
+
+  if(!JsonInt(StreamJobField(job, "max complex size"), maxComplexSize)
+     || *maxComplexSize < 1){
+    strcpy(error, "expected a positive \"max complex size\"");
+    return 0;
+  }
+
+  if(StreamJobField(job, "temperature") != NULL){
+    if(!JsonDouble(StreamJobField(job, "temperature"), &T)){
+      strcpy(error, "invalid temperature");
+      return 0;
+    }
+    globalArgs.T = T;
+  }
+
+  // every ordering becomes the line the prompt would have read
+  *nNewPerms = 0;
+  if(perms != NULL && perms->type != JSON_ARRAY){
+    strcpy(error, "\"permutations\" must be a list");
+    return 0;
+  }
+  n = perms == NULL ? 0 : perms->nItems;
+  *newPerms = (char**) malloc(sizeof(char*) * (n + 1));
+  for(int x=0 ; x<n ; ++x){
+    item = &perms->items[x];
+    (*newPerms)[x] = (char*) calloc(MAXLINE, sizeof(char));
+    (*nNewPerms)++;
+    if(item->type == JSON_STRING && strlen(item->text) < MAXLINE - 1){
+      strcpy((*newPerms)[x], item->text);
+    }
+    else if(item->type == JSON_ARRAY && item->nItems < MAXLINE / 12){
+      for(int k=0 ; k<item->nItems ; ++k){
+        if(!JsonInt(&item->items[k], &code)){
+          (*newPerms)[x][0] = '\0';
+          break;
+        }
+        sprintf((*newPerms)[x] + strlen((*newPerms)[x]), "%d ", code);
+      }
+    }
+
+    // the indices have to name strands, and at least one
+    char line[MAXLINE];
+    strcpy(line, (*newPerms)[x]);
+    int curNumStrands = 0;
+    for(token = strtok(line, " ,\t\n"); token != NULL;
+        token = strtok(NULL, " ,\t\n")){
+      if(sscanf(token, "%d", &code) != 1 || code < 1 || code > nStrands){
+        break;
+      }
+      curNumStrands++;
+    }
+    if(token != NULL || curNumStrands == 0){
+      sprintf(error, "permutation %d is not a list of strand indices", x+1);
+      return 0;
+    }
+  }
+
+  *seqs = (char**) malloc(sizeof(char*) * nStrands);
+  for(int i=0 ; i<nStrands ; ++i){
+    (*seqs)[i] = sequences->items[i].text;
+  }
+  return nStrands;
+}
+
+
+
+/* -stream: one result line per job of standard input. The parameter
+   tables and the partition function cache stay open between jobs; the
+   pooled dynamic programming buffers are released after each one
+ */
+static void ServeJobs(int argc, char **argv, pfCache *cache){
+
+  char error[STREAM_ERROR_LEN];
+  char **seqs;
+  char **newPerms;
+  int maxComplexSize;
+  int nNewPerms;
+  int read;
+  int status;
+  long double T = globalArgs.T;
+  char *result;
+  size_t len;
+  FILE *out;
+  streamJob job;
+
+  while((read = ReadStreamJob(stdin, &job, error)) != 0){
+    seqs = newPerms = NULL;
+    nNewPerms = 0;
+    globalArgs.T = T;
+
+    if(read < 0 || !ReadComplexesJob(&job, &seqs, &maxComplexSize,
+          &nNewPerms, &newPerms, error)){
+      WriteStreamError(stdout, &job, 1, error);
+    }
+    else{
+      out = open_memstream(&result, &len);
+      status = RunComplexes(out, argc, argv, seqs, maxComplexSize, nNewPerms,
+            newPerms, cache);
+      fclose(out);
+      WriteStreamResult(stdout, &job, status, result, len);
+      free(result);
+    }
+
+    for(int x=0 ; x<nNewPerms ; ++x){
+      free(newPerms[x]);
+    }
+    free(newPerms);
+    free(seqs); // the sequences themselves belong to the job
+    FreeStreamJob(&job);
+    ClearLDoublesPool();
+  }
+}
+
+
+
+int main( int argc, char **argv) {
+
+  char **seqs; // list of all seqs
+  char **newPerms; // orderings to add to the enumerated ones
+  int maxComplexSize = 0;
+  int nNewPerms = 0;
+  int status;
+  int stream = 0;
+  pfCache *cache = NULL; // partition functions of earlier runs, if enabled
+  char line[MAXLINE];
+
+
+  // global argument defaults
+  globalArgs.T = 37.0;
+  globalArgs.dangles = 1;
+  globalArgs.dopairs = 0;
+  globalArgs.parameters = RNA;
+  globalArgs.listonly = 0;
+  globalArgs.cutoff = 0.001; // cutoff bp probability to report
+  globalArgs.onlyOneMFE = 1;
+  globalArgs.sodiumconc = 1.0;
+  globalArgs.magnesiumconc = 0.0;
+  globalArgs.uselongsalt = 0;
+  strcpy(globalArgs.inputFilePrefix, "NoInputFile");
+
+  for(int i=1 ; i<argc ; ++i){
+    if(strcmp(argv[i], "-stream") == 0 || strcmp(argv[i], "--stream") == 0){
+      stream = 1;
+    }
+  }
+
+  // opt-in partition function cache shared by every run that names it
+  if(getenv("NUPACK_PFCACHE") != NULL && getenv("NUPACK_PFCACHE")[0] != '\0'){
+    cache = pfCacheOpen(getenv("NUPACK_PFCACHE"));
+  }
+
+  if(stream){
+    ServeJobs(argc, argv, cache);
+    pfCacheClose(cache);
+    return 0;
+  }
+
+
+  /* read number of sequences
+   */
+  char newline;
+  printf("Enter number of different sequences: ");
+  scanf("%d%c", &nStrands, &newline);
+
+  // allocate function variables
+  seqs = (char**) malloc(sizeof(char*) * nStrands);
+
+  /* read sequences
+   */
+  for(int i=0 ; i<=(nStrands-1) ; ++i) {
+    printf("Enter sequence %d:\n", i+1);
+    scanf("%s", line);
+    seqs[i] = (char*) malloc(sizeof(char) * (strlen(line)+1));
+    strcpy(seqs[i], line);
+  }
+
+  /* read max complex size
+   */
+  char *q, r[MAXLINE];
+  while (fgets(r, MAXLINE, stdin)){
+      maxComplexSize = strtol(r, &q, 10);
+      if (q == r || *q != '\n') {
+        printf("Enter max complex size to completely enumerate: ");
+      } else break;
+  }
+
+  /* read permutations, one per strand
+   */
+  nNewPerms = nStrands;
+  newPerms = (char**) malloc(sizeof(char*) * nNewPerms);
+  for(int x=1 ; x<=nNewPerms ; ++x){
+    printf("Enter permutation %d: ", x);
+    // at the end of the input the line keeps what was last read
+    fgets(line, MAXLINE, stdin);
+    newPerms[x-1] = (char*) malloc(sizeof(char) * MAXLINE);
+    strcpy(newPerms[x-1], line);
+  }
+
+  status = RunComplexes(stdout, argc, argv, seqs, maxComplexSize, nNewPerms,
+        newPerms, cache);
+
+  for(int x=0 ; x<nNewPerms ; ++x){
+    free(newPerms[x]);
+  }
+  free(newPerms);
+  for(int i=0 ; i<=(nStrands-1) ; ++i){
+    free(seqs[i]);
+    seqs[i] = NULL;
+  }
+  free(seqs);
+  seqs = NULL;
+
+  pfCacheClose(cache);
+  ClearLDoublesPool();
+
+  return status;
+}
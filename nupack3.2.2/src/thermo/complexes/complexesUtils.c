@@ -84,28 +84,6 @@ void nextMultiset( int nStrands, int *oldCode, int *newCode, int *seqCount,
 }
 
 
-/* ***************** */
-int isCyclicP( int size, int *a, int *b) {
-  //determine if a and b are cyclic permutations of one another
-
-  int i,j;
-
-
-  i = 0;
-  while( i <= size-1) {
-    for( j = 0; j <= size-1; j++) {
-      if( a[j] != b[(i+j) % size]) {
-        break;
-      }
-    }
-    if( j == size) return TRUE;
-    i++;
-  }
-
-
-  return FALSE;
-}
-
 /* ************************* */
 void symmetryCheck( multiset *allSets, int i, permutation *pm) {
   int j, k;
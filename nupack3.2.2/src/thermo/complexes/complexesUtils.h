@@ -11,7 +11,6 @@ extern "C" {
 int getPermutation(int, int, int*);
 void resetNicks(int, int*);
 void nextMultiset(int, int*, int*, int*, int); //generate a multiset
-int isCyclicP(int, int*, int*); //check if a cyclic permutation
 void symmetryCheck(multiset*, int, permutation*); //check if symmetry
 void printPerms(FILE*, int, int, multiset*);
 void printMfesToFile(const dnaStructures *ds, FILE *fp,
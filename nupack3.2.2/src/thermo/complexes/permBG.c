@@ -5,25 +5,21 @@
 */
 
 /*======================================================================*/
-/* C program for distribution from the Combinatorial Object             */
-/* Server. Generate permutations of a multiset in Gray code order.      */
-/* This is the same version used in the book "Combinatorial Generation."*/
-/* The program can be modified, translated to other languages, etc.,    */
-/* so long as proper acknowledgement is given (author and source).      */  
-/* Programmer: Frank Ruskey, 1995.                                      */
-/* Programmer: Joe Sawada, 1997 (translation to C).                     */
-/* The latest version of this program may be found at the site          */
-/* http://www.theory.csc.uvic.ca/~cos/inf/mult/Multiset.html            */
+/* Fixed content necklaces are generated with the algorithm of          */
+/* J. Sawada, "A fast algorithm to generate necklaces with fixed        */
+/* content", Theoretical Computer Science 301 (2003) 477-489, as given   */
+/* on the Combinatorial Object Server                                   */
+/* http://www.theory.csc.uvic.ca/~cos/inf/neck/NecklaceInfo.html        */
 /*======================================================================*/
 
-// A direct CAT implementation of the Eades-McKay algorithm
-// modified to handle multisets.                           
-
-// This program takes as input t (the number of different elements 0..t )
-//	followed by the number of each element n(0).. n(t)  
-
-// modified by Robert Dirks 10/08/04
-// for incorporation into my multistranded pf code
+// Each necklace is built as its lexicographically smallest rotation, one
+// position at a time, over the strands still left in the content.  A
+// prefix a[1..t-1] whose longest Lyndon prefix has length p can only be
+// extended by a strand >= a[t-p], and the completed string is a necklace
+// exactly when p divides its length, in which case its rotational
+// symmetry is length/p.  Necklaces come out in lexicographic order, so no
+// circular duplicates are ever generated and nothing needs to be sorted
+// or compared afterwards.
 
 #include "permBG.h"
 #include <stdlib.h>
@@ -31,290 +27,130 @@
 #include "complexesUtils.h"
 
 
-//global variables
-int n,t,cnt,calls;
-int a[100], num[20], permsum[20], off[20];
-int dir[20];
-
-int **allPerms = NULL;
-int *integer = NULL;
-int nPrint;
+typedef struct {
+  int length; // strands in the complex
+  int nSymbols; // distinct strands in the complex
+  int *symbol; // their ids (from 1), in increasing order
+  int *num; // copies of each symbol not yet placed
+  int *a; // a[1..length]: the symbols of the prenecklace
+  permutation *location; // where to store the necklaces, or NULL
+  int *content; // strand_sums of every necklace
+  int nStrands;
+  int count; // necklaces generated so far
+} necklaceGen;
 
-/* ********* */
+/* ************ */
 
-void PrintIt() {
-  //"print to an array"
+static void storeNecklace( necklaceGen *g, int p) {
 
   int i;
-
-    
-  allPerms[cnt] = (int*) malloc( permsum[0]*sizeof(int));
-  
-  for(i=1; i<= permsum[0]; i++) {
-    allPerms[cnt][ i-1] = integer[ a[i]];
+  permutation *pm;
+
+  if( g->location != NULL) {
+    pm = g->location + g->count;
+    pm->nSeqs = g->length;
+    pm->code = (int*) malloc( g->length*sizeof(int));
+    pm->strand_sums = (int*) malloc( g->nStrands*sizeof(int));
+    pm->symmetryFactor = g->length/p;
+    for( i = 0; i < g->length; i++) {
+      pm->code[i] = g->symbol[ g->a[i+1]];
+    }
+    for( i = 0; i < g->nStrands; i++) {
+      pm->strand_sums[i] = g->content[i];
+    }
   }
-  
-  cnt++;
-
+  g->count++;
 }
 
 /* ************ */
 
-void BigGen( int t) {
+static void genNecklaces( necklaceGen *g, int t, int p) {
 
-	if (dir[t]) gen(t,permsum[t-1],permsum[t]);
-	else neg(t,permsum[t-1],permsum[t]);
-	
-	if (t>1) BigGen(t-1);
-	dir[t] = (dir[t] + 1)%2;
-	if (dir[t]) off[t] = off[t-1] + num[t-1];
-	else off[t] = off[t-1];
-
-}
+  int j;
 
-/* ***************** */
-	
-void swap(int t, int x, int y) {
-
-	int b,temp;
-
-	if (t>1) BigGen(t-1);
-	b = off[t-1];
-	temp = a[x+b];
-	a[x+b] = a[y+b];
-	a[y+b] = temp;
-	PrintIt();
-
-}
-/* **************** */
-	
-void gen( int t, int n, int k) { // This is the Eades-McKay algorithm
-
-	int i;
-
-	calls++;
-	if ((1<k) && (k<n)) {
-     		gen( t, n-2, k-2 );  swap( t, n-1, k-1 );
-     		neg( t, n-2, k-1 );  swap( t,  n, n-1 );
-     		gen( t, n-1, k );
-	}
-	else if (k == 1) {
-		for (i=n-1; i>= 1; i--) swap(t,i,i+1);
-	}
-}
-
-/* ***************** */
-		
-void neg( int t, int n, int k) {
-
-	int i;
-
-	calls++;
-	if ((1<k) && (k<n)) {
-     		neg( t, n-1, k );    swap( t,  n, n-1 );
-     		gen( t, n-2, k-1 );  swap( t, n-1, k-1 );
-     		neg( t, n-2, k-2 );  
-	}
-	else if (k == 1) {
-		for (i=1; i<=n-1; i++) swap(t,i,i+1);
-	}
-}
-
-/* ************** */
-
-void initializeMP( int size, int *multiPerm) { 
-  //computes all multiset permutations
-
-  int i,j;
-  int lastNum;
-  
-  nPrint = 1; //the first permutation is already set (multiPerm)
-  
-  t = 0;
-  lastNum = multiPerm[0];
-  for( i = 1; i <= size - 1; i++) {
-    if( multiPerm[i] != lastNum) {
-      lastNum = multiPerm[i];
-      t++;
-    }
+  if( t > g->length) {
+    if( g->length % p == 0) storeNecklace( g, p);
+    return;
   }
-  
-  integer = (int*) malloc( (t+1)*sizeof(int));
-  
-  j = 0;
-  for( i = 0; i <= t; i++) {
-    dir[i] = 1;
-    num[i] = 0;
-    integer[i] = lastNum = multiPerm[j];
-    while( j <= size-1 && multiPerm[j] == lastNum) {
-      a[j+1] = i;
-      num[i]++;
-      j++;
+
+  for( j = g->a[t-p]; j < g->nSymbols; j++) {
+    if( g->num[j] > 0) {
+      g->a[t] = j;
+      g->num[j]--;
+      if( j == g->a[t-p]) genNecklaces( g, t+1, p);
+      else genNecklaces( g, t+1, t);
+      g->num[j]++;
     }
   }
-  
-  //allocate memory
-  allPerms = (int **) malloc( ((int) factorial(size))*
-			      sizeof( int*) );
-  
-  off[0] = 0;
-  for(i=1; i<=t; i++) off[i] = off[i-1] + num[i-1];
-  dir[t+1] = 1;
-  permsum[t] = num[t];
-  for(i=t-1; i>=0; i--)  permsum[i] = permsum[i+1] + num[i];
-  
-  cnt = 0;  calls = 0;  
-  PrintIt();
-  BigGen( t );
 }
 
-/* ***************** */
-int nextPerm() {
-  
-  if( nPrint == cnt) {
-    freeMP();
-    return 0;
-  } 
-
-  nPrint++;
-  return 1;
-}
+/* ************ */
 
-// if location is NULL, return the number of permutations but save nothing.
+// if location is NULL, return the number of necklaces but save nothing.
 int makeFCPermutations(permutation * location, int * content, int length, int nStrands) {
-  // Generate all permutations and check for symmetry 
-  int * current_code = (int *) calloc(length, sizeof(int));
-  int offset = 0;
-  int permi = 0;
-  int strandi = 0;
-  int strandj = 0;
-  int codei = 0;
-  int codek = 0;
-  int codel = 0;
-
-  permutation * head = NULL; // points to the head of a temporary linked list for counting
-  permutation * curPerm = NULL;
-
-  //location[offset].nSeqs = length;
-  //location[offset].code = (int*) calloc(length,sizeof(int));
-  //location[offset].strand_sums = (int*) calloc(nStrands,sizeof(int));
-  strandj = 0;
-  for(strandi = 0 ; strandi < nStrands ; strandi++) {
-    // location[offset].strand_sums[strandi] = content[strandi];
-    for(codei = 0 ; codei < content[strandi] ; codei++) {
-      if(strandj >= length) {
-        fprintf(stderr,"Internal error: too many strands in complex\n");
-        exit(1);
-      }
-      current_code[strandj] = 1 + strandi;
-      strandj++;
+
+  int strandi;
+  int total = 0;
+  necklaceGen g;
+
+  g.length = length;
+  g.nStrands = nStrands;
+  g.content = content;
+  g.location = location;
+  g.count = 0;
+  g.symbol = (int*) malloc( nStrands*sizeof(int));
+  g.num = (int*) malloc( nStrands*sizeof(int));
+  g.a = (int*) malloc( (length+1)*sizeof(int));
+
+  g.nSymbols = 0;
+  for( strandi = 0; strandi < nStrands; strandi++) {
+    if( content[strandi] > 0) {
+      g.symbol[ g.nSymbols] = strandi + 1;
+      g.num[ g.nSymbols] = content[strandi];
+      g.nSymbols++;
+      total += content[strandi];
     }
   }
+  if( total != length) {
+    fprintf(stderr,"Internal error: too many strands in complex\n");
+    exit(1);
+  }
 
-  if(location != NULL) {
-    location[offset].nSeqs = length;
-    location[offset].code = (int*)malloc(length * sizeof(int));
-    location[offset].strand_sums = (int*) malloc(nStrands * sizeof(int));
-    location[offset].symmetryFactor = 1;
-    for(codei = 0; codei < length ; codei++) {
-      location[offset].code[codei] = current_code[codei];
-    }
-    for(strandi = 0; strandi < nStrands ; strandi++) {
-      location[offset].strand_sums[strandi] = content[strandi];
-    }
-    offset ++;
-  } else {
-    head = (permutation *) malloc(sizeof(permutation));
-    curPerm = head;
-    curPerm->nSeqs = length;
-    curPerm->code = (int*)malloc(length * sizeof(int));
-    for(codei = 0; codei < length ; codei++) {
-      curPerm->code[codei] = current_code[codei];
-    }
-    curPerm->next = NULL;
-    offset ++;
+  // every necklace starts with its smallest strand
+  if( length > 0) {
+    g.a[0] = 0;
+    g.a[1] = 0;
+    g.num[0]--;
+    genNecklaces( &g, 2, 1);
   }
 
+  free( g.symbol);
+  free( g.num);
+  free( g.a);
+  return g.count;
+}
 
-  while(1) {
-    // Generate all permutations of the set
-    codek = -1;
-    for(codei = 1 ; codei < length - 1; codei++) {
-      if(current_code[codei] < current_code[codei + 1]) {
-        codek = codei;
-      }
-    }
-    if(codek == -1) {
-      break;
-    }
-    codel = codek + 1;
-    for(codei = codek + 1; codei < length; codei++) {
-      if(current_code[codek] < current_code[codei]) {
-        codel = codei;
-      }
-    }
-    strandi = current_code[codek];
-    current_code[codek] = current_code[codel];
-    current_code[codel] = strandi;
-
-    codel = length - 1;
-    int distance = (length - codek - 1) / 2;
-    for(codei = 0 ; codei < distance ; codei++) {
-      strandi = current_code[codek + 1 + codei] ;
-      current_code[codek + 1 + codei] = current_code[length - codei - 1] ;
-      current_code[length - codei - 1] = strandi;
-    }
-    int present = 0;
-    if(location != NULL) {
-      for(permi = 0 ; permi < offset ; permi++) {
-        if(!present && isCyclicP(length,current_code,location[permi].code)) {
-          present = 1;
-          break;
-        }
-      }
-      if(!present ) {
-        location[offset].nSeqs = length;
-        location[offset].code = (int*)malloc(length * sizeof(int));
-        location[offset].strand_sums = (int*) malloc(nStrands * sizeof(int));
-        for(codei = 0; codei < length ; codei++) {
-          location[offset].code[codei] = current_code[codei];
-        }
-        for(strandi = 0; strandi < nStrands ; strandi++) {
-          location[offset].strand_sums[strandi] = content[strandi];
-        }
-        offset++;
-      }
-    } else {
-      curPerm = head;
-      while(NULL != curPerm) {
-        if(!present && isCyclicP(length,current_code,curPerm->code)) {
-          present = 1;
-          break;
-        }
-        curPerm = curPerm->next;
-      }
-      if(!present) {
-        curPerm = head;
-        head = (permutation*)malloc(sizeof(permutation));
-        head->code = (int*)malloc(length * sizeof(int));
-        for(codei = 0 ; codei < length ; codei++) {
-          head->code[codei] = current_code[codei];
-        }
-        head->next = curPerm;
-        offset++;
-      }
-    }
+/* ************ */
+
+static int makeCompositionPermutations( permutation * location, int * content,
+                                        int strandi, int left, int length,
+                                        int nStrands) {
+  // the necklaces of every content of size length that agrees with
+  // content[0..strandi-1], largest content[strandi] first
+  int added = 0;
+  int c;
+
+  if( strandi == nStrands - 1) {
+    content[strandi] = left;
+    return makeFCPermutations( location, content, length, nStrands);
   }
-  if(head) {
-    while(NULL != head) {
-      curPerm = head;
-      head = head->next;
-      free(curPerm->code);
-      free(curPerm);
-    }
+  for( c = left; c >= 0; c--) {
+    content[strandi] = c;
+    added += makeCompositionPermutations( location == NULL ? NULL : location + added,
+                                          content, strandi + 1, left - c,
+                                          length, nStrands);
   }
-  free(current_code);
-  return offset;
+  return added;
 }
 
 
@@ -371,7 +207,6 @@ int FillSets(multiset * allSets, permutation * allPermutations,
       allPermutations[permi].baseCode = (int*)malloc(allSets[seti].totalLength * 2 * sizeof(int));
       allPermutations[permi].seq = (char *)malloc((allSets[seti].totalLength 
                                   + allSets[seti].nSeqs)*sizeof(char));
-      allPermutations[permi].symmetryFactor = 1;
 
       basej = 0;
       for(strandi = 0; strandi < allPermutations[permi].nSeqs; strandi++) {
@@ -382,7 +217,10 @@ int FillSets(multiset * allSets, permutation * allPermutations,
         }
       }
 
-      symmetryCheck(allSets,seti,allPermutations + permi);
+      // necklaces come with their symmetry, permutations read in do not
+      if(allPermutations[permi].symmetryFactor == 0) {
+        symmetryCheck(allSets,seti,allPermutations + permi);
+      }
       permi++;
       // We are out of permutations
       if(permi >= totalPerms) {
@@ -451,78 +289,9 @@ int GetMaxComplexSize(multiset * allSets, int totalSets) {
 /* ************* */
 // return the number of permutations generated
 int makePermutations(permutation * location, int length, int nStrands) {
-  int * current_code = (int *) calloc(length + 1, sizeof(int));
-  int offset = 0;
-  int code_counter = 0;
-  int i = length;
-  int j = 0;
-  int test = nStrands > 1;
-
-  location[offset].nSeqs = length;
-  location[offset].code = (int*) calloc(length,sizeof(int));
-  location[offset].strand_sums = (int*) calloc(nStrands,sizeof(int));
-  for(code_counter = 0 ; code_counter < length ; code_counter++) {
-    int current_strand = current_code[code_counter + 1] + 1;
-    location[offset].code[code_counter] = current_strand;
-    location[offset].strand_sums[current_strand - 1] ++;
-  }
-  offset ++;
-  
-  while(test) {
-    current_code[i] = current_code[i] + 1;
-    for(j = 1 ; j <= length - i ; j++) {
-      current_code[i + j] = current_code[j];
-    }
-    if(length % i == 0) {
-      location[offset].nSeqs = length;
-      location[offset].code = (int *) calloc(length, sizeof(int));
-      location[offset].strand_sums = (int *)calloc(nStrands,sizeof(int));
-      for(code_counter = 0; code_counter < length ; code_counter++) {
-        int current_strand = current_code[code_counter + 1] + 1;
-        location[offset].code[code_counter] = current_strand;
-        location[offset].strand_sums[current_strand - 1] ++;
-      }
-      offset++;
-    }
-    i = length;
-    while(current_code[i] == nStrands - 1) {
-      i = i - 1;
-    }
-    test = i != 0;
-  }
-  free(current_code);
+  int * content = (int *) calloc(nStrands, sizeof(int));
+  int offset = makeCompositionPermutations(location, content, 0, length,
+                                           length, nStrands);
+  free(content);
   return offset;
 }
-
-/* ************* */
-
-void setPerm( int *perm) {
-  
-  int i;
-
-  if( nPrint <= 0 || nPrint >= cnt+1) {
-    printf("Error, setPerm called illegally!\n");
-    exit(1);
-  }
-
-  //printf("%d %d\n", nPrint-1, permsum[0]-1);
-  for(i=0; i<= permsum[0]-1; i++) {
-    perm[i] = allPerms[nPrint-1][ i];
-  }
-
-}
-
-/* ************** */
-void freeMP() {
-  
-  int i;
-
-  free( integer); integer = NULL;
-  for( i = 0; i <= cnt - 1; i++) {
-    free( allPerms[i]); allPerms[i] = NULL;
-  }
-  free( allPerms); allPerms = NULL;
-
-}
-  
-
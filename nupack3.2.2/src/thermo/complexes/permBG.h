@@ -7,15 +7,6 @@
 extern "C" {
 #endif /* __cplusplus */
 
-void neg(int t, int n, int k);
-void gen(int t, int n, int k);
-void PrintIt(void);
-void BigGen(int);
-void swap(int, int, int);
-void initializeMP(int, int*);
-void freeMP(void);
-int nextPerm(void);
-void setPerm(int*);
 // Count the number of sets in a list of permutations
 int CountSets(permutation * perms, int nPerms, int nStrands);
 // Get the maximum complex size
@@ -24,14 +15,12 @@ int GetMaxComplexSize(multiset * allSets, int totalSets);
 int FillSets(multiset * allSets, permutation * allPermutations,
              int totalSets, int totalPerms,
              int nStrands, int * seqlength);
-// Generate fixed content necklaces.
-// There is a more efficient algorithm
-// (see Sawada 2003) but we don't need this for the commonly used (and actually
-// documented) use cases of the executable. The only time this is used is when a
-// C line stands alone and we need to generate all necklaces for that complex.
+// Generate the fixed content necklaces (Sawada 2003) of the complex with
+// composition[i] copies of strand i+1, in lexicographic order and with their
+// symmetry factors. With loc NULL, only count them.
 int makeFCPermutations(permutation * loc, int * composition, int length, int nStrands);
 // fill out circular permutations of length "length" and
-// alphabet size "nStrands"
+// alphabet size "nStrands", in the order of comparePermutations
 int makePermutations(permutation * loc, int length, int nStrands);
 
 #ifdef __cplusplus
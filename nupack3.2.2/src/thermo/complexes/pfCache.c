@@ -0,0 +1,288 @@
+/*
+  pfCache.c is part of the NUPACK software suite
+  Copyright (c) 2007 Caltech. All rights reserved.
+
+  On-disk partition function cache for complexes (see pfCache.h).
+
+  The file holds a header followed by PF_CACHE_SLOTS slots of 64 bytes.
+  It is created sparse, so only the pages that hold entries take up
+  disk space.  A slot goes from empty to claimed (by the compare-and-swap
+  of the process that writes it) to ready, and readers only trust ready
+  slots.  A process that dies holding a claim leaves that slot unused.
+*/
+
+/* flock, ftruncate, mmap (the build uses -std=c99) */
+#define _DEFAULT_SOURCE
+
+#include "pfCache.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define PF_CACHE_MAGIC "NPKPFC01"
+#define PF_CACHE_SLOTS (1 << 20) // a power of 2
+#define PF_CACHE_MAX_PROBE 64 // slots searched for a key before giving up
+
+enum { SLOT_EMPTY = 0, SLOT_CLAIMED = 1, SLOT_READY = 2 };
+
+typedef struct {
+  char magic[8];
+  uint32_t slotSize;
+  uint32_t longDoubleSize; // the cache is only valid on like machines
+  uint64_t nSlots;
+  char unused[40];
+} pfCacheHeader;
+
+typedef struct {
+  uint32_t state;
+  uint32_t unused;
+  unsigned char digest[32];
+  long double pf;
+  char pad[64 - 40 - sizeof(long double)];
+} pfCacheSlot;
+
+struct pfCache {
+  int fd;
+  size_t size;
+  pfCacheHeader *header;
+  pfCacheSlot *slots;
+  uint64_t mask;
+};
+
+
+/* ******************** */
+/* SHA-256 (FIPS 180-4) */
+static const uint32_t sha256K[64] = {
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+  0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+  0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+  0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+  0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+  0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+  0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+  0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+  0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+#define ROTR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+static void sha256Block( uint32_t h[8], const unsigned char *p) {
+
+  uint32_t w[64], a, b, c, d, e, f, g, k, t1, t2;
+  int i;
+
+  for( i = 0; i < 16; i++) {
+    w[i] = ((uint32_t) p[4*i] << 24) | ((uint32_t) p[4*i+1] << 16) |
+      ((uint32_t) p[4*i+2] << 8) | (uint32_t) p[4*i+3];
+  }
+  for( i = 16; i < 64; i++) {
+    w[i] = w[i-16] + (ROTR(w[i-15], 7) ^ ROTR(w[i-15], 18) ^ (w[i-15] >> 3))
+      + w[i-7] + (ROTR(w[i-2], 17) ^ ROTR(w[i-2], 19) ^ (w[i-2] >> 10));
+  }
+
+  a = h[0]; b = h[1]; c = h[2]; d = h[3];
+  e = h[4]; f = h[5]; g = h[6]; k = h[7];
+  for( i = 0; i < 64; i++) {
+    t1 = k + (ROTR(e, 6) ^ ROTR(e, 11) ^ ROTR(e, 25)) + ((e & f) ^ (~e & g))
+      + sha256K[i] + w[i];
+    t2 = (ROTR(a, 2) ^ ROTR(a, 13) ^ ROTR(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+    k = g; g = f; f = e; e = d + t1;
+    d = c; c = b; b = a; a = t1 + t2;
+  }
+  h[0] += a; h[1] += b; h[2] += c; h[3] += d;
+  h[4] += e; h[5] += f; h[6] += g; h[7] += k;
+}
+
+static void sha256( const char *msg, size_t len, unsigned char digest[32]) {
+
+  uint32_t h[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+  };
+  unsigned char last[128];
+  size_t i, rest, nLast;
+  uint64_t bits = (uint64_t) len * 8;
+
+  for( i = 0; i + 64 <= len; i += 64) {
+    sha256Block( h, (const unsigned char *) msg + i);
+  }
+
+  // pad with a 1 bit, zeros and the length in bits
+  rest = len - i;
+  memcpy( last, msg + i, rest);
+  last[rest] = 0x80;
+  nLast = rest + 9 <= 64 ? 64 : 128;
+  memset( last + rest + 1, 0, nLast - rest - 1);
+  for( i = 0; i < 8; i++) {
+    last[nLast - 1 - i] = (unsigned char) (bits >> (8*i));
+  }
+  sha256Block( h, last);
+  if( nLast == 128) sha256Block( h, last + 64);
+
+  for( i = 0; i < 8; i++) {
+    digest[4*i] = (unsigned char) (h[i] >> 24);
+    digest[4*i+1] = (unsigned char) (h[i] >> 16);
+    digest[4*i+2] = (unsigned char) (h[i] >> 8);
+    digest[4*i+3] = (unsigned char) h[i];
+  }
+}
+
+
+/* ******************** */
+static uint64_t firstSlot( const pfCache *cache, const unsigned char digest[32]) {
+
+  uint64_t x = 0;
+  int i;
+
+  for( i = 0; i < 8; i++) {
+    x = (x << 8) | digest[i];
+  }
+  return x & cache->mask;
+}
+
+
+/* ******************** */
+pfCache *pfCacheOpen( const char *filename) {
+
+  pfCache *cache;
+  pfCacheHeader header;
+  struct stat st;
+  int fd;
+  size_t size = sizeof(pfCacheHeader) + (size_t) PF_CACHE_SLOTS*sizeof(pfCacheSlot);
+  void *map;
+
+  if( (fd = open( filename, O_RDWR | O_CREAT, 0666)) < 0) {
+    fprintf( stderr, "WARNING: unable to open pf cache %s; not using it\n",
+             filename);
+    return NULL;
+  }
+
+  // one process at a time lays out a new file
+  flock( fd, LOCK_EX);
+  if( fstat( fd, &st) != 0) {
+    st.st_size = -1;
+  }
+  if( st.st_size == 0) {
+    memset( &header, 0, sizeof(header));
+    memcpy( header.magic, PF_CACHE_MAGIC, 8);
+    header.slotSize = sizeof(pfCacheSlot);
+    header.longDoubleSize = sizeof(long double);
+    header.nSlots = PF_CACHE_SLOTS;
+    if( ftruncate( fd, size) != 0 ||
+        pwrite( fd, &header, sizeof(header), 0) != (ssize_t) sizeof(header)) {
+      st.st_size = -1;
+    }
+    else {
+      st.st_size = size;
+    }
+  }
+  else if( st.st_size > 0 &&
+           (pread( fd, &header, sizeof(header), 0) != (ssize_t) sizeof(header) ||
+            memcmp( header.magic, PF_CACHE_MAGIC, 8) != 0 ||
+            header.slotSize != sizeof(pfCacheSlot) ||
+            header.longDoubleSize != sizeof(long double) ||
+            header.nSlots != PF_CACHE_SLOTS)) {
+    st.st_size = -1;
+  }
+  flock( fd, LOCK_UN);
+
+  if( st.st_size != (off_t) size) {
+    fprintf( stderr, "WARNING: %s is not a pf cache of this build; "
+             "not using it\n", filename);
+    close( fd);
+    return NULL;
+  }
+
+  map = mmap( NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if( map == MAP_FAILED) {
+    fprintf( stderr, "WARNING: unable to map pf cache %s; not using it\n",
+             filename);
+    close( fd);
+    return NULL;
+  }
+
+  cache = (pfCache *) malloc( sizeof(pfCache));
+  cache->fd = fd;
+  cache->size = size;
+  cache->header = (pfCacheHeader *) map;
+  cache->slots = (pfCacheSlot *) ((char *) map + sizeof(pfCacheHeader));
+  cache->mask = PF_CACHE_SLOTS - 1;
+  return cache;
+}
+
+
+/* ******************** */
+void pfCacheClose( pfCache *cache) {
+
+  if( cache == NULL) return;
+  munmap( cache->header, cache->size);
+  close( cache->fd);
+  free( cache);
+}
+
+
+/* ******************** */
+int pfCacheLookup( pfCache *cache, const char *key, size_t len,
+                   long double *pf) {
+
+  unsigned char digest[32];
+  uint64_t s;
+  uint32_t state;
+  pfCacheSlot *slot;
+  int probe;
+
+  sha256( key, len, digest);
+  s = firstSlot( cache, digest);
+  for( probe = 0; probe < PF_CACHE_MAX_PROBE; probe++) {
+    slot = cache->slots + ((s + probe) & cache->mask);
+    state = __atomic_load_n( &slot->state, __ATOMIC_ACQUIRE);
+    if( state == SLOT_EMPTY) {
+      return 0;
+    }
+    if( state == SLOT_READY && memcmp( slot->digest, digest, 32) == 0) {
+      *pf = slot->pf;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+
+/* ******************** */
+void pfCacheStore( pfCache *cache, const char *key, size_t len,
+                   long double pf) {
+
+  unsigned char digest[32];
+  uint64_t s;
+  uint32_t state;
+  pfCacheSlot *slot;
+  int probe;
+
+  sha256( key, len, digest);
+  s = firstSlot( cache, digest);
+  for( probe = 0; probe < PF_CACHE_MAX_PROBE; probe++) {
+    slot = cache->slots + ((s + probe) & cache->mask);
+    state = __atomic_load_n( &slot->state, __ATOMIC_ACQUIRE);
+    if( state == SLOT_EMPTY &&
+        __atomic_compare_exchange_n( &slot->state, &state, SLOT_CLAIMED, 0,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+      memcpy( slot->digest, digest, 32);
+      slot->pf = pf;
+      __atomic_store_n( &slot->state, SLOT_READY, __ATOMIC_RELEASE);
+      return;
+    }
+    // state holds what another process left in the slot
+    if( state == SLOT_READY && memcmp( slot->digest, digest, 32) == 0) {
+      return;
+    }
+  }
+}
@@ -0,0 +1,43 @@
+#ifndef NUPACK_COMPLEXES_PFCACHE_H__
+#define NUPACK_COMPLEXES_PFCACHE_H__
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* On-disk cache of partition functions, used by complexes when
+   NUPACK_PFCACHE names the cache file.
+
+   The file is a fixed-size open-addressing hash table that every run
+   maps shared.  Entries are keyed by the SHA-256 digest of a string
+   describing the calculation (the ordered strand sequences and every
+   model setting, with the contents of a user parameter file), so runs
+   on overlapping strand sets find each other's orderings.  Slots are
+   claimed with an atomic compare-and-swap and published only once
+   written, so any number of processes may read and write one cache
+   file at the same time. */
+
+typedef struct pfCache pfCache;
+
+// Opens (creating it if needed) the cache file, or returns NULL with a
+// warning if it cannot be used; the run then goes on without a cache.
+pfCache *pfCacheOpen(const char *filename);
+
+void pfCacheClose(pfCache *cache);
+
+// Returns 1 and sets *pf if the key is in the cache, 0 otherwise.
+int pfCacheLookup(pfCache *cache, const char *key, size_t len,
+                  long double *pf);
+
+// Adds the key; does nothing if it is already there or the table is full
+// around it.
+void pfCacheStore(pfCache *cache, const char *key, size_t len,
+                  long double pf);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* NUPACK_COMPLEXES_PFCACHE_H__ */
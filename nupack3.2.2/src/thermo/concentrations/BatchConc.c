@@ -0,0 +1,262 @@
+/*
+ * BatchConc.c is part of the NUPACK software suite
+ * Copyright (c) 2007 Caltech. All rights reserved.
+ *
+ * Batch mode of concentrations (-batch). Titrations and melt series solve
+ * one complex set for many nearly identical conditions, so each row of the
+ * batch file is warm-started from the solution of the row before it.
+ * The rows are split into contiguous runs among -batchjobs forked workers,
+ * which write their results to a shared mapping (the solver's random
+ * restarts use the global Mersenne twister, so workers are processes
+ * rather than threads).
+ *
+ * Each row of the batch file holds the total concentration IN MOLAR of every
+ * strand, optionally followed by a temperature (C) and the free energy of
+ * every complex IN KCAL/MOL, in the order of the ocx input. Rows without
+ * free energies use those of the ocx input. Blank lines and lines starting
+ * with % or # are ignored.
+ */
+
+/* fork, waitpid, sysconf, mmap, getline (the build uses -std=c99) */
+#define _DEFAULT_SOURCE
+
+#include "constants.h"
+#include "CalcConc.h"
+#include "BatchConc.h"
+
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+
+/* Reads the batch file into bc. G (units of kT at the given temperature)
+ * holds the free energies read from standard input.
+ */
+void ReadBatchConditions(BatchConditions *bc, char *filename, int numSS,
+        int numTotal, double *G, double temperature){
+
+  FILE *fp;
+  char *line = NULL;
+  size_t lineCap = 0;
+  char separators[] = " \t,\n\r";
+  char *tok;
+  double *values;
+  int nValues;
+  int maxCond = 16;
+  int k, n;
+  double kT;
+
+  if ((fp = fopen(filename, "r")) == NULL) {
+    fprintf(stderr, "Error opening batch file %s\n", filename);
+    exit(ERR_CON);
+  }
+
+  bc->numSS = numSS;
+  bc->numTotal = numTotal;
+  bc->nCond = 0;
+  bc->x0 = malloc(sizeof(double) * maxCond * numSS);
+  bc->G = malloc(sizeof(double) * maxCond * numTotal);
+  bc->temperature = malloc(sizeof(double) * maxCond);
+  bc->MolesWaterPerLiter = malloc(sizeof(double) * maxCond);
+  values = malloc(sizeof(double) * (numSS + 1 + numTotal));
+
+  while (getline(&line, &lineCap, fp) != -1) {
+
+    nValues = 0;
+    for (tok = strtok(line, separators); tok != NULL;
+         tok = strtok(NULL, separators)) {
+      if (nValues == 0 && (tok[0] == '%' || tok[0] == '#')) {
+        break;
+      }
+      if (nValues == numSS + 1 + numTotal) {
+        nValues++;
+        break;
+      }
+      values[nValues++] = str2double(tok);
+    }
+    if (nValues == 0) {
+      continue;
+    }
+    if (nValues != numSS && nValues != numSS + 1 + numTotal) {
+      fprintf(stderr, "Batch condition %d: expected %d or %d values\n",
+          bc->nCond + 1, numSS, numSS + 1 + numTotal);
+      exit(ERR_BADROWINP);
+    }
+
+    if (bc->nCond == maxCond) {
+      maxCond *= 2;
+      bc->x0 = realloc(bc->x0, sizeof(double) * maxCond * numSS);
+      bc->G = realloc(bc->G, sizeof(double) * maxCond * numTotal);
+      bc->temperature = realloc(bc->temperature, sizeof(double) * maxCond);
+      bc->MolesWaterPerLiter = realloc(bc->MolesWaterPerLiter,
+          sizeof(double) * maxCond);
+    }
+
+    k = bc->nCond;
+    if (nValues == numSS) {
+      bc->temperature[k] = temperature;
+      for (n = 0; n < numTotal; n++) {
+        bc->G[k*numTotal + n] = G[n];
+      }
+    }
+    else {
+      bc->temperature[k] = values[numSS];
+      kT = kB*(bc->temperature[k] + ZERO_C_IN_KELVIN);
+      for (n = 0; n < numTotal; n++) {
+        bc->G[k*numTotal + n] = values[numSS + 1 + n] / kT;
+      }
+    }
+    bc->MolesWaterPerLiter[k] = WaterDensity(bc->temperature[k]);
+    for (n = 0; n < numSS; n++) {
+      bc->x0[k*numSS + n] = values[n] / bc->MolesWaterPerLiter[k];
+    }
+    bc->nCond++;
+  }
+
+  free(values);
+  free(line);
+  fclose(fp);
+}
+
+
+
+void FreeBatchConditions(BatchConditions *bc){
+  free(bc->x0);
+  free(bc->G);
+  free(bc->temperature);
+  free(bc->MolesWaterPerLiter);
+}
+
+
+
+/* Solves conditions first..last-1 in order, each warm-started from the one
+ * before it once a solve has converged
+ */
+static void SolveBatchRun(BatchConditions *bc, CalcConcWorkspace *ws,
+        int first, int last, double *x, int *converged, int *iters,
+        int MaxIters, double tol, double deltaBar, double eta, int MaxNoStep,
+        int MaxTrial, double PerturbScale, unsigned long seed){
+
+  int numSS = bc->numSS;
+  int numTotal = bc->numTotal;
+
+  ws->WarmStart = 0;
+  for (int k=first ; k<last ; ++k){
+    converged[k] = CalcConcWithWorkspace(ws, &x[k*numTotal],
+        &bc->G[k*numTotal], &bc->x0[k*numSS], MaxIters, tol, deltaBar, eta,
+        kB*(bc->temperature[k] + ZERO_C_IN_KELVIN), MaxNoStep, MaxTrial,
+        PerturbScale, bc->MolesWaterPerLiter[k], seed);
+    iters[k] = ws->Iters;
+    ws->WarmStart = converged[k];
+  }
+}
+
+
+
+/* Solves every condition of bc. x holds nCond x numTotal mole fractions on
+ * return, converged and iters one entry per condition.
+ */
+void RunBatchConc(BatchConditions *bc, int **A, double *x, int *converged,
+        int *iters, int nJobs, int MaxIters, double tol, double deltaBar,
+        double eta, int MaxNoStep, int MaxTrial, double PerturbScale,
+        unsigned long seed){
+
+  int nCond = bc->nCond;
+  int numTotal = bc->numTotal;
+  int w, status, failed = 0;
+  size_t nBytes;
+  pid_t *workers;
+  double *sharedx;
+  int *sharedConverged, *sharedIters;
+  CalcConcWorkspace *ws;
+
+  if (nJobs <= 0) nJobs = (int) sysconf(_SC_NPROCESSORS_ONLN);
+  if (nJobs > nCond) nJobs = nCond;
+
+  ws = NewCalcConcWorkspace(bc->numSS, numTotal);
+  SetCalcConcStoichiometry(ws, A);
+
+  if (nJobs <= 1) {
+    SolveBatchRun(bc, ws, 0, nCond, x, converged, iters, MaxIters, tol,
+        deltaBar, eta, MaxNoStep, MaxTrial, PerturbScale, seed);
+    FreeCalcConcWorkspace(ws);
+    return;
+  }
+
+  nBytes = sizeof(double) * nCond * numTotal + 2 * sizeof(int) * nCond;
+  sharedx = mmap(NULL, nBytes, PROT_READ | PROT_WRITE,
+      MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (sharedx == MAP_FAILED) {
+    fprintf(stderr, "RunBatchConc: unable to map %lu bytes\n",
+        (unsigned long) nBytes);
+    exit(1);
+  }
+  sharedConverged = (int *) (sharedx + nCond * numTotal);
+  sharedIters = sharedConverged + nCond;
+
+  workers = malloc(sizeof(pid_t) * nJobs);
+  fflush(NULL);
+
+  for (w = 0; w < nJobs; w++) {
+    workers[w] = fork();
+    if (workers[w] < 0) {
+      fprintf(stderr, "RunBatchConc: unable to start worker %d\n", w);
+      exit(1);
+    }
+    if (workers[w] == 0) {
+      SolveBatchRun(bc, ws, (int) ((long) w * nCond / nJobs),
+          (int) ((long) (w + 1) * nCond / nJobs), sharedx, sharedConverged,
+          sharedIters, MaxIters, tol, deltaBar, eta, MaxNoStep, MaxTrial,
+          PerturbScale, seed);
+      _exit(0);
+    }
+  }
+
+  for (w = 0; w < nJobs; w++) {
+    waitpid(workers[w], &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+      failed = WIFEXITED(status) ? WEXITSTATUS(status) : 1;
+    }
+  }
+  free(workers);
+  FreeCalcConcWorkspace(ws);
+
+  if (failed) {
+    fprintf(stderr, "RunBatchConc: a worker failed\n");
+    exit(failed);
+  }
+
+  memcpy(x, sharedx, sizeof(double) * nCond * numTotal);
+  memcpy(converged, sharedConverged, sizeof(int) * nCond);
+  memcpy(iters, sharedIters, sizeof(int) * nCond);
+  munmap(sharedx, nBytes);
+}
+
+
+
+/* One row per condition: index, temperature, convergence, trust region
+ * iterations, then the concentration IN MOLAR of each complex in the order
+ * of the ocx input
+ */
+void WriteBatchOutput(FILE *out, BatchConditions *bc, int *CompIDArray,
+        double *x, int *converged, int *iters, int NUPACK_VALIDATE){
+
+  int numTotal = bc->numTotal;
+  const char *fmt = NUPACK_VALIDATE ? "\t%.14e" : "\t%8.6e";
+
+  fprintf(out, "%% condition\tT (C)\tconverged\titerations");
+  for (int j=0 ; j<numTotal ; ++j){
+    fprintf(out, "\t%d", CompIDArray[j]);
+  }
+  fprintf(out, "\n");
+
+  for (int k=0 ; k<bc->nCond ; ++k){
+    fprintf(out, "%d\t%.2f\t%d\t%d", k + 1, bc->temperature[k],
+        converged[k], iters[k]);
+    for (int j=0 ; j<numTotal ; ++j){
+      fprintf(out, fmt, x[k*numTotal + j] * bc->MolesWaterPerLiter[k]);
+    }
+    fprintf(out, "\n");
+  }
+}
@@ -0,0 +1,41 @@
+#ifndef NUPACK_THERMO_CONCENTRATIONS_BATCHCONC_H__
+#define NUPACK_THERMO_CONCENTRATIONS_BATCHCONC_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <stdio.h>
+
+/* Conditions of a batch run (concentrations -batch), one per row of the
+ * batch file. Row k holds x0[k*numSS..] (mole fractions), G[k*numTotal..]
+ * (units of kT), its temperature (C) and the molarity of water there.
+ */
+typedef struct {
+  int numSS;
+  int numTotal;
+  int nCond;
+  double *x0;
+  double *G;
+  double *temperature;
+  double *MolesWaterPerLiter;
+} BatchConditions;
+
+void ReadBatchConditions(BatchConditions *bc, char *filename, int numSS,
+        int numTotal, double *G, double temperature);
+
+void FreeBatchConditions(BatchConditions *bc);
+
+void RunBatchConc(BatchConditions *bc, int **A, double *x, int *converged,
+        int *iters, int nJobs, int MaxIters, double tol, double deltaBar,
+        double eta, int MaxNoStep, int MaxTrial, double PerturbScale,
+        unsigned long seed);
+
+void WriteBatchOutput(FILE *out, BatchConditions *bc, int *CompIDArray,
+        double *x, int *converged, int *iters, int NUPACK_VALIDATE);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* NUPACK_THERMO_CONCENTRATIONS_BATCHCONC_H__ */
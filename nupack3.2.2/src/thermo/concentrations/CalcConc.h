@@ -6,34 +6,39 @@ extern "C" {
 #endif /* __cplusplus */
 
 
-void getInitialGuess(double *x0, double *lambda, double *G, int **AT, int **A,
-         int numSS, int numTotal, double PerturbScale, 
-         unsigned long rand_seed);
+struct _EQ_WORKSPACE_T_;
 
-int getx(double *x, double *lambda, double *G, int **AT, int numSS, int numTotal);
+/* State of the concentrations solver for a system of numSS monomer types and
+ * numTotal complexes.  The trust region iterations themselves are those of
+ * the nupackconc library shared with the design engines; this wraps its
+ * workspace with the stoichiometry and the last converged solution.
+ */
+typedef struct {
+  int numSS;
+  int numTotal;
+  double *A; // A[i*numTotal + j]: number of monomers of type i in complex j
+  double *lambda; // Lagrange multipliers of the last converged solve
+  struct _EQ_WORKSPACE_T_ *eq; // solver scratch storage
+  int WarmStart; // 1 to start the next solve from lambda
+  int Iters; // trust region iterations taken by the last solve
+} CalcConcWorkspace;
 
-void getGrad(double *Grad, double *x0, double *x, int **A, int numSS, int numTotal);
+CalcConcWorkspace *NewCalcConcWorkspace(int numSS, int numTotal);
 
-void getHes(double **Hes, double *x, int **A, int numSS, int numTotal);
+void FreeCalcConcWorkspace(CalcConcWorkspace *ws);
 
-int getSearchDir(double *p, double *Grad, double **Hes, double delta, int numSS);
-
-double getRho(double *lambda, double *p, double *Grad, double *x, double **Hes, 
-        double *x0, double *G, int **AT, int numSS, int numTotal);
-
-void getCauchyPoint(double *CauchyPoint, double **Hes, double *Grad, double delta, 
-        int numSS);
-
-void PerturbLambda(double *lambda, double PerturbScale, double *G, int **AT, 
-       int numSS, int numTotal);
-
-int CheckTol(double *Grad, double *AbsTol, int numSS);
+void SetCalcConcStoichiometry(CalcConcWorkspace *ws, int **A);
 
 int CalcConc(double *x, int **A, double *G, double *x0, int numSS,
         int numTotal, int MaxIters, double tol, double deltaBar, double eta,
         double kT, int MaxNoStep, int MaxTrial, double PerturbScale,
         double MolesWaterPerLiter, unsigned long seed);
 
+int CalcConcWithWorkspace(CalcConcWorkspace *ws, double *x, double *G,
+        double *x0, int MaxIters, double tol, double deltaBar, double eta,
+        double kT, int MaxNoStep, int MaxTrial, double PerturbScale,
+        double MolesWaterPerLiter, unsigned long seed);
+
 
 #ifdef __cplusplus
 }
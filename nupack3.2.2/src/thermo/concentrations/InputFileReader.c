@@ -48,6 +48,71 @@ void getSize(int *numSS, int *numTotal, int *nTotal, int *LargestCompID,
 
 
 
+/* Allocates the problem's arrays for nSS monomer types and cTotal
+ * complexes
+ */
+static void AllocateInput(int ***A, double **G, int **CompIDArray,
+        int **PermIDArray, double **x0, double **concentrations, int nSS,
+        int cTotal){
+
+  // A
+  *A = malloc(sizeof(int*) * nSS);
+  for(int i=0 ; i<nSS ; ++i){
+    (*A)[i] = malloc(sizeof(int) * cTotal);
+  }
+
+  // G
+  *G = malloc(sizeof(double) * cTotal);
+
+  // CompIDArray
+  *CompIDArray = malloc(sizeof(int) * cTotal);
+
+  // PermIDArray
+  *PermIDArray = malloc(sizeof(int) * cTotal);
+  for (int i=0 ; i<cTotal ; ++i){
+    (*PermIDArray)[i] = 0;
+  }
+
+  // x0
+  *x0 = malloc(sizeof(double) * nSS);
+
+  // concentrations
+  *concentrations = malloc(sizeof(double) * nSS);
+}
+
+
+
+/* Makes the matrix A, the free energies G and the complex ID list from
+ * InputStruct, and converts x0 from molar to mole fractions.
+ * Returns the moles of water per liter
+ */
+static double SetUpInput(int **A, double *G, int *CompIDArray, double *x0,
+        int nSS, int cTotal, double kT, struct InStruct* InputStruct){
+
+  double MolesWaterPerLiter; // moles of water per liter
+
+  // make the matrix A and free energy G and the complex ID list
+  for(int j=0 ; j<cTotal ; ++j){
+    for(int i=0 ; i<nSS ; ++i){
+      A[i][j] = InputStruct[j].Aj[i];
+    }
+    G[j] = InputStruct[j].FreeEnergy;
+    CompIDArray[j] = InputStruct[j].CompID;
+  }
+
+
+  // calculate molarity of water and convert appropriate quantities to the
+  // right units
+  MolesWaterPerLiter = WaterDensity(kT/kB - ZERO_C_IN_KELVIN);
+  for(int i=0 ; i<nSS; ++i){
+    x0[i] /= MolesWaterPerLiter;
+  }
+
+  return MolesWaterPerLiter;
+}
+
+
+
 /* If one of concentrations is zero, the problem is reformulated as if the
  * corresponding strand does not exist.
  * The input is stored as follows:
@@ -62,7 +127,6 @@ double ReadInputFiles(int ***A, double **G, int **CompIDArray,
         int *numSS0, int *numTotal, int *numPermsArray, double *kT,
         double* temperature, int Toverride, struct InStruct* InputStruct){
 
-  double MolesWaterPerLiter; // moles of water per liter
   char *tok;
   char separators[] = " \t\n";
   char separators_ocx[] = ",\n";
@@ -87,30 +151,8 @@ double ReadInputFiles(int ***A, double **G, int **CompIDArray,
 
   /* memory allocations
    */
-
-  // A
-  *A = malloc(sizeof(int*) * nSS);
-  for(int i=0 ; i<nSS ; ++i){
-    (*A)[i] = malloc(sizeof(int) * cTotal);
-  }
-
-  // G
-  *G = malloc(sizeof(double) * cTotal);
-
-  // CompIDArray
-  *CompIDArray = malloc(sizeof(int) * cTotal);
-
-  // PermIDArray
-  *PermIDArray = malloc(sizeof(int) * cTotal);
-  for (int i=0 ; i<cTotal ; ++i){
-    (*PermIDArray)[i] = 0;
-  }
-
-  // x0
-  *x0 = malloc(sizeof(double) * nSS);
-
-  // concentrations
-  *concentrations = malloc(sizeof(double) * nSS);
+  AllocateInput(A, G, CompIDArray, PermIDArray, x0, concentrations, nSS,
+        cTotal);
 
   // partition function for complexes Q
   long double* Q = malloc (sizeof(long double) * cTotal);
@@ -167,27 +209,111 @@ double ReadInputFiles(int ***A, double **G, int **CompIDArray,
   }
 
 
-  // make the matrix A and free energy G and the complex ID list
-  for(int j=0 ; j<cTotal ; ++j){
-    for(int i=0 ; i<nSS ; ++i){
-      (*A)[i][j] = InputStruct[j].Aj[i];
-    }
-    (*G)[j] = InputStruct[j].FreeEnergy;
-    (*CompIDArray)[j] = InputStruct[j].CompID;
+  // free allocated memory
+  free(Q);
+
+  return SetUpInput(*A, *G, *CompIDArray, *x0, nSS, cTotal, *kT,
+        InputStruct);
+}
+
+
+
+/* Reads the input of a -stream job, i.e. what getSize and ReadInputFiles
+ * read from the prompts: the "concentrations" (M) of the strands, the
+ * "temperature" (C) and the "ocx" lines, each a string as the prompt takes
+ * it ("1,1,1,0,-12.5") or a list of the same numbers. InputStruct and
+ * numPermsArray are allocated here, like the outputs of ReadInputFiles.
+ * Returns 0 (and a message) if the job is malformed, the moles of water per
+ * liter otherwise
+ */
+double ReadStreamInput(const streamJob *job, int ***A, double **G,
+        int **CompIDArray, int **PermIDArray, double **x0,
+        double** concentrations, int *numSS, int *numSS0, int *numTotal,
+        int *nTotal, int *LargestCompID, int **numPermsArray, double *kT,
+        double* temperature, struct InStruct** InputStruct, char *error){
+
+  const jsonValue *conc = StreamJobField(job, "concentrations");
+  const jsonValue *ocx = StreamJobField(job, "ocx");
+  const jsonValue *entry;
+  char separators_ocx[] = ", \t\n";
+  char *tok;
+  double *values;
+  int nSS, cTotal, nValues;
+
+  if(conc == NULL || conc->type != JSON_ARRAY || conc->nItems == 0){
+    strcpy(error, "expected \"concentrations\", a list of one per strand");
+    return 0;
+  }
+  if(ocx == NULL || ocx->type != JSON_ARRAY || ocx->nItems == 0){
+    strcpy(error, "expected \"ocx\", a list of one entry per complex");
+    return 0;
+  }
+  if(!JsonDouble(StreamJobField(job, "temperature"), temperature)){
+    strcpy(error, "expected a \"temperature\"");
+    return 0;
   }
 
+  nSS = conc->nItems;
+  cTotal = ocx->nItems;
+  *numSS = *numSS0 = nSS;
+  *numTotal = *nTotal = *LargestCompID = cTotal;
+  *kT = kB*((*temperature) + ZERO_C_IN_KELVIN);
 
-  // free allocated memory
-  free(Q);
+  *numPermsArray = malloc(sizeof(int) * cTotal);
+  *InputStruct = malloc(sizeof(InStruct) * cTotal);
+  for(int x=0 ; x<cTotal ; ++x){
+    (*numPermsArray)[x] = 1;
+    (*InputStruct)[x].Aj = malloc(sizeof(int) * nSS);
+  }
+  AllocateInput(A, G, CompIDArray, PermIDArray, x0, concentrations, nSS,
+        cTotal);
 
+  for(int x=0 ; x<nSS ; ++x){
+    if(!JsonDouble(&conc->items[x], &(*x0)[x]) || (*x0)[x] <= 0){
+      sprintf(error, "concentration %d is not a positive number", x+1);
+      return 0;
+    }
+    (*concentrations)[x] = (*x0)[x];
+  }
 
-  // calculate molarity of water and convert appropriate quantities to the
-  // right units
-  MolesWaterPerLiter = WaterDensity((*kT)/kB - ZERO_C_IN_KELVIN);
-  for(int i=0 ; i<(*numSS); ++i){
-    (*x0)[i] /= MolesWaterPerLiter;
+  // complex ID, permutation ID, strand counts, free energy (kcal/mol)
+  values = malloc(sizeof(double) * (nSS + 4));
+  for(int x=0 ; x<cTotal ; ++x){
+    entry = &ocx->items[x];
+    nValues = 0;
+    if(entry->type == JSON_STRING){
+      char line[MAXLINE];
+      strncpy(line, entry->text, MAXLINE - 1);
+      line[MAXLINE - 1] = '\0';
+      for(tok = strtok(line, separators_ocx); tok != NULL && nValues < nSS + 4;
+          tok = strtok(NULL, separators_ocx)){
+        values[nValues++] = str2double(tok);
+      }
+    }
+    else if(entry->type == JSON_ARRAY){
+      while(nValues < entry->nItems && nValues < nSS + 4
+            && JsonDouble(&entry->items[nValues], &values[nValues])){
+        nValues++;
+      }
+      if(nValues < entry->nItems) nValues = 0;
+    }
+    if(nValues != nSS + 3 || values[0] < 1 || values[0] > cTotal){
+      sprintf(error, "ocx %d: expected a complex ID up to %d, a permutation "
+            "ID, %d strand counts and a free energy", x+1, cTotal, nSS);
+      free(values);
+      return 0;
+    }
+    (*InputStruct)[x].numSS  = nSS;
+    (*InputStruct)[x].CompID = (int) values[0];
+    (*InputStruct)[x].PermID = (int) values[1];
+    for(int y=0 ; y<nSS ; ++y){
+      (*InputStruct)[x].Aj[y] = (int) values[2 + y];
+    }
+    (*InputStruct)[x].FreeEnergy = values[2 + nSS]/(*kT);
   }
+  free(values);
 
-  return MolesWaterPerLiter;
+  return SetUpInput(*A, *G, *CompIDArray, *x0, nSS, cTotal, *kT,
+        *InputStruct);
 }
 
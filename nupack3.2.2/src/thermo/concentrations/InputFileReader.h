@@ -13,6 +13,12 @@ double ReadInputFiles(int ***A, double **G, int **CompIDArray,
         int *numSS0, int *numTotal, int *numPermsArray, double *kT,
         double* temperature, int Toverride, struct InStruct* InputStruct);
 
+double ReadStreamInput(const streamJob *job, int ***A, double **G,
+        int **CompIDArray, int **PermIDArray, double **x0,
+        double** concentrations, int *numSS, int *numSS0, int *numTotal,
+        int *nTotal, int *LargestCompID, int **numPermsArray, double *kT,
+        double* temperature, struct InStruct** InputStruct, char *error);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -11,7 +11,8 @@
 void ReadCommandLine(int nargs, char** args, int* SortOutput, int* MaxIters,
         double* tol, double* kT, int* MaxNoStep, int* MaxTrial,
         double* PerturbScale, int* Toverride, unsigned long* seed,
-        double* cutoff, int* NUPACK_VALIDATE){
+        double* cutoff, int* NUPACK_VALIDATE, char* BatchFile,
+        int* BatchJobs, int* Stream){
 
   int options;
   int option_index = 0;
@@ -31,6 +32,9 @@ void ReadCommandLine(int nargs, char** args, int* SortOutput, int* MaxIters,
   *SortOutput = 1;  // sort output by concentration
   *tol = 0.0000001; // tolerance percentage of the minimum count among
                     // single-strands
+  BatchFile[0] = '\0'; // no batch of conditions
+  *BatchJobs = 0;   // one worker per online cpu
+  *Stream = 0;      // read the prompts
 
   SetExecutionPath(nargs, args);
 
@@ -39,11 +43,14 @@ void ReadCommandLine(int nargs, char** args, int* SortOutput, int* MaxIters,
     static struct option long_options[] = {
         {"T",             required_argument,  0, 'd'},
         {"validate",      no_argument,        0, 'o'},
+        {"batch",         required_argument,  0, 'b'},
+        {"batchjobs",     required_argument,  0, 'j'},
+        {"stream",        no_argument,        0, 's'},
         {0, 0, 0, 0}
     };
 
 
-    options = getopt_long_only (nargs, args, "d:o", long_options,
+    options = getopt_long_only (nargs, args, "d:ob:j:s", long_options,
         &option_index);
 
     // detect the end of the options
@@ -65,6 +72,22 @@ void ReadCommandLine(int nargs, char** args, int* SortOutput, int* MaxIters,
         *cutoff = 0;
         break;
 
+      case 'b':
+        if(strlen(optarg) >= MAXLINE){
+          fprintf(stderr, "Batch file name too long\n");
+          exit(ERR_NOINPUT);
+        }
+        strcpy(BatchFile, optarg);
+        break;
+
+      case 'j':
+        *BatchJobs = atoi(optarg);
+        break;
+
+      case 's':
+        *Stream = 1;
+        break;
+
       default:
         abort();
     }
@@ -10,7 +10,8 @@ extern "C" {
 void ReadCommandLine(int nargs, char** args, int* SortOutput, int* MaxIters,
         double* tol, double* kT, int* MaxNoStep, int* MaxTrial,
         double* PerturbScale, int* Toverride, unsigned long* seed,
-        double* cutoff, int* NUPACK_VALIDATE);
+        double* cutoff, int* NUPACK_VALIDATE, char* BatchFile,
+        int* BatchJobs, int* Stream);
 
 void DisplayHelpConc(void);
 
@@ -16,45 +16,73 @@
  * page 71. The subroutine used to do this calculation is CalcConc.c.
  */
 
+/* open_memstream (the build uses -std=c99) */
+#define _DEFAULT_SOURCE
+
 #include "constants.h"
 #include "CalcConc.h"
+#include "BatchConc.h"
 #include "FracPair.h"
 #include "InputFileReader.h"
 #include "OutputWriter.h"
 #include "ReadCommandLine.h"
 
 
-int main(int argc, char *argv[]){
+/* Solves the conditions of the batch file for the complexes read from
+ * standard input and prints them as a table.
+ * Returns the exit status of the program
+ */
+static int RunBatch(char *BatchFile, int BatchJobs, int **A, double *G,
+        int *CompIDArray, int numSS, int numTotal, double temperature,
+        int MaxIters, double tol, double deltaBar, double eta, int MaxNoStep,
+        int MaxTrial, double PerturbScale, unsigned long seed,
+        int NUPACK_VALIDATE){
+
+  BatchConditions bc;
+  double *x;
+  int *converged;
+  int *iters;
+  int status = 0;
+
+  ReadBatchConditions(&bc, BatchFile, numSS, numTotal, G, temperature);
+  x = malloc(sizeof(double) * bc.nCond * numTotal);
+  converged = malloc(sizeof(int) * bc.nCond);
+  iters = malloc(sizeof(int) * bc.nCond);
+
+  RunBatchConc(&bc, A, x, converged, iters, BatchJobs, MaxIters, tol,
+        deltaBar, eta, MaxNoStep, MaxTrial, PerturbScale, seed);
+  printf("\n");
+  WriteBatchOutput(stdout, &bc, CompIDArray, x, converged, iters,
+        NUPACK_VALIDATE);
+
+  for(int k=0 ; k<bc.nCond ; ++k){
+    if (converged[k] == 0) {
+      status = ERR_NOCONVERGE;
+    }
+  }
+
+  free(x);
+  free(converged);
+  free(iters);
+  FreeBatchConditions(&bc);
+  return status;
+}
+
+
+
+/* Solves the problem read from the input and writes the provenance blocks
+ * to out. Returns the exit status of the run
+ */
+static int RunConcentrations(FILE *out, int argc, char *argv[], int **A,
+        double *G, int *CompIDArray, double *x0, double *conc, int numSS,
+        int numSS0, int numTotal, int nTotal, int LargestCompID, double kT,
+        double temperature, double MolesWaterPerLiter,
+        struct InStruct* InputStruct, int SortOutput, int MaxIters,
+        double tol, double deltaBar, double eta, int MaxNoStep, int MaxTrial,
+        double PerturbScale, unsigned long seed, int NUPACK_VALIDATE){
 
-  int numSS;  // number of single-strand (monomer) types
-  int numSS0; // number of monomer types including zero concentration ones
-  int numTotal; // total number of complexes
-  int nTotal;   // total number of permutations
-  int LargestCompID; // largest complex ID
-  int MaxIters;   // maximum number of iterations in trust region method
-  int SortOutput; // sorting options for output
   int CalcConcConverge; // 1 for convergence, 0 otherwise
-  int Toverride; // 1 when user provided new temperature in the command line
-  int MaxNoStep; // maximum number of iterations allowed without taking a step
-  int MaxTrial;  // maximum number ot perturbations allowed in a calculation
-  int NUPACK_VALIDATE; // 1 if validation mode (14 digit printout)
-  int *numPermsArray; // number of permutations of each species
-  int *CompIDArray;   // complex IDs
-  int *PermIDArray;   // permutation IDs
-  unsigned long seed; // seed for random number generation
-  double tol;      // absolute tolerance is tol*(mininium monomer init. conc.)
-  double deltaBar; // maximum allowed step size in trust region method
-  double eta;      // eta parameter in trust region method, 0 < eta < 0.25
-  double kT;       // thermal energy in kcal/mol
-  double MolesWaterPerLiter; // moles of water per liter
-  double cutoff; // cutoff value for reporting pair fractions
-  double PerturbScale; // multiplier on the random number for perturbations
-  int **A;    // number of monomers of type i in complex j
-  double *G;  // free energies of complexes
   double *x;  // the mole fractions
-  double *x0; // total concentrations of single-species
-  double *conc;
-  double temperature;
 
   // provenance blocks
   int len_header = 1000;
@@ -63,32 +91,6 @@ int main(int argc, char *argv[]){
   int len_provenance;
 
 
-  eta = TRUST_REGION_ETA;
-  deltaBar = TRUST_REGION_DELTABAR;
-
-
-  // read command line arguments
-  ReadCommandLine(argc, argv, &SortOutput, &MaxIters, &tol, &kT, &MaxNoStep,
-        &MaxTrial, &PerturbScale, &Toverride, &seed, &cutoff,
-        &NUPACK_VALIDATE);
-
-
-  // get the system's size
-  getSize(&numSS,&numTotal,&nTotal,&LargestCompID,&numPermsArray);
-
-
-  // store input parameters
-  struct InStruct* InputStruct = malloc(sizeof(InStruct) * nTotal);
-  for(int j=0 ; j<nTotal; ++j){
-    InputStruct[j].Aj = malloc (sizeof(int) * numSS);
-  }
-
-  // read input files
-  MolesWaterPerLiter = ReadInputFiles(&A, &G, &CompIDArray, &PermIDArray, &x0,
-        &conc, &numSS, &numSS0, &numTotal, numPermsArray, &kT, &temperature,
-        Toverride, InputStruct);
-
-
   // compute convergence
   x = malloc (sizeof(double) * numTotal);
   CalcConcConverge = CalcConc(x, A, G, x0, numSS, numTotal, MaxIters, tol,
@@ -113,9 +115,7 @@ int main(int argc, char *argv[]){
 
   // fill provenance block
   len_provenance = concentrations_header(header, argc, argv);
-  for(int y=0 ; y<len_provenance ; ++y){
-    printf("%c", header[y]);
-  }
+  fwrite(header, sizeof(char), len_provenance, out);
 
   // free provenance block
   free(header);
@@ -138,9 +138,7 @@ int main(int argc, char *argv[]){
   // fill provenance block
   len_provenance = concentrations_parameters(parameters, numSS, conc,
         temperature);
-  for(int y=0 ; y<len_provenance ; ++y){
-    printf("%c", parameters[y]);
-  }
+  fwrite(parameters, sizeof(char), len_provenance, out);
 
   // free provenance block
   free(parameters);
@@ -163,10 +161,7 @@ int main(int argc, char *argv[]){
   // fill provenance block
   len_provenance = concentrations_results(concentrations, numSS, nTotal, kT,
         MolesWaterPerLiter, NUPACK_VALIDATE, InputStruct);
-
-  for(int y=0 ; y<len_provenance ; ++y){
-    printf("%c", concentrations[y]);
-  }
+  fwrite(concentrations, sizeof(char), len_provenance, out);
 
   // free provenance block
   free(concentrations);
@@ -174,31 +169,196 @@ int main(int argc, char *argv[]){
   /*
    * echo provenance concentrations ends */
 
+  free(x);
 
-  // free memory allocations
-  for(int i=0 ; i<numSS ; ++i){
-    free(A[i]); // allocated in ReadInput
+
+  // If didn't converge, give error message
+  if (CalcConcConverge == 0) {
+    return ERR_NOCONVERGE;
+  }
+
+  return 0;
+}
+
+
+
+/* Frees what getSize and ReadInputFiles (or ReadStreamInput) allocated;
+ * pointers that were never set are NULL
+ */
+static void FreeInput(int **A, double *G, int *numPermsArray,
+        int *CompIDArray, int *PermIDArray, double *x0, double *conc,
+        int numSS, int nTotal, struct InStruct* InputStruct){
+
+  if(A != NULL){
+    for(int i=0 ; i<numSS ; ++i){
+      free(A[i]);
+    }
   }
-  free(A); // allocated in ReadInput
-  free(G); // allocated in ReadInput
-  free(numPermsArray); // allocated in getSize
-  free(CompIDArray);   // allocated in ReadInput
-  free(PermIDArray);   // allocated in ReadInput
-  free(x0); // allocated in ReadInput
+  free(A);
+  free(G);
+  free(numPermsArray);
+  free(CompIDArray);
+  free(PermIDArray);
+  free(x0);
   free(conc);
-  free(x);
 
-  for(int i=0 ; i<nTotal ; ++i){
-    free(InputStruct[i].Aj);
+  if(InputStruct != NULL){
+    for(int i=0 ; i<nTotal ; ++i){
+      free(InputStruct[i].Aj);
+    }
   }
   free(InputStruct);
+}
+
+
+
+/* -stream: one result line per job of standard input, solved with the
+ * options of the command line
+ */
+static void ServeJobs(int argc, char *argv[], int SortOutput, int MaxIters,
+        double tol, double deltaBar, double eta, int MaxNoStep, int MaxTrial,
+        double PerturbScale, unsigned long seed, int NUPACK_VALIDATE){
+
+  char error[STREAM_ERROR_LEN];
+  int numSS, numSS0, numTotal, nTotal, LargestCompID;
+  int **A;
+  double *G;
+  int *numPermsArray, *CompIDArray, *PermIDArray;
+  double *x0, *conc;
+  double kT, temperature, MolesWaterPerLiter;
+  struct InStruct* InputStruct;
+  int read;
+  int status;
+  char *result;
+  size_t len;
+  FILE *out;
+  streamJob job;
+
+  while((read = ReadStreamJob(stdin, &job, error)) != 0){
+    A = NULL;
+    G = x0 = conc = NULL;
+    numPermsArray = CompIDArray = PermIDArray = NULL;
+    InputStruct = NULL;
+    numSS = nTotal = 0;
+
+    if(read < 0 || (MolesWaterPerLiter = ReadStreamInput(&job, &A, &G,
+          &CompIDArray, &PermIDArray, &x0, &conc, &numSS, &numSS0,
+          &numTotal, &nTotal, &LargestCompID, &numPermsArray, &kT,
+          &temperature, &InputStruct, error)) == 0){
+      WriteStreamError(stdout, &job, ERR_NOINPUT, error);
+    }
+    else{
+      out = open_memstream(&result, &len);
+      status = RunConcentrations(out, argc, argv, A, G, CompIDArray, x0,
+            conc, numSS, numSS0, numTotal, nTotal, LargestCompID, kT,
+            temperature, MolesWaterPerLiter, InputStruct, SortOutput,
+            MaxIters, tol, deltaBar, eta, MaxNoStep, MaxTrial, PerturbScale,
+            seed, NUPACK_VALIDATE);
+      fclose(out);
+      WriteStreamResult(stdout, &job, status, result, len);
+      free(result);
+    }
+
+    FreeInput(A, G, numPermsArray, CompIDArray, PermIDArray, x0, conc,
+          numSS, nTotal, InputStruct);
+    FreeStreamJob(&job);
+  }
+}
+
+
+
+int main(int argc, char *argv[]){
+
+  int numSS;  // number of single-strand (monomer) types
+  int numSS0; // number of monomer types including zero concentration ones
+  int numTotal; // total number of complexes
+  int nTotal;   // total number of permutations
+  int LargestCompID; // largest complex ID
+  int MaxIters;   // maximum number of iterations in trust region method
+  int SortOutput; // sorting options for output
+  int Toverride; // 1 when user provided new temperature in the command line
+  int MaxNoStep; // maximum number of iterations allowed without taking a step
+  int MaxTrial;  // maximum number ot perturbations allowed in a calculation
+  int NUPACK_VALIDATE; // 1 if validation mode (14 digit printout)
+  int *numPermsArray; // number of permutations of each species
+  int *CompIDArray;   // complex IDs
+  int *PermIDArray;   // permutation IDs
+  unsigned long seed; // seed for random number generation
+  double tol;      // absolute tolerance is tol*(mininium monomer init. conc.)
+  double deltaBar; // maximum allowed step size in trust region method
+  double eta;      // eta parameter in trust region method, 0 < eta < 0.25
+  double kT;       // thermal energy in kcal/mol
+  double MolesWaterPerLiter; // moles of water per liter
+  double cutoff; // cutoff value for reporting pair fractions
+  double PerturbScale; // multiplier on the random number for perturbations
+  int **A;    // number of monomers of type i in complex j
+  double *G;  // free energies of complexes
+  double *x0; // total concentrations of single-species
+  double *conc;
+  double temperature;
+  char BatchFile[MAXLINE]; // conditions of a batch run, empty for none
+  int BatchJobs; // worker processes of a batch run, 0 = number of cpus
+  int Stream; // 1 to serve JSON jobs from standard input
+  int status;
+
+
+  eta = TRUST_REGION_ETA;
+  deltaBar = TRUST_REGION_DELTABAR;
+
+
+  // read command line arguments
+  ReadCommandLine(argc, argv, &SortOutput, &MaxIters, &tol, &kT, &MaxNoStep,
+        &MaxTrial, &PerturbScale, &Toverride, &seed, &cutoff,
+        &NUPACK_VALIDATE, BatchFile, &BatchJobs, &Stream);
+
+
+  // stream run: every job brings its own complexes and conditions
+  if (Stream) {
+    ServeJobs(argc, argv, SortOutput, MaxIters, tol, deltaBar, eta,
+          MaxNoStep, MaxTrial, PerturbScale, seed, NUPACK_VALIDATE);
+    return 0;
+  }
+
+
+  // get the system's size
+  getSize(&numSS,&numTotal,&nTotal,&LargestCompID,&numPermsArray);
+
+
+  // store input parameters
+  struct InStruct* InputStruct = malloc(sizeof(InStruct) * nTotal);
+  for(int j=0 ; j<nTotal; ++j){
+    InputStruct[j].Aj = malloc (sizeof(int) * numSS);
+  }
+
+  // read input files
+  MolesWaterPerLiter = ReadInputFiles(&A, &G, &CompIDArray, &PermIDArray, &x0,
+        &conc, &numSS, &numSS0, &numTotal, numPermsArray, &kT, &temperature,
+        Toverride, InputStruct);
+
+
+  // batch run: solve every condition of the batch file, write one table
+  if (BatchFile[0] != '\0') {
+    return RunBatch(BatchFile, BatchJobs, A, G, CompIDArray, numSS, numTotal,
+          temperature, MaxIters, tol, deltaBar, eta, MaxNoStep, MaxTrial,
+          PerturbScale, seed, NUPACK_VALIDATE);
+  }
+
+
+  status = RunConcentrations(stdout, argc, argv, A, G, CompIDArray, x0, conc,
+        numSS, numSS0, numTotal, nTotal, LargestCompID, kT, temperature,
+        MolesWaterPerLiter, InputStruct, SortOutput, MaxIters, tol, deltaBar,
+        eta, MaxNoStep, MaxTrial, PerturbScale, seed, NUPACK_VALIDATE);
+
+
+  // free memory allocations
+  FreeInput(A, G, numPermsArray, CompIDArray, PermIDArray, x0, conc, numSS,
+        nTotal, InputStruct);
 
 
   // If didn't converge, give error message
-  if (CalcConcConverge == 0) {
-    exit(ERR_NOCONVERGE);
+  if (status != 0) {
+    exit(status);
   }
 
   return 0;
 }
-
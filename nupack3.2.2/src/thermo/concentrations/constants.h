@@ -24,6 +24,7 @@
 // Constants used in trust region
 #define TRUST_REGION_DELTABAR 1000.0 // Maximal size of trust region
 #define TRUST_REGION_ETA 0.125 // Decision criterion for trust region
+#define TRUST_REGION_MINDELTA 1e-12 // Radius below which Newton steps are tried
 
 #define MAXLOGX 250 // Maximum logarithm of a concentration (prevents overflow)
 
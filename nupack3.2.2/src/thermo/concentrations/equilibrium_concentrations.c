@@ -13,7 +13,16 @@
   computes the equilibrium mole fractions of the compounds, and the
   auxillary functions it calls.  Some of the functions it calls are
   standard utility functions, such as functions to sum entries in an
-  array, etc.  These are included in utils.c.
+  array, etc.  These are included in equilibrium_utils.c.
+
+  This is the solver of the nupackconc library, shared by the
+  concentrations executable and both design engines.  Its scratch
+  storage lives in an eq_workspace_t that callers keep across solves,
+  the stoichiometry is stored sparsely (only the nonzero entries of A
+  are visited, in the order of the dense loops, so results are
+  unchanged), a solve can be warm-started from the Lagrange
+  multipliers of the last one, and calc_conc_sensitivity gives the
+  derivatives of the mole fractions with respect to the free energies.
 
   The trust region algorithm for solving the dual problem is that in
   Nocedal and Wright, Numerical Optimization, 1999, page 68, with the
@@ -52,11 +61,206 @@
 #include <stdlib.h>
 #include <math.h>  // Must compile with -lm option
 #include <float.h>
-#include "pathway_debug.h"
+#include "equilibrium_errors.h"
 #include "equilibrium_concentrations.h" // Header file for concentrations
 
 /* ************************************************************************** */
 
+/* ************************************************************************** */
+/*                         BEGIN WORKSPACE FUNCTIONS                          */
+/* ************************************************************************** */
+static double *take_doubles(char **cursor, size_t n) {
+  /*
+    Carves n doubles out of a workspace block.
+  */
+  double *ar = (double *) *cursor;
+  *cursor += n * sizeof(double);
+  return ar;
+}
+
+
+static int *take_ints(char **cursor, size_t n) {
+  /*
+    Carves n ints out of a workspace block.
+  */
+  int *ar = (int *) *cursor;
+  *cursor += n * sizeof(int);
+  return ar;
+}
+
+
+/* ************************************************************************** */
+eq_workspace_t *new_eq_workspace(int n_particles, int n_compounds) {
+  /*
+    Allocates a workspace for problems of up to n_particles particles and
+    n_compounds compounds.  Returns NULL if out of memory.
+  */
+
+  eq_workspace_t *ws = (eq_workspace_t *) calloc(1, sizeof(eq_workspace_t));
+
+  if (ws != NULL && 
+      reserve_eq_workspace(ws, n_particles, n_compounds) != ERR_OK) {
+    free(ws);
+    ws = NULL;
+  }
+  return ws;
+}
+/* ************************************************************************** */
+
+
+/* ************************************************************************** */
+void free_eq_workspace(eq_workspace_t *ws) {
+  if (ws == NULL) {
+    return;
+  }
+  free(ws->block);
+  free(ws);
+}
+/* ************************************************************************** */
+
+
+/* ************************************************************************** */
+int reserve_eq_workspace(eq_workspace_t *ws, int n_particles, 
+                         int n_compounds) {
+  /*
+    Grows the arrays of ws to hold problems of n_particles particles and
+    n_compounds compounds.  The saved lambda of a warm start survives.
+  */
+
+  size_t np, nc, n_doubles, n_ints;
+  char *block;
+  char *cursor;
+  double *old_saved = ws->saved_lambda;
+  int i;
+
+  if (ws->block != NULL && n_particles <= ws->max_particles 
+      && n_compounds <= ws->max_compounds) {
+    return ERR_OK;
+  }
+
+  if (n_particles < ws->max_particles) n_particles = ws->max_particles;
+  if (n_compounds < ws->max_compounds) n_compounds = ws->max_compounds;
+  if (n_particles < 1) n_particles = 1;
+  if (n_compounds < 1) n_compounds = 1;
+  np = n_particles;
+  nc = n_compounds;
+
+  n_doubles = 2 * np * nc + 3 * np * np + 20 * np + 8 * nc;
+  n_ints = (nc + 1) + np * nc + 3 * np + nc;
+  block = (char *) malloc(n_doubles * sizeof(double) + n_ints * sizeof(int));
+  if (block == NULL) {
+    return ERR_OOM;
+  }
+
+  cursor = block;
+  ws->a_coeff = take_doubles(&cursor, np * nc);
+  ws->A_tmp = take_doubles(&cursor, np * nc);
+  ws->hes = take_doubles(&cursor, np * np);
+  ws->hes_copy = take_doubles(&cursor, np * np);
+  ws->a_at = take_doubles(&cursor, np * np);
+
+  ws->particle_x0 = take_doubles(&cursor, np);
+  ws->totals_tmp = take_doubles(&cursor, np);
+  ws->full_grad = take_doubles(&cursor, np);
+  ws->full_abs_tol = take_doubles(&cursor, np);
+  ws->lambda_guess = take_doubles(&cursor, np);
+  ws->saved_lambda = take_doubles(&cursor, np);
+  ws->abs_tol = take_doubles(&cursor, np);
+  ws->grad = take_doubles(&cursor, np);
+  ws->lambda = take_doubles(&cursor, np);
+  ws->p = take_doubles(&cursor, np);
+  ws->new_grad = take_doubles(&cursor, np);
+  ws->new_lambda = take_doubles(&cursor, np);
+  ws->pB = take_doubles(&cursor, np);
+  ws->pU = take_doubles(&cursor, np);
+  ws->hes_dot_grad = take_doubles(&cursor, np);
+  ws->hes_dot_p = take_doubles(&cursor, np);
+  ws->rho_lambda = take_doubles(&cursor, np);
+  ws->trial_lambda = take_doubles(&cursor, np);
+  ws->c = take_doubles(&cursor, np);
+  ws->work = take_doubles(&cursor, np);
+
+  ws->x_tmp = take_doubles(&cursor, nc);
+  ws->G_tmp = take_doubles(&cursor, nc);
+  ws->x0_tmp = take_doubles(&cursor, nc);
+  ws->new_x = take_doubles(&cursor, nc);
+  ws->log_x = take_doubles(&cursor, nc);
+  ws->rho_x = take_doubles(&cursor, nc);
+  ws->dummy_x = take_doubles(&cursor, nc);
+  ws->G_plus_log_x = take_doubles(&cursor, nc);
+
+  ws->a_start = take_ints(&cursor, nc + 1);
+  ws->a_particle = take_ints(&cursor, np * nc);
+  ws->active_particles = take_ints(&cursor, np);
+  ws->num_active = take_ints(&cursor, np);
+  ws->perm = take_ints(&cursor, np);
+  ws->active_compounds = take_ints(&cursor, nc);
+
+  for (i = 0; i < ws->n_saved; i++) {
+    ws->saved_lambda[i] = old_saved[i];
+  }
+  free(ws->block);
+
+  ws->block = block;
+  ws->max_particles = n_particles;
+  ws->max_compounds = n_compounds;
+  return ERR_OK;
+}
+/* ************************************************************************** */
+
+
+/* ************************************************************************** */
+void set_eq_stoichiometry(eq_workspace_t *ws, double *A, int n_particles, 
+                          int n_compounds) {
+  /*
+    Stores the n_particles x n_compounds matrix A (A[ij(i, j, n_compounds)]
+    is the number of particles of type i in compound j) in ws as a list of
+    (particle, coefficient) pairs per compound.  The solver only touches
+    these nonzero entries, visiting them in the order the dense loops did,
+    so results are unchanged.  ws must hold the problem.
+  */
+
+  int i, j, k;
+
+  k = 0;
+  for (j = 0; j < n_compounds; j++) {
+    ws->a_start[j] = k;
+    for (i = 0; i < n_particles; i++) {
+      if (A[ij(i, j, n_compounds)] != 0.0) {
+        ws->a_particle[k] = i;
+        ws->a_coeff[k] = A[ij(i, j, n_compounds)];
+        k++;
+      }
+    }
+  }
+  ws->a_start[n_compounds] = k;
+}
+/* ************************************************************************** */
+
+
+/* ************************************************************************** */
+void get_particle_totals(eq_workspace_t *ws, double *totals, double *x0,
+                         int n_particles, int n_compounds) {
+  /*
+    The constraints of the problem stored in ws, totals = dot(A, x0), given
+    the initial mole fractions x0 of the compounds.
+  */
+
+  int i, j, k;
+
+  for (i = 0; i < n_particles; i++) {
+    totals[i] = 0.0;
+  }
+  for (j = 0; j < n_compounds; j++) {
+    for (k = ws->a_start[j]; k < ws->a_start[j+1]; k++) {
+      totals[ws->a_particle[k]] += ws->a_coeff[k] * x0[j];
+    }
+  }
+}
+/* ************************************************************************** */
+/*                          END WORKSPACE FUNCTIONS                           */
+/* ************************************************************************** */
+
 /* ************************************************************************** */
 /*                BEGIN CALC_CONC_FROM_FREE_ENERGIES                          */
 /* ************************************************************************** */
@@ -68,6 +272,36 @@ int calc_conc_from_free_energies(double *x, double *A, double *G, double *x0,
                                  int max_trial, double perturb_scale, 
                                  int quiet, int write_log_file, char *log_file, 
                                  unsigned long seed, run_stats_t *run_stats) {
+  /*
+    Same as calc_conc_from_free_energies_ws, with a workspace of its own.
+  */
+
+  int ret_val;
+  eq_workspace_t *ws = new_eq_workspace(n_particles, n_compounds);
+
+  if (ws == NULL) {
+    return ERR_OOM;
+  }
+  ret_val = calc_conc_from_free_energies_ws(ws, x, A, G, x0, n_particles,
+      n_compounds, n_points, max_iters, tol, delta_bar, eta, min_delta, 
+      max_trial, perturb_scale, quiet, write_log_file, log_file, seed, 
+      run_stats);
+  free_eq_workspace(ws);
+
+  return ret_val;
+}
+/* ************************************************************************** */
+
+
+/* ************************************************************************** */
+int calc_conc_from_free_energies_ws(eq_workspace_t *ws, double *x, double *A,
+                                 double *G, double *x0, int n_particles, 
+                                 int n_compounds, int n_points, 
+                                 int max_iters, double tol, double delta_bar, 
+                                 double eta, double min_delta, 
+                                 int max_trial, double perturb_scale, 
+                                 int quiet, int write_log_file, char *log_file, 
+                                 unsigned long seed, run_stats_t *run_stats) {
   /*
     Computes the equilbrium mole fractions of species in dilute
     solution using a trust region algorithm on the dual problem.
@@ -77,6 +311,10 @@ int calc_conc_from_free_energies(double *x, double *A, double *G, double *x0,
     is that in Nocedal and Wright, Numerical Optimization, 1999, page
     68, with the dogleg method on page 71.
 
+    All scratch storage is taken from ws, which is grown if needed.  With
+    ws->warm_start set, each point starts from the Lagrange multipliers
+    of the last converged solve.
+
     Return codes:
     0: Convergence
     1: Failed to converge, too many iterations
@@ -86,16 +324,17 @@ int calc_conc_from_free_energies(double *x, double *A, double *G, double *x0,
   int i, j, i_tmp, j_tmp, k; // indices, i over particles and j over compounds
   int i_point; // the current point in the titration
   int cur_rank;
-  int *active_particles = NULL; // Particles with nonzero concentration
-  int *active_compounds = NULL; // Compounds that have nonzero concentration
-  int *num_active = NULL;
-  double *grad = NULL;
-  double *abs_tol = NULL;
-  double *x_tmp = NULL; // Temporary x for storing nonzero concentrations
-  double *new_x0 = NULL; // x0 containing only particle counts
-  double *x0_tmp = NULL; // Temporary x0 for storing nonzero entries in x0
-  double *G_tmp = NULL; // Temporary G for storing free energies of active cmpds
-  double *A_tmp = NULL; // Temporary x for storing info about active compounds
+  int *active_particles; // Particles with nonzero concentration
+  int *active_compounds; // Compounds that have nonzero concentration
+  int *num_active;
+  double *grad;
+  double *abs_tol;
+  double *x_tmp; // Temporary x for storing nonzero concentrations
+  double *new_x0; // x0 containing only particle counts
+  double *x0_tmp; // Temporary x0 for storing nonzero entries in x0
+  double *G_tmp; // Temporary G for storing free energies of active cmpds
+  double *A_tmp; // Temporary x for storing info about active compounds
+  double *lambda_guess; // Warm start, NULL for the standard initial guess
   int n_compounds_tmp; // Temporary number of compounds
   int n_particles_tmp; // Temporary number of particles
   int ret_val = ERR_OK;
@@ -103,226 +342,223 @@ int calc_conc_from_free_energies(double *x, double *A, double *G, double *x0,
   run_stats_t * act_run_stats = NULL;
  
   /* ********** CUT OUT PARTICLES WITH ZERO CONC  ************************** */
-  // Allocate memory for temporary variables
-  active_particles = (int *) malloc(n_particles * sizeof(int));
-  active_compounds = (int *) malloc(n_compounds * sizeof(int));
-  num_active = (int *) malloc(n_particles * sizeof(int));
-
-  // Build new problem, start with memory allocation
-  A_tmp = (double *) malloc(n_particles * n_compounds * sizeof(double));
-  x_tmp = (double *) malloc(n_compounds * sizeof(double));
-  G_tmp = (double *) malloc(n_compounds * sizeof(double));
-  x0_tmp = (double *) malloc(n_compounds * sizeof(double));
-  new_x0 = (double *) malloc(n_particles * sizeof(double));
-  grad = (double *) malloc(n_particles * sizeof(double));
-  abs_tol = (double *) malloc(n_particles * sizeof(double));
+  if (reserve_eq_workspace(ws, n_particles, n_compounds) != ERR_OK) {
+    return ERR_OOM;
+  }
+  active_particles = ws->active_particles;
+  active_compounds = ws->active_compounds;
+  num_active = ws->num_active;
+  A_tmp = ws->A_tmp;
+  x_tmp = ws->x_tmp;
+  G_tmp = ws->G_tmp;
+  x0_tmp = ws->x0_tmp;
+  new_x0 = ws->particle_x0;
+  grad = ws->full_grad;
+  abs_tol = ws->full_abs_tol;
 
   if(NULL == run_stats) {
-    act_run_stats = (run_stats_t *) malloc(sizeof(run_stats_t));
+    act_run_stats = &ws->run_stats;
   } 
   else {
     act_run_stats = run_stats;
   }
 
-
-  if(NULL == active_particles ||
-     NULL == active_compounds ||
-     NULL == num_active ||
-     NULL == A_tmp ||
-     NULL == x_tmp || 
-     NULL == G_tmp ||
-     NULL == x0_tmp || 
-     NULL == act_run_stats ||
-     NULL == grad ||
-     NULL == abs_tol) {
-    ret_val = ERR_OOM;
-  }
-
-  if(ret_val == ERR_OK) {
-
-    for (i_point = 0; i_point < n_points; i_point++) {
-      // Find total particle mass for pruning
-      for (i = 0; i < n_particles; i++) {
-        new_x0[i] = 0.0;
-        for (j = 0; j < n_compounds; j++) {
-          new_x0[i] += x0[ij(i_point, j, n_compounds)] 
-            * A[ij(i, j, n_compounds)];
-        }
+  for (i_point = 0; i_point < n_points; i_point++) {
+    // Find total particle mass for pruning
+    for (i = 0; i < n_particles; i++) {
+      new_x0[i] = 0.0;
+      for (j = 0; j < n_compounds; j++) {
+        new_x0[i] += x0[ij(i_point, j, n_compounds)] 
+          * A[ij(i, j, n_compounds)];
       }
-      // Determine which particles have nonzero concentration
-      for (i = 0; i < n_particles; i++) {
-        if (new_x0[i] < DBL_MIN && -new_x0[i] < DBL_MIN) {
-          active_particles[i] = 0;
-        }
-        else {
-          active_particles[i] = 1;
-        }
+    }
+    // Determine which particles have nonzero concentration
+    for (i = 0; i < n_particles; i++) {
+      if (new_x0[i] < DBL_MIN && -new_x0[i] < DBL_MIN) {
+        active_particles[i] = 0;
+      }
+      else {
+        active_particles[i] = 1;
       }
+    }
 
-      changed = 1;
+    changed = 1;
 
-      for (j = 0; j < n_compounds; j++) {
-        active_compounds[j] = 1;
-      }
+    for (j = 0; j < n_compounds; j++) {
+      active_compounds[j] = 1;
+    }
 
 
-      while (changed) {
-        changed = 0;
-        // Disable compounds if they contain an inactive particle
-        for (i = 0; i < n_particles; i++) {
-          if (active_particles[i] == 0) {
-            for (j = 0; j < n_compounds; j++) {
-              if (active_compounds[j] && 
-                  !(A[ij(i, j, n_compounds)] < DBL_MIN && 
-                    -A[ij(i, j, n_compounds)] < DBL_MIN)) {
-                active_compounds[j] = 0;
-                changed = 1;
-              }
-            }
-          }
-        }
-        
-        // Only enable particles if there is more than one active compound
-        // that contains them
-        for (i = 0; i < n_particles; i++) {
-          num_active[i] = 0;
-        }
-        for (i = 0; i < n_particles; i++) {
+    while (changed) {
+      changed = 0;
+      // Disable compounds if they contain an inactive particle
+      for (i = 0; i < n_particles; i++) {
+        if (active_particles[i] == 0) {
           for (j = 0; j < n_compounds; j++) {
-            if (active_compounds[j] &&
-                (A[ij(i, j, n_compounds)] > DBL_MIN || 
-                -A[ij(i, j, n_compounds)] < DBL_MIN)) {
-
-              num_active[i]++;
+            if (active_compounds[j] && 
+                !(A[ij(i, j, n_compounds)] < DBL_MIN && 
+                  -A[ij(i, j, n_compounds)] < DBL_MIN)) {
+              active_compounds[j] = 0;
+              changed = 1;
             }
           }
         }
-        for (i = 0; i < n_particles; i++) {
-          if (num_active[i] <= 1 && active_particles[i]) {
-            changed = 1;
-            active_particles[i] = 0;
-          }
-        }
       }
+      
+      // Only enable particles if there is more than one active compound
+      // that contains them
+      for (i = 0; i < n_particles; i++) {
+        num_active[i] = 0;
+      }
+      for (i = 0; i < n_particles; i++) {
+        for (j = 0; j < n_compounds; j++) {
+          if (active_compounds[j] &&
+              (A[ij(i, j, n_compounds)] > DBL_MIN || 
+              -A[ij(i, j, n_compounds)] < DBL_MIN)) {
 
-
-      for (k = 0; k < n_particles; k++) {
-        if (active_particles[k]) {
-          n_particles_tmp = sumint(active_particles, k+1);
-          n_compounds_tmp = sumint(active_compounds, n_compounds);
-          i_tmp = 0;
-          for (i = 0; i < k+1; i++) {
-            if (active_particles[i]) {
-              j_tmp = 0;
-              for (j = 0; j < n_compounds; j++) {
-                if (active_compounds[j]) {
-                  A_tmp[ij(i_tmp, j_tmp, n_compounds_tmp)]
-                    = A[ij(i, j, n_compounds)];
-                  j_tmp++;
-                }
-              }
-              i_tmp++;
-            }
-          }
-          cur_rank = get_approx_rank(A_tmp, n_particles_tmp, 
-              n_compounds_tmp, NUM_PRECISION);
-          if (cur_rank != n_particles_tmp) {
-            active_particles[k] = 0;
+            num_active[i]++;
           }
         }
       }
-      
-      n_particles_tmp = sumint(active_particles, n_particles);
-      n_compounds_tmp = sumint(active_compounds, n_compounds);
+      for (i = 0; i < n_particles; i++) {
+        if (num_active[i] <= 1 && active_particles[i]) {
+          changed = 1;
+          active_particles[i] = 0;
+        }
+      }
+    }
+
 
-      if (n_particles_tmp != 0 && n_compounds_tmp != 0) {
-        // Build new A and x0, A_tmp and x0_tmp, respectively
+    for (k = 0; k < n_particles; k++) {
+      if (active_particles[k]) {
+        n_particles_tmp = sumint(active_particles, k+1);
+        n_compounds_tmp = sumint(active_compounds, n_compounds);
         i_tmp = 0;
-        for (i = 0; i < n_particles; i++) {
+        for (i = 0; i < k+1; i++) {
           if (active_particles[i]) {
             j_tmp = 0;
             for (j = 0; j < n_compounds; j++) {
               if (active_compounds[j]) {
-                A_tmp[ij(i_tmp, j_tmp++, n_compounds_tmp)] 
-                   = A[ij(i, j, n_compounds)];
+                A_tmp[ij(i_tmp, j_tmp, n_compounds_tmp)]
+                  = A[ij(i, j, n_compounds)];
+                j_tmp++;
               }
             }
             i_tmp++;
           }
         }
-        
-        // Build new G, x0
-        j_tmp = 0;
-        for (j = 0; j < n_compounds; j++) {
-          if (active_compounds[j]) {
-            x0_tmp[j_tmp] = x0[ij(i_point, j, n_compounds)];
-            G_tmp[j_tmp++] = G[j];
-          }
+        cur_rank = get_approx_rank(A_tmp, n_particles_tmp, 
+            n_compounds_tmp, NUM_PRECISION);
+        if (cur_rank != n_particles_tmp) {
+          active_particles[k] = 0;
         }
-      
-        /* *************** END CUTTING OUT ZERO CONCS *********************** */
-        ret_val = calc_conc_optimize(x_tmp, A_tmp, G_tmp, x0_tmp, 
-              n_particles_tmp, n_compounds_tmp, max_iters, tol, delta_bar, eta, 
-              min_delta, max_trial, perturb_scale, seed, act_run_stats, grad, 
-              abs_tol);
       }
+    }
+    
+    n_particles_tmp = sumint(active_particles, n_particles);
+    n_compounds_tmp = sumint(active_compounds, n_compounds);
 
-      /* *************** CONVERT BACK TO ORIGINAL PROBLEM ******************* */
-      // Give the full gradient, zero where x0 was zero
-      i_tmp = n_particles_tmp - 1;
-      for (i = n_particles - 1; i >= 0; i--) {
+    if (n_particles_tmp != 0 && n_compounds_tmp != 0) {
+      // Build new A and x0, A_tmp and x0_tmp, respectively
+      i_tmp = 0;
+      for (i = 0; i < n_particles; i++) {
         if (active_particles[i]) {
-          abs_tol[i] = abs_tol[i_tmp];
-          grad[i] = grad[i_tmp--];
-        }
-        else {
-          abs_tol[i] = 0;
-          grad[i] = 0.0;
+          j_tmp = 0;
+          for (j = 0; j < n_compounds; j++) {
+            if (active_compounds[j]) {
+              A_tmp[ij(i_tmp, j_tmp++, n_compounds_tmp)] 
+                 = A[ij(i, j, n_compounds)];
+            }
+          }
+          i_tmp++;
         }
       }
-
-      // Report concentrations
+      
+      // Build new G, x0
       j_tmp = 0;
       for (j = 0; j < n_compounds; j++) {
         if (active_compounds[j]) {
-          x[ij(i_point, j, n_compounds)] = x_tmp[j_tmp++];
-        }
-        else {  // Not active. Use original concentration
-          x[ij(i_point, j, n_compounds)] = x0[ij(i_point, j, n_compounds)];
+          x0_tmp[j_tmp] = x0[ij(i_point, j, n_compounds)];
+          G_tmp[j_tmp++] = G[j];
         }
       }
 
-      /* *************** DONE CONVERTING BACK TO ORIGINAL PROBLEM *********** */
-
-      // Report errors in conservation of mass to screen
-      if (quiet == 0) {
-        // Print out values of the gradient, which is the error in cons. of mass
-        printf("Error in conservation of mass (units of mole fraction):\n");
+      // Start from the last solution if asked to and there is one
+      lambda_guess = NULL;
+      if (ws->warm_start && ws->n_saved == n_particles) {
+        i_tmp = 0;
         for (i = 0; i < n_particles; i++) {
-          printf("   %8.6e \n", grad[i]);
+          if (active_particles[i]) {
+            ws->lambda_guess[i_tmp++] = ws->saved_lambda[i];
+          }
         }
-        printf("\n");
+        lambda_guess = ws->lambda_guess;
       }
+    
+      /* *************** END CUTTING OUT ZERO CONCS *********************** */
+      set_eq_stoichiometry(ws, A_tmp, n_particles_tmp, n_compounds_tmp);
+      get_particle_totals(ws, ws->totals_tmp, x0_tmp, n_particles_tmp, 
+          n_compounds_tmp);
+      ret_val = calc_conc_optimize_ws(ws, x_tmp, G_tmp, ws->totals_tmp, 
+            lambda_guess, n_particles_tmp, n_compounds_tmp, max_iters, tol, 
+            delta_bar, eta, min_delta, max_trial, perturb_scale, seed, 
+            act_run_stats, grad, abs_tol);
+
+      // Keep the solution for the next warm start
+      if (ret_val == ERR_OK) {
+        i_tmp = 0;
+        for (i = 0; i < n_particles; i++) {
+          if (active_particles[i]) {
+            ws->saved_lambda[i] = ws->lambda[i_tmp++];
+          }
+          else if (ws->n_saved != n_particles) {
+            ws->saved_lambda[i] = 0.0;
+          }
+        }
+        ws->n_saved = n_particles;
+      }
+    }
 
-      if (write_log_file == 1) {
-        write_concentration_log_file(act_run_stats, grad, abs_tol, log_file);
+    /* *************** CONVERT BACK TO ORIGINAL PROBLEM ******************* */
+    // Give the full gradient, zero where x0 was zero
+    i_tmp = n_particles_tmp - 1;
+    for (i = n_particles - 1; i >= 0; i--) {
+      if (active_particles[i]) {
+        abs_tol[i] = abs_tol[i_tmp];
+        grad[i] = grad[i_tmp--];
+      }
+      else {
+        abs_tol[i] = 0;
+        grad[i] = 0.0;
       }
     }
-  }
-  if(active_particles != NULL) free(active_particles);
-  if(active_compounds != NULL) free(active_compounds);
-  if(num_active != NULL) free(num_active);
 
-  if(A_tmp != NULL) free(A_tmp);
-  if(x_tmp != NULL) free(x_tmp); 
-  if(G_tmp  != NULL) free(G_tmp); 
-  if(x0_tmp  != NULL) free(x0_tmp); 
-  if(new_x0 != NULL) free(new_x0);
-  if(grad != NULL) free(grad);
-  if(abs_tol != NULL) free(abs_tol);
+    // Report concentrations
+    j_tmp = 0;
+    for (j = 0; j < n_compounds; j++) {
+      if (active_compounds[j]) {
+        x[ij(i_point, j, n_compounds)] = x_tmp[j_tmp++];
+      }
+      else {  // Not active. Use original concentration
+        x[ij(i_point, j, n_compounds)] = x0[ij(i_point, j, n_compounds)];
+      }
+    }
+
+    /* *************** DONE CONVERTING BACK TO ORIGINAL PROBLEM *********** */
+
+    // Report errors in conservation of mass to screen
+    if (quiet == 0) {
+      // Print out values of the gradient, which is the error in cons. of mass
+      printf("Error in conservation of mass (units of mole fraction):\n");
+      for (i = 0; i < n_particles; i++) {
+        printf("   %8.6e \n", grad[i]);
+      }
+      printf("\n");
+    }
 
-  if(run_stats == NULL && act_run_stats != NULL) {
-        free(act_run_stats);
+    if (write_log_file == 1) {
+      write_concentration_log_file(act_run_stats, grad, abs_tol, log_file);
+    }
   }
 
   return ret_val;
@@ -339,72 +575,77 @@ int calc_conc_optimize(double *x, double *A, double *G, double *x0,
           double delta_bar, double eta, double min_delta, int max_trial,
           double perturb_scale, unsigned long seed, run_stats_t * run_stats,
           double *final_gradient, double *absolute_tolerance) {
+  /*
+    Same as calc_conc_optimize_ws for the dense A and initial compound mole
+    fractions x0, with a workspace of its own.
+  */
+
+  int ret_val;
+  eq_workspace_t *ws = new_eq_workspace(n_constraints, n_compounds);
+
+  if (ws == NULL) {
+    return ERR_OOM;
+  }
+  set_eq_stoichiometry(ws, A, n_constraints, n_compounds);
+  get_particle_totals(ws, ws->totals_tmp, x0, n_constraints, n_compounds);
+  ret_val = calc_conc_optimize_ws(ws, x, G, ws->totals_tmp, NULL,
+      n_constraints, n_compounds, max_iters, tol, delta_bar, eta, min_delta,
+      max_trial, perturb_scale, seed, run_stats, final_gradient, 
+      absolute_tolerance);
+  free_eq_workspace(ws);
+
+  return ret_val;
+}
+/* ************************************************************************** */
+
+
+/* ************************************************************************** */
+int calc_conc_optimize_ws(eq_workspace_t *ws, double *x, double *G, 
+          double *new_x0, double *lambda_guess, int n_constraints, 
+          int n_compounds, int max_iters, double tol,
+          double delta_bar, double eta, double min_delta, int max_trial,
+          double perturb_scale, unsigned long seed, run_stats_t * run_stats,
+          double *final_gradient, double *absolute_tolerance) {
+  /*
+    Solves the problem whose stoichiometry was given to ws with
+    set_eq_stoichiometry.  new_x0 holds the constraints, i.e., dot(A, x0)
+    (see get_particle_totals).  If lambda_guess is not NULL, the first
+    trial starts from it rather than from the standard initial guess.
+    The Lagrange multipliers of the solution are left in ws->lambda.
+    Nothing is allocated.
+  */
 
   int i, j; // indices, i over particles and j over all compounds
   int iters = 0; // Number of iterations
-  double *abs_tol; // The absolute tolerance on all values of gradient
+  double *abs_tol = ws->abs_tol; // The absolute tolerance on all values of gradient
   double rho; // Ratio of actual to predicted reduction in trust region method
   double delta; // Radius of trust region
-  double *lambda; // Lagrange multipliers
-  double *p; // The step we take toward minimization
-  double *hes; // The Hessian
+  double *lambda = ws->lambda; // Lagrange multipliers
+  double *p = ws->p; // The step we take toward minimization
+  double *hes = ws->hes; // The Hessian
   unsigned long rand_seed = 0; // Random number seed
-  double *new_x0; // Constraint values
-  double *new_lambda; // Adjusted lambda if taking Newton step
+  double *new_lambda = ws->new_lambda; // Adjusted lambda if taking Newton step
   double new_log_scale_fact = 0.0; // Adjusted scale factor if taking Newt step
-  double *new_x; // Adjusted x if taking Newton step
-  double *new_grad; // Adjusted gradient if taking Newton step
-  double *grad;
+  double *new_x = ws->new_x; // Adjusted x if taking Newton step
+  double *new_grad = ws->new_grad; // Adjusted gradient if taking Newton step
+  double *grad = ws->grad;
   double log_scale_fact = 0.0; // Log of scale factor dividing the x values
 
   double n_old; // Old norm of grad
   double n_new; // New norm of grad
   int n_trial; // Number of times we've perturbed lambda
+  int n_no_step; // Number of consecutive rejected steps
+  int warm; // Whether this trial starts from lambda_guess
   int newton_success; // Whether Newton's method was successful
   int ret_val = ERR_OK;
   
-  // Allocate memory
-  new_x0 = (double *) malloc(n_constraints * sizeof(double));
-  hes = (double *) malloc(n_constraints * n_constraints * sizeof(double));
-  abs_tol = (double *) malloc(n_constraints * sizeof(double));
-  grad = (double *) malloc(n_constraints * sizeof(double));
-  lambda = (double *) malloc(n_constraints * sizeof(double));
-  p = (double *) malloc(n_constraints * sizeof(double));
-
-  new_grad = (double *) malloc(n_constraints * sizeof(double));
-  new_lambda = (double *) malloc(n_constraints * sizeof(double));
-  new_x = (double *) malloc(n_compounds * sizeof(double));
-
   run_stats->max_n_trials = max_trial;
   run_stats->n_constraints = n_constraints;
 
-  if(NULL == new_x0 || 
-     NULL == hes || 
-     NULL == abs_tol || 
-     NULL == grad || 
-     NULL == lambda || 
-     NULL == p ||
-     NULL == new_grad ||
-     NULL == new_lambda || 
-     NULL == new_x) {
-    ret_val = ERR_OOM;
-goto end_calc_conc_optimize;
-  } 
-
-  // Make an "x0" that is the constraints, i.e., dot(A, x0).
-  for(i = 0; i < n_constraints; i++) {
-    new_x0[i] = 0.0;
-    for(j = 0; j < n_compounds; j++) {
-      new_x0[i] += A[ij(i,j,n_compounds)] * x0[j];
-    }
-  }
-
   n_trial = 0;
 
-  // The absolute tolerance is a percentage of the entries in x0
-  make_tol(abs_tol, A, x0, n_constraints, n_compounds, tol);
-
   for (i = 0; i < n_constraints; i++) {
+    abs_tol[i] = 0.0;
     grad[i] = abs_tol[i] + 1.0; // Initialize just to get started.
   }
 
@@ -417,15 +658,27 @@ goto end_calc_conc_optimize;
       init_genrand(rand_seed);
     }
 
+    // A warm start is only tried on the first trial, and given up if its
+    // mole fractions overflow
+    warm = 0;
+    if (n_trial == 0 && lambda_guess != NULL) {
+      for (i = 0; i < n_constraints; i++) {
+        lambda[i] = lambda_guess[i];
+      }
+      warm = (get_x(ws, x, &log_scale_fact, lambda, G, n_constraints, 
+                    n_compounds) == ERR_OK);
+    }
+
     // Set initial guess
-    if (get_initial_guess(new_x0, lambda, G, A, n_constraints, 
+    if (!warm && get_initial_guess(ws, new_x0, lambda, G, n_constraints, 
                           n_compounds, perturb_scale, rand_seed)) {
       ret_val = ERR_INITIAL;
 goto end_calc_conc_optimize;
     }
 
     // Calculate the counts of the species based on lambda
-    if (get_x(x, &log_scale_fact, lambda, G, A, n_constraints, n_compounds)){ 
+    if (!warm && get_x(ws, x, &log_scale_fact, lambda, G, n_constraints, 
+                       n_compounds)){ 
       // Should be fine; checked prev.
       // If it overflows on the initial guess, we probably won't be able to
       // find a valid initial guess
@@ -440,13 +693,6 @@ goto end_calc_conc_optimize;
       for (j = 0; j < n_compounds; j++) {
 	printf("%.6e  ", G[j]);
       }
-      printf("\nA = \n");
-      for (i = 0; i < n_constraints; i++) {
-	for (j = 0; j < n_compounds; j++) {
-	  printf("%.8f  ", A[ij(i, j, n_compounds)]);
-	}
-	printf("\n");
-      }
       printf("\n");
 #endif
 
@@ -454,16 +700,17 @@ goto end_calc_conc_optimize;
     }
 
     // Calculate the gradient
-    get_grad(grad, log_scale_fact, new_x0, x, A, n_constraints, n_compounds);
+    get_grad(ws, grad, log_scale_fact, new_x0, x, n_constraints, n_compounds);
     
     // Compute the Hessian (symmetric, positive, positive definite)
-    ret_val = get_hessian(hes, x, A, n_constraints, n_compounds);
+    ret_val = get_hessian(ws, hes, x, n_constraints, n_compounds);
     if(ret_val) goto end_calc_conc_optimize;
       
     // Initialize delta to be just less than delta_bar
     delta = 0.99 * delta_bar;
     
     // Initializations
+    n_no_step = 0;
     run_stats->n_newton_steps = 0; // Number of pure Newton steps
     run_stats->n_cauchy_steps = 0; // Number of pure Cauchy steps
                                    // (hit trust region boundary)
@@ -475,7 +722,7 @@ goto end_calc_conc_optimize;
                                       // Cholesky failures
     run_stats->n_dogleg_fail = 0; // Number of failed dogleg calculations
 
-    make_tol(abs_tol, A, x, n_constraints, n_compounds, tol);
+    make_tol(ws, abs_tol, x, n_constraints, n_compounds, tol);
 
 
 #ifdef DEBUG
@@ -498,14 +745,16 @@ goto end_calc_conc_optimize;
 
     // Run trust region with these initial conditions
     while (iters < max_iters && check_tol(grad, abs_tol, n_constraints) == 0 
-           && delta > min_delta) {
+           && delta > min_delta 
+           && (ws->max_no_step == 0 || n_no_step < ws->max_no_step)) {
 
       // Solve for the search direction
-      ret_val = get_search_dir(p, grad, hes, delta, n_constraints, run_stats);
+      ret_val = get_search_dir(ws, p, grad, hes, delta, n_constraints, 
+                               run_stats);
       if(ret_val) goto end_calc_conc_optimize;
       
       // Calculate rho, ratio of actual to predicted reduction
-      rho = get_rho(lambda, p, grad, x, hes, new_x0, G, A, log_scale_fact,
+      rho = get_rho(ws, lambda, p, grad, x, hes, new_x0, G, log_scale_fact,
                     n_constraints, n_compounds);
       
       // Adjust delta and make step based on rho
@@ -520,9 +769,10 @@ goto end_calc_conc_optimize;
         for (i = 0; i < n_constraints; i++) {
           lambda[i] += p[i];
         }
+        n_no_step = 0;
 
         // Calculate the mole fractions of the complexes based on lambda
-        if (get_x(x, &log_scale_fact, lambda, G, A, 
+        if (get_x(ws, x, &log_scale_fact, lambda, G, 
 		  n_constraints, n_compounds)) {
           // Should be fine; checked prev.
           ret_val = ERR_OVERFLOW;
@@ -533,15 +783,18 @@ goto end_calc_conc_optimize;
         }
       
         // Calculate the gradient
-        get_grad(grad, log_scale_fact, new_x0, x, A, n_constraints, 
+        get_grad(ws, grad, log_scale_fact, new_x0, x, n_constraints, 
 		 n_compounds);
 
         // Compute the Hessian (symmetric, positive, positive definite)
-        ret_val = get_hessian(hes, x, A, n_constraints, n_compounds);
+        ret_val = get_hessian(ws, hes, x, n_constraints, n_compounds);
         if(ret_val) goto end_calc_conc_optimize;
       }
+      else {
+        n_no_step++;
+      }
       
-      make_tol(abs_tol, A, x, n_constraints, n_compounds, tol);
+      make_tol(ws, abs_tol, x, n_constraints, n_compounds, tol);
       // Advance the iterations count
       iters++;
     }
@@ -553,14 +806,14 @@ goto end_calc_conc_optimize;
       while (newton_success && check_tol(grad, abs_tol, n_constraints) == 0 
              && iters < max_iters) {
         // Attempt Newton step
-        if (compute_newton_step(p, grad, hes, n_constraints) == 0) {
+        if (compute_newton_step(ws, p, grad, hes, n_constraints) == 0) {
           // Compute new lambda to see if the gradient decreased
           for (i = 0; i < n_constraints; i++) {
             new_lambda[i] = lambda[i] + p[i];
           }
 
           // Calculate the mole fractions of the complexes based on new lambda
-          ret_val = get_x(new_x, &new_log_scale_fact, new_lambda, G, A, 
+          ret_val = get_x(ws, new_x, &new_log_scale_fact, new_lambda, G, 
 			  n_constraints, n_compounds);
 #ifdef DEBUG
 	  if (ret_val == ERR_OVERFLOW) {
@@ -570,7 +823,7 @@ goto end_calc_conc_optimize;
           if(ret_val != ERR_OK) goto end_calc_conc_optimize;
           
           // Calculate the new gradient
-          get_grad(new_grad, new_log_scale_fact, new_x0, new_x, A, 
+          get_grad(ws, new_grad, new_log_scale_fact, new_x0, new_x, 
 		   n_constraints, n_compounds);
           
           // If we got better with the Newton step, accept it.
@@ -590,7 +843,7 @@ goto end_calc_conc_optimize;
             }
 
             // Calculate the new Hessian
-            ret_val = get_hessian(hes, x, A, n_constraints, n_compounds);
+            ret_val = get_hessian(ws, hes, x, n_constraints, n_compounds);
             if(ret_val) goto end_calc_conc_optimize;
 
             run_stats->n_newton_steps++;
@@ -602,7 +855,7 @@ goto end_calc_conc_optimize;
         else { // Failed to invert matrix in Newton step.
           newton_success = 0;
         }
-        make_tol(abs_tol, A, x, n_constraints, n_compounds, tol);
+        make_tol(ws, abs_tol, x, n_constraints, n_compounds, tol);
         iters++;
       }
     }
@@ -612,7 +865,7 @@ goto end_calc_conc_optimize;
   run_stats->n_iterations = iters;
   run_stats->n_trials = n_trial;
 
-  make_tol(abs_tol, A, x, n_constraints, n_compounds, tol);
+  make_tol(ws, abs_tol, x, n_constraints, n_compounds, tol);
   if (check_tol(grad, abs_tol, n_constraints) == 0) { // failed, too many iters
     ret_val = ERR_NOCONVERGE;
   }
@@ -647,39 +900,16 @@ goto end_calc_conc_optimize;
     }
     printf("\n");
     printf("n_iters = %d\n", iters);
-    printf("\nA = \n");
-    for (i = 0; i < n_constraints; i++) {
-      for (j = 0; j < n_compounds; j++) {
-	printf("%.6e   ", A[ij(i, j, n_compounds)]);
-      }
-      printf("\n");
-    }
     printf("\nG = ");
     for (j = 0; j < n_compounds; j++) {
       printf("%.6e  ", G[j]);
     }
-    printf("\nx0 = ");
-    for (j = 0; j < n_compounds; j++) {
-      printf("%.6e  ", x0[j]);
-    }
     printf("\n\n");
 #endif
 
 
 
 end_calc_conc_optimize:
-  // Free memory
-  if(new_x0 != NULL) free(new_x0);
-  if(hes != NULL) free(hes);
-  if(abs_tol != NULL) free(abs_tol);
-  if(grad != NULL) free(grad);
-  if(lambda != NULL) free(lambda);
-  if(p != NULL) free(p);
-    
-  if(new_grad != NULL) free(new_grad); 
-  if(new_lambda != NULL) free(new_lambda ); 
-  if(new_x != NULL) free(new_x ); 
-
   // Return convergence
   return ret_val;
 }
@@ -688,6 +918,70 @@ end_calc_conc_optimize:
 /* ************************************************************************** */
 
 
+/* ************************************************************************** */
+int calc_conc_sensitivity(double *dxdG, double *x, double *A, 
+                          int n_particles, int n_compounds, 
+                          eq_workspace_t *ws) {
+  /*
+    Derivatives of the equilibrium mole fractions x (a solution for the
+    n_particles x n_compounds matrix A) with respect to the free energies
+    (units of kT): dxdG[ij(j, k, n_compounds)] = dx_j / dG_k.
+
+    With ln x_j = -G_j + A_j^T lambda and the constraints A x fixed,
+
+      dx_j / dG_k = x_j (-delta_jk + A_j^T H^{-1} A_k x_k),
+
+    where A_j is column j of A and H = A diag(x) A^T is the Hessian of the
+    dual.  H is factored once by modified Cholesky, which also regularizes
+    the rows of particles absent from the solution.  All scratch storage is
+    taken from ws, whose stoichiometry is replaced by A.
+  */
+
+  int i, j, k, m; // i over particles, j and k over compounds
+  double dot_prod;
+  double *hes; // Factored Hessian
+  double *rhs; // A_k x_k
+  double *w; // H^{-1} A_k x_k
+
+  if (reserve_eq_workspace(ws, n_particles, n_compounds) != ERR_OK) {
+    return ERR_OOM;
+  }
+  hes = ws->hes_copy;
+  rhs = ws->c;
+  w = ws->p;
+
+  set_eq_stoichiometry(ws, A, n_particles, n_compounds);
+  get_hessian(ws, hes, x, n_particles, n_compounds);
+  modified_cholesky(hes, ws->perm, n_particles);
+
+  for (k = 0; k < n_compounds; k++) {
+    // w = H^{-1} A_k x_k
+    for (i = 0; i < n_particles; i++) {
+      rhs[i] = 0.0;
+    }
+    for (m = ws->a_start[k]; m < ws->a_start[k+1]; m++) {
+      rhs[ws->a_particle[m]] = ws->a_coeff[m] * x[k];
+    }
+    modified_cholesky_solve_work(hes, ws->perm, n_particles, rhs, w, 
+                                 ws->work);
+
+    for (j = 0; j < n_compounds; j++) {
+      dot_prod = 0.0;
+      for (m = ws->a_start[j]; m < ws->a_start[j+1]; m++) {
+        dot_prod += ws->a_coeff[m] * w[ws->a_particle[m]];
+      }
+      if (j == k) {
+        dot_prod -= 1.0;
+      }
+      dxdG[ij(j, k, n_compounds)] = x[j] * dot_prod;
+    }
+  }
+
+  return ERR_OK;
+}
+/* ************************************************************************** */
+
+
 /* ************************************************************************** */
 int get_G_from_K(double *G, double *minus_log_K, double *augmented_N, 
 		 int n_reactions, int n_compounds) {
@@ -1496,8 +1790,8 @@ int calc_titration_from_free_energies(
 
 
 /* ************************************************************************** */
-int get_initial_guess(double *x0, double *lambda, double *G, double *A, 
-                      int n_constraints, int n_compounds, 
+int get_initial_guess(eq_workspace_t *ws, double *x0, double *lambda, 
+                      double *G, int n_constraints, int n_compounds, 
                       double perturb_scale, unsigned long rand_seed) {
   /*
     Pick initial lambda such that ln x = 1 for all x (x ~ 3).
@@ -1505,47 +1799,41 @@ int get_initial_guess(double *x0, double *lambda, double *G, double *A,
     This is done by solving:
       A . A_transpose . lambda = A . (G + 1)
 
-    lambda must be preallocated to have n_constraints entries.
+    lambda must be preallocated to have n_constraints entries.  x0 holds
+    the constraints, dot(A, x0).
   */
 
-  int i, j, k; // indices
+  int i, j, k, m, n; // indices
   double log_x = 1.0; // log of the mole fractions
-  double *c = NULL; // Right hand side of eqtn to solve.
-  int *p = NULL; // Permutation array for LUP decomposition
-  double *G_plus_log_x = NULL;
-  double *A_AT = NULL; // A times its transpose
-  double sum_parts = 0;
-  int n_nonzero = 0;
+  double *c = ws->c; // Right hand side of eqtn to solve.
+  int *p = ws->perm; // Permutation array for LUP decomposition
+  double *G_plus_log_x = ws->G_plus_log_x;
+  double *A_AT = ws->a_at; // A times its transpose
+  int *a_start = ws->a_start;
+  int *a_particle = ws->a_particle;
+  double *a_coeff = ws->a_coeff;
   int ret_val;  // Return value of LUP solve
 
-
-  // Allocate memory
-  G_plus_log_x = (double *) malloc(n_compounds * sizeof(double));
-  c = (double *) malloc(n_constraints * sizeof(double));
-  p = (int *) malloc(n_constraints * sizeof(int));
-  A_AT = (double *) malloc(n_constraints * n_constraints * sizeof(double));
-  if (NULL == A_AT ||
-      NULL == G_plus_log_x ||
-      NULL == c ||
-      NULL == p) {
-    return ERR_OOM;
-  }
-
   // Compute G + log_x, a vector
   for (j = 0; j < n_compounds; j++) {
     G_plus_log_x[j] = G[j] + log_x;
   }
 
-  // c is the right hand side of equation to solve.
-  matrix_vector_mult(c, A, G_plus_log_x, n_constraints, n_compounds);
-
-  // Compute matrix multiplying lambda (usually identity, but not assuming that)
+  // c is the right hand side of equation to solve, and A_AT the matrix
+  // multiplying lambda (usually identity, but not assuming that).  Both
+  // are accumulated compound by compound over the nonzero entries of A.
   for (i = 0; i < n_constraints; i++) {
+    c[i] = 0.0;
     for (j = 0; j < n_constraints; j++) {
       A_AT[ij(i, j, n_constraints)] = 0.0;
-      for (k = 0; k < n_compounds; k++) {
-        A_AT[ij(i, j, n_constraints)] 
-          += A[ij(i, k, n_compounds)] * A[ij(j, k, n_compounds)];
+    }
+  }
+  for (k = 0; k < n_compounds; k++) {
+    for (m = a_start[k]; m < a_start[k+1]; m++) {
+      i = a_particle[m];
+      c[i] += a_coeff[m] * G_plus_log_x[k];
+      for (n = a_start[k]; n < a_start[k+1]; n++) {
+        A_AT[ij(i, a_particle[n], n_constraints)] += a_coeff[m] * a_coeff[n];
       }
     }
   }
@@ -1554,63 +1842,22 @@ int get_initial_guess(double *x0, double *lambda, double *G, double *A,
   // could use modified cholesky
   // Solve using LUP decomposition
   modified_cholesky(A_AT, p, n_constraints);  
-  ret_val = modified_cholesky_solve(A_AT, p, n_constraints, c, lambda);
+  ret_val = modified_cholesky_solve_work(A_AT, p, n_constraints, c, lambda,
+                                         ws->work);
   
   // Perturb lambda if desired
   if (rand_seed != 0) {
-    perturb_lambda(lambda, perturb_scale, G, A, n_constraints, n_compounds);
+    perturb_lambda(ws, lambda, perturb_scale, G, n_constraints, n_compounds);
   }
 
-  // If we already know concentration (particle is inert), set lambda
-  for (i = 0; i < n_constraints; i++) {
-    sum_parts = 0;
-    n_nonzero = 0;
-    for (j = 0; j < n_compounds; j++) {
-      sum_parts += A[ij(i, j, n_compounds)];
-      n_nonzero++;
-    }
-
-    if (n_nonzero == 1) {
-      // Find the first nonzero entry in the row of A
-      j = 0;
-      while (j < n_compounds && A[ij(i, j, n_compounds)] < DBL_MIN 
-          && -A[ij(i, j, n_compounds)] < DBL_MIN) {
-        j++;
-      }
-      
-      lambda[i] = (log(x0[i]) + G[j]) / sum_parts;
-    }
-  }
-
-  /*
-  // THIS STUFF IS BRIAN'S HACK TO ADJUST LAMBDA IF WE HAVE OVERFLOW
-  // THIS SHOULD NOT BE NECESSARY WITH OUR NEW SCALED CONCENTRATIONS METHOD
-  double dot_prod;
-  double magnitude;
-  double diff;
-  for (j = 0; j < n_compounds; j++) {
-    dot_prod = 0.0;
-    magnitude = 0.0;
-    for (i = 0; i < n_constraints; i++) {
-      dot_prod += lambda[i] * A[ij(i, j, n_compounds)];
-      magnitude += fabs(A[ij(i, j, n_compounds)]);
-    }
-    log_x = -G[j] + dot_prod;
-    if (log_x > MAXLOGX / 2) {
-      diff = log_x - MAXLOGX / 2;
-      diff /= magnitude;
-      for (i = 0; i < n_constraints; i++) {
-        lambda[i] -= diff * A[ij(i, j, n_compounds)];
-      }
+  // If we already know concentration (particle is inert), set lambda.  This
+  // is only the case when there is a single compound.
+  if (n_compounds == 1) {
+    for (m = a_start[0]; m < a_start[1]; m++) {
+      i = a_particle[m];
+      lambda[i] = (log(x0[i]) + G[0]) / a_coeff[m];
     }
   }
-  */
-
-  // Free memory. Avoid freeing NULL pointer
-  if(NULL != G_plus_log_x) free(G_plus_log_x);
-  if(NULL != A_AT) free(A_AT);
-  if(NULL != p) free(p);
-  if(NULL != c) free(c);
 
   return ret_val;
 }
@@ -1618,8 +1865,8 @@ int get_initial_guess(double *x0, double *lambda, double *G, double *A,
 
 
 /* ************************************************************************** */
-int get_x(double *x, double *log_scale_fact, double *lambda, double *G, 
-	  double *A, int n_constraints, int n_compounds) {
+int get_x(eq_workspace_t *ws, double *x, double *log_scale_fact, 
+          double *lambda, double *G, int n_constraints, int n_compounds) {
   /* 
      Calculates the mole fractions of all species from lambda, G, and
      A.  Returns 0 if the calculation was ok and ERR_OVERFLOW if there will
@@ -1629,34 +1876,20 @@ int get_x(double *x, double *log_scale_fact, double *lambda, double *G,
     concentrations, then x = x_real / exp(log_scale_fact).
   */
 
-  int i, j; // indices
-  int ret_val = 0; // Value to be returned
-  double *log_x = NULL; // log of the mole fraction
-  double log_scale_factor; // The log of the scaling factor for the concs
+  int j, k; // indices
+  double *log_x = ws->log_x; // log of the mole fraction
+  double log_scale_factor = 0.0; // The log of the scaling factor for the concs
   double dot_prod; // Dot product
   double exp_arg; // Argument for exponential, log_x - log_scale_fact
 
-  // Allocate memory
-  if (NULL == (log_x = (double *) malloc(n_compounds * sizeof(double)))) {
-    return ERR_OOM;
-  }
-
-  // Compute log_x for first compound
-  dot_prod = 0.0;
-  for (i = 0; i < n_constraints; i++) {
-    dot_prod += lambda[i] * A[ij(i, 0, n_compounds)];
-  }
-  log_x[0] = -G[0] + dot_prod;
-  log_scale_factor = log_x[0];
-
-  // Compute log_x for the rest of the compounds
-  for (j = 1; j < n_compounds; j++) {
+  // Compute log_x for the compounds
+  for (j = 0; j < n_compounds; j++) {
     dot_prod = 0.0;
-    for (i = 0; i < n_constraints; i++) {
-      dot_prod += lambda[i] * A[ij(i, j, n_compounds)];
+    for (k = ws->a_start[j]; k < ws->a_start[j+1]; k++) {
+      dot_prod += lambda[ws->a_particle[k]] * ws->a_coeff[k];
     }
     log_x[j] = -G[j] + dot_prod;
-    if (log_x[j] > log_scale_factor) {
+    if (j == 0 || log_x[j] > log_scale_factor) {
       log_scale_factor = log_x[j];
     }
   }
@@ -1665,27 +1898,22 @@ int get_x(double *x, double *log_scale_fact, double *lambda, double *G,
   for (j = 0; j < n_compounds; j++) {
     exp_arg = log_x[j] - log_scale_factor;
     if (exp_arg > MAXLOGX) {
-      ret_val = ERR_OVERFLOW;
-goto end_get_x;
+      return ERR_OVERFLOW;
     }
     x[j] = exp(exp_arg);
   }
 
   *log_scale_fact = log_scale_factor;
 
-end_get_x:
-  // Free memory
-  if(NULL != log_x) free(log_x);
-
   // No overflow errors
-  return ret_val;
+  return ERR_OK;
 }
 /* ************************************************************************** */
 
 
 /* ************************************************************************** */
-void get_grad(double *grad, double log_scale_fact, double *x0, double *x, 
-	      double *A, int n_constraints, int n_compounds) {
+void get_grad(eq_workspace_t *ws, double *grad, double log_scale_fact, 
+              double *x0, double *x, int n_constraints, int n_compounds) {
   /*
     Calculates the gradient of -h(\lambda), the dual function for
     which we're trying to find the minimum.
@@ -1696,22 +1924,27 @@ void get_grad(double *grad, double log_scale_fact, double *x0, double *x,
     The outputted gradient is also scaled.
   */
 
-  int i, j; // indices
-  double dot_prod;
+  int i, j, k; // indices
 
+  // dot(A, x), accumulated compound by compound
   for (i = 0; i < n_constraints; i++) {
-    dot_prod = 0.0;
-    for (j = 0; j < n_compounds; j++) {
-      dot_prod += x[j] * A[ij(i, j, n_compounds)];
+    grad[i] = 0.0;
+  }
+  for (j = 0; j < n_compounds; j++) {
+    for (k = ws->a_start[j]; k < ws->a_start[j+1]; k++) {
+      grad[ws->a_particle[k]] += x[j] * ws->a_coeff[k];
     }
-    grad[i] = -x0[i] * exp(-log_scale_fact) + dot_prod;
+  }
+
+  for (i = 0; i < n_constraints; i++) {
+    grad[i] = -x0[i] * exp(-log_scale_fact) + grad[i];
   }
 }
 /* ************************************************************************** */
 
 
 /* ************************************************************************** */
-int get_hessian(double *hes, double *x, double *A, int n_constraints, 
+int get_hessian(eq_workspace_t *ws, double *hes, double *x, int n_constraints,
                  int n_compounds) {
   /*
     Calculates the Hessian, hes.  Must be preallocated and of size
@@ -1722,46 +1955,43 @@ int get_hessian(double *hes, double *x, double *A, int n_constraints,
     The inputted x is the scaled x.  If x_real is the "real"
     concentrations, then x = x_real / exp(log_scale_fact).
 
-    Avec is a vector consisting of elements of one row of A multiplied by 
-    those of another.
+    Each compound adds x_j times the products of the pairs of its nonzero
+    entries of A.
   */
 
+  int m, n, j, a, b; // index
 
-  int m, n, j; // index
-  double *Avec;
-  int ret_val = ERR_OK;
-
-  Avec = (double *) malloc(n_compounds * sizeof(double));
-
-  if(NULL == Avec) {
-    ret_val = ERR_OOM;
-  } else {
-    for (n = 0; n < n_constraints; n++) {
-      for (m = 0; m <= n; m++) {
-        for (j = 0; j < n_compounds; j++) {
-          Avec[j] = A[ij(m, j, n_compounds)] * A[ij(n, j, n_compounds)];
-        }
-        hes[ij(m, n, n_constraints)] = dot(x, Avec, n_compounds);
+  for (n = 0; n < n_constraints; n++) {
+    for (m = 0; m <= n; m++) {
+      hes[ij(m, n, n_constraints)] = 0.0;
+    }
+  }
+  for (j = 0; j < n_compounds; j++) {
+    for (a = ws->a_start[j]; a < ws->a_start[j+1]; a++) {
+      m = ws->a_particle[a];
+      for (b = a; b < ws->a_start[j+1]; b++) {
+        n = ws->a_particle[b];
+        hes[ij(m, n, n_constraints)] += 
+          x[j] * (ws->a_coeff[a] * ws->a_coeff[b]);
       }
     }
+  }
 
-    // Fill out the lower entries in the Hessian (needed for matrix mults)
-    for(m = 1; m < n_constraints; m++) {
-      for (n = 0; n < m; n++) {
-        hes[ij(m, n, n_constraints)] = hes[ij(n, m, n_constraints)];
-      }
+  // Fill out the lower entries in the Hessian (needed for matrix mults)
+  for(m = 1; m < n_constraints; m++) {
+    for (n = 0; n < m; n++) {
+      hes[ij(m, n, n_constraints)] = hes[ij(n, m, n_constraints)];
     }
   }
 
-  if(Avec != NULL) free(Avec);
-  return ret_val;
+  return ERR_OK;
 }
 /* ************************************************************************** */
 
 
 /* ************************************************************************** */
-int get_search_dir(double *p, double *grad, double *hes, double delta, 
-                   int n_constraints, run_stats_t * run_stats) {
+int get_search_dir(eq_workspace_t *ws, double *p, double *grad, double *hes, 
+                   double delta, int n_constraints, run_stats_t * run_stats) {
   /*
     Computes the search direction using the dogleg method (Nocedal and Wright,
     page 71).  Notation is consistent with that in this reference.
@@ -1787,12 +2017,12 @@ int get_search_dir(double *p, double *grad, double *hes, double delta,
   double t1, t2, t3; // Temporary variables used in quadratic formula
   double tau; // Multipler in Newtonstep
   double beta; // = tau - 1
-  double *pB; // Unconstrained minimizer (the regular Newton step)
-  double *pU; // Minimizer along steepest descent direction
+  double *pB = ws->pB; // Unconstrained minimizer (the regular Newton step)
+  double *pU = ws->pU; // Minimizer along steepest descent direction
   double pB2; // pj^2
   double pU2; // pu^2
   double pBpU; // pj . pc
-  double *hes_dot_grad; // Hessian dotted with the gradient
+  double *hes_dot_grad = ws->hes_dot_grad; // Hessian dotted with the gradient
   double pUcoeff;  // The coefficient on the Cauchy step
   double delta2; // delta^2
   int newton_fail; // = 1 if Newton step failed
@@ -1804,18 +2034,9 @@ int get_search_dir(double *p, double *grad, double *hes, double delta,
   // Useful to have delta^2 around.
   delta2 = pow(delta, 2);
 
-  // Allocate all memory arrays
-  pB = (double *) malloc(n_constraints * sizeof(double));
-  hes_dot_grad = (double *) malloc(n_constraints * sizeof(double));
-  pU = (double *) malloc(n_constraints * sizeof(double));
-  if(pB == NULL || hes_dot_grad == NULL || pU == NULL) {
-    ret_val = ERR_OOM;
-goto end_get_search_dir;
-  }
-
   /* ********** Compute the Newton step ************** */
 
-  newton_fail = compute_newton_step(pB, grad, hes, n_constraints);
+  newton_fail = compute_newton_step(ws, pB, grad, hes, n_constraints);
   if (newton_fail == 0) {
     // If Newton step is within trust region, take it
     pB2 = dot(pB, pB, n_constraints);
@@ -1912,9 +2133,6 @@ goto end_get_search_dir;
 
 end_get_search_dir:
 
-  free(pB);
-  free(pU);
-  free(hes_dot_grad);
   return ret_val;
   /* ************************************************* */
 }
@@ -1922,8 +2140,8 @@ end_get_search_dir:
 
 
 /* ************************************************************************** */
-int compute_newton_step(double *pB, double *grad, double *hes, 
-                        int n_constraints) {
+int compute_newton_step(eq_workspace_t *ws, double *pB, double *grad, 
+                        double *hes, int n_constraints) {
   /*
     Computes a Newton step, given the Hessian and the gradient
     (assuming the Hessian is positive definite).  Returns 0 is the
@@ -1933,16 +2151,13 @@ int compute_newton_step(double *pB, double *grad, double *hes,
   */
 
   int i, j; // indices
-  double *hes_copy; // Copy of the upper triangle of the Hessian 
-                    // (don't want to mess with actual Hessian).
-  int *p;
+  double *hes_copy = ws->hes_copy; // Copy of the upper triangle of the 
+                    // Hessian (don't want to mess with actual Hessian).
+  int *p = ws->perm;
   int chol_success; // Whether of not Cholesky decomposition is successful
 
   // Make a copy of the Hessian because the Cholesky decomposition messes
   // with its entries.  We only have to copy the upper diagonal.
-  hes_copy = (double *) malloc(n_constraints * n_constraints * sizeof(double));
-  p = (int *) malloc(n_constraints * sizeof(int));
- 
   for (j = 0; j < n_constraints; j++) {
     for (i = j; i < n_constraints; i++) {
       hes_copy[ij(i, j, n_constraints)] = hes[ij(i, j, n_constraints)];
@@ -1952,11 +2167,8 @@ int compute_newton_step(double *pB, double *grad, double *hes,
   chol_success = modified_cholesky(hes_copy, p, n_constraints);
 
   if (chol_success == 0) {
-    modified_cholesky_solve(hes_copy, p, n_constraints, grad, pB);
-
-    // Free memory from the Hessian
-    free(hes_copy);
-    free(p);
+    modified_cholesky_solve_work(hes_copy, p, n_constraints, grad, pB, 
+                                 ws->work);
 
     // Newton step is -H^{-1} grad
     for (i = 0; i < n_constraints; i++) {
@@ -1965,33 +2177,26 @@ int compute_newton_step(double *pB, double *grad, double *hes,
 
     return 0;
   }
-  else { // Free memory from failed Newton step computation and return 0
+  else { // Fall back on LUP decomposition and return 1 if it fails too
     for(i = 0; i < n_constraints; i++) {
       for(j = 0; j < n_constraints; j++) {
         hes_copy[ij(i, j, n_constraints)] = hes[ij(i, j, n_constraints)];
       }
     }
     lup_decomposition(hes_copy, p, n_constraints);
-    if(0 == lup_solve(hes_copy, p, n_constraints, grad, pB)) {
+    if(0 == lup_solve_work(hes_copy, p, n_constraints, grad, pB, ws->work)) {
       for(i = 0; i < n_constraints; i++) {
         pB[i] *= -1.0;
       }
-      free(hes_copy);
-      free(p);
       return 0;
     }
-    free(hes_copy);
-    free(p);
     return 1;
   }
 }
 /* ************************************************************************** */
-
-
-/* ************************************************************************** */
-double get_rho(double *lambda, double *p, double *grad, double *x, double *hes, 
-               double *x0, double *G, double *A, double log_scale_fact, 
-	       int n_constraints, int n_compounds) {
+double get_rho(eq_workspace_t *ws, double *lambda, double *p, double *grad, 
+               double *x, double *hes, double *x0, double *G, 
+               double log_scale_fact, int n_constraints, int n_compounds) {
   /*
     Calculates rho based on equations 4.4 and 4.1 of Nocedal and
     Wright.  This is the ratio of the actual correction based on the
@@ -2004,21 +2209,15 @@ double get_rho(double *lambda, double *p, double *grad, double *x, double *hes,
 
   int i; // index
   double rho; // That which we return
-  double *new_lambda; // y after the step
-  double *new_x; // x after the Newton step
-  double *hes_dot_p; // the vector hes*p
+  double *new_lambda = ws->rho_lambda; // y after the step
+  double *new_x = ws->rho_x; // x after the Newton step
+  double *hes_dot_p = ws->hes_dot_p; // the vector hes*p
   double obj_fun; // -h(lambda)
   double new_obj_fun; // New one
   double p_dot_hes_dot_p; // p * H * p
   double new_log_scale_fact; // New scale factor with new x
   double l_dot_x0;
 
-
-  // Allocate memory for arrays used in the calculation.
-  new_lambda = (double *) malloc(n_constraints * sizeof(double));
-  new_x = (double *) malloc(n_compounds * sizeof(double));
-  hes_dot_p = (double *) malloc(n_constraints * sizeof(double));
-
   l_dot_x0 = dot(lambda, x0, n_constraints);
   l_dot_x0 *= exp(-log_scale_fact);
 
@@ -2031,7 +2230,7 @@ double get_rho(double *lambda, double *p, double *grad, double *x, double *hes,
   }
 
   // Calculate the counts of the species based on new lambda
-  if (get_x(new_x, &new_log_scale_fact, new_lambda, G, A, n_constraints, 
+  if (get_x(ws, new_x, &new_log_scale_fact, new_lambda, G, n_constraints, 
 	    n_compounds) == 0) {
 
     new_obj_fun = sum(new_x, n_compounds);
@@ -2059,18 +2258,14 @@ double get_rho(double *lambda, double *p, double *grad, double *x, double *hes,
     rho = -1.0;
   }
 
-  free(new_lambda);
-  free(new_x);
-  free(hes_dot_p);
-
   return rho;
 }
 /* ************************************************************************** */
 
 
 /* ************************************************************************** */
-void get_cauchy_point(double *cauchy_point, double *hes, double *grad, 
-                      double delta, int n_constraints) {
+void get_cauchy_point(eq_workspace_t *ws, double *cauchy_point, double *hes, 
+                      double *grad, double delta, int n_constraints) {
   /*
    Computes the Cauchy point using the formulas 4.7 and 4.8 in Nocedal
    and Wright, Numerical Optimization (1999), page 70.
@@ -2083,9 +2278,7 @@ void get_cauchy_point(double *cauchy_point, double *hes, double *grad,
   double coeff; // Coefficient on gradient for Cauchy point
   double tau; // Multiplier used in Cauchy point calculation
   double norm_grad; // ||Grad||
-  double *hes_dot_grad; // Hessian dotted with the gradient
-  
-  hes_dot_grad = (double *) malloc (n_constraints * sizeof(double));
+  double *hes_dot_grad = ws->hes_dot_grad; // Hessian dotted with the gradient
 
   norm_grad = norm(grad, n_constraints);
   matrix_vector_mult(hes_dot_grad, hes, grad, n_constraints, n_constraints);
@@ -2097,15 +2290,13 @@ void get_cauchy_point(double *cauchy_point, double *hes, double *grad,
   for (i = 0; i < n_constraints; i++) {
     cauchy_point[i] = coeff * grad[i];
   }
-   
-  free(hes_dot_grad);
 }
 /* ************************************************************************** */
 
 
 /* ************************************************************************** */
-int perturb_lambda(double *lambda, double perturb_scale, double *G, double *A, 
-                int n_constraints, int n_compounds) {
+int perturb_lambda(eq_workspace_t *ws, double *lambda, double perturb_scale, 
+                   double *G, int n_constraints, int n_compounds) {
   /*
     Perturbs the values of lambda in case the trust region has shrunk to be 
     very small.
@@ -2114,28 +2305,21 @@ int perturb_lambda(double *lambda, double perturb_scale, double *G, double *A,
   */
 
   int i; // index
-  double *dummy_x; // A dummy mole fraction vector for checking overflow
+  double *dummy_x = ws->dummy_x; // A dummy mole fraction vector for 
+                                 // checking overflow
   double dummy_log_scale_fact; // Dummy variable for checking overflow
-  double *new_lambda; // The new perturbed lambda
+  double *new_lambda = ws->trial_lambda; // The new perturbed lambda
   int xOK; // = 0 is there is no overflow error induced in the concentrations
   int ret_val = ERR_OK;
   int counter = 0;
   int max_counter = 10000;
 
-  dummy_x = (double *) malloc(n_compounds * sizeof(double));
-  new_lambda = (double *) malloc(n_constraints * sizeof(double));
-
-  if(NULL == dummy_x ||
-     NULL == new_lambda) {
-    ret_val = ERR_OOM;
-  }
-
   xOK = 1;
   while (xOK == 1 && ret_val == ERR_OK && counter < max_counter) {
     for (i = 0; i < n_constraints; i++) {
       new_lambda[i] = lambda[i] + perturb_scale * 2.0 * (genrand_real1() - 0.5);
     }
-    xOK = get_x(dummy_x, &dummy_log_scale_fact, new_lambda, G, A, 
+    xOK = get_x(ws, dummy_x, &dummy_log_scale_fact, new_lambda, G, 
 		n_constraints, n_compounds);
     perturb_scale /= 2.0; // Reduce scale to try not to have overflow problems
   }
@@ -2152,25 +2336,25 @@ int perturb_lambda(double *lambda, double perturb_scale, double *G, double *A,
     lambda[i] = new_lambda[i];
   }
   
-  free(dummy_x);
-  free(new_lambda);
   return ret_val;
 }
 /* ************************************************************************** */
 
 /* ************************************************************************** */
-void make_tol(double *abs_tol, double *A, double *x, int n_constraints, 
-        int n_compounds, double tol) {
+void make_tol(eq_workspace_t *ws, double *abs_tol, double *x, 
+        int n_constraints, int n_compounds, double tol) {
   /*
     Determines what the absolute tolerance is for each of the constraints.
   */
 
-  int i, j;
+  int i, j, k;
 
   for (i = 0; i < n_constraints; i++) {
     abs_tol[i] = 0.0;
-    for (j = 0; j < n_compounds; j++) {
-      abs_tol[i] += tol * fabs(A[ij(i, j, n_compounds)]) * x[j];
+  }
+  for (j = 0; j < n_compounds; j++) {
+    for (k = ws->a_start[j]; k < ws->a_start[j+1]; k++) {
+      abs_tol[ws->a_particle[k]] += tol * fabs(ws->a_coeff[k]) * x[j];
     }
   }
 }
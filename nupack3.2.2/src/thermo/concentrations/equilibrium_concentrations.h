@@ -7,9 +7,14 @@
   Header file with global variables and function prototypes for use
   with concentrations.c Contains trust region parameters, among
   others.
+
+  The solver is built into the nupackconc library and used by the
+  concentrations executable (through CalcConc.c) and by both design
+  engines.  Return codes are those of ERROR_RETURN in the design
+  engines' pathway_debug.h.
 */
 
-#include "utils.h"
+#include "equilibrium_utils.h"
   
 #include <getopt.h>// Takes options from the command line
 #include <stdlib.h>
@@ -27,10 +32,16 @@ extern "C" {
 #define EQCONVERSION "0.05"
 
 // Constants used in trust region
+#ifndef TRUST_REGION_DELTABAR
 #define TRUST_REGION_DELTABAR 1000.0 // Maximal size of trust region
+#endif
+#ifndef TRUST_REGION_ETA
 #define TRUST_REGION_ETA 0.125 // Decision criterion for trust region
+#endif
 
+#ifndef MAXLOGX
 #define MAXLOGX 250 // Maximum logarithm of a concentration (prevents overflow)
+#endif
 
 /* *************************** Struct Definitions *************************** */
 typedef struct _RUN_STATS_T_ {
@@ -48,11 +59,89 @@ typedef struct _RUN_STATS_T_ {
   int n_irrel_chol_fail;
   int n_dogleg_fail;
 } run_stats_t;
+
+typedef struct _EQ_WORKSPACE_T_ {
+  /*
+    Scratch storage of the solver, reused across solves so that repeated
+    evaluations (one per tube per design step) allocate nothing.  It grows
+    on demand; all arrays are carved out of block.
+
+    The stoichiometry of the problem being optimized is kept sparse, as a
+    list of (particle, coefficient) pairs per compound in increasing
+    particle order: compound j holds entries a_start[j]..a_start[j+1]-1.
+  */
+  int max_particles; // Capacity of the arrays below
+  int max_compounds;
+  char *block;
+
+  int *a_start;
+  int *a_particle;
+  double *a_coeff;
+
+  // Used by calc_conc_from_free_energies_ws to cut out inactive species
+  int *active_particles;
+  int *active_compounds;
+  int *num_active;
+  double *A_tmp;
+  double *x_tmp;
+  double *G_tmp;
+  double *x0_tmp;
+  double *particle_x0;
+  double *totals_tmp;
+  double *full_grad;
+  double *full_abs_tol;
+  double *lambda_guess;
+
+  // Used by calc_conc_optimize_ws and the functions it calls
+  double *hes;
+  double *hes_copy;
+  double *a_at;
+  double *abs_tol;
+  double *grad;
+  double *lambda; // Lagrange multipliers of the last solve
+  double *p;
+  double *new_grad;
+  double *new_lambda;
+  double *new_x;
+  double *log_x;
+  double *pB;
+  double *pU;
+  double *hes_dot_grad;
+  double *hes_dot_p;
+  double *rho_lambda;
+  double *rho_x;
+  double *trial_lambda;
+  double *dummy_x;
+  double *G_plus_log_x;
+  double *c;
+  double *work;
+  int *perm;
+
+  // Warm start: with warm_start set, each solve starts from the lambda of
+  // the last converged one (n_saved particles, 0 if there is none)
+  int warm_start;
+  int n_saved;
+  double *saved_lambda;
+
+  // Restart once this many consecutive trust region steps are rejected
+  // (0 for no limit)
+  int max_no_step;
+
+  run_stats_t run_stats;
+} eq_workspace_t;
 /* ************************************************************************** */
 
 
 // Function prototypes
 /* ***************** IN EQUILIBRIUM_CONCENTRATIONS.C  *********************** */
+eq_workspace_t *new_eq_workspace(int n_particles, int n_compounds);
+void free_eq_workspace(eq_workspace_t *ws);
+int reserve_eq_workspace(eq_workspace_t *ws, int n_particles, 
+                         int n_compounds);
+void set_eq_stoichiometry(eq_workspace_t *ws, double *A, int n_particles, 
+                          int n_compounds);
+void get_particle_totals(eq_workspace_t *ws, double *totals, double *x0,
+                         int n_particles, int n_compounds);
 int calc_conc_from_free_energies(double *x, double *A, double *G, double *x0,
                                  int n_particles, int n_compounds, 
                                  int n_points, int max_iters, double tol, 
@@ -61,6 +150,14 @@ int calc_conc_from_free_energies(double *x, double *A, double *G, double *x0,
                                  double perturb_scale, int quiet, 
                                  int write_log_file, char *log_file, 
 				 unsigned long seed, run_stats_t * run_stats);
+int calc_conc_from_free_energies_ws(eq_workspace_t *ws, double *x, double *A,
+                                 double *G, double *x0, int n_particles, 
+                                 int n_compounds, int n_points, int max_iters,
+                                 double tol, double delta_bar, double eta, 
+                                 double min_delta, int max_trial, 
+                                 double perturb_scale, int quiet, 
+                                 int write_log_file, char *log_file, 
+                                 unsigned long seed, run_stats_t * run_stats);
 int calc_conc(double *x, double *N, double *minus_log_K,
 	      double *x0, int n_reactions, int n_compounds, 
               int n_points, int max_iters, double tol, 
@@ -74,6 +171,14 @@ int calc_conc_optimize(double *x, double *A, double *G, double *x0,
               double min_delta, int max_trial, double perturb_scale,
               unsigned long seed, run_stats_t * run_stats,
               double * gradient, double * abs_tol);
+int calc_conc_optimize_ws(eq_workspace_t *ws, double *x, double *G, 
+              double *x0, double *lambda_guess, int n_particles, 
+              int n_compounds, int max_iters, double tol, double delta_bar,
+              double eta, double min_delta, int max_trial, 
+              double perturb_scale, unsigned long seed, 
+              run_stats_t * run_stats, double * gradient, double * abs_tol);
+int calc_conc_sensitivity(double *dxdG, double *x, double *A, 
+              int n_particles, int n_compounds, eq_workspace_t *ws);
 int get_G_from_K(double *G, double *minus_log_K, double *N, int n_compounds, 
 		 int n_particles);
 int prune_N_K_x(double *N_new, double *minus_log_K_new, double * x0_new, 
@@ -105,29 +210,29 @@ int calc_titration_from_free_energies(
                        double eta, double min_delta,
                        int max_trial, double perturb_scale, 
                        int quiet);
-int get_initial_guess(double *x0, double *lambda, double *G, double *A, 
-		      int n_particles, int n_compounds, double perturb_scale, 
-		      unsigned long rand_seed);
-int get_x(double *x, double *log_scale_fact, double *lambda, double *G, 
-	  double *A, int n_particles, int n_compounds);
-void get_grad(double *grad, double log_scale_fact, double *x0, double *x, 
-	      double *A, int n_particles, int n_compounds);
-int get_hessian(double *hes, double *x, double *A, int n_particles, 
+int get_initial_guess(eq_workspace_t *ws, double *x0, double *lambda, 
+                      double *G, int n_particles, int n_compounds, 
+                      double perturb_scale, unsigned long rand_seed);
+int get_x(eq_workspace_t *ws, double *x, double *log_scale_fact, 
+          double *lambda, double *G, int n_particles, int n_compounds);
+void get_grad(eq_workspace_t *ws, double *grad, double log_scale_fact, 
+              double *x0, double *x, int n_particles, int n_compounds);
+int get_hessian(eq_workspace_t *ws, double *hes, double *x, int n_particles, 
 		 int n_compounds);
-int get_search_dir(double *p, double *grad, double *hes, double delta, 
-		   int n_particles, run_stats_t * run_stats);
-int compute_newton_step(double *pB, double *grad, double *hes, 
-			int n_particles);
-double get_rho(double *lambda, double *p, double *grad, double *x, double *hes, 
-	       double *x0, double *G, double *A, double log_scale_fact, 
-	       int n_particles, int n_compounds);
-void get_cauchy_point(double *cauchy_point, double *hes, double *grad, 
-		      double delta, int n_particles);
-int perturb_lambda(double *lambda, double perturb_scale, double *G, double *A, 
-		int n_particles, int n_compounds);
+int get_search_dir(eq_workspace_t *ws, double *p, double *grad, double *hes, 
+                   double delta, int n_particles, run_stats_t * run_stats);
+int compute_newton_step(eq_workspace_t *ws, double *pB, double *grad, 
+                        double *hes, int n_particles);
+double get_rho(eq_workspace_t *ws, double *lambda, double *p, double *grad, 
+               double *x, double *hes, double *x0, double *G, 
+               double log_scale_fact, int n_particles, int n_compounds);
+void get_cauchy_point(eq_workspace_t *ws, double *cauchy_point, double *hes, 
+                      double *grad, double delta, int n_particles);
+int perturb_lambda(eq_workspace_t *ws, double *lambda, double perturb_scale, 
+                   double *G, int n_particles, int n_compounds);
 int check_tol(double *grad, double *abs_tol, int n_particles);
-void make_tol(double *abs_tol, double *A, double *x, int n_constraints, 
-        int n_compounds, double tol);
+void make_tol(eq_workspace_t *ws, double *abs_tol, double *x, 
+              int n_constraints, int n_compounds, double tol);
 int write_concentration_log_file(run_stats_t * run_stats, double * grad,
                             double * abs_tol, char *log_file);
 void write_error_message(int key);
@@ -0,0 +1,35 @@
+#pragma once
+
+/*
+  equilibrium_errors.h is part of the NUPACK software suite
+  Copyright (c) 2007 Caltech. All rights reserved.
+
+  Return codes of the equilibrium concentrations solver.  These are the
+  values of ERROR_RETURN in the design engines' pathway_debug.h, which
+  test them against ERR_OK.  Only the library sources include this file:
+  the concentrations executable defines ERR_* macros of its own.
+*/
+
+enum EQ_ERROR_RETURN
+{
+  ERR_OK              = 0, // explicit for clarity
+  ERR_NOCONVERGE      = 1,
+  ERR_OVERFLOW        = 2,
+  ERR_BADN            = 3,
+  ERR_BADK            = 4,
+  ERR_NOINPUT         = 5,
+  ERR_HELP            = 6,
+  ERR_HELP_OPEN       = 7,
+  ERR_NOCMP           = 8,
+  ERR_SOLVDENS        = 9,
+  ERR_BADFREEENERGY   = 10,
+  ERR_BADROWINP       = 11,
+  ERR_CON             = 12,
+  ERR_LOG             = 13,
+  ERR_EQ              = 14,
+  ERR_OOM             = 15,
+  ERR_INITIAL         = 16,
+  ERR_INVALID_STATE   = 17,
+  ERR_INVALID_INPUT   = 18,
+  ERR_OTHER           = 19
+};
@@ -6,7 +6,7 @@
   Copyright (c) 2007 Caltech. All rights reserved.
   Coded by: Justin Bois, 1/2007, except where noted.
 
-  UTILS.C 
+  EQUILIBRIUM_UTILS.C 
 
   General utility functions for processing arrays (e.g., dot products,
   matrix multiplication, etc.), numbers (e.g., factorials, random
@@ -17,7 +17,7 @@
   For use with NUPACK.
 */
 
-#include "utils.h"
+#include "equilibrium_utils.h"
 
 
 /* ************************************************************************** */
@@ -594,42 +594,43 @@ int lup_solve(double *A, int *p, int n, double *b, double *x) {
     returns 0 on success
     returns 1 on memory error
    */
-  int i,j;
-  double *L = NULL;      // temporary L for lower_tri_solve
   double *b_perm = NULL; // permuted b
   int ret_val = 0;// return value
 
-  if(NULL == (L = (double *) malloc(n * n * sizeof(double)))) {
-    ret_val = 1;
-    goto end_lup_solve;
-  }
   if(NULL == (b_perm = (double *) malloc(n*sizeof(double)))) {
-    free(L);
-    ret_val = 1;
-    goto end_lup_solve;
+    return 1;
   }
 
-  for(i = 0; i < n; i++) {
-    L[ij(i, i, n)] = 1.0;
-    for(j = 0; j < i; j++) {
-      L[ij(i, j, n)] = A[ij(i, j, n)];
-    }
-  }
+  ret_val = lup_solve_work(A, p, n, b, x, b_perm);
+
+  free(b_perm);
+
+  return ret_val;
+}
+/* ************************************************************************** */
+
+
+/* ************************************************************************** */
+int lup_solve_work(double *A, int *p, int n, double *b, double *x,
+                   double *work) {
+  /*
+    Same as lup_solve, with the permuted b kept in work (n doubles), so
+    nothing is allocated.  L is read in place from the strict lower
+    triangle of A (its diagonal is unity).
+   */
+  int i;
+  int ret_val = 0;// return value
 
   for(i = 0; i < n; i++) {
-    b_perm[i] = b[p[i]];
+    work[i] = b[p[i]];
   }
 
   // Solve Ly = b_perm, storing y in x.
-  ret_val = lower_tri_solve(L, n, b_perm, x);
+  ret_val = unit_lower_tri_solve(A, n, work, x);
 
   // Solve Ux = y by back substitution
   ret_val += upper_tri_solve(A, n, x, x);
 
-end_lup_solve:
-  if(L != NULL) free(L);
-  if(b_perm != NULL) free(b_perm);
-
   return ret_val;
 }
 /* ************************************************************************** */
@@ -637,48 +638,52 @@ end_lup_solve:
 /* ************************************************************************** */
 int modified_cholesky_solve(double *A, int * p, int n, double *b, double *x) {
   /*
+    Solves A x = b, where A has undergone modified_cholesky (L in the
+    lower triangle of A, permutation in p).
   */
 
-  int i,j;
-  double *U = NULL; // Upper triangular matrix made from L^T
   double *xp = NULL;
   int ret_val = 0;
 
-  // Allocate and compute U
-  U = (double *) malloc(n * n * sizeof(double));
-  xp = (double *) malloc(n * sizeof(double));
-
-  if (U == NULL || xp == NULL) {
-    ret_val = 1;
-    goto end_mod_cholesky;
+  if (NULL == (xp = (double *) malloc(n * sizeof(double)))) {
+    return 1;
   }
 
-  for (i = 0; i < n; i++) {
-    for (j = i; j < n; j++) {
-      U[ij(i, j, n)] = A[ij(j, i, n)];
-    }
-  }
+  ret_val = modified_cholesky_solve_work(A, p, n, b, x, xp);
 
-  // Copy b to x
+  free(xp);
+  return ret_val;
+}
+/* ************************************************************************** */
+
+
+/* ************************************************************************** */
+int modified_cholesky_solve_work(double *A, int * p, int n, double *b, 
+                                 double *x, double *work) {
+  /*
+    Same as modified_cholesky_solve, with n doubles of scratch in work.
+    L^T is read in place rather than copied out to an upper triangular
+    matrix, so nothing is allocated.
+  */
+
+  int i;
+
+  // Permute b
   for (i = 0; i < n; i++) {
-    xp[i] = b[p[i]];
+    work[i] = b[p[i]];
   }
 
-  // Solve Ly = b, storing y in xp.
-  lower_tri_solve(A, n, xp, x);
+  // Solve Ly = b, storing y in x.
+  lower_tri_solve(A, n, work, x);
 
   // Solve L^T x = y by back substitution
-  upper_tri_solve(U, n, x, xp);
+  lower_tri_transpose_solve(A, n, x, work);
 
   for (i = 0; i < n; i++) {
-    x[p[i]] = xp[i];
+    x[p[i]] = work[i];
   }
 
-end_mod_cholesky:
-  // Free U
-  if (U != NULL) free(U);
-  if (xp != NULL) free(xp);
-  return ret_val;
+  return 0;
 }
 /* ************************************************************************** */
 
@@ -816,6 +821,73 @@ int upper_tri_solve(double *U, int n, double *b, double *x) {
 /* ************************************************************************** */
 
 
+/* ************************************************************************** */
+int unit_lower_tri_solve(double *L, int n, double *b, double *x) {
+  /*
+    Solves Lx = b, where L is the strict lower triangle of the n x n
+    matrix L with a unit diagonal (as left by lup_decomposition).  The
+    diagonal entries stored in L are ignored.
+  */
+
+  int i,j;
+  
+  // Copy b to x
+  for (i = 0; i < n; i++) {
+    x[i] = b[i];
+  }
+
+  // Solve Lx = b by column-based forward substitution
+  for (j = 0; j < n-1; j++) {
+    for (i = j+1; i < n; i++) {
+      x[i] -= x[j] * L[ij(i, j, n)];
+    }
+  }
+  return 0;
+}
+/* ************************************************************************** */
+
+
+/* ************************************************************************** */
+int lower_tri_transpose_solve(double *L, int n, double *b, double *x) {
+  /*
+    Solves L^T x = b, where L is lower-triangular (including diagonal),
+    by column-based back substitution on the transpose read in place.
+    Gives the same result as upper_tri_solve on a copy of L^T.
+  */
+
+  int i,j;
+  int ret_val = 0;
+  
+  // Copy b to x
+  for (i = 0; i < n; i++) {
+    x[i] = b[i];
+  }
+
+  // Solve L^T x = b by back substitution
+  for (j = n-1; j > 0; j--) {
+    if (fabs(L[ij(j, j, n)]) > FLOAT_EPS) {
+      x[j] /= L[ij(j, j, n)];
+      for (i = 0; i < j; i++) {
+        x[i] -= x[j] * L[ij(j, i, n)];
+      }
+    } else {
+      x[j] = 0.0;
+      ret_val = 1;
+    }
+  }
+  if(n > 0) {
+    if (fabs(L[ij(0, 0, n)]) > FLOAT_EPS) {
+      x[0] /= L[ij(0, 0, n)];
+    } else {
+      x[0] = 0.0;
+      ret_val = 1;
+    }
+  }
+  return ret_val;
+}
+/* ************************************************************************** */
+
+
 /* ************************************************************************** */
 /*                          END ARRAY PROCESSING FUNCTIONS                    */
 /* ************************************************************************** */
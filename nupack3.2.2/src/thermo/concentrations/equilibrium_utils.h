@@ -5,15 +5,15 @@
   Copyright (c) 2007 Caltech. All rights reserved.
   Coded by: Justin Bois 1/2007
 
-  UTILSHEADER.H
+  EQUILIBRIUM_UTILS.H
 
   Header file for use with utility functions included in NUPACK.  These
   utility functions are generate routines for handling vectors and
-  matrices, random numbers, factorials, etc.
+  matrices, random numbers, factorials, etc.  They back the equilibrium
+  concentrations solver of the nupackconc library, shared by the
+  concentrations executable and both design engines.
 */
 
-#include "constants.h"
-
 #include <stdio.h>
 #include <time.h>
 #include <math.h>
@@ -21,6 +21,16 @@
 #include <ctype.h>
 #include <stdlib.h>
 
+/* ******************************* CONSTANTS ******************************** */
+// The same values as the design engines' constants.h
+#ifndef NUM_PRECISION
+#define NUM_PRECISION 1e-12 // A small number that's basically zero
+#endif
+#ifndef FLOAT_EPS
+#define FLOAT_EPS 1e-206
+#endif
+/* ************************************************************************** */
+
 /* **************************** INDEXING MACRO ****************************** */
 #define ij(i, j, n) ((i) * (n) + (j))   // Lex index for 2d array, n = # COLUMNS
 /* ************************************************************************** */
@@ -57,11 +67,17 @@ int get_approx_rank(double *A, int m, int n, double tol);
 // Get rank of matrix using Gaussian elimination
 void lup_decomposition(double *A, int * p, int n); // LUP decomposition
 int lup_solve(double *A, int * p, int n, double * x, double * b); // LUP solve
+int lup_solve_work(double *A, int * p, int n, double * b, double * x,
+        double * work); // LUP solve, n doubles of scratch in work
 void cholesky_solve(double *a, int n, double b[], double x[]);  // Chol solve
 int lower_tri_solve(double *L, int n, double *b, double *x);
 int upper_tri_solve(double *U, int n, double *b, double *x);
+int unit_lower_tri_solve(double *L, int n, double *b, double *x);
+int lower_tri_transpose_solve(double *L, int n, double *b, double *x);
 int modified_cholesky_solve(double *a, int * p, int n, 
         double b[], double x[]);  // Modified Chol. solve
+int modified_cholesky_solve_work(double *a, int * p, int n, double b[],
+        double x[], double work[]); // Same, n doubles of scratch in work
 double min2(double a, double b); // Returns minimum of two arguments
 double max2(double a, double b); // Maximum of two arguments
 unsigned long get_random_seed(unsigned long s); // seed for random number gen
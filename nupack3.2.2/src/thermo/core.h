@@ -9,12 +9,15 @@
 #include "core/min.h"
 #include "core/nsStar.h"
 #include "core/pairsPr.h"
+#include "core/pairsPrSparse.h"
 #include "core/pf.h"
 #include "core/pfuncUtils.h"
 #include "core/pknots.h"
 #include "core/ReadCommandLineNPK.h"
+#include "core/segmentMemo.h"
 #include "core/sumexp.h"
 #include "core/sumexp_pk.h"
+#include "core/sweep.h"
 
 
 #endif /* NUPACK_THERMO_CORE_H__ */
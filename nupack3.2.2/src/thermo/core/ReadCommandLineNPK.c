@@ -36,12 +36,36 @@
 
   -validate
   print everything to 14 decimal places. print all pairs.
+
+  -sparse [no argument]
+  only keep pair probabilities at or above the cutoff in memory (pairs)
+
+  -gapspill [string]
+  directory for file-backed (mmap) storage of the pseudoknot gap matrices
+
+  -Tsweep [start:stop:step]
+  evaluate every temperature (C) of the range in one run (pfunc, mfe)
+
+  -saltsweep [start:stop:step]
+  evaluate every sodium concentration (M) of the range in one run
+
+  -sweepjobs [int]
+  number of worker processes for a sweep (default = number of cpus)
+
+  -stream [no argument]
+  read one JSON job per line of standard input and write one JSON result
+  line per job (see shared/streamjob.h)
 */
 
 #include "ReadCommandLineNPK.h"
 
 double CUTOFF; // = 0.001 by default and can be changed by user
 int Multistranded; //  = 1 if this is a multistranded calculation
+int SparsePairs; // = 1 to store pair probabilities in sparse form
+double SweepT[3]; // -Tsweep start, stop, step (step == 0 if not sweeping)
+double SweepSodium[3]; // -saltsweep start, stop, step
+int SweepJobs; // worker processes for a sweep, 0 = number of cpus
+int StreamInput; // = 1 to serve JSON jobs from standard input (-stream)
 int seqlengthArray[MAXSTRANDS]; // Length of sequences
 int perm[MAXSTRANDS];  // Perm IDs
 int nUniqueSequences; // Number of unique sequences entered
@@ -83,6 +107,12 @@ int ReadCommandLineNPK(int nargs, char **args, char *inputFile) {
       #endif //NUPACK_SAMPLE
       {"sort",required_argument,NULL,'p'},
       {"validate",no_argument,NULL,'q'},
+      {"sparse",no_argument,NULL,'r'},
+      {"gapspill",required_argument,NULL,'u'},
+      {"Tsweep",required_argument,NULL,'v'},
+      {"saltsweep",required_argument,NULL,'w'},
+      {"sweepjobs",required_argument,NULL,'x'},
+      {"stream",no_argument,NULL,'s'},
       {0, 0, 0, 0}
     };
 
@@ -98,6 +128,7 @@ int ReadCommandLineNPK(int nargs, char **args, char *inputFile) {
   USE_MFE = 0;
   mfe_sort_method = 0;
   Multistranded = 0;
+  SparsePairs = 0;
   CUTOFF = 0.001;
   SODIUM_CONC = 1.0;
   MAGNESIUM_CONC = 0.0;
@@ -105,6 +136,11 @@ int ReadCommandLineNPK(int nargs, char **args, char *inputFile) {
   NUPACK_VALIDATE=0;
   EXTERN_QB = NULL;
   EXTERN_Q = NULL;
+  GAP_SPILL_DIR[0] = '\0';
+  SweepT[0] = SweepT[1] = SweepT[2] = 0;
+  SweepSodium[0] = SweepSodium[1] = SweepSodium[2] = 0;
+  SweepJobs = 0;
+  StreamInput = 0;
 
 
   // Get the option flags
@@ -263,6 +299,44 @@ int ReadCommandLineNPK(int nargs, char **args, char *inputFile) {
       mfe_sort_method = 1;
       CUTOFF=0.0;
       break;
+    case 'r':
+      SparsePairs = 1;
+      break;
+    case 'u':
+      strcpy( line, optarg);
+      if( sscanf(line, "%s", GAP_SPILL_DIR) != 1) {
+        printf("Invalid gap spill directory\n");
+        exit(1);
+      }
+      break;
+    case 'v':
+      strcpy( line, optarg);
+      if( sscanf(line, "%lf:%lf:%lf", &SweepT[0], &SweepT[1], &SweepT[2]) != 3
+          || SweepT[2] <= 0 || SweepT[1] < SweepT[0]) {
+        printf("Invalid Tsweep range, expected start:stop:step\n");
+        exit(1);
+      }
+      break;
+    case 'w':
+      strcpy( line, optarg);
+      if( sscanf(line, "%lf:%lf:%lf", &SweepSodium[0], &SweepSodium[1],
+                 &SweepSodium[2]) != 3
+          || SweepSodium[2] <= 0 || SweepSodium[1] < SweepSodium[0]
+          || SweepSodium[0] <= 0) {
+        printf("Invalid saltsweep range, expected start:stop:step with [Na+] > 0\n");
+        exit(1);
+      }
+      break;
+    case 'x':
+      strcpy( line, optarg);
+      if( sscanf(line, "%d", &SweepJobs) != 1 || SweepJobs < 0) {
+        printf("Invalid number of sweep jobs\n");
+        exit(1);
+      }
+      break;
+    case 's':
+      StreamInput = 1;
+      break;
     default:
       abort ();
     }
@@ -277,6 +351,13 @@ int ReadCommandLineNPK(int nargs, char **args, char *inputFile) {
     MAGNESIUM_CONC = 0.0;
   }
 
+  if (SweepSodium[2] > 0 && DNARNACOUNT != DNA) {
+    printf("%% ************************************************************************  %%\n");
+    printf("%%    WARNING: No salt corrections availabe for RNA.  Ignoring -saltsweep.    %%\n");
+    printf("%% ************************************************************************  %%\n");
+    SweepSodium[0] = SweepSodium[1] = SweepSodium[2] = 0;
+  }
+
   if (SODIUM_CONC  <= 0.0) {
     printf("ERROR: Invalid sodium concentration.  Must have [Na+] > 0.\n");
     exit(1);
@@ -311,6 +392,9 @@ int ReadCommandLineNPK(int nargs, char **args, char *inputFile) {
   }
 
   // Get the the input file
+  if (StreamInput) { // jobs come from standard input, keep stdout clean
+    return 0;
+  }
   if (optind == nargs) { // There's no input from the user
     printf("No input file specified.\n");
     if (!batch) {
@@ -343,6 +427,12 @@ void PrintNupackThermoHelp() {
   printf(" -dangles TREATMENT           specify treatment of dangle energies\n");
   printf("                              none, some, or all\n");
   printf(" -T TEMPERATURE               set the temperature to TEMPERATURE\n");
+  printf(" -Tsweep START:STOP:STEP      evaluate each temperature of the range\n");
+  printf("                              (pfunc, mfe)\n");
+  printf(" -saltsweep START:STOP:STEP   evaluate each sodium concentration of\n");
+  printf("                              the range (pfunc, mfe)\n");
+  printf(" -sweepjobs N                 worker processes for a sweep\n");
+  printf("                              (default: number of cpus)\n");
   printf("\n");
 }
 
@@ -353,6 +443,10 @@ void PrintNupackUtilitiesHelp() {
   printf(" -multi                       specify calculation involving complexes\n");
   printf("                              of multiple strands\n");
   printf(" -pseudo                      include a subclass of pseudoknots\n");
+  printf(" -gapspill DIR                keep the pseudoknot gap matrices in\n");
+  printf("                              memory-mapped files in DIR instead of RAM\n");
+  printf(" -stream                      read one JSON job per line of standard\n");
+  printf("                              input, write one JSON result per line\n");
   printf("\n");
 }
 
@@ -708,6 +802,113 @@ void getUserInput( char *theseq, int *v_pi, float *gap, char *structure) {
 
 }
 
+/* ************ */
+
+int isStreamSequence( const char *seq) {
+  // only bases Base2int accepts, so a bad job cannot end the process
+  return seq[0] != '\0' && strspn( seq, "ACGTUacgtu") == strlen( seq);
+}
+
+/* ************ */
+
+int getJobInput( const streamJob *job, char *theseq, int *v_pi, char *error) {
+
+  const jsonValue *seqs, *order, *item;
+  char line[ MAXLINE];
+  char *token;
+  int i, length, permSize = 0;
+  int nStrands = 0;
+
+  if( !Multistranded) {
+    item = StreamJobField( job, "sequence");
+    if( item == NULL || item->type != JSON_STRING ||
+        !isStreamSequence( item->text)) {
+      strcpy( error, "expected a \"sequence\" of A, C, G, T or U");
+      return 0;
+    }
+    if( strlen( item->text) >= MAXSEQLENGTH) {
+      strcpy( error, "sequence too long");
+      return 0;
+    }
+    strcpy( theseq, item->text);
+    *v_pi = 1;
+    nUniqueSequences = 0;
+    return 1;
+  }
+
+  seqs = StreamJobField( job, "sequences");
+  if( seqs == NULL || seqs->type != JSON_ARRAY || seqs->nItems == 0 ||
+      seqs->nItems > MAXSTRANDS) {
+    sprintf( error, "expected \"sequences\", a list of 1 to %d strands",
+             MAXSTRANDS);
+    return 0;
+  }
+  nStrands = seqs->nItems;
+  for( i = 0; i < nStrands; i++) {
+    item = &seqs->items[i];
+    if( item->type != JSON_STRING || !isStreamSequence( item->text)) {
+      sprintf( error, "sequence %d is not made of A, C, G, T or U", i+1);
+      return 0;
+    }
+    seqlengthArray[i] = strlen( item->text);
+  }
+
+  // the order of the strands, e.g. "1 2 3" or [1, 2, 3]
+  order = StreamJobField( job, "permutation");
+  if( order != NULL && order->type == JSON_STRING &&
+      strlen( order->text) < MAXLINE) {
+    strcpy( line, order->text);
+    for( token = strtok( line, ",+ "); token != NULL && permSize < MAXSTRANDS;
+         token = strtok( NULL, ",+ ")) {
+      if( sscanf( token, "%d", &(perm[ permSize])) != 1) {
+        break;
+      }
+      permSize++;
+    }
+    if( token != NULL) {
+      permSize = 0;
+    }
+  }
+  else if( order != NULL && order->type == JSON_ARRAY &&
+           order->nItems <= MAXSTRANDS) {
+    for( permSize = 0; permSize < order->nItems; permSize++) {
+      if( !JsonInt( &order->items[ permSize], &(perm[ permSize]))) {
+        break;
+      }
+    }
+    if( permSize < order->nItems) {
+      permSize = 0;
+    }
+  }
+  if( permSize == 0) {
+    strcpy( error, "expected a \"permutation\" of strand indices");
+    return 0;
+  }
+
+  length = 0;
+  for( i = 0; i < permSize; i++) {
+    if( perm[i] < 1 || perm[i] > nStrands) {
+      sprintf( error, "illegal permutation index %d", perm[i]);
+      return 0;
+    }
+    length += seqlengthArray[ perm[i]-1] + 1;
+  }
+  if( length > MAXSEQLENGTH) {
+    strcpy( error, "sequence too long");
+    return 0;
+  }
+
+  strcpy( theseq, seqs->items[ perm[0]-1].text);
+  for( i = 1; i < permSize; i++) {
+    strcat( theseq, "+");
+    strcat( theseq, seqs->items[ perm[i]-1].text);
+  }
+
+  *v_pi = calculateVPi( perm, permSize);
+  nUniqueSequences = nStrands;
+  return 1;
+}
+
 /* ********* */
 
 void header( int argc, char **argv, char *name, char *outputFile) {
@@ -28,6 +28,11 @@ int ReadInputFile( char*, char*, int*, float*, char*, int*);
 //get input interactively
 void getUserInput(char*, int*,  float*, char*);
 
+//get the input of a -stream job; 0 (and a message) if it is malformed
+int getJobInput(const streamJob*, char*, int*, char*);
+//1 if the sequence is made only of bases
+int isStreamSequence(const char*);
+
 //determine if a permutation has a cyclic symmetry
 int calculateVPi( int *, int);
 
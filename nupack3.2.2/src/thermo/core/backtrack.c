@@ -1085,7 +1085,7 @@ void bktrFgN5( int i, int d, int e, int j, int seq[], int seqlength,
   int c, f;
   DBL_TYPE energy;
   DBL_TYPE bp_penalty, IJ_bp_penalty;
-  int gap_idej = gap_index( i,d,e,j,seqlength);
+  long int gap_idej = gap_index( i,d,e,j,seqlength);
   
   dnaStructures rootStr = {NULL, 0, 0, 0, NAD_INFINITY};
   dnaStructures newStr = {NULL, 0, 0, 0, NAD_INFINITY};
@@ -1729,7 +1729,7 @@ void bktrFgl(  int i, int e, int f, int j, int seq[], int seqlength,
              const DBL_TYPE mfeEpsilon) {
                
   int d;
-  int gap_idfj;
+  long int gap_idfj;
   DBL_TYPE bp_penalty = 0.0;
   DBL_TYPE energy;
 
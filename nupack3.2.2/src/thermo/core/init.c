@@ -1,5 +1,11 @@
+/* mkstemp, ftruncate, fmemopen (the build uses -std=c99) */
+#define _XOPEN_SOURCE 700
+
 #include "init.h"
 
+#include <sys/mman.h>
+#include <unistd.h>
+
 /* ************************************************* */
 void ReadSequence( int *seqlength, char **seq, char filename[ MAXLINE] ) {
   FILE *fp;
@@ -172,8 +178,41 @@ void processMultiSequence( int inputSeq[], int seqlength, int nStrands,
 
 
 /* ********************************************* */
+// Matrices returned with FreeLDoublesMatrix are kept here and handed out
+// again by InitLDoublesMatrix, so the design engines and complexes,
+// which call pfunc/mfe many times on similar lengths, do not map, fault
+// in and unmap fresh pages for every call.  The pool holds at most
+// LDOUBLES_POOL_BYTES; matrices beyond that are freed.  Long-lived
+// callers release it with ClearLDoublesPool once a job is done.  The
+// pool is process-wide and not thread safe.
+#define LDOUBLES_POOL_SIZE 32
+#define LDOUBLES_POOL_BYTES (64L << 20)
+static DBL_TYPE *ldoublesPool[ LDOUBLES_POOL_SIZE];
+static long int ldoublesPoolSize[ LDOUBLES_POOL_SIZE];
+static int ldoublesPoolCount = 0;
+static long int ldoublesPoolBytes = 0;
+
 void InitLDoublesMatrix( DBL_TYPE **Q, int size, char name[]) {
   // Allocate cleared memory for a DBL_TYPEs matrix.
+  int k, best = -1;
+
+  // best fit among the pooled matrices, wasting at most half of it
+  for( k = 0; k < ldoublesPoolCount; k++) {
+    if( ldoublesPoolSize[k] >= size && ldoublesPoolSize[k] <= 2*(long int) size &&
+        (best == -1 || ldoublesPoolSize[k] < ldoublesPoolSize[best])) {
+      best = k;
+    }
+  }
+  if( best != -1) {
+    *Q = ldoublesPool[ best];
+    ldoublesPoolBytes -= ldoublesPoolSize[ best] * (long int) sizeof( DBL_TYPE);
+    ldoublesPoolCount--;
+    ldoublesPool[ best] = ldoublesPool[ ldoublesPoolCount];
+    ldoublesPoolSize[ best] = ldoublesPoolSize[ ldoublesPoolCount];
+    memset( *Q, 0, size * sizeof( DBL_TYPE));
+    return;
+  }
+
   *Q =  (DBL_TYPE *) calloc( size, sizeof( DBL_TYPE));
   if( *Q == NULL) {
     fprintf(stderr, "InitLDoublesMatrix: unable to allocate %lu bytes for"
@@ -182,11 +221,115 @@ void InitLDoublesMatrix( DBL_TYPE **Q, int size, char name[]) {
   }
 }
 
+void FreeLDoublesMatrix( DBL_TYPE **Q, int size) {
+  long int nBytes = size * (long int) sizeof( DBL_TYPE);
+  if( *Q == NULL) return;
+
+  if( ldoublesPoolCount < LDOUBLES_POOL_SIZE &&
+      ldoublesPoolBytes + nBytes <= LDOUBLES_POOL_BYTES) {
+    ldoublesPool[ ldoublesPoolCount] = *Q;
+    ldoublesPoolSize[ ldoublesPoolCount] = size;
+    ldoublesPoolCount++;
+    ldoublesPoolBytes += nBytes;
+  }
+  else {
+    free( *Q);
+  }
+  *Q = NULL;
+}
+
+void ClearLDoublesPool( void) {
+  while( ldoublesPoolCount > 0) {
+    ldoublesPoolCount--;
+    free( ldoublesPool[ ldoublesPoolCount]);
+    ldoublesPool[ ldoublesPoolCount] = NULL;
+  }
+  ldoublesPoolBytes = 0;
+}
+
 void ClearLDoublesMatrix(DBL_TYPE **Q, int size, char name[]) {
   (void)name;
   memset(*Q, 0,size * sizeof(DBL_TYPE));
 }
 
+/* ********************************************* */
+// Gap matrices mapped from a spill file, so FreeGapMatrix knows their
+// length.  Up to 10 gap matrices (the five Q and five P, or the five F)
+// are live at once; the table has room for 16.
+#define MAX_MAPPED_GAP_MATRICES 16
+static DBL_TYPE *mappedGapMatrix[ MAX_MAPPED_GAP_MATRICES];
+static size_t mappedGapBytes[ MAX_MAPPED_GAP_MATRICES];
+
+void InitGapMatrix( DBL_TYPE **Q, long int size, char name[]) {
+  char spillFile[ MAX_FILENAME_LEN + 32];
+  size_t nBytes = (size_t) size * sizeof( DBL_TYPE);
+  void *mapped;
+  int fd, k;
+
+  if( GAP_SPILL_DIR[0] == '\0' || size <= 0) {
+    *Q = (DBL_TYPE *) calloc( size, sizeof( DBL_TYPE));
+    if( *Q == NULL) {
+      fprintf(stderr, "InitGapMatrix: unable to allocate %lu bytes for"
+         " %s! (try -gapspill DIR)\n", (unsigned long) nBytes, name);
+      exit(1);
+    }
+    return;
+  }
+
+  for( k = 0; k < MAX_MAPPED_GAP_MATRICES; k++) {
+    if( mappedGapMatrix[k] == NULL) break;
+  }
+  if( k == MAX_MAPPED_GAP_MATRICES) {
+    fprintf(stderr, "InitGapMatrix: too many mapped gap matrices (%s)\n", name);
+    exit(1);
+  }
+
+  snprintf( spillFile, sizeof( spillFile), "%s/nupack-%s-XXXXXX",
+           GAP_SPILL_DIR, name);
+  fd = mkstemp( spillFile);
+  if( fd < 0) {
+    fprintf(stderr, "InitGapMatrix: unable to create spill file %s for %s!\n",
+           spillFile, name);
+    exit(1);
+  }
+  // the mapping keeps the file alive; nothing is left behind on exit
+  unlink( spillFile);
+
+  // a freshly extended file reads as zeros, as calloc would
+  if( ftruncate( fd, (off_t) nBytes) != 0) {
+    fprintf(stderr, "InitGapMatrix: unable to reserve %lu bytes for %s in %s!\n",
+           (unsigned long) nBytes, name, GAP_SPILL_DIR);
+    exit(1);
+  }
+  mapped = mmap( NULL, nBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close( fd);
+  if( mapped == MAP_FAILED) {
+    fprintf(stderr, "InitGapMatrix: unable to map %lu bytes for %s!\n",
+           (unsigned long) nBytes, name);
+    exit(1);
+  }
+
+  *Q = (DBL_TYPE *) mapped;
+  mappedGapMatrix[k] = *Q;
+  mappedGapBytes[k] = nBytes;
+}
+
+void FreeGapMatrix( DBL_TYPE **Q) {
+  int k;
+
+  if( *Q == NULL) return;
+  for( k = 0; k < MAX_MAPPED_GAP_MATRICES; k++) {
+    if( mappedGapMatrix[k] == *Q) {
+      munmap( *Q, mappedGapBytes[k]);
+      mappedGapMatrix[k] = NULL;
+      *Q = NULL;
+      return;
+    }
+  }
+  free( *Q);
+  *Q = NULL;
+}
+
 /* ******************************************** */
 void nonZeroInit( DBL_TYPE Q[], int seq[], int seqlength) {
   // Set Q[i, i-1] = 1.
@@ -343,9 +486,24 @@ void PrecomputeValuesN5f( int seqlength) {
   }
 }
 
+/* *************************************************** */
+int QxPeakStorage( int seqlength) {
+  // Largest (seqlength - len)*(len - 1) over all lengths, i.e. the
+  // number of entries any Qx/Fx/Px buffer ever needs for this sequence
+
+  int len;
+  int maxStorage = 0;
+
+  for( len = 1; len <= seqlength; len++) {
+    maxStorage = MAX( maxStorage, ( seqlength - len)*(len - 1) );
+  }
+  return maxStorage;
+}
+
 /* *************************************************** */
 void manageQx( DBL_TYPE **Qx, DBL_TYPE **Qx_1, DBL_TYPE **Qx_2, int len, int seqlength) {
-  // Allocate and deallocate QbIx matrices
+  // Allocate and rotate QbIx matrices.  The three buffers are sized for
+  // the largest length once, then the oldest one is cleared and reused.
 
   int i;
   int maxStorage;
@@ -357,11 +515,12 @@ void manageQx( DBL_TYPE **Qx, DBL_TYPE **Qx_1, DBL_TYPE **Qx_2, int len, int seq
   }
 
   if( len == 11) { //first use of these matrices
-    *Qx = (DBL_TYPE *) calloc( maxStorage, sizeof( DBL_TYPE));
+    int peakStorage = MAX( maxStorage, QxPeakStorage( seqlength));
+    *Qx = (DBL_TYPE *) calloc( peakStorage, sizeof( DBL_TYPE));
     *Qx_1 = 
-      (DBL_TYPE *) calloc( maxStorage, sizeof( DBL_TYPE));
+      (DBL_TYPE *) calloc( peakStorage, sizeof( DBL_TYPE));
     *Qx_2 = 
-      (DBL_TYPE *) calloc( maxStorage, sizeof( DBL_TYPE));
+      (DBL_TYPE *) calloc( peakStorage, sizeof( DBL_TYPE));
     
     if( *Qx == NULL || *Qx_1 == NULL || *Qx_2 == NULL) {
       fprintf(stderr, "Error in Qx, Qx_1, Qx_2 allocation\n");
@@ -369,41 +528,19 @@ void manageQx( DBL_TYPE **Qx, DBL_TYPE **Qx_1, DBL_TYPE **Qx_2, int len, int seq
     
   }
 
-  //else if( len == seqlength - 1) {
-  //new
-  //free( *Qx); *Qx = NULL;
-  //free( *Qx_1); *Qx_1 = NULL;
-  //free( *Qx_2); *Qx_2 = NULL;
-  
-  /* old
-  temp = *Qx;
-  *Qx = *Qx_1;
-  *Qx_1 = temp; //this is needed for pairs calculations
-  */
-  
-  /*
-  *Qx_2 = //this array is worthless
-  (DBL_TYPE *) calloc( maxStorage, sizeof( DBL_TYPE));
-  */
-  //}
-
   else if( len > 11) {
 
     temp = *Qx;
     *Qx = *Qx_1;
     *Qx_1 = *Qx_2;
-    free( temp);
-    *Qx_2 = (DBL_TYPE *) calloc( maxStorage, sizeof( DBL_TYPE));
-
-    if( *Qx_2 == NULL) {
-      fprintf(stderr, "Error in Qx_2 allocation\n");
-    }
+    *Qx_2 = temp;
+    memset( *Qx_2, 0, maxStorage * sizeof( DBL_TYPE));
   }
 }
 
 /* *************************************************** */
 void manageFx( DBL_TYPE **Fx, DBL_TYPE **Fx_1, DBL_TYPE **Fx_2, int len, int seqlength) {
-  // Allocate and deallocate Fx matrices
+  // Allocate and rotate Fx matrices, as in manageQx
   
   int i;
   int maxStorage;
@@ -416,11 +553,12 @@ void manageFx( DBL_TYPE **Fx, DBL_TYPE **Fx_1, DBL_TYPE **Fx_2, int len, int seq
   
   
   if( len == 11) { //first use of these matrices
-    *Fx = (DBL_TYPE *) calloc( maxStorage, sizeof( DBL_TYPE));
+    int peakStorage = MAX( maxStorage, QxPeakStorage( seqlength));
+    *Fx = (DBL_TYPE *) calloc( peakStorage, sizeof( DBL_TYPE));
     *Fx_1 = 
-      (DBL_TYPE *) calloc( maxStorage, sizeof( DBL_TYPE));
+      (DBL_TYPE *) calloc( peakStorage, sizeof( DBL_TYPE));
     *Fx_2 = 
-      (DBL_TYPE *) calloc( maxStorage, sizeof( DBL_TYPE));
+      (DBL_TYPE *) calloc( peakStorage, sizeof( DBL_TYPE));
     
     if( *Fx == NULL || *Fx_1 == NULL || *Fx_2 == NULL) {
       fprintf(stderr, "Error in Fx, Fx_1, Fx_2 allocation\n");
@@ -436,13 +574,7 @@ void manageFx( DBL_TYPE **Fx, DBL_TYPE **Fx_1, DBL_TYPE **Fx_2, int len, int seq
     temp = *Fx;
     *Fx = *Fx_1;
     *Fx_1 = *Fx_2;
-    free( temp);
-    *Fx_2 =
-      (DBL_TYPE *) calloc( maxStorage, sizeof( DBL_TYPE));
-    
-    if( *Fx_2 == NULL) {
-      fprintf(stderr, "Error in Fx_2 allocation\n");
-    }
+    *Fx_2 = temp;
     for( i = 0; i < maxStorage; i++) 
       (*Fx_2)[i] = NAD_INFINITY;
     
@@ -469,6 +601,165 @@ DBL_TYPE computeSaltCorrection(DBL_TYPE sodiumConc, DBL_TYPE magnesiumConc,
 
 
 
+/* ************************************** */
+// Parameter files are read from disk once per process and parsed from
+// memory afterwards, so a temperature or salt sweep (or a design run
+// switching conditions) does not reread them at every LoadEnergies.
+#define MAX_CACHED_PARAM_FILES 8
+static char cachedParamName[ MAX_CACHED_PARAM_FILES][ MAX_FILENAME_LEN];
+static char *cachedParamData[ MAX_CACHED_PARAM_FILES];
+static size_t cachedParamLen[ MAX_CACHED_PARAM_FILES];
+static int nCachedParamFiles = 0;
+
+static FILE *openParameterFile( const char *fileName) {
+  FILE *fp;
+  char *data;
+  long len;
+  int k;
+
+  for( k = 0; k < nCachedParamFiles; k++) {
+    if( strcmp( cachedParamName[k], fileName) == 0) {
+      return fmemopen( cachedParamData[k], cachedParamLen[k], "r");
+    }
+  }
+
+  fp = fopen( fileName, "r");
+  if( fp == NULL || nCachedParamFiles == MAX_CACHED_PARAM_FILES) return fp;
+
+  if( fseek( fp, 0, SEEK_END) != 0 || (len = ftell( fp)) <= 0 ||
+      fseek( fp, 0, SEEK_SET) != 0) {
+    rewind( fp);
+    return fp;
+  }
+  data = (char *) malloc( len);
+  if( data == NULL || fread( data, 1, len, fp) != (size_t) len) {
+    free( data);
+    rewind( fp);
+    return fp;
+  }
+  fclose( fp);
+
+  k = nCachedParamFiles++;
+  strncpy( cachedParamName[k], fileName, MAX_FILENAME_LEN-1);
+  cachedParamName[k][ MAX_FILENAME_LEN-1] = '\0';
+  cachedParamData[k] = data;
+  cachedParamLen[k] = len;
+
+  return fmemopen( data, len, "r");
+}
+
+/* ************************************** */
+// Sets fileG and fileH to the .dG and .dH files for fileNameRoot, looking
+// in the places listed in LoadEnergies; exits if there are none.
+static void findParameterFiles( const char *fileNameRoot, char *fileG,
+                                char *fileH) {
+  const char *cur_loc = NULL;
+  int n_param_locations = 2;
+  int i_param_location;
+  const char *default_param_locations[] = {
+    "/usr/local/share/nupack",
+    "/usr/share/nupack"
+  };
+  int n_env_prefixes = 2;
+  int n_env_suffixes = 2;
+  const char *default_env_var_prefixes[] = {
+    "NUPACKINSTALL",
+    "NUPACKHOME"
+  };
+  const char *default_env_var_suffixes[] = {
+    "share/nupack",
+    "parameters",
+  };
+  int i_env_prefix;
+  int i_env_suff;
+
+  //check first for .dG parameter file using current directory as home
+  strcpy( fileG, fileNameRoot);
+  strcat( fileG, ".dG");
+
+  strcpy( fileH, fileNameRoot);
+  strcat( fileH, ".dH");
+  
+  if( !fileExists( fileG) ) {
+    //if files not found, use environment variable NUPACKINSTALL as root
+    
+    i_env_prefix = 0;
+    i_env_suff = 0;
+    while (!fileExists(fileG) && i_env_prefix < n_env_prefixes) {
+      cur_loc = getenv(default_env_var_prefixes[i_env_prefix]);
+      if (cur_loc != NULL) {
+        for (i_env_suff = 0; i_env_suff < n_env_suffixes; i_env_suff++) {
+          snprintf(fileG, MAX_FILENAME_LEN, "%s/%s/%s.dG", cur_loc, 
+              default_env_var_suffixes[i_env_suff], fileNameRoot);
+          snprintf(fileH, MAX_FILENAME_LEN, "%s/%s/%s.dH", cur_loc,
+              default_env_var_suffixes[i_env_suff], fileNameRoot);
+          if (fileExists(fileG)) {
+            break;
+          }
+        }
+      }
+      i_env_prefix ++;
+    }
+
+    if (!fileExists(fileG)) {
+      for (i_env_suff = 0; i_env_suff < n_env_suffixes; i_env_suff++) {
+        snprintf(fileG, MAX_FILENAME_LEN, "%s/../%s/%s.dG", COMMAND_PATH,
+            default_env_var_suffixes[i_env_suff], fileNameRoot);
+        snprintf(fileH, MAX_FILENAME_LEN, "%s/../%s/%s.dH", COMMAND_PATH,
+            default_env_var_suffixes[i_env_suff], fileNameRoot);
+        if (fileExists(fileG)) {
+          break;
+        }
+      }
+    }
+
+    i_param_location = 0;
+    while (!fileExists(fileG) && i_param_location < n_param_locations) {
+      cur_loc = default_param_locations[i_param_location];
+      snprintf(fileG, MAX_FILENAME_LEN, "%s/%s.dG", cur_loc,
+          fileNameRoot);
+      snprintf(fileH, MAX_FILENAME_LEN, "%s/%s.dH", cur_loc,
+          fileNameRoot);
+      i_param_location ++;
+    }
+
+    if (!fileExists(fileG)) {
+      fprintf(stderr, "Unable to find %s.dG in any lookup location.\n", fileNameRoot);
+      fprintf(stderr, "Ensure that parameter files are in the current directory,\n");
+      fprintf(stderr, "$NUPACKINSTALL/parameters, or another default lookup directory\n");
+      exit(1);
+    } 
+  }
+}
+
+/* ************************************** */
+// FNV-1a hash of the bytes of the .dG and .dH files for fileNameRoot.
+// The files are read through the in-memory copies above.
+unsigned long long ParameterFilesHash( const char *fileNameRoot) {
+  char fileG[MAX_FILENAME_LEN];
+  char fileH[MAX_FILENAME_LEN];
+  const char *files[2] = { fileG, fileH};
+  unsigned long long hash = 14695981039346656037ULL;
+  FILE *fp;
+  int c, k;
+
+  findParameterFiles( fileNameRoot, fileG, fileH);
+  for( k = 0; k < 2; k++) {
+    fp = openParameterFile( files[k]);
+    if( fp == NULL) {
+      fprintf(stderr, "Error opening loop data file: %s\n", files[k]);
+      exit(1);
+    }
+    while( (c = fgetc( fp)) != EOF) {
+      hash = (hash ^ (unsigned char) c) * 1099511628211ULL;
+    }
+    fclose( fp);
+    // separate the two files
+    hash = (hash ^ 0xff) * 1099511628211ULL;
+  }
+  return hash;
+}
+
 /* ************************************** */
 void LoadEnergies( void) {
   
@@ -524,7 +815,6 @@ void LoadEnergies( void) {
   int i, j, k;
   char fileG[MAX_FILENAME_LEN];
   char fileH[MAX_FILENAME_LEN];
-  const char *cur_loc = NULL;
   char fileNameRoot[MAX_FILENAME_LEN];
   
   static DBL_TYPE temp = 0;
@@ -532,24 +822,6 @@ void LoadEnergies( void) {
   static int params = -1;
   static int dtype = -1;
   static char parameterFileName[MAX_FILENAME_LEN] = "";
-  int n_param_locations = 2;
-  int i_param_location;
-  const char *default_param_locations[] = {
-    "/usr/local/share/nupack",
-    "/usr/share/nupack"
-  };
-  int n_env_prefixes = 2;
-  int n_env_suffixes = 2;
-  const char *default_env_var_prefixes[] = {
-    "NUPACKINSTALL",
-    "NUPACKHOME"
-  };
-  const char *default_env_var_suffixes[] = {
-    "share/nupack",
-    "parameters",
-  };
-  int i_env_prefix;
-  int i_env_suff;
 
   /*
   //check if invalid temperature and parameters are used
@@ -608,65 +880,9 @@ void LoadEnergies( void) {
     strcpy( parameterFileName, PARAM_FILE); //store this to check if parameter reload is needed.
   }
   
-  //check first for .dG parameter file using current directory as home
-  strcpy( fileG, fileNameRoot);
-  strcat( fileG, ".dG");
-
-  strcpy( fileH, fileNameRoot);
-  strcat( fileH, ".dH");
-  
-  if( !fileExists( fileG) ) {
-    //if files not found, use environment variable NUPACKINSTALL as root
-    
-    i_env_prefix = 0;
-    i_env_suff = 0;
-    while (!fileExists(fileG) && i_env_prefix < n_env_prefixes) {
-      cur_loc = getenv(default_env_var_prefixes[i_env_prefix]);
-      if (cur_loc != NULL) {
-        for (i_env_suff = 0; i_env_suff < n_env_suffixes; i_env_suff++) {
-          snprintf(fileG, MAX_FILENAME_LEN, "%s/%s/%s.dG", cur_loc, 
-              default_env_var_suffixes[i_env_suff], fileNameRoot);
-          snprintf(fileH, MAX_FILENAME_LEN, "%s/%s/%s.dH", cur_loc,
-              default_env_var_suffixes[i_env_suff], fileNameRoot);
-          if (fileExists(fileG)) {
-            break;
-          }
-        }
-      }
-      i_env_prefix ++;
-    }
-
-    if (!fileExists(fileG)) {
-      for (i_env_suff = 0; i_env_suff < n_env_suffixes; i_env_suff++) {
-        snprintf(fileG, MAX_FILENAME_LEN, "%s/../%s/%s.dG", COMMAND_PATH,
-            default_env_var_suffixes[i_env_suff], fileNameRoot);
-        snprintf(fileH, MAX_FILENAME_LEN, "%s/../%s/%s.dH", COMMAND_PATH,
-            default_env_var_suffixes[i_env_suff], fileNameRoot);
-        if (fileExists(fileG)) {
-          break;
-        }
-      }
-    }
-
-    i_param_location = 0;
-    while (!fileExists(fileG) && i_param_location < n_param_locations) {
-      cur_loc = default_param_locations[i_param_location];
-      snprintf(fileG, MAX_FILENAME_LEN, "%s/%s.dG", cur_loc,
-          fileNameRoot);
-      snprintf(fileH, MAX_FILENAME_LEN, "%s/%s.dH", cur_loc,
-          fileNameRoot);
-      i_param_location ++;
-    }
-
-    if (!fileExists(fileG)) {
-      fprintf(stderr, "Unable to find %s.dG in any lookup location.\n", fileNameRoot);
-      fprintf(stderr, "Ensure that parameter files are in the current directory,\n");
-      fprintf(stderr, "$NUPACKINSTALL/parameters, or another default lookup directory\n");
-      exit(1);
-    } 
-  }
+  findParameterFiles( fileNameRoot, fileG, fileH);
 
-  fp = fopen( fileG, "r");
+  fp = openParameterFile( fileG);
   
   if( fp == NULL) {  // Make sure input file exits 
     fprintf(stderr, "Error opening loop data file: %s\n", fileG);
@@ -1215,7 +1431,7 @@ void LoadEnergies( void) {
   }
   
   
-  fp = fopen( fileH, "r");
+  fp = openParameterFile( fileH);
   if( fp == NULL) {  // Make sure input file exits 
     fprintf(stderr, "Error opening loop data file: %s\n", fileH);
     exit(1);  
@@ -1915,7 +2131,7 @@ void initPF( int seqlength) {
   extern long int maxGapIndex; 
   
   if( oldSeqlength != seqlength) {
-    maxGapIndex = seqlength*(seqlength-1)*(seqlength-2)*(seqlength-3)/24;
+    maxGapIndex = (long int) seqlength*(seqlength-1)*(seqlength-2)*(seqlength-3)/24;
     PrecomputeValuesN5( seqlength);
   }
   oldSeqlength = seqlength;
@@ -1928,7 +2144,7 @@ void initMfe( int seqlength) {
   static int oldSeqlength = -1;
   
   if( oldSeqlength != seqlength) {
-    maxGapIndex = seqlength*(seqlength-1)*(seqlength-2)*(seqlength-3)/24;
+    maxGapIndex = (long int) seqlength*(seqlength-1)*(seqlength-2)*(seqlength-3)/24;
     PrecomputeValuesN5f( seqlength);
   }
   oldSeqlength = seqlength;
@@ -34,12 +34,32 @@ int getSequenceLengthInt(int seq[], int *nStrands);
 void processMultiSequence(int inputSeq[], int seqlength, int nStrands,
                            int seq[], int nicks[]);
 
-//Allocates Q and sets the values to zero.
+//Allocates Q and sets the values to zero.  Memory released with
+//FreeLDoublesMatrix is reused when a matrix of similar size is requested.
 void InitLDoublesMatrix(DBL_TYPE **Q, int size, char name[]);
 
+//Returns Q (allocated with InitLDoublesMatrix, size entries) to the pool
+//and sets *Q to NULL
+void FreeLDoublesMatrix(DBL_TYPE **Q, int size);
+
+//Releases all matrices held by the pool
+void ClearLDoublesPool(void);
+
 //Sets Q to all zero
 void ClearLDoublesMatrix(DBL_TYPE **Q, int size, char name[]);
 
+//Allocates an O(N^4) gap matrix (Qg, Fg, Pg, ...) and sets the values to
+//zero.  If GAP_SPILL_DIR is set, the matrix is backed by an unlinked
+//temporary file in that directory and mapped into memory, so the kernel
+//can page it out instead of the process running out of RAM.
+void InitGapMatrix(DBL_TYPE **Q, long int size, char name[]);
+
+//Releases a matrix allocated with InitGapMatrix
+void FreeGapMatrix(DBL_TYPE **Q);
+
+//Number of entries the rotating Qx/Fx/Px buffers need at their peak
+int QxPeakStorage(int seqlength);
+
 //Memory management for "fast" interior loops subroutine
 void manageQx(DBL_TYPE **Qx, DBL_TYPE **Qx_1,
                DBL_TYPE **Qx_2, int len, int seqlength);
@@ -61,6 +81,8 @@ DBL_TYPE computeSaltCorrection(DBL_TYPE sodiumConc, DBL_TYPE magenesiumConc,
 //Load energy parameters.  Global variable DNARNACOUNT determines parameter set
 void LoadEnergies(void);
 void setParametersToZero(void);
+// Hash of the contents of the .dG/.dH files LoadEnergies reads for a root
+unsigned long long ParameterFilesHash(const char *fileNameRoot);
 
 //Set Q[ pf_index(i, i-1, seqlength)] = 1;
 void nonZeroInit(DBL_TYPE Q[], int seq[], int seqlength);
@@ -53,7 +53,7 @@ DBL_TYPE mfeFullWithSym_SubOpt( int inputSeq[], int seqLen,
   */
 
   int i, j, k; // the beginning and end bases for F
-  long int maxIndex;
+  long int maxIndex, g;
   int L; //This the length of the current subsequence
   DBL_TYPE min_energy;
   int pf_ij;
@@ -122,6 +122,8 @@ DBL_TYPE mfeFullWithSym_SubOpt( int inputSeq[], int seqLen,
    initMfe( seqlength);
 
 
+  MakePairPartners( seq, seqlength);
+
   arraySize = seqlength*(seqlength+1)/2 + (seqlength+1);
   // Allocate and Initialize Matrices
   InitLDoublesMatrix( &F, arraySize, "F");
@@ -142,13 +144,13 @@ DBL_TYPE mfeFullWithSym_SubOpt( int inputSeq[], int seqLen,
   if( complexity >= 5) {
    InitLDoublesMatrix( &Fp, arraySize, "Fp");
    InitLDoublesMatrix( &Fz, arraySize, "Fz");
-   InitLDoublesMatrix( &Fg, maxGapIndex, "Fg");
+   InitGapMatrix( &Fg, maxGapIndex, "Fg");
    
    if( complexity == 5) {
-     InitLDoublesMatrix( &Fgl, maxGapIndex, "Fgl");
-     InitLDoublesMatrix( &Fgr, maxGapIndex, "Fgr");
-     InitLDoublesMatrix( &Fgls, maxGapIndex, "Fgls");
-     InitLDoublesMatrix( &Fgrs, maxGapIndex, "Fgrs");
+     InitGapMatrix( &Fgl, maxGapIndex, "Fgl");
+     InitGapMatrix( &Fgr, maxGapIndex, "Fgr");
+     InitGapMatrix( &Fgls, maxGapIndex, "Fgls");
+     InitGapMatrix( &Fgrs, maxGapIndex, "Fgrs");
      CheckPossiblePairs( &possiblePairs, seqlength, seq);
    }
   }
@@ -160,19 +162,19 @@ DBL_TYPE mfeFullWithSym_SubOpt( int inputSeq[], int seqLen,
   else
    maxIndex = arraySize;
 
-  for( i = 0; i < maxIndex; i++) {    
-   if(  i < arraySize ) {
-     F[i] = Fb[i] = Fm[i] = NAD_INFINITY; 
+  for( g = 0; g < maxIndex; g++) {    
+   if(  g < arraySize ) {
+     F[g] = Fb[g] = Fm[g] = NAD_INFINITY; 
      if( complexity == 3)
-       Fs[i] = Fms[i] = NAD_INFINITY;
+       Fs[g] = Fms[g] = NAD_INFINITY;
      
      if( complexity >= 5) 
-       Fp[i] = Fz[i] = NAD_INFINITY; 
+       Fp[g] = Fz[g] = NAD_INFINITY; 
    } 
    if( complexity >= 5) {
-     Fg[i] = NAD_INFINITY;
+     Fg[g] = NAD_INFINITY;
      if( complexity == 5)
-       Fgl[i] = Fgr[i] = Fgls[i] = Fgrs[i] = NAD_INFINITY;
+       Fgl[g] = Fgr[g] = Fgls[g] = Fgrs[g] = NAD_INFINITY;
    }
   }
 
@@ -437,20 +439,21 @@ DBL_TYPE mfeFullWithSym_SubOpt( int inputSeq[], int seqLen,
       }
     } 
 
+  FreePairPartners();
   free( seq);
   free( foldparens);
   seq = foldparens = NULL;
 
 
-  free( F);
-  free( Fb);
-  free( Fm);
+  FreeLDoublesMatrix( &F, arraySize);
+  FreeLDoublesMatrix( &Fb, arraySize);
+  FreeLDoublesMatrix( &Fm, arraySize);
 
   F = Fb = Fm = NULL;
 
   if(complexity == 3) {
-   free( Fs);
-   free( Fms);
+   FreeLDoublesMatrix( &Fs, arraySize);
+   FreeLDoublesMatrix( &Fms, arraySize);
    free( Fx);
    free( Fx_1);
    free( Fx_2);
@@ -459,17 +462,17 @@ DBL_TYPE mfeFullWithSym_SubOpt( int inputSeq[], int seqLen,
   }
 
     if( complexity  >= 5) {
-    free( Fp);
-    free( Fz);
-    free( Fg);
+    FreeLDoublesMatrix( &Fp, arraySize);
+    FreeLDoublesMatrix( &Fz, arraySize);
+    FreeGapMatrix( &Fg);
 
     Fp = Fz = Fg = NULL;
 
     if( complexity == 5) {
-      free( Fgl);
-      free( Fgr);
-      free( Fgls);
-      free( Fgrs);
+      FreeGapMatrix( &Fgl);
+      FreeGapMatrix( &Fgr);
+      FreeGapMatrix( &Fgls);
+      FreeGapMatrix( &Fgrs);
       free( possiblePairs);
       free( FgIx);
       free( FgIx_1);
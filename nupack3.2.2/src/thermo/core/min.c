@@ -200,18 +200,21 @@ void makeNewFx( int i, int j, int seq[], int seqlength,
   int size, L1, L2; //size parameters: L1 + L2 = size, L1 = h-i-1, L2 = j-m-1
   DBL_TYPE tempMin;
   int fbix;
+  int k;
   //Add in all the cases that are not an extended version of an
   //extensible case.
 	
   //Case 1:  L1 = 4, L2 >= 4;
   L1 = 4;
   d = i + L1 + 1;
-  for( L2 = 4; L2 <= j - d - 2; L2++) {
+  //partners e of d with L2 = 4, 5, ..., i.e. e = j-5 down to d+1
+  for( k = FirstPairPartner( d, j - 4) - 1;
+       k >= pairPartnerStart[d] && pairPartners[k] > d; k--) {
+    e = pairPartners[k];
+    L2 = j - e - 1;
     size = L1 + L2;
-    e = j - L2 - 1;
     
-    if( CanPair( seq[d], seq[e]) == TRUE &&
-	(etaN[ EtaNIndex(i+0.5, d-0.5,seqlength)][0] == 0) &&
+    if( (etaN[ EtaNIndex(i+0.5, d-0.5,seqlength)][0] == 0) &&
 	(etaN[ EtaNIndex(e+0.5, j-0.5,seqlength)][0] == 0) ) {
 			
       energy = asymmetryEfn( L1, L2, size) + InteriorMM( seq[e], seq[d], seq[e+1], seq[d-1]);
@@ -228,12 +231,13 @@ void makeNewFx( int i, int j, int seq[], int seqlength,
   //Case 2  L1 > 4, L2 = 4
   L2 = 4;
   e = j - L2 -1;
-  for( L1 = 5; L1 <= e-i-2; L1++) {   
+  for( k = FirstPairPartner( e, i + 6);
+       k < pairPartnerStart[e+1] && pairPartners[k] < e; k++) {
+    d = pairPartners[k];
+    L1 = d - i - 1;
     size = L1 + L2;
-    d = i + L1 + 1;
     
-    if( CanPair( seq[d], seq[e]) == TRUE &&
-	(etaN[ EtaNIndex(i+0.5, d-0.5,seqlength)][0] == 0) &&
+    if( (etaN[ EtaNIndex(i+0.5, d-0.5,seqlength)][0] == 0) &&
 	(etaN[ EtaNIndex(e+0.5, j-0.5,seqlength)][0] == 0) ) {
 			
       energy = asymmetryEfn( L1, L2, size) + InteriorMM( seq[e], seq[d], seq[e+1], seq[d-1]);
@@ -292,6 +296,7 @@ DBL_TYPE MinInextensibleIL( int i, int j, int seq[], int seqlength,
   int d, e; //Internal pair.(h, m will be restricted to special cases)  
   int L1, L2; //size parameters: L1 + L2 = size, L1 = h-i-1, L2 = j-m-1
   int size;
+  int k;
 	
   DBL_TYPE tempMin;
   DBL_TYPE min_energy = NAD_INFINITY;
@@ -322,12 +327,15 @@ DBL_TYPE MinInextensibleIL( int i, int j, int seq[], int seqlength,
   // Case 2a  L1 = 0,1,2,3, L2 >= 4;
   for( L1 = 0; L1 <= 3; L1++) {
     d = i + L1 + 1;
-    for( L2 = 4; L2 <= j - d - 2; L2++) {
-      e = j - L2 - 1;
+    if( j - d - 2 < 4) continue;
+    //partners e of d with L2 = 4, 5, ..., i.e. e = j-5 down to d+1
+    for( k = FirstPairPartner( d, j - 4) - 1;
+         k >= pairPartnerStart[d] && pairPartners[k] > d; k--) {
+      e = pairPartners[k];
+      L2 = j - e - 1;
       size = L1 + L2;
 
-      if( CanPair( seq[d], seq[e]) == TRUE &&
-	  (etaN[ EtaNIndex(i+0.5, d-0.5,seqlength)][0] == 0) &&
+      if( (etaN[ EtaNIndex(i+0.5, d-0.5,seqlength)][0] == 0) &&
 	  (etaN[ EtaNIndex(e+0.5, j-0.5,seqlength)][0] == 0) ) {
 				
 				
@@ -344,12 +352,15 @@ DBL_TYPE MinInextensibleIL( int i, int j, int seq[], int seqlength,
   // Case 2b L1 >= 4, L2 = 0,1,2,3;
   for( L2 = 0; L2 <= 3; L2++) {
     e = j - L2 - 1;
-    for( L1 = 4;  L1 <= e - i - 2; L1++) {
-      d = i + L1 + 1;
+    if( e - i - 2 < 4) continue;
+    //partners d of e with L1 = 4, 5, ..., i.e. d = i+5 up to e-1
+    for( k = FirstPairPartner( e, i + 5);
+         k < pairPartnerStart[e+1] && pairPartners[k] < e; k++) {
+      d = pairPartners[k];
+      L1 = d - i - 1;
       size = L1 + L2;
 			
-      if( CanPair( seq[d], seq[e]) == TRUE &&
-	  (etaN[ EtaNIndex(i+0.5, d-0.5,seqlength)][0] == 0) &&
+      if( (etaN[ EtaNIndex(i+0.5, d-0.5,seqlength)][0] == 0) &&
 	  (etaN[ EtaNIndex(e+0.5, j-0.5,seqlength)][0] == 0) ) {
 				
 	energy = InteriorEnergy( i, j, d, e, seq);
@@ -379,6 +390,7 @@ void MakeFs_Fms( int i, int j, int seq[], int seqlength,
   int nNicks;
   int index_ij = EtaNIndex( i+0.5, j-0.5, seqlength);
   int start;
+  int k;
   DBL_TYPE tempMin;
   
   nNicks = etaN[ index_ij][0];
@@ -389,11 +401,12 @@ void MakeFs_Fms( int i, int j, int seq[], int seqlength,
     start = i+4;
   }
   
-  for( d = start; d <= j; d++) {
+  for( k = FirstPairPartner( i, start); k < pairPartnerStart[i+1]; k++) {
+    d = pairPartners[k];
+    if( d > j) break;
     bp_penalty = 0.0;
     
-    if( CanPair( seq[i], seq[ d]) == TRUE &&
-       CanWCPair(seq[i], seq[d])) {
+    if( CanWCPair(seq[i], seq[d])) {
          
          if( seq[i] != BASE_C && seq[d] != BASE_C) {
            bp_penalty = AT_PENALTY;
@@ -479,13 +492,15 @@ DBL_TYPE MinInterior_Multi( int i, int j, int seq[], int seqlength,
   DBL_TYPE min_energy = NAD_INFINITY;
   DBL_TYPE tempMin;
   int d, e; // d - e is internal basepair 
+  int k;
   DBL_TYPE bp_penalty = 0;
 	
 	
   for( d = i+1; d <= j - 5; d++) {
-    for( e = d + 4; e <= j - 1; e++) {
-      if( CanPair( seq[d], seq[e]) == TRUE) {
-        bp_penalty = 0.0;
+    for( k = FirstPairPartner( d, d + 4); k < pairPartnerStart[d+1]; k++) {
+      e = pairPartners[k];
+      if( e > j - 1) break;
+      bp_penalty = 0.0;
 				
 	if( etaN[ EtaNIndex(e+0.5, j-0.5, seqlength)][0] == 0) {
 				
@@ -514,8 +529,6 @@ DBL_TYPE MinInterior_Multi( int i, int j, int seq[], int seqlength,
 	    min_energy = MIN( tempMin, min_energy);
 	  }
         }
-				
-      }
 			
     }
   }
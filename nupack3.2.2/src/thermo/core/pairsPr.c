@@ -192,21 +192,26 @@ void calculatePairsN3( DBL_TYPE *Q, DBL_TYPE *Qb, DBL_TYPE *Qm, DBL_TYPE *Qms,
     }
 
     //store values in pairPr
-    for( i = 0; i <= seqlength-1; i++) {
-      rowsum = 0;
-      indI = i*(seqlength+1);
-      for( j = 0; j <= seqlength; j++) {
-        if( j == seqlength) {
-          pairPr[ indI + j] = 1 - rowsum;
-        }
-        else if ( i <= j) {
-          pf_ij = pf_index(i,j, seqlength);
-          rowsum += Pb[ pf_ij];
-          pairPr[ indI + j] = Pb[ pf_ij];
-        } else {
-          pf_ij = pf_index(j,i, seqlength);
-          rowsum += Pb[ pf_ij];
-          pairPr[ indI + j] = Pb[ pf_ij];
+    if( pairPr == NULL && pairPrSparse != NULL) {
+      FillSparsePairPr( pairPrSparse, Pb, NULL, seqlength);
+    }
+    else {
+      for( i = 0; i <= seqlength-1; i++) {
+        rowsum = 0;
+        indI = i*(seqlength+1);
+        for( j = 0; j <= seqlength; j++) {
+          if( j == seqlength) {
+            pairPr[ indI + j] = 1 - rowsum;
+          }
+          else if ( i <= j) {
+            pf_ij = pf_index(i,j, seqlength);
+            rowsum += Pb[ pf_ij];
+            pairPr[ indI + j] = Pb[ pf_ij];
+          } else {
+            pf_ij = pf_index(j,i, seqlength);
+            rowsum += Pb[ pf_ij];
+            pairPr[ indI + j] = Pb[ pf_ij];
+          }
         }
       }
     }
@@ -231,6 +236,7 @@ void prFastILoops( int i, int j, int L, int seqlength, int seq[],
                    int *nicks, int **etaN, float *preX, float *preX_2) {
 
   int d, e, L1, L2, pf_de;
+  int k;
   int pf_ij = pf_index(i,j,seqlength);
   DBL_TYPE pr = 0;
   int size;
@@ -306,30 +312,29 @@ void prFastILoops( int i, int j, int L, int seqlength, int seq[],
     for( d = i + 5; d <= j - 6; d++) {
       if( leftNick != -1 && leftNick <= d-1) break;
 
-      for( e = d + 1; e <= j - 5; e++) {
+      for( k = FirstPairPartner( d, d + 1); k < pairPartnerStart[d+1]; k++) {
+        e = pairPartners[k];
+        if( e > j - 5) break;
         if( rightNick != -1 && rightNick >= e) continue;
 
-        if( CanPair( seq[d], seq[e]) == TRUE) {
+        L1 = d - i - 1;
+        L2 = j - e - 1;
+        size = L1 + L2;
 
-          L1 = d - i - 1;
-          L2 = j - e - 1;
-          size = L1 + L2;
-
-          pf_de = pf_index( d,e,seqlength);
+        pf_de = pf_index( d,e,seqlength);
 
-          energy = asymmetryEfn( L1, L2, size);
-          energy += InteriorMM( seq[e], seq[d], seq[e+1], seq[d-1]);
-          /*Exclude the i-j stacking energy here, just in case i-j
-            don't pair */
+        energy = asymmetryEfn( L1, L2, size);
+        energy += InteriorMM( seq[e], seq[d], seq[e+1], seq[d-1]);
+        /*Exclude the i-j stacking energy here, just in case i-j
+          don't pair */
 
 
-          fbix =  fbixIndex( j-i, i, size, seqlength);
+        fbix =  fbixIndex( j-i, i, size, seqlength);
 
-          Qx[ fbix ] +=
-            EXP_FUNC(-energy/(kB*TEMP_K))*Qb[ pf_de];
+        Qx[ fbix ] +=
+          EXP_FUNC(-energy/(kB*TEMP_K))*Qb[ pf_de];
 
 
-        }
       }
     }
   }//end special cases
@@ -376,136 +381,119 @@ void prFastILoops( int i, int j, int L, int seqlength, int seq[],
   if( L >= 12 && (leftNick == -1 || leftNick >= i+5) ) {
     L1 = 4;
     d = i + L1 + 1;
-    for( L2 = 4; L2 <= j - d - 2; L2++) {
+    //partners e of d with L2 = 4, 5, ..., i.e. e = j-5 down to d+1
+    for( k = FirstPairPartner( d, j - 4) - 1;
+         k >= pairPartnerStart[d] && pairPartners[k] > d; k--) {
+      e = pairPartners[k];
+      L2 = j - e - 1;
       size = L1 + L2;
-      e = j - L2 - 1;
       fbix =  fbixIndex( j-i, i, size, seqlength);
       if( rightNick != -1 && rightNick >= e) continue;
 
-      if( CanPair( seq[d], seq[e]) == TRUE) {
+      energy = asymmetryEfn( L1, L2, size);
+      energy += InteriorMM( seq[e], seq[d], seq[e+1], seq[d-1]);
+      /*Exclude the i-j stacking energy here, just in case i-j
+        don't pair */
 
-        energy = asymmetryEfn( L1, L2, size);
-        energy += InteriorMM( seq[e], seq[d], seq[e+1], seq[d-1]);
-        /*Exclude the i-j stacking energy here, just in case i-j
-          don't pair */
-
-        pf_de = pf_index(d,e,seqlength);
-        if( Qx[ fbix] > 0) {
+      pf_de = pf_index(d,e,seqlength);
+      if( Qx[ fbix] > 0) {
 
-          if( (pr > 1.0 + NUM_PRECISION ) ) {
-            printf("Numerical precision loss in pairsPr.c\n");
-            printf("6a! %Le\n", (long double) Px[ fbix]);
-          }
+        if( (pr > 1.0 + NUM_PRECISION ) ) {
+          printf("Numerical precision loss in pairsPr.c\n");
+          printf("6a! %Le\n", (long double) Px[ fbix]);
+        }
 
-          pr = Px[ fbix ] *
-            EXP_FUNC(-energy/(kB*TEMP_K))*Qb[ pf_de] / Qx[ fbix];
+        pr = Px[ fbix ] *
+          EXP_FUNC(-energy/(kB*TEMP_K))*Qb[ pf_de] / Qx[ fbix];
 #ifdef NUPACK_SAMPLE
-          if(!nupack_sample) {
+        if(!nupack_sample) {
 #endif
-            Pb[ pf_de] += pr;
-            Px[ fbix] -= pr;
+          Pb[ pf_de] += pr;
+          Px[ fbix] -= pr;
 #ifdef NUPACK_SAMPLE
-          } else {
-            samplingGlobals.pqx += pr;
-            if( (pr > 1.0 + NUM_PRECISION ) ) {
-              printf("Numerical precision loss in pairsPr.c\n");
-              printf("8! Px[fbix] = %Le\n", (long double) Px[ fbix]);
-              printf("pr - 1 = %Le  energy = %Le  Qb[pf_de] = %Le  Qx[fbix] = %Le \n",pr - 1.0, energy,Qb[pf_de] ,Qx[fbix]);
-              exit(1);
-            }
-            pr = 0;
-
-            if(!samplingGlobals.pqxset && samplingGlobals.pqx >= samplingGlobals.Zqx) {
-              samplingGlobals.pqxset = 1;
-              Pb[pf_de] = 1;
-              Px[fbix] = 0;
-            }
-          }
-#endif
-
-
+        } else {
+          samplingGlobals.pqx += pr;
           if( (pr > 1.0 + NUM_PRECISION ) ) {
             printf("Numerical precision loss in pairsPr.c\n");
-            printf("7\n");
+            printf("8! Px[fbix] = %Le\n", (long double) Px[ fbix]);
+            printf("pr - 1 = %Le  energy = %Le  Qb[pf_de] = %Le  Qx[fbix] = %Le \n",pr - 1.0, energy,Qb[pf_de] ,Qx[fbix]);
             exit(1);
           }
-        }
+          pr = 0;
 
-        precisionLost = subtractLongDouble( &(Qx[ fbix]),
-                                            //scale( j-i+d-e) *
-                                            EXP_FUNC(-energy/(kB*TEMP_K))*
-                                            Qb[ pf_de]);
+          if(!samplingGlobals.pqxset && samplingGlobals.pqx >= samplingGlobals.Zqx) {
+            samplingGlobals.pqxset = 1;
+            Pb[pf_de] = 1;
+            Px[fbix] = 0;
+          }
+        }
+#endif
 
 
-        preX[ fbix] += precisionLost;
-        if( preX[ fbix] >= MAXPRECERR) {
-          recalculateQx( i, j, size, fbix, seq, seqlength, Qx, Qb, nicks, etaN,  1);
-          preX[ fbix] = 0.0;
+        if( (pr > 1.0 + NUM_PRECISION ) ) {
+          printf("Numerical precision loss in pairsPr.c\n");
+          printf("7\n");
+          exit(1);
         }
+      }
+
+      precisionLost = subtractLongDouble( &(Qx[ fbix]),
+                                          //scale( j-i+d-e) *
+                                          EXP_FUNC(-energy/(kB*TEMP_K))*
+                                          Qb[ pf_de]);
+
 
+      preX[ fbix] += precisionLost;
+      if( preX[ fbix] >= MAXPRECERR) {
+        recalculateQx( i, j, size, fbix, seq, seqlength, Qx, Qb, nicks, etaN,  1);
+        preX[ fbix] = 0.0;
       }
+
     }
   }
   if( L>=12 && (rightNick == -1 || rightNick <= j - 6) ) {
     //Case 2  L1 > 4, L2 = 4
     L2 = 4;
     e = j - L2 -1;
-    for( L1 = 5; L1 <= e-i-2; L1++) {
+    for( k = FirstPairPartner( e, i + 6);
+         k < pairPartnerStart[e+1] && pairPartners[k] < e; k++) {
+      d = pairPartners[k];
+      L1 = d - i - 1;
       size = L1 + L2;
-      d = i + L1 + 1;
       if( leftNick != -1 && leftNick <= d-1) break;
 
       fbix =  fbixIndex( j-i, i, size, seqlength);
 
-      if( CanPair( seq[d], seq[e]) == TRUE) {
+      energy = asymmetryEfn( L1, L2, size);
+      energy += InteriorMM( seq[e], seq[d], seq[e+1], seq[d-1]);
 
-        energy = asymmetryEfn( L1, L2, size);
-        energy += InteriorMM( seq[e], seq[d], seq[e+1], seq[d-1]);
+      pf_de = pf_index(d,e,seqlength);
+      if( Qx[ fbix] > 0) {
 
-        pf_de = pf_index(d,e,seqlength);
-        if( Qx[ fbix] > 0) {
+
+        if( (pr > 1.0 + NUM_PRECISION ) ) {
+          printf("Numerical precision loss in pairsPr.c\n");
+          printf("7a! %Le\n", (long double) Px[ fbix]);
+        }
 
 
+        pr = ((Px[ fbix ] *
+          (EXP_FUNC(-energy/(kB*TEMP_K))))*Qb[ pf_de]) / Qx[ fbix];
+        #ifdef NUPACK_SAMPLE
+        if(!nupack_sample) {
+        #endif // NUPACK_SAMPLE
+          Pb[ pf_de] += pr;
+          Px[ fbix] -= pr;
+        #ifdef NUPACK_SAMPLE
+        } else {
+          samplingGlobals.pqx += pr;
           if( (pr > 1.0 + NUM_PRECISION ) ) {
             printf("Numerical precision loss in pairsPr.c\n");
-            printf("7a! %Le\n", (long double) Px[ fbix]);
-          }
-
-
-          pr = ((Px[ fbix ] *
-            (EXP_FUNC(-energy/(kB*TEMP_K))))*Qb[ pf_de]) / Qx[ fbix];
-          #ifdef NUPACK_SAMPLE
-          if(!nupack_sample) {
-          #endif // NUPACK_SAMPLE
-            Pb[ pf_de] += pr;
-            Px[ fbix] -= pr;
-          #ifdef NUPACK_SAMPLE
-          } else {
-            samplingGlobals.pqx += pr;
-            if( (pr > 1.0 + NUM_PRECISION ) ) {
-              printf("Numerical precision loss in pairsPr.c\n");
-              printf("8! Px[fbix] = %Le\n", (long double) Px[ fbix]);
-              printf("pr - 1 = %Le  energy = %Le  Qb[pf_de] = %Le  Qx[fbix] = %Le \n",pr - 1.0, energy,Qb[pf_de] ,Qx[fbix]);
-              exit(1);
-            }
-            pr = 0;
-
-            if( (pr > 1.0 + NUM_PRECISION ) ) {
-              printf("Numerical precision loss in pairsPr.c\n");
-              printf("8! Px[fbix] = %Le\n", (long double) Px[ fbix]);
-              printf("pr - 1 = %Le  energy = %Le  Qb[pf_de] = %Le  Qx[fbix] = %Le \n",pr - 1.0, energy,Qb[pf_de] ,Qx[fbix]);
-              exit(1);
-            }
-            pr = 0;
-            if(!samplingGlobals.pqxset && samplingGlobals.pqx >= samplingGlobals.Zqx) {
-              samplingGlobals.pqxset = 1;
-              Pb[pf_de] = 1;
-              Px[fbix] = 0;
-            }
+            printf("8! Px[fbix] = %Le\n", (long double) Px[ fbix]);
+            printf("pr - 1 = %Le  energy = %Le  Qb[pf_de] = %Le  Qx[fbix] = %Le \n",pr - 1.0, energy,Qb[pf_de] ,Qx[fbix]);
+            exit(1);
           }
-          #endif //NUPACK_SAMPLE
-
-
+          pr = 0;
 
           if( (pr > 1.0 + NUM_PRECISION ) ) {
             printf("Numerical precision loss in pairsPr.c\n");
@@ -513,20 +501,36 @@ void prFastILoops( int i, int j, int L, int seqlength, int seq[],
             printf("pr - 1 = %Le  energy = %Le  Qb[pf_de] = %Le  Qx[fbix] = %Le \n",pr - 1.0, energy,Qb[pf_de] ,Qx[fbix]);
             exit(1);
           }
+          pr = 0;
+          if(!samplingGlobals.pqxset && samplingGlobals.pqx >= samplingGlobals.Zqx) {
+            samplingGlobals.pqxset = 1;
+            Pb[pf_de] = 1;
+            Px[fbix] = 0;
+          }
         }
+        #endif //NUPACK_SAMPLE
+
 
-        precisionLost = subtractLongDouble( &(Qx[ fbix]),
-                                            //scale( j-i+d-e) *
-                                            EXP_FUNC(-energy/(kB*TEMP_K))*
-                                            Qb[ pf_de]);
 
-        preX[ fbix] += precisionLost;
-        if( preX[ fbix] >= MAXPRECERR) {
-          recalculateQx( i, j, size, fbix, seq, seqlength, Qx, Qb, nicks, etaN, 2);
-          preX[ fbix] = 0.0;
+        if( (pr > 1.0 + NUM_PRECISION ) ) {
+          printf("Numerical precision loss in pairsPr.c\n");
+          printf("8! Px[fbix] = %Le\n", (long double) Px[ fbix]);
+          printf("pr - 1 = %Le  energy = %Le  Qb[pf_de] = %Le  Qx[fbix] = %Le \n",pr - 1.0, energy,Qb[pf_de] ,Qx[fbix]);
+          exit(1);
         }
+      }
+
+      precisionLost = subtractLongDouble( &(Qx[ fbix]),
+                                          //scale( j-i+d-e) *
+                                          EXP_FUNC(-energy/(kB*TEMP_K))*
+                                          Qb[ pf_de]);
 
+      preX[ fbix] += precisionLost;
+      if( preX[ fbix] >= MAXPRECERR) {
+        recalculateQx( i, j, size, fbix, seq, seqlength, Qx, Qb, nicks, etaN, 2);
+        preX[ fbix] = 0.0;
       }
+
     }
   }
 
@@ -682,63 +686,57 @@ void prManageQx( DBL_TYPE **Qx, DBL_TYPE **Qx_1,
 
   if( len == seqlength-1 && len >= 11) { //first use of these matrices
 
-    free( *Qx);
-    free( *Qx_1);
-    free( *Qx_2);
-
-    *Qx = (DBL_TYPE *) calloc( maxStorage, sizeof( DBL_TYPE));
-    *Qx_1 = (DBL_TYPE *) calloc( maxStorage, sizeof( DBL_TYPE));
-    *Qx_2 = (DBL_TYPE *) calloc( maxStorage, sizeof( DBL_TYPE));
+    // Qx buffers come from the forward pass already sized for the
+    // peak length, so they only need clearing
+    int peakStorage = MAX( maxStorage, QxPeakStorage( seqlength));
+    if( *Qx == NULL || *Qx_1 == NULL || *Qx_2 == NULL) {
+      free( *Qx);
+      free( *Qx_1);
+      free( *Qx_2);
+      *Qx = (DBL_TYPE *) calloc( peakStorage, sizeof( DBL_TYPE));
+      *Qx_1 = (DBL_TYPE *) calloc( peakStorage, sizeof( DBL_TYPE));
+      *Qx_2 = (DBL_TYPE *) calloc( peakStorage, sizeof( DBL_TYPE));
+    }
+    else {
+      memset( *Qx, 0, peakStorage * sizeof( DBL_TYPE));
+      memset( *Qx_1, 0, peakStorage * sizeof( DBL_TYPE));
+      memset( *Qx_2, 0, peakStorage * sizeof( DBL_TYPE));
+    }
 
-    /* old
-       free( *Qx_2);
-       *Qx_2 =
-       (DBL_TYPE *) calloc( maxStorage, sizeof( DBL_TYPE));
-    */
+    *Px = (DBL_TYPE *) calloc( peakStorage, sizeof( DBL_TYPE));
+    *Px_1 = (DBL_TYPE *) calloc( peakStorage, sizeof( DBL_TYPE));
+    *Px_2 = (DBL_TYPE *) calloc( peakStorage, sizeof( DBL_TYPE));
 
-    *Px = (DBL_TYPE *) calloc( maxStorage, sizeof( DBL_TYPE));
-    *Px_1 = (DBL_TYPE *) calloc( maxStorage, sizeof( DBL_TYPE));
-    *Px_2 = (DBL_TYPE *) calloc( maxStorage, sizeof( DBL_TYPE));
+    *preX = (float *) calloc( peakStorage, sizeof( float));
+    *preX_1 = (float *) calloc( peakStorage, sizeof( float));
+    *preX_2 = (float *) calloc( peakStorage, sizeof( float));
 
-    *preX = (float *) calloc( maxStorage, sizeof( float));
-    *preX_1 = (float *) calloc( maxStorage, sizeof( float));
-    *preX_2 = (float *) calloc( maxStorage, sizeof( float));
-
-    if( *Qx_2 == NULL || *Px == NULL || *Px_1 == NULL || *Px_2 == NULL
-        || *preX_1 == NULL || *preX_1 == NULL || *preX_2 == NULL) {
+    if( *Qx == NULL || *Qx_1 == NULL || *Qx_2 == NULL ||
+        *Px == NULL || *Px_1 == NULL || *Px_2 == NULL
+        || *preX == NULL || *preX_1 == NULL || *preX_2 == NULL) {
       printf("Error in Qx, Px, preX allocation\n");
     }
 
   }
   else if( len >= 11) {
+    // rotate, clearing the oldest buffer for reuse as the _2 slot
     temp = *Px;
     *Px = *Px_1;
     *Px_1 = *Px_2;
-    free( temp);
-    *Px_2 =
-      (DBL_TYPE *) calloc( maxStorage, sizeof( DBL_TYPE));
+    *Px_2 = temp;
+    memset( *Px_2, 0, maxStorage * sizeof( DBL_TYPE));
 
     temp = *Qx;
     *Qx = *Qx_1;
     *Qx_1 = *Qx_2;
-    free( temp);
-    *Qx_2 =
-      (DBL_TYPE *) calloc( maxStorage, sizeof( DBL_TYPE));
+    *Qx_2 = temp;
+    memset( *Qx_2, 0, maxStorage * sizeof( DBL_TYPE));
 
     tempf = *preX;
     *preX = *preX_1;
     *preX_1 = *preX_2;
-
-    free( tempf);
-    tempf = NULL;
-
-    *preX_2 =
-      (float *) calloc( maxStorage, sizeof( float));
-
-    if( *Qx_2 == NULL || *Px_2 == NULL || *preX_2 == NULL) {
-      printf("Error in Qx_2, Px_2, preX_2 allocation\n");
-    }
-
+    *preX_2 = tempf;
+    memset( *preX_2, 0, maxStorage * sizeof( float));
   }
 }
 
@@ -874,6 +872,7 @@ void MakePs_Pms( int i, int j, int seq[], int seqlength,
   int nNicks;
   int index_ij = EtaNIndex( i+0.5, j-0.5, seqlength);
   int start;
+  int k;
 
   nNicks = etaN[ index_ij][0];
   if( nNicks >= 1) {
@@ -883,13 +882,14 @@ void MakePs_Pms( int i, int j, int seq[], int seqlength,
     start = i+4;
   }
 
-  for( d = start; d <= j; d++) {
+  for( k = FirstPairPartner( i, start); k < pairPartnerStart[i+1]; k++) {
+    d = pairPartners[k];
+    if( d > j) break;
     pf_id = pf_index(i,d,seqlength);
 
     bp_penalty = 0.0;
 
-    if( CanPair( seq[i], seq[ d]) == TRUE &&
-        CanWCPair(seq[i], seq[d])) {
+    if( CanWCPair(seq[i], seq[d])) {
 
       if( seq[i] != BASE_C && seq[d] != BASE_C) {
         bp_penalty = AT_PENALTY;
@@ -1136,7 +1136,8 @@ void calculatePairsN8( DBL_TYPE Q[], DBL_TYPE Qb[], DBL_TYPE Qm[],
 
   int L, i, j, d, e;
   DBL_TYPE rowsum;
-  int pf_ij, gap_idej;
+  int pf_ij;
+  long int gap_idej;
   //DBL_TYPE prob; //probability
 
 #ifdef FILEOUTPUT
@@ -1239,22 +1240,27 @@ void calculatePairsN8( DBL_TYPE Q[], DBL_TYPE Qb[], DBL_TYPE Qm[],
 
 
   //store values in pairPr
-  for( i = 0; i <= seqlength-1; i++) {
-    rowsum = 0;
-    indI = i*(seqlength+1);
-    for( j = 0; j <= seqlength; j++) {
-      if( j == seqlength) {
-        pairPr[ indI + j] = 1 - rowsum;
-      }
-      else if ( i <= j) {
-        pf_ij = pf_index(i,j, seqlength);
-        rowsum += Pb[ pf_ij] + Pbg[ pf_ij];
-        pairPr[ indI + j] = Pb[ pf_ij] + Pbg[ pf_ij];
-      }
-      else {
-        pf_ij = pf_index(j,i, seqlength);
-        rowsum += Pb[ pf_ij] + Pbg[ pf_ij];
-        pairPr[ indI + j] = Pb[ pf_ij] + Pbg[ pf_ij];
+  if( pairPr == NULL && pairPrSparse != NULL) {
+    FillSparsePairPr( pairPrSparse, Pb, Pbg, seqlength);
+  }
+  else {
+    for( i = 0; i <= seqlength-1; i++) {
+      rowsum = 0;
+      indI = i*(seqlength+1);
+      for( j = 0; j <= seqlength; j++) {
+        if( j == seqlength) {
+          pairPr[ indI + j] = 1 - rowsum;
+        }
+        else if ( i <= j) {
+          pf_ij = pf_index(i,j, seqlength);
+          rowsum += Pb[ pf_ij] + Pbg[ pf_ij];
+          pairPr[ indI + j] = Pb[ pf_ij] + Pbg[ pf_ij];
+        }
+        else {
+          pf_ij = pf_index(j,i, seqlength);
+          rowsum += Pb[ pf_ij] + Pbg[ pf_ij];
+          pairPr[ indI + j] = Pb[ pf_ij] + Pbg[ pf_ij];
+        }
       }
     }
   }
@@ -1550,7 +1556,8 @@ void calculatePairsN5( DBL_TYPE *Q, DBL_TYPE *Qb, DBL_TYPE *Qm,
 
   int L, i, j, d, e;
   DBL_TYPE rowsum, rowsumPb, rowsumPbg;
-  int pf_ij, gap_idej;
+  int pf_ij;
+  long int gap_idej;
 
   float *preX, *preX_1, *preX_2;
 
@@ -1651,33 +1658,38 @@ void calculatePairsN5( DBL_TYPE *Q, DBL_TYPE *Qb, DBL_TYPE *Qm,
   preX = preX_1 = preX_2 = NULL;
 
   //store values in pairPr (pairPrPbg, PairPrPb)
-  for( i = 0; i <= seqlength-1; i++) {
-    rowsum = rowsumPb = rowsumPbg = 0;
+  if( pairPr == NULL && pairPrSparse != NULL) {
+    FillSparsePairPr( pairPrSparse, Pb, Pbg, seqlength);
+  }
+  else {
+    for( i = 0; i <= seqlength-1; i++) {
+      rowsum = rowsumPb = rowsumPbg = 0;
 
-    indI = i*(seqlength+1);
-    for( j = 0; j <= seqlength; j++) {
-      if( j == seqlength) {
-        pairPr[ indI + j] = 1 - rowsum;
-        pairPrPb[ indI + j] = 1 - rowsumPb;
-        pairPrPbg[ indI + j] = 1 - rowsumPbg;
-      }
-      else if ( i <= j) {
-        pf_ij = pf_index(i,j, seqlength);
-        rowsum += Pb[ pf_ij] + Pbg[ pf_ij];
-        rowsumPb += Pb[ pf_ij];
-        rowsumPbg += Pbg[ pf_ij];
-        pairPr[ indI + j] = Pb[ pf_ij] + Pbg[ pf_ij];
-        pairPrPb[ indI + j] = Pb[ pf_ij];
-        pairPrPbg[ indI + j] = Pbg[ pf_ij];
-      }
-      else {
-        pf_ij = pf_index(j,i, seqlength);
-        rowsum += Pb[ pf_ij] + Pbg[ pf_ij];
-        rowsumPb += Pb[ pf_ij];
-        rowsumPbg += Pbg[ pf_ij];
-        pairPr[ indI + j] = Pb[ pf_ij] + Pbg[ pf_ij];
-        pairPrPb[ indI + j] = Pb[ pf_ij];
-        pairPrPbg[ indI + j] = Pbg[ pf_ij];
+      indI = i*(seqlength+1);
+      for( j = 0; j <= seqlength; j++) {
+        if( j == seqlength) {
+          pairPr[ indI + j] = 1 - rowsum;
+          pairPrPb[ indI + j] = 1 - rowsumPb;
+          pairPrPbg[ indI + j] = 1 - rowsumPbg;
+        }
+        else if ( i <= j) {
+          pf_ij = pf_index(i,j, seqlength);
+          rowsum += Pb[ pf_ij] + Pbg[ pf_ij];
+          rowsumPb += Pb[ pf_ij];
+          rowsumPbg += Pbg[ pf_ij];
+          pairPr[ indI + j] = Pb[ pf_ij] + Pbg[ pf_ij];
+          pairPrPb[ indI + j] = Pb[ pf_ij];
+          pairPrPbg[ indI + j] = Pbg[ pf_ij];
+        }
+        else {
+          pf_ij = pf_index(j,i, seqlength);
+          rowsum += Pb[ pf_ij] + Pbg[ pf_ij];
+          rowsumPb += Pb[ pf_ij];
+          rowsumPbg += Pbg[ pf_ij];
+          pairPr[ indI + j] = Pb[ pf_ij] + Pbg[ pf_ij];
+          pairPrPb[ indI + j] = Pb[ pf_ij];
+          pairPrPbg[ indI + j] = Pbg[ pf_ij];
+        }
       }
     }
   }
@@ -2058,7 +2070,8 @@ void MakePgr( int i, int j, int seq[], int seqlength,
   //make sure to call this BEFORE MakeQg and MakeQgl
 
   int d, e, f;
-  int gap_idej, gap_idfj, pf_ef1;
+  int pf_ef1;
+  long int gap_idej, gap_idfj;
   DBL_TYPE prob;
 
   for( d = i+1; d <= j-3; d++) {
@@ -2093,7 +2106,8 @@ void MakePgl( int i, int j, int seq[], int seqlength,
   //make sure to call this BEFORE MakeQg and AFTER MakeQgr
 
   int d, e, f;
-  int gap_idfj, gap_iefj, pf_d1e, pf_df;
+  int pf_d1e, pf_df;
+  long int gap_idfj, gap_iefj;
   DBL_TYPE bp_penalty = 0.0;
   DBL_TYPE prob;
 
@@ -2139,7 +2153,8 @@ void MakePgrs( int i, int j, int seq[], int seqlength, DBL_TYPE *Qg,
                DBL_TYPE *Pgrs) {
 
   int d, e, f;
-  int gap_idej, gap_idef, pf_f1j;
+  int pf_f1j;
+  long int gap_idej, gap_idef;
   DBL_TYPE bp_penalty = 0;
   DBL_TYPE prob;
 
@@ -2182,7 +2197,8 @@ void MakePgls( int i, int j, int seq[], int seqlength, DBL_TYPE *Qg,
                DBL_TYPE *Qm,  DBL_TYPE *Qgls, DBL_TYPE *Pg, DBL_TYPE *Pm,
                DBL_TYPE *Pgls) {
   int c, d, e;
-  int pf_ic1, gap_idej, gap_cdej;
+  int pf_ic1;
+  long int gap_idej, gap_cdej;
   DBL_TYPE bp_penalty = 0;
   DBL_TYPE prob;
 
@@ -2237,7 +2253,8 @@ void MakePg_N5( int i, int j, int seq[], int seqlength, DBL_TYPE *Qg,
 
   //  Make the gap matrix for Qg
   int c,d,e,f;
-  int gap_idej,  pf_i1d1, pf_e1j1, gap_i1def, gap_cdej1, pf_i1c1;
+  int pf_i1d1, pf_e1j1, pf_i1c1;
+  long int gap_idej, gap_i1def, gap_cdej1;
   DBL_TYPE IJ_bp_penalty = 0.0;
   DBL_TYPE bp_penalty = 0;
   DBL_TYPE prob;
@@ -2560,7 +2577,8 @@ void MakePg_N8( int i, int j, char seq[], int seqlength, DBL_TYPE Qg[],
                 DBL_TYPE Qm[], DBL_TYPE Pg[], DBL_TYPE Pm[]) {
   //  Make the gap matrix for Qg
   int c,d,e,f;
-  int gap_idej, gap_cdef, pf_i1d1, pf_e1j1;
+  int pf_i1d1, pf_e1j1;
+  long int gap_idej, gap_cdef;
   DBL_TYPE IJ_bp_penalty = 0.0;
   DBL_TYPE bp_penalty = 0;
   DBL_TYPE prob;
@@ -2946,11 +2964,11 @@ void prFastILoopsN5( int i, int j, int seq[], int seqlength,
   int L = j - i + 1;
   int qgix, qgix2;
   DBL_TYPE ExplInteriorMM = NAD_INFINITY;
-  int gap_idej;
+  long int gap_idej;
   DBL_TYPE energy;
   int c, f; //Internal pair.(c, f will be restricted to special cases)
   int L1, L2; //size parameters: L1 + L2 = size, L1 = c-i-1, L2 = j-f-1
-  int gap_cdef;
+  long int gap_cdef;
   //extern DBL_TYPE loop37[];
   //extern DBL_TYPE asymmetry_penalty[];
   //extern DBL_TYPE max_asymmetry;
@@ -3171,8 +3189,8 @@ void MakePg_Inextensible( int i, int j,int d, int e, int seq[], int seqlength,
   int c, f; //Internal pair.(c, f will be restricted to special cases)
   int L1, L2; //size parameters: L1 + L2 = size, L1 = c-i-1, L2 = j-f-1
   DBL_TYPE pr;
-  int gap_idej = gap_index(i,d,e,j,seqlength);
-  int gap_cdef;
+  long int gap_idej = gap_index(i,d,e,j,seqlength);
+  long int gap_cdef;
 
   if( CanPair( seq[i], seq[j]) == FALSE) {
     return;
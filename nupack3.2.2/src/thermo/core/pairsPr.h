@@ -2,6 +2,7 @@
 #define __PAIRSPR_H__
 
 #include "pfuncUtils.h"
+#include "pairsPrSparse.h"
 
 
 #ifdef __cplusplus
@@ -0,0 +1,109 @@
+/*
+  pairsPrSparse.c is part of the NUPACK software suite
+  Copyright (c) 2007 Caltech. All rights reserved.
+
+  Compressed sparse row storage for the pair probability matrix.  For
+  long sequences nearly all entries of pairPr are close to zero, so
+  callers that apply a cutoff anyway (pairs -sparse, the design
+  engines) only keep the entries they will look at.
+*/
+
+#include "pairsPrSparse.h"
+
+/* ******************** */
+void InitSparsePairPr( sparsePairPr *sp, DBL_TYPE cutoff) {
+  sp->seqlength = 0;
+  sp->nnz = 0;
+  sp->nAlloc = 0;
+  sp->rowStart = NULL;
+  sp->col = NULL;
+  sp->prob = NULL;
+  sp->cutoff = cutoff;
+}
+
+/* ******************** */
+void ClearSparsePairPr( sparsePairPr *sp) {
+  free( sp->rowStart);
+  free( sp->col);
+  free( sp->prob);
+  InitSparsePairPr( sp, sp->cutoff);
+}
+
+/* ******************** */
+static void reserveSparsePairPr( sparsePairPr *sp, int nnz) {
+  if( nnz <= sp->nAlloc) return;
+
+  sp->nAlloc = nnz + nnz/2;
+  sp->col = (int*) realloc( sp->col, sp->nAlloc*sizeof( int));
+  sp->prob = (DBL_TYPE*) realloc( sp->prob, sp->nAlloc*sizeof( DBL_TYPE));
+  if( sp->col == NULL || sp->prob == NULL) {
+    printf("Unable to allocate %d sparse pair probabilities\n", nnz);
+    exit(1);
+  }
+}
+
+/* ******************** */
+void FillSparsePairPr( sparsePairPr *sp, const DBL_TYPE *Pb,
+                       const DBL_TYPE *Pbg, int seqlength) {
+
+  int i, j, pf_ij, k;
+  int nnz;
+  DBL_TYPE rowsum, value;
+
+  if( sp->seqlength != seqlength || sp->rowStart == NULL) {
+    free( sp->rowStart);
+    sp->rowStart = (int*) malloc( (seqlength+1)*sizeof( int));
+    sp->seqlength = seqlength;
+  }
+
+  //count the stored entries first, so col/prob are sized exactly once
+  nnz = 0;
+  for( i = 0; i <= seqlength-1; i++) {
+    for( j = 0; j <= seqlength-1; j++) {
+      pf_ij = i <= j ? pf_index(i,j,seqlength) : pf_index(j,i,seqlength);
+      value = Pbg != NULL ? Pb[ pf_ij] + Pbg[ pf_ij] : Pb[ pf_ij];
+      if( value >= sp->cutoff) nnz++;
+    }
+    nnz++; //unpaired entry is always kept
+  }
+  reserveSparsePairPr( sp, nnz);
+
+  //rowsum is accumulated over all entries, in the same order as the dense
+  //pairPr fill, so the unpaired probabilities are identical
+  k = 0;
+  for( i = 0; i <= seqlength-1; i++) {
+    sp->rowStart[i] = k;
+    rowsum = 0;
+    for( j = 0; j <= seqlength-1; j++) {
+      pf_ij = i <= j ? pf_index(i,j,seqlength) : pf_index(j,i,seqlength);
+      value = Pbg != NULL ? Pb[ pf_ij] + Pbg[ pf_ij] : Pb[ pf_ij];
+      rowsum += value;
+      if( value >= sp->cutoff) {
+        sp->col[k] = j;
+        sp->prob[k] = value;
+        k++;
+      }
+    }
+    sp->col[k] = seqlength;
+    sp->prob[k] = 1 - rowsum;
+    k++;
+  }
+  sp->rowStart[seqlength] = k;
+  sp->nnz = k;
+}
+
+/* ******************** */
+DBL_TYPE GetSparsePairPr( const sparsePairPr *sp, int i, int j) {
+  int lo = sp->rowStart[i];
+  int hi = sp->rowStart[i+1] - 1;
+  int mid;
+
+  while( lo <= hi) {
+    mid = (lo + hi)/2;
+    if( sp->col[mid] == j) return sp->prob[mid];
+    if( sp->col[mid] < j) lo = mid + 1;
+    else hi = mid - 1;
+  }
+  return 0.0;
+}
+/* ****** */
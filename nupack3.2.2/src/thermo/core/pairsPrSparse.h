@@ -0,0 +1,34 @@
+#ifndef __PAIRSPRSPARSE_H__
+#define __PAIRSPRSPARSE_H__
+
+#include "pfuncUtils.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Sparse (CSR) storage of pair probabilities, see sparsePairPr in
+   shared/structs.h.  When the global pairPrSparse is set (and pairPr is
+   NULL), the pair probability calculations fill it instead of allocating
+   the dense (seqlength+1)^2 pairPr matrix. */
+
+//initialize an empty matrix that keeps entries >= cutoff
+void InitSparsePairPr( sparsePairPr *sp, DBL_TYPE cutoff);
+
+//release the storage of sp (sp itself is not freed)
+void ClearSparsePairPr( sparsePairPr *sp);
+
+//fill sp from the Pb (and, if not NULL, Pbg) matrices.  Storage is reused
+//across calls, so a single sparsePairPr can serve many pfunc evaluations.
+void FillSparsePairPr( sparsePairPr *sp, const DBL_TYPE *Pb,
+                       const DBL_TYPE *Pbg, int seqlength);
+
+//probability of pair (i,j), j == seqlength for unpaired.  Entries that were
+//not stored (below the cutoff) are returned as 0.
+DBL_TYPE GetSparsePairPr( const sparsePairPr *sp, int i, int j);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif
@@ -9,6 +9,7 @@
 */
 
 #include "pf.h"
+#include "segmentMemo.h"
 
 /* ************************************************ */
 
@@ -17,6 +18,12 @@
 static DBL_TYPE * pairing_bonuses = NULL;
 static int use_bonuses = 0;
 
+// see pfuncFullWithPairBonuses
+static int n_bonus_pairs = 0;
+static const int *bonus_pairs = NULL;
+static const DBL_TYPE *bonus_values = NULL;
+static DBL_TYPE *root_q = NULL;
+
 /* ******************** */
 DBL_TYPE pfuncFullWithBonuses( int inputSeq[], int complexity, int naType, int dangles, 
                     DBL_TYPE temperature, int calcPairs, int perm_symm, DBL_TYPE sodiumconc, 
@@ -37,6 +44,35 @@ DBL_TYPE pfuncFullWithBonuses( int inputSeq[], int complexity, int naType, int d
 }
 
 
+/* ******************** */
+DBL_TYPE pfuncFullWithPairBonuses( int inputSeq[], int complexity, int naType,
+                    int dangles, DBL_TYPE temperature, int calcPairs,
+                    int perm_symm, DBL_TYPE sodiumconc,
+                    DBL_TYPE magnesiumconc, int uselongsalt, int nBonuses,
+                    const int bonusPairs[], const DBL_TYPE bonuses[],
+                    DBL_TYPE *rootQ) {
+
+  int nStrands;
+  int seqlength=getSequenceLengthInt (inputSeq, &nStrands);
+  DBL_TYPE res;
+
+  n_bonus_pairs = nBonuses;
+  bonus_pairs = bonusPairs;
+  bonus_values = bonuses;
+  root_q = rootQ;
+
+  res = pfuncFullWithSymHelper(inputSeq, seqlength, nStrands, complexity, naType,
+                               dangles, temperature, calcPairs, perm_symm,
+                               sodiumconc, magnesiumconc, uselongsalt);
+
+  n_bonus_pairs = 0;
+  bonus_pairs = NULL;
+  bonus_values = NULL;
+  root_q = NULL;
+  return res;
+}
+
+
 // This is the main function for computing partition functions.
 DBL_TYPE pfuncFullWithSymHelper( int inputSeq[], int seqlength, int nStrands,
                                 int complexity, int naType, 
@@ -144,6 +180,7 @@ DBL_TYPE pfuncFullWithSymHelper( int inputSeq[], int seqlength, int nStrands,
 
   int **etaN;
   int arraySize;
+  int useSegments;
 
   //assign global variables
   TEMP_K = temperature + ZERO_C_IN_KELVIN;
@@ -178,6 +215,12 @@ DBL_TYPE pfuncFullWithSymHelper( int inputSeq[], int seqlength, int nStrands,
   if( complexity >= 5) //pseudoknotted
     initPF( seqlength); //precompute values
 
+  MakePairPartners( seq, seqlength);
+
+  useSegments = SEGMENT_MEMO != NULL && complexity == 3 &&
+    !(pairing_bonuses && use_bonuses) && n_bonus_pairs == 0 &&
+    SegmentMemoBegin( SEGMENT_MEMO, seqlength, nStrands, nicks);
+
   // Allocate and Initialize Matrices
   arraySize = seqlength*(seqlength+1)/2+(seqlength+1);
   InitLDoublesMatrix( &Q, arraySize, "Q");
@@ -201,13 +244,13 @@ DBL_TYPE pfuncFullWithSymHelper( int inputSeq[], int seqlength, int nStrands,
     InitLDoublesMatrix( &Qz, arraySize, "Qz");
     nonZeroInit( Qz, seq, seqlength);
 
-    InitLDoublesMatrix( &Qg, maxGapIndex, "Qg");
+    InitGapMatrix( &Qg, maxGapIndex, "Qg");
 
     if( complexity == 5) {
-      InitLDoublesMatrix( &Qgl, maxGapIndex, "Qgl");
-      InitLDoublesMatrix( &Qgr, maxGapIndex, "Qgr");
-      InitLDoublesMatrix( &Qgls, maxGapIndex, "Qgls");
-      InitLDoublesMatrix( &Qgrs, maxGapIndex, "Qgrs");
+      InitGapMatrix( &Qgl, maxGapIndex, "Qgl");
+      InitGapMatrix( &Qgr, maxGapIndex, "Qgr");
+      InitGapMatrix( &Qgls, maxGapIndex, "Qgls");
+      InitGapMatrix( &Qgrs, maxGapIndex, "Qgrs");
       CheckPossiblePairs( &possiblePairs, seqlength, seq);
     }
   }
@@ -227,6 +270,10 @@ DBL_TYPE pfuncFullWithSymHelper( int inputSeq[], int seqlength, int nStrands,
         Qb_bonus[pf_index(i, j, seqlength)] = 1.0;
       }
     }
+    for (i = 0; i < n_bonus_pairs; i++) {
+      Qb_bonus[pf_index(bonus_pairs[2*i], bonus_pairs[2*i+1], seqlength)] *=
+        bonus_values[i];
+    }
   }
 
   for( L = 1; L <= seqlength; L++) {
@@ -251,6 +298,14 @@ DBL_TYPE pfuncFullWithSymHelper( int inputSeq[], int seqlength, int nStrands,
     for( i = iMin; i <= iMax; i++) {
       j = i + L - 1;
       pf_ij = pf_index( i, j, seqlength);
+
+      if( useSegments &&
+         SegmentMemoFetch( SEGMENT_MEMO, i, j, Q, Qb, Qm, Qs, Qms)) {
+        //folded with another ordering; Qx still runs through [i,j]
+        fastILoopsQx( i, j, L, seqlength, seq, etaN, Qb, Qx, Qx_2);
+        continue;
+      }
+
       /* Recursions for Qb.  See figure 13 of paper */
       /* bp = base pairs, pk = pseudoknots */
       if( CanPair( seq[ i], seq[ j]) == FALSE) {
@@ -343,6 +398,14 @@ DBL_TYPE pfuncFullWithSymHelper( int inputSeq[], int seqlength, int nStrands,
     }
   }
 
+  if( useSegments) {
+    SegmentMemoKeep( SEGMENT_MEMO, Q, Qb, Qm, Qs, Qms);
+  }
+
+  if( root_q != NULL) {
+    *root_q = Q[ pf_index(0, seqlength-1, seqlength)];
+  }
+
   //adjust this for nStrands, symmetry at rank == 0 node
     returnValue = EXP_FUNC( -1*(BIMOLECULAR + SALT_CORRECTION)*(nStrands-1)/(kB*TEMP_K) )*
       Q[ pf_index(0,seqlength-1, seqlength)]/((DBL_TYPE) permSymmetry);
@@ -410,11 +473,11 @@ DBL_TYPE pfuncFullWithSymHelper( int inputSeq[], int seqlength, int nStrands,
       }
       nupack_sample_list[sample_count][seqlength + nNicks] = '\0';
     }
-    free(P);
-    free(Pb);
-    free(Pm);
-    free(Pms);
-    free(Ps);
+    FreeLDoublesMatrix( &P, arraySize);
+    FreeLDoublesMatrix( &Pb, arraySize);
+    FreeLDoublesMatrix( &Pm, arraySize);
+    FreeLDoublesMatrix( &Pms, arraySize);
+    FreeLDoublesMatrix( &Ps, arraySize);
   } 
 #endif //NUPACK_SAMPLE
   //Calculate Pair Probabilities as needed 
@@ -426,7 +489,7 @@ DBL_TYPE pfuncFullWithSymHelper( int inputSeq[], int seqlength, int nStrands,
     }
     */
     isPairPrExtern = TRUE;
-    if( pairPr == NULL 
+    if( pairPr == NULL && pairPrSparse == NULL
         ) {
       pairPr = (DBL_TYPE*) calloc( (seqlength+1)*(seqlength+1), 
                                   sizeof(DBL_TYPE));
@@ -471,11 +534,11 @@ DBL_TYPE pfuncFullWithSymHelper( int inputSeq[], int seqlength, int nStrands,
       InitLDoublesMatrix( &Pm, arraySize, "Pm");
       InitLDoublesMatrix( &Pp, arraySize, "Pp");
       InitLDoublesMatrix( &Pz, arraySize, "Pz");
-      InitLDoublesMatrix( &Pg, maxGapIndex, "Pg");
-      InitLDoublesMatrix( &Pgl, maxGapIndex, "Pgl");
-      InitLDoublesMatrix( &Pgr, maxGapIndex, "Pgr");
-      InitLDoublesMatrix( &Pgls, maxGapIndex, "Pgls");
-      InitLDoublesMatrix( &Pgrs, maxGapIndex,"Pgrs");
+      InitGapMatrix( &Pg, maxGapIndex, "Pg");
+      InitGapMatrix( &Pgl, maxGapIndex, "Pgl");
+      InitGapMatrix( &Pgr, maxGapIndex, "Pgr");
+      InitGapMatrix( &Pgls, maxGapIndex, "Pgls");
+      InitGapMatrix( &Pgrs, maxGapIndex,"Pgrs");
       InitLDoublesMatrix( &Pbg, seqlength*(seqlength+1)/2, "Pbg");
 
       P[ pf_index( 0, seqlength-1, seqlength)] = 1.0;
@@ -511,16 +574,16 @@ DBL_TYPE pfuncFullWithSymHelper( int inputSeq[], int seqlength, int nStrands,
   }
 
 
-  free( Q);
-  free( Qb);
-  free( Qm);
-  free( Qb_bonus);
+  FreeLDoublesMatrix( &Q, arraySize);
+  FreeLDoublesMatrix( &Qb, arraySize);
+  FreeLDoublesMatrix( &Qm, arraySize);
+  FreeLDoublesMatrix( &Qb_bonus, arraySize);
 
   Q = Qb = Qm = NULL;
 
   if( complexity == 3) {
-    free( Qs);
-    free( Qms);
+    FreeLDoublesMatrix( &Qs, arraySize);
+    FreeLDoublesMatrix( &Qms, arraySize);
     
     free( Qx);
     free( Qx_1);
@@ -530,17 +593,17 @@ DBL_TYPE pfuncFullWithSymHelper( int inputSeq[], int seqlength, int nStrands,
   }
 
   if( complexity >= 5) {
-    free( Qp);
-    free( Qz);
-    free( Qg);
+    FreeLDoublesMatrix( &Qp, arraySize);
+    FreeLDoublesMatrix( &Qz, arraySize);
+    FreeGapMatrix( &Qg);
 
     Qp = Qz = Qg = NULL;
 
     if( complexity == 5) {
-      free(Qgl);
-      free(Qgr);
-      free(Qgls);
-      free(Qgrs);
+      FreeGapMatrix( &Qgl);
+      FreeGapMatrix( &Qgr);
+      FreeGapMatrix( &Qgls);
+      FreeGapMatrix( &Qgrs);
       free(QgIx);
       free(QgIx_1);
       free(QgIx_2);
@@ -562,48 +625,49 @@ DBL_TYPE pfuncFullWithSymHelper( int inputSeq[], int seqlength, int nStrands,
 
     /*
     if( complexity == 4) {
-    free( Pb);
+    FreeLDoublesMatrix( &Pb, arraySize);
     Pb = NULL;
     }
     */
 
     if( complexity == 3) {
-      free(   P);
-      free(  Pb);
-      free(  Pm);
-      free( Pms);
-      free(  Ps);
+      FreeLDoublesMatrix( &P, arraySize);
+      FreeLDoublesMatrix( &Pb, arraySize);
+      FreeLDoublesMatrix( &Pm, arraySize);
+      FreeLDoublesMatrix( &Pms, arraySize);
+      FreeLDoublesMatrix( &Ps, arraySize);
       
       P = Pb = Pm = Pms = Ps = NULL;
     }
 
     if( complexity == 8) {
-      free(P);
-      free(Pb);
-      free(Pz);
-      free(Pp);
-      free(Pg);
+      FreeLDoublesMatrix( &P, arraySize);
+      FreeLDoublesMatrix( &Pb, arraySize);
+      FreeLDoublesMatrix( &Pz, arraySize);
+      FreeLDoublesMatrix( &Pp, arraySize);
+      FreeGapMatrix( &Pg);
       free(Pbg);
-      free(Pm);
+      FreeLDoublesMatrix( &Pm, arraySize);
       P = Pb = Pz = Pp = Pg = Pbg = Pm = NULL;
     }
 
     if( complexity == 5) {
-      free(P);
-      free(Pb);
-      free(Pz);
-      free(Pp);
-      free(Pg);
+      FreeLDoublesMatrix( &P, arraySize);
+      FreeLDoublesMatrix( &Pb, arraySize);
+      FreeLDoublesMatrix( &Pz, arraySize);
+      FreeLDoublesMatrix( &Pp, arraySize);
+      FreeGapMatrix( &Pg);
       free(Pbg);
-      free(Pm);
-      free(Pgl);
-      free(Pgr);
-      free(Pgls);
-      free(Pgrs);
+      FreeLDoublesMatrix( &Pm, arraySize);
+      FreeGapMatrix( &Pgl);
+      FreeGapMatrix( &Pgr);
+      FreeGapMatrix( &Pgls);
+      FreeGapMatrix( &Pgrs);
       P = Pb = Pz = Pp = Pg = Pbg = Pm = Pgl = Pgr = Pgls = Pgrs = NULL;
     }
   }
 
+  FreePairPartners();
   free( seq);
 
   for( i = 0; i <= seqlength-1; i++) {
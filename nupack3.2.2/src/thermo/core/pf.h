@@ -40,6 +40,18 @@ DBL_TYPE pfuncFullWithBonuses(int inputSeq[], int complexity, int naType,
     DBL_TYPE sodium_conc, DBL_TYPE magnesium_conc, int use_long_salt, 
     DBL_TYPE * bonuses);
 
+/* pfuncFullWithPairBonuses: as pfuncFullWithBonuses, with the bonuses
+   given as a list instead of a dense seqlength*seqlength matrix: bonus k
+   multiplies the weight of the pair (bonusPairs[2k], bonusPairs[2k+1]),
+   i < j.  If rootQ is not NULL it receives the partition function of the
+   whole sequence before the strand association and symmetry corrections
+   (what EXTERN_Q holds at (0, seqlength-1)). */
+DBL_TYPE pfuncFullWithPairBonuses(int inputSeq[], int complexity, int naType,
+    int dangles, DBL_TYPE temperature, int calcPairs, int perm_sym,
+    DBL_TYPE sodium_conc, DBL_TYPE magnesium_conc, int use_long_salt,
+    int nBonuses, const int bonusPairs[], const DBL_TYPE bonuses[],
+    DBL_TYPE *rootQ);
+
 //pfuncFullWithSym is the Same as pfuncFull, but divides
 //the result by permSym to account for symmetries
 DBL_TYPE pfuncFullWithSym( int inputSeq[], int complexity, int naType,
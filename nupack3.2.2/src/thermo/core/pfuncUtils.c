@@ -10,7 +10,7 @@
 /* ********************************************** */
 //Added 08/21/2001
 
-int gap_index( int h, int r, int m, int s, int seqlength) {
+long int gap_index( int h, int r, int m, int s, int seqlength) {
   // index variable should actually be h..h1..m1..m, but i will use
   // the above indices for simplicity. 
 
@@ -304,6 +304,58 @@ void CheckPossiblePairs( short **possiblePairs, int seqlength, int seq[]) {
   }
 }
 
+/* ******************************************** */
+void MakePairPartners( int seq[], int seqlength) {
+  int i, j, k;
+
+  pairPartnerStart = (int *) realloc( pairPartnerStart, 
+                                      (seqlength+1)*sizeof( int));
+  k = 0;
+  for( i = 0; i < seqlength; i++) {
+    pairPartnerStart[i] = k;
+    for( j = 0; j < seqlength; j++) {
+      if( j != i && CanPair( seq[i], seq[j]) == TRUE) k++;
+    }
+  }
+  pairPartnerStart[ seqlength] = k;
+
+  pairPartners = (int *) realloc( pairPartners, (k > 0 ? k : 1)*sizeof( int));
+  if( pairPartnerStart == NULL || pairPartners == NULL) {
+    fprintf(stderr, "Error in allocation of pairPartners!\n");
+    exit(1);
+  }
+
+  k = 0;
+  for( i = 0; i < seqlength; i++) {
+    for( j = 0; j < seqlength; j++) {
+      if( j != i && CanPair( seq[i], seq[j]) == TRUE) {
+        pairPartners[ k++] = j;
+      }
+    }
+  }
+}
+
+/* ******************************************** */
+void FreePairPartners( void) {
+  free( pairPartners);
+  free( pairPartnerStart);
+  pairPartners = pairPartnerStart = NULL;
+}
+
+/* ******************************************** */
+int FirstPairPartner( int i, int d) {
+  int lo = pairPartnerStart[i];
+  int hi = pairPartnerStart[i+1];
+  int mid;
+
+  while( lo < hi) {
+    mid = (lo + hi)/2;
+    if( pairPartners[ mid] < d) lo = mid + 1;
+    else hi = mid;
+  }
+  return lo;
+}
+
 /* ******************************************** */
 int fbixIndexOld( int d, int i, int size, int N ) {
   if( d < 0 || i < 0 || i + d >= N) {
@@ -45,7 +45,7 @@ int CanPairOld( int i, int j);
 #define CanWCPair(i, j) ((i) + (j) == 5 ? TRUE : FALSE)
 
 //gap_index calculates the array index of a "gap" matrix.
-int gap_index( int h, int r, int m, int s, int seqlength);
+long int gap_index( int h, int r, int m, int s, int seqlength);
 
 //fbixIndex computes the array index for a Qx/Fx array (fast i loops)
 int fbixIndexOld( int d, int i, int size, int N );
@@ -74,6 +74,15 @@ int printSeqNum(int seqnum[]);
 //Sets possiblePairs[ pf_index(i,j,seqlength)] == TRUE if possible
 void CheckPossiblePairs( short **possiblePairs, int seqlength, int seq[]);
 
+//MakePairPartners lists, for every base i, the bases that can pair with
+//it in increasing order: pairPartners[ pairPartnerStart[i] ..
+//pairPartnerStart[i+1]-1].  The N^3 fill loops iterate over these lists
+//instead of testing CanPair for every d/e.
+void MakePairPartners( int seq[], int seqlength);
+void FreePairPartners( void);
+//index in pairPartners of the first partner of i that is >= d
+int FirstPairPartner( int i, int d);
+
 //LoadFold loads a structure of type fold from a data file.
 void LoadFold( fold *thefold, char filename[]);
 
@@ -65,7 +65,7 @@ void MakeFg_N5( int i, int j, int seq[], int seqlength, DBL_TYPE *Fg,
 		DBL_TYPE *FgIx_2, short *possiblePairs) {
   //  Make the gap matrix for Qg
   int c,d,e,f;
-  int gap_idej;
+  long int gap_idej;
   DBL_TYPE IJ_bp_penalty = 0.0;
   DBL_TYPE bp_penalty = 0;
   DBL_TYPE tempMin;
@@ -239,7 +239,7 @@ void fastIloop_Fg(int i, int j, int seq[], int seqlength,
   int L = j - i + 1;
   int pf_ij = pf_index(i, j, seqlength);
   int index;
-  int gap_idej;
+  long int gap_idej;
   DBL_TYPE tempMin;
 	
   //FgIx recurions
@@ -470,7 +470,7 @@ void MakeFgls( int i, int j, int seq[], int seqlength, DBL_TYPE *Fg,
   int pf_ic1;
   DBL_TYPE bp_penalty = 0;
   DBL_TYPE tempMin;
-  int gap_idej;
+  long int gap_idej;
 	
   for( c = i + 5; c <= j-6; c++) {
     if( CanPair( seq[c], seq[j]) == TRUE 
@@ -510,7 +510,7 @@ void MakeFgrs( int i, int j, int seq[], int seqlength, DBL_TYPE *Fg,
 	       DBL_TYPE *Fm, DBL_TYPE *Fgrs) {
 	
   int d, e, f;
-  int gap_idej;
+  long int gap_idej;
   DBL_TYPE bp_penalty = 0;
   DBL_TYPE tempMin;
 	
@@ -547,7 +547,7 @@ void MakeFgl( int i, int j, int seq[], int seqlength,
   //make sure to call this AFTER MakeFg and BEFORE MakeFgr
   
   int d, e, f;
-  int gap_idfj, gap_iefj;
+  long int gap_idfj, gap_iefj;
   DBL_TYPE bp_penalty = 0.0;
   DBL_TYPE tempMin;
   
@@ -584,7 +584,7 @@ void MakeFgr( int i, int j, int seq[], int seqlength,
   //make sure to call this AFTER MakeQg and AFTER MakeQgl
   
   int d, e, f;
-  int gap_idej;
+  long int gap_idej;
   DBL_TYPE tempMin;
 	
   for( d = i+1; d <= j-3; d++) {
@@ -879,7 +879,7 @@ void MakeFg_N8( int i, int j, int seq[], int seqlength, DBL_TYPE Fg[],
 		DBL_TYPE Fm[]) {
   //  Make the gap matrix for Fg
   int c,d,e,f;
-  int gap_idej;
+  long int gap_idej;
   DBL_TYPE IJ_bp_penalty = 0.0;
   DBL_TYPE bp_penalty = 0;
   DBL_TYPE tempMin;
@@ -0,0 +1,252 @@
+/*
+  segmentMemo.c is part of the NUPACK software suite
+  Copyright (c) 2007 Caltech. All rights reserved.
+
+  Partition function blocks shared between strand orderings (see
+  segmentMemo.h).  A kept fold is a copy of the five matrices of one
+  ordering.  Every segment is found through a hash keyed by its strand
+  codes, which gives the fold holding it and where it starts there.
+*/
+
+#include "segmentMemo.h"
+
+segmentMemo *SEGMENT_MEMO = NULL;
+
+typedef struct {
+  int seqlength;
+  DBL_TYPE *Q, *Qb, *Qm, *Qs, *Qms;
+} keptFold;
+
+typedef struct {
+  int fold;   // index in kept
+  int start;  // first base of the segment in that fold
+  int key[];  // number of strands, then their codes
+} segmentPlace;
+
+struct segmentMemo {
+  size_t maxBytes;
+  size_t nBytes;
+  hash *places;
+  segmentPlace **allPlaces;
+  int nPlaces, placesAlloc;
+  keptFold *kept;
+  int nKept, keptAlloc;
+
+  // the current fold
+  int nStrands;            // 0 until SegmentMemoSetStrands
+  int *codes;
+  int seqlength;
+  int *starts;             // first base of each strand, then seqlength
+  int *strandOf;           // strand of each base
+  const segmentPlace **found; // [a*nStrands + b], the segment of strands a..b
+  int strandsAlloc, basesAlloc;
+};
+
+
+/* ******************** */
+segmentMemo *NewSegmentMemo( size_t maxBytes) {
+
+  segmentMemo *memo = (segmentMemo *) calloc( 1, sizeof(segmentMemo));
+
+  memo->maxBytes = maxBytes;
+  memo->places = hash_new( 64);
+  return memo;
+}
+
+
+/* ******************** */
+void FreeSegmentMemo( segmentMemo *memo) {
+
+  int n;
+
+  if( memo == NULL) return;
+  if( SEGMENT_MEMO == memo) SEGMENT_MEMO = NULL;
+
+  for( n = 0; n < memo->nKept; n++) {
+    free( memo->kept[n].Q);
+    free( memo->kept[n].Qb);
+    free( memo->kept[n].Qm);
+    free( memo->kept[n].Qs);
+    free( memo->kept[n].Qms);
+  }
+  for( n = 0; n < memo->nPlaces; n++) {
+    free( memo->allPlaces[n]);
+  }
+  hash_destroy( memo->places);
+  free( memo->allPlaces);
+  free( memo->kept);
+  free( memo->codes);
+  free( memo->starts);
+  free( memo->strandOf);
+  free( memo->found);
+  free( memo);
+}
+
+
+/* ******************** */
+void SegmentMemoSetStrands( segmentMemo *memo, const int codes[], int nStrands) {
+
+  if( nStrands > memo->strandsAlloc) {
+    memo->strandsAlloc = nStrands;
+    memo->codes = (int *) realloc( memo->codes, (nStrands+1)*sizeof(int));
+    memo->starts = (int *) realloc( memo->starts, (nStrands+1)*sizeof(int));
+    memo->found = (const segmentPlace **)
+      realloc( memo->found, nStrands*nStrands*sizeof(segmentPlace *));
+  }
+  memcpy( memo->codes, codes, nStrands*sizeof(int));
+  memo->nStrands = nStrands;
+}
+
+
+/* ******************** */
+// fills key with the key of the segment of strands a..b; returns its size
+static int segmentKey( const segmentMemo *memo, int a, int b, int key[]) {
+
+  key[0] = b - a + 1;
+  memcpy( key + 1, memo->codes + a, (b - a + 1)*sizeof(int));
+  return (b - a + 2)*sizeof(int);
+}
+
+
+/* ******************** */
+int SegmentMemoBegin( segmentMemo *memo, int seqlength, int nStrands,
+                      const int nicks[]) {
+
+  int a, b, s, i, len;
+  int key[ MAXSTRANDS+1]; // hash_get may compare the whole of a longer key
+
+  if( memo->nStrands != nStrands) {
+    memo->nStrands = 0;
+    return 0;
+  }
+
+  if( seqlength > memo->basesAlloc) {
+    memo->basesAlloc = seqlength;
+    memo->strandOf = (int *) realloc( memo->strandOf, seqlength*sizeof(int));
+  }
+  memo->seqlength = seqlength;
+
+  // nicks[s] is the last base of strand s
+  memo->starts[0] = 0;
+  for( s = 1; s < nStrands; s++) {
+    memo->starts[s] = nicks[s-1] + 1;
+  }
+  memo->starts[nStrands] = seqlength;
+  for( s = 0; s < nStrands; s++) {
+    for( i = memo->starts[s]; i < memo->starts[s+1]; i++) {
+      memo->strandOf[i] = s;
+    }
+  }
+
+  for( a = 0; a < nStrands; a++) {
+    for( b = a; b < nStrands; b++) {
+      len = segmentKey( memo, a, b, key);
+      memo->found[a*nStrands + b] = (const segmentPlace *)
+        hash_get( memo->places, (const char *) key, len);
+    }
+  }
+  return 1;
+}
+
+
+/* ******************** */
+int SegmentMemoFetch( const segmentMemo *memo, int i, int j,
+                      DBL_TYPE *Q, DBL_TYPE *Qb, DBL_TYPE *Qm,
+                      DBL_TYPE *Qs, DBL_TYPE *Qms) {
+
+  const segmentPlace *place;
+  const keptFold *fold;
+  int a, shift, pf_ij, pf_kept;
+
+  if( i == 0 || j == memo->seqlength - 1) return 0;
+
+  a = memo->strandOf[i-1];
+  place = memo->found[ a*memo->nStrands + memo->strandOf[j+1]];
+  if( place == NULL) return 0;
+
+  fold = memo->kept + place->fold;
+  shift = place->start - memo->starts[a];
+  pf_ij = pf_index( i, j, memo->seqlength);
+  pf_kept = pf_index( i + shift, j + shift, fold->seqlength);
+
+  Q[ pf_ij] = fold->Q[ pf_kept];
+  Qb[ pf_ij] = fold->Qb[ pf_kept];
+  Qm[ pf_ij] = fold->Qm[ pf_kept];
+  Qs[ pf_ij] = fold->Qs[ pf_kept];
+  Qms[ pf_ij] = fold->Qms[ pf_kept];
+  return 1;
+}
+
+
+/* ******************** */
+static DBL_TYPE *copyMatrix( const DBL_TYPE *m, int arraySize) {
+
+  DBL_TYPE *copy = (DBL_TYPE *) malloc( arraySize*sizeof(DBL_TYPE));
+
+  memcpy( copy, m, arraySize*sizeof(DBL_TYPE));
+  return copy;
+}
+
+
+/* ******************** */
+void SegmentMemoKeep( segmentMemo *memo, const DBL_TYPE *Q,
+                      const DBL_TYPE *Qb, const DBL_TYPE *Qm,
+                      const DBL_TYPE *Qs, const DBL_TYPE *Qms) {
+
+  int nStrands = memo->nStrands;
+  int seqlength = memo->seqlength;
+  int arraySize = seqlength*(seqlength+1)/2 + (seqlength+1);
+  size_t bytes = 5*(size_t) arraySize*sizeof(DBL_TYPE);
+  int a, b, len, isNew = FALSE;
+  int key[ MAXSTRANDS+1];
+  segmentPlace *place;
+  keptFold *fold;
+
+  memo->nStrands = 0; // the strands only name one fold
+
+  for( a = 0; a < nStrands && !isNew; a++) {
+    for( b = a; b < nStrands && !isNew; b++) {
+      isNew = memo->found[a*nStrands + b] == NULL;
+    }
+  }
+  if( !isNew || memo->nBytes + bytes > memo->maxBytes) return;
+
+  if( memo->nKept == memo->keptAlloc) {
+    memo->keptAlloc = memo->keptAlloc ? 2*memo->keptAlloc : 16;
+    memo->kept = (keptFold *) realloc( memo->kept,
+                                       memo->keptAlloc*sizeof(keptFold));
+  }
+  fold = memo->kept + memo->nKept;
+  fold->seqlength = seqlength;
+  fold->Q = copyMatrix( Q, arraySize);
+  fold->Qb = copyMatrix( Qb, arraySize);
+  fold->Qm = copyMatrix( Qm, arraySize);
+  fold->Qs = copyMatrix( Qs, arraySize);
+  fold->Qms = copyMatrix( Qms, arraySize);
+  memo->nBytes += bytes;
+
+  for( a = 0; a < nStrands; a++) {
+    for( b = a; b < nStrands; b++) {
+      len = segmentKey( memo, a, b, key);
+      // an ordering may hold the same segment twice
+      if( memo->found[a*nStrands + b] != NULL ||
+          hash_get( memo->places, (const char *) key, len) != NULL) {
+        continue;
+      }
+
+      place = (segmentPlace *) malloc( sizeof(segmentPlace) + len);
+      place->fold = memo->nKept;
+      place->start = memo->starts[a];
+      memcpy( place->key, key, len);
+
+      if( memo->nPlaces == memo->placesAlloc) {
+        memo->placesAlloc = memo->placesAlloc ? 2*memo->placesAlloc : 64;
+        memo->allPlaces = (segmentPlace **)
+          realloc( memo->allPlaces, memo->placesAlloc*sizeof(segmentPlace *));
+      }
+      memo->allPlaces[ memo->nPlaces++] = place;
+      hash_add( memo->places, (const char *) place->key, len, place);
+    }
+  }
+  memo->nKept++;
+}
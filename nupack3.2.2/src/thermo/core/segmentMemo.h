@@ -0,0 +1,53 @@
+#ifndef __SEGMENTMEMO_H__
+#define __SEGMENTMEMO_H__
+
+#include "pfuncUtils.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Sharing of complexity = 3 partition function blocks between the
+   strand orderings of a complexes run.
+
+   The Q, Qb, Qm, Qs and Qms entries of an interval [i,j] only depend on
+   the bases i-1 to j+1 and the nicks among them.  So when that window
+   lies within a run of consecutive strands (a segment) that was already
+   folded, as part of another ordering or of a smaller complex, the
+   entries are copied from that fold instead of being recomputed.  Each
+   fold is kept (up to the memory bound) if it holds a segment not seen
+   before, and the memo only lives as long as the model settings do. */
+
+typedef struct segmentMemo segmentMemo;
+
+// folds keep at most this many bytes of matrices
+#define SEGMENT_MEMO_MAX_BYTES ((size_t) 256 << 20)
+
+// when set, pfuncFullWithSymHelper uses and fills this memo for the
+// calls that follow SegmentMemoSetStrands
+extern segmentMemo *SEGMENT_MEMO;
+
+segmentMemo *NewSegmentMemo( size_t maxBytes);
+void FreeSegmentMemo( segmentMemo *memo);
+
+//names the strands of the next fold; codes[s] must identify the
+//sequence of strand s for the whole life of the memo
+void SegmentMemoSetStrands( segmentMemo *memo, const int codes[], int nStrands);
+
+//called by pfuncFullWithSymHelper.  Begin returns 0 if the fold is not
+//the one SegmentMemoSetStrands announced; Fetch returns 1 if it filled
+//the entries of [i,j]; Keep records the finished fold.
+int SegmentMemoBegin( segmentMemo *memo, int seqlength, int nStrands,
+                      const int nicks[]);
+int SegmentMemoFetch( const segmentMemo *memo, int i, int j,
+                      DBL_TYPE *Q, DBL_TYPE *Qb, DBL_TYPE *Qm,
+                      DBL_TYPE *Qs, DBL_TYPE *Qms);
+void SegmentMemoKeep( segmentMemo *memo, const DBL_TYPE *Q,
+                      const DBL_TYPE *Qb, const DBL_TYPE *Qm,
+                      const DBL_TYPE *Qs, const DBL_TYPE *Qms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
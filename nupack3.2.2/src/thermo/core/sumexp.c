@@ -150,13 +150,8 @@ void fastILoops( int i, int j, int L, int seqlength, int seq[],
   int pf_ij = pf_index( i, j, seqlength);
   DBL_TYPE extraTerms;
 
-  int isEndNicked = FALSE;
-  if( etaN[ EtaNIndex( i-0.5,i-0.5, seqlength)][0] == 1 || 
-     etaN[ EtaNIndex( j+0.5,j+0.5, seqlength)][0] == 1) 
-    isEndNicked = TRUE;
-  if( L >= 12) {
-    makeNewQx( i, j, seq, seqlength, etaN, Qb, Qx);
-  }
+  //completes Qx(i,j); the Qx_2 entries it extends are only read for L+2
+  fastILoopsQx( i, j, L, seqlength, seq, etaN, Qb, Qx, Qx_2);
 
   //Use extensible cases              
   if( CanPair( seq[ i], seq[j]) == TRUE) {
@@ -173,10 +168,6 @@ void fastILoops( int i, int j, int L, int seqlength, int seq[],
     }
   }
 
-  if( L >= 12 && i != 0 && j != seqlength -1 && isEndNicked == FALSE) {
-    extendOldQx( i, j, seqlength, Qx,Qx_2);
-  }
-  
   /* Add in inextensible cases */  
   if( CanPair( seq[ i], seq[j]) == TRUE) {
     //first check inextensible cases
@@ -187,6 +178,23 @@ void fastILoops( int i, int j, int L, int seqlength, int seq[],
   } 
 }
 
+/* *************** */
+void fastILoopsQx( int i, int j, int L, int seqlength, int seq[],
+                   int **etaN, DBL_TYPE *Qb, DBL_TYPE *Qx, DBL_TYPE *Qx_2) {
+
+  int isEndNicked = FALSE;
+  if( etaN[ EtaNIndex( i-0.5,i-0.5, seqlength)][0] == 1 || 
+     etaN[ EtaNIndex( j+0.5,j+0.5, seqlength)][0] == 1) 
+    isEndNicked = TRUE;
+  if( L >= 12) {
+    makeNewQx( i, j, seq, seqlength, etaN, Qb, Qx);
+  }
+
+  if( L >= 12 && i != 0 && j != seqlength -1 && isEndNicked == FALSE) {
+    extendOldQx( i, j, seqlength, Qx,Qx_2);
+  }
+}
+
 /* *************** */
 
 /* Qs, Qms  Recursion */
@@ -203,6 +211,7 @@ void MakeQs_Qms( int i, int j, int seq[], int seqlength,
   int nNicks;
   int index_ij = EtaNIndex( i+0.5, j-0.5, seqlength);
   int start;
+  int k;
 
   nNicks = etaN[ index_ij][0];
   if( nNicks >= 1) {
@@ -212,11 +221,12 @@ void MakeQs_Qms( int i, int j, int seq[], int seqlength,
     start = i+4;
   }
 
-  for( d = start; d <= j; d++) {
+  for( k = FirstPairPartner( i, start); k < pairPartnerStart[i+1]; k++) {
+    d = pairPartners[k];
+    if( d > j) break;
     bp_penalty = 0.0;
     
-    if( CanPair( seq[i], seq[ d]) == TRUE &&
-       CanWCPair(seq[i], seq[d])) {
+    if( CanWCPair(seq[i], seq[d])) {
          
          if( seq[i] != BASE_C && seq[d] != BASE_C) {
            bp_penalty = AT_PENALTY;
@@ -302,6 +312,7 @@ void makeNewQx( int i, int j, int seq[], int seqlength,
 
   DBL_TYPE energy;
   int d, e; //Internal pair.(d, e will be restricted to special cases)
+  int k;
 
   int size, L1, L2; //size parameters: L1 + L2 = size, L1 = h-i-1, L2 = j-m-1
 
@@ -312,12 +323,14 @@ void makeNewQx( int i, int j, int seq[], int seqlength,
   L1 = 4;
   d = i + L1 + 1;
 
-  for( L2 = 4; L2 <= j - d - 2; L2++) {
+  //partners e of d with L2 = 4, 5, ..., i.e. e = j-5 down to d+1
+  for( k = FirstPairPartner( d, j - 4) - 1;
+       k >= pairPartnerStart[d] && pairPartners[k] > d; k--) {
+    e = pairPartners[k];
+    L2 = j - e - 1;
     size = L1 + L2;
-    e = j - L2 - 1;
 
-    if( CanPair( seq[d], seq[e]) == TRUE &&
-      (etaN[ EtaNIndex(i+0.5, d-0.5,seqlength)][0] == 0) &&
+    if( (etaN[ EtaNIndex(i+0.5, d-0.5,seqlength)][0] == 0) &&
       (etaN[ EtaNIndex(e+0.5, j-0.5,seqlength)][0] == 0) ) {
 
         energy = asymmetryEfn( L1, L2, size) + InteriorMM( seq[e], seq[d], seq[e+1], seq[d-1]);
@@ -335,12 +348,13 @@ void makeNewQx( int i, int j, int seq[], int seqlength,
   //Case 2  L1 > 4, L2 = 4
   L2 = 4;
   e = j - L2 -1;
-  for( L1 = 5; L1 <= e-i-2; L1++) {
+  for( k = FirstPairPartner( e, i + 6);
+       k < pairPartnerStart[e+1] && pairPartners[k] < e; k++) {
+    d = pairPartners[k];
+    L1 = d - i - 1;
     size = L1 + L2;
-    d = i + L1 + 1;
 
-    if( CanPair( seq[d], seq[e]) == TRUE &&
-      (etaN[ EtaNIndex(i+0.5, d-0.5,seqlength)][0] == 0) &&
+    if( (etaN[ EtaNIndex(i+0.5, d-0.5,seqlength)][0] == 0) &&
       (etaN[ EtaNIndex(e+0.5, j-0.5,seqlength)][0] == 0) ) {
 
         energy = asymmetryEfn( L1, L2, size) + InteriorMM( seq[e], seq[d], seq[e+1], seq[d-1]);
@@ -404,6 +418,7 @@ DBL_TYPE SumExpInextensibleIL( int i, int j, int seq[], int seqlength,
   // int nse=0;
   int d, e; //Internal pair.(h, m will be restricted to special cases)  
   int L1, L2; //size parameters: L1 + L2 = size, L1 = h-i-1, L2 = j-m-1
+  int k;
 
   DBL_TYPE sumexp = 0.0;
 
@@ -430,11 +445,13 @@ DBL_TYPE SumExpInextensibleIL( int i, int j, int seq[], int seqlength,
   // Case 2a  L1 = 0,1,2,3, L2 >= 4;
   for( L1 = 0; L1 <= 3; L1++) {
     d = i + L1 + 1;
-    for( L2 = 4; L2 <= j - d - 2; L2++) {
-      e = j - L2 - 1;
+    if( j - d - 2 < 4) continue;
+    //partners e of d with L2 = 4, 5, ..., i.e. e = j-5 down to d+1
+    for( k = FirstPairPartner( d, j - 4) - 1;
+         k >= pairPartnerStart[d] && pairPartners[k] > d; k--) {
+      e = pairPartners[k];
 
-      if( CanPair( seq[d], seq[e]) == TRUE &&
-         (etaN[ EtaNIndex(i+0.5, d-0.5,seqlength)][0] == 0) &&
+      if( (etaN[ EtaNIndex(i+0.5, d-0.5,seqlength)][0] == 0) &&
          (etaN[ EtaNIndex(e+0.5, j-0.5,seqlength)][0] == 0) ) {
 
            energy = InteriorEnergy( i, j, d, e, seq);
@@ -448,11 +465,13 @@ DBL_TYPE SumExpInextensibleIL( int i, int j, int seq[], int seqlength,
   // Case 2b L1 >= 4, L2 = 0,1,2,3;
   for( L2 = 0; L2 <= 3; L2++) {
     e = j - L2 - 1;
-    for( L1 = 4;  L1 <= e - i - 2; L1++) {
-      d = i + L1 + 1;
+    if( e - i - 2 < 4) continue;
+    //partners d of e with L1 = 4, 5, ..., i.e. d = i+5 up to e-1
+    for( k = FirstPairPartner( e, i + 5);
+         k < pairPartnerStart[e+1] && pairPartners[k] < e; k++) {
+      d = pairPartners[k];
 
-      if( CanPair( seq[d], seq[e]) == TRUE &&
-         (etaN[ EtaNIndex(i+0.5, d-0.5,seqlength)][0] == 0) &&
+      if( (etaN[ EtaNIndex(i+0.5, d-0.5,seqlength)][0] == 0) &&
          (etaN[ EtaNIndex(e+0.5, j-0.5,seqlength)][0] == 0) ) {
 
            energy = InteriorEnergy( i, j, d, e, seq);
@@ -476,40 +495,40 @@ DBL_TYPE SumExpInterior_Multi( int i, int j, int seq[], int seqlength,
 
   DBL_TYPE sum_expl = 0.0;
   int d, e; // d - e is internal basepair 
+  int k;
   DBL_TYPE bp_penalty = 0;
   // int S1 = j-i+1;
   // int S2;
   // int S3;
 
   for( d = i+1; d <= j - 5; d++) {
-    for( e = d + 4; e <= j - 1; e++) {
+    for( k = FirstPairPartner( d, d + 4); k < pairPartnerStart[d+1]; k++) {
+      e = pairPartners[k];
+      if( e > j - 1) break;
       //  S2 = e-d+1;
       //  S3 = d-i-1;
-      
-      if( CanPair( seq[d], seq[e]) == TRUE) {
-        bp_penalty = 0.0;
+      bp_penalty = 0.0;
 
-        sum_expl += 
-          ExplInternal( i, j, d, e, seq) *
-          Qb[ pf_index( d, e, seqlength) ];
+      sum_expl += 
+        ExplInternal( i, j, d, e, seq) *
+        Qb[ pf_index( d, e, seqlength) ];
 
-        if( seq[d] != BASE_C && seq[e] != BASE_C) {
-          bp_penalty = AT_PENALTY;
-        }
-        if( seq[i] != BASE_C && seq[j] != BASE_C) {
-          bp_penalty += AT_PENALTY;
-        }
+      if( seq[d] != BASE_C && seq[e] != BASE_C) {
+        bp_penalty = AT_PENALTY;
+      }
+      if( seq[i] != BASE_C && seq[j] != BASE_C) {
+        bp_penalty += AT_PENALTY;
+      }
 
-        if( d>= i+6 && CanWCPair(seq[d], seq[e]) &&
-           CanWCPair(seq[i], seq[j])) {
+      if( d>= i+6 && CanWCPair(seq[d], seq[e]) &&
+         CanWCPair(seq[i], seq[j])) {
 
-             sum_expl += 
-               Qm[ pf_index(i+1, d-1, seqlength)] *
-               Qb[ pf_index( d, e, seqlength)] *
-               EXP_FUNC( -(ALPHA_1 + 2*ALPHA_2 + ALPHA_3*(j-e-1) + bp_penalty)/
-                    (kB*TEMP_K) )*
-               ExplDangle( e+1, j-1, seq, seqlength);
-        }
+           sum_expl += 
+             Qm[ pf_index(i+1, d-1, seqlength)] *
+             Qb[ pf_index( d, e, seqlength)] *
+             EXP_FUNC( -(ALPHA_1 + 2*ALPHA_2 + ALPHA_3*(j-e-1) + bp_penalty)/
+                  (kB*TEMP_K) )*
+             ExplDangle( e+1, j-1, seq, seqlength);
       }
     }
   }
@@ -46,6 +46,11 @@ void fastILoops( int i, int j, int L, int seqlength, int seq[],
                  DBL_TYPE *Qb, DBL_TYPE *Qx, DBL_TYPE *Qx_2,
                  DBL_TYPE *Qb_bonus);
 
+//The Qx bookkeeping of fastILoops alone, for an interval whose Qb is
+//already known (see segmentMemo.h)
+void fastILoopsQx( int i, int j, int L, int seqlength, int seq[],
+                   int **etaN, DBL_TYPE *Qb, DBL_TYPE *Qx, DBL_TYPE *Qx_2);
+
 
 //makeNewQx creates new "extensible" base cases for the interval i,j.
 void makeNewQx( int i, int j, int seq[], int seqlength,
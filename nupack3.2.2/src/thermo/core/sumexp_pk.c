@@ -72,7 +72,7 @@ void MakeQg_N5( int i, int j, int seq[], int seqlength, DBL_TYPE *Qg,
 
   //  Make the gap matrix for Qg
   int c,d,e,f;
-  int gap_idej;
+  long int gap_idej;
   DBL_TYPE IJ_bp_penalty = 0.0;
   DBL_TYPE bp_penalty = 0;
 
@@ -242,7 +242,7 @@ void fastIloop_Qg(int i, int j, int seq[], int seqlength,
   int pf_ij = pf_index(i, j, seqlength);
   int index;
   DBL_TYPE ExplInteriorMM = NAD_INFINITY;
-  int gap_idej;
+  long int gap_idej;
   
   if( CanPair( seq[i], seq[j]) == TRUE) {
     ExplInteriorMM = EXP_FUNC( -InteriorMM( seq[i], seq[j], seq[i+1], 
@@ -327,7 +327,7 @@ void MakeQgrs( int i, int j, int seq[], int seqlength, DBL_TYPE *Qg,
               DBL_TYPE *Qm, DBL_TYPE *Qgrs) {
                 
   int d, e, f;
-  int gap_idej;
+  long int gap_idej;
   DBL_TYPE bp_penalty = 0;
   
   for( d = i + 1; d <= j-10; d++) {
@@ -362,7 +362,7 @@ void MakeQgl( int i, int j, int seq[], int seqlength,
                //make sure to call this AFTER MakeQg and BEFORE MakeQgr
                
   int d, e, f;
-  int gap_idfj;
+  long int gap_idfj;
   DBL_TYPE bp_penalty = 0.0;
 
   for( d = i+1; d <= j-5; d++) {
@@ -394,7 +394,7 @@ void MakeQgr( int i, int j, int seq[], int seqlength,
  //make sure to call this AFTER MakeQg and AFTER MakeQgl
  
   int d, e, f;
-  int gap_idej;
+  long int gap_idej;
 
 
   for( d = i+1; d <= j-3; d++) {
@@ -882,7 +882,7 @@ void MakeQg_N8( int i, int j, char seq[], int seqlength, DBL_TYPE Qg[],
                DBL_TYPE Qm[]) {
   //  Make the gap matrix for Qg
   int c,d,e,f;
-  int gap_idej;
+  long int gap_idej;
   DBL_TYPE IJ_bp_penalty = 0.0;
   DBL_TYPE bp_penalty = 0;
 
@@ -0,0 +1,222 @@
+/*
+  sweep.c is part of the NUPACK software suite
+  Copyright (c) 2007 Caltech. All rights reserved.
+
+  Melt curves and salt titrations: evaluate the ensemble free energy,
+  enthalpy, entropy and the mfe of one sequence over a grid of
+  temperatures and sodium concentrations in a single run.
+*/
+
+/* fork, pipe, waitpid, sysconf (the build uses -std=c99) */
+#define _XOPEN_SOURCE 700
+
+#include "sweep.h"
+#include "init.h"
+#include "mfeUtils.h"
+#include "pf.h"
+
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern double SweepT[3]; // start, stop, step (C); step == 0 for no sweep
+extern double SweepSodium[3]; // start, stop, step (M)
+extern int SweepJobs; // worker processes, 0 = number of online cpus
+
+typedef struct {
+  int index;
+  sweepCondition cond;
+} sweepRecord;
+
+/* ******************** */
+int SweepRequested( void) {
+  return SweepT[2] > 0 || SweepSodium[2] > 0;
+}
+
+/* ******************** */
+static int sweepPoints( const double range[3]) {
+  if( range[2] <= 0) return 1;
+  return (int) ((range[1] - range[0]) / range[2] + 1e-9) + 1;
+}
+
+/* ******************** */
+int MakeSweepConditions( sweepCondition **conds) {
+  int nT = sweepPoints( SweepT);
+  int nNa = sweepPoints( SweepSodium);
+  int i, j, k = 0;
+
+  *conds = (sweepCondition *) calloc( nT*nNa, sizeof( sweepCondition));
+  if( *conds == NULL) {
+    fprintf( stderr, "MakeSweepConditions: unable to allocate %d conditions\n",
+             nT*nNa);
+    exit(1);
+  }
+
+  for( i = 0; i < nT; i++) {
+    for( j = 0; j < nNa; j++) {
+      (*conds)[k].temperature = SweepT[2] > 0 ?
+        SweepT[0] + i*SweepT[2] : TEMP_K - ZERO_C_IN_KELVIN;
+      (*conds)[k].sodium = SweepSodium[2] > 0 ?
+        SweepSodium[0] + j*SweepSodium[2] : SODIUM_CONC;
+      k++;
+    }
+  }
+  return k;
+}
+
+/* ******************** */
+static DBL_TYPE sweepFreeEnergy( int seqNum[], int complexity,
+                                 int permSymmetry, DBL_TYPE temperature,
+                                 DBL_TYPE sodium) {
+  DBL_TYPE pf = pfuncFullWithSym( seqNum, complexity, DNARNACOUNT,
+                                  DANGLETYPE, temperature, 0, permSymmetry,
+                                  sodium, MAGNESIUM_CONC,
+                                  USE_LONG_HELIX_FOR_SALT_CORRECTION);
+  return -kB*(temperature + ZERO_C_IN_KELVIN)*LOG_FUNC( pf);
+}
+
+/* ******************** */
+static void evaluateCondition( int seqNum[], int seqLen, int complexity,
+                               int permSymmetry, sweepCondition *c) {
+  DBL_TYPE gLow, gHigh;
+  dnaStructures mfeStructs = {NULL, 0, 0, 0, NAD_INFINITY};
+
+  c->freeEnergy = sweepFreeEnergy( seqNum, complexity, permSymmetry,
+                                   c->temperature, c->sodium);
+
+  // S = -dG/dT, H = G + TS
+  gLow = sweepFreeEnergy( seqNum, complexity, permSymmetry,
+                          c->temperature - SWEEP_DT, c->sodium);
+  gHigh = sweepFreeEnergy( seqNum, complexity, permSymmetry,
+                           c->temperature + SWEEP_DT, c->sodium);
+  c->entropy = -(gHigh - gLow) / (2*SWEEP_DT);
+  c->enthalpy = c->freeEnergy +
+    (c->temperature + ZERO_C_IN_KELVIN)*c->entropy;
+
+  c->mfe = mfeFullWithSym( seqNum, seqLen, &mfeStructs, complexity,
+                           DNARNACOUNT, DANGLETYPE, c->temperature,
+                           permSymmetry, 1, c->sodium, MAGNESIUM_CONC,
+                           USE_LONG_HELIX_FOR_SALT_CORRECTION);
+  clearDnaStructures( &mfeStructs);
+}
+
+/* ******************** */
+void RunSweep( int seqNum[], int seqLen, int complexity, int permSymmetry,
+               sweepCondition *conds, int nConds, int nJobs) {
+
+  int fds[2];
+  int w, k, status, nDone = 0;
+  pid_t *workers;
+  sweepRecord rec;
+
+  if( nJobs <= 0) nJobs = (int) sysconf( _SC_NPROCESSORS_ONLN);
+  if( nJobs > nConds) nJobs = nConds;
+
+  // parse the parameter files here so that every worker inherits them
+  LoadEnergies();
+
+  if( nJobs <= 1) {
+    for( k = 0; k < nConds; k++) {
+      evaluateCondition( seqNum, seqLen, complexity, permSymmetry, &conds[k]);
+    }
+    return;
+  }
+
+  if( pipe( fds) != 0) {
+    fprintf( stderr, "RunSweep: unable to create pipe\n");
+    exit(1);
+  }
+  workers = (pid_t *) malloc( nJobs*sizeof( pid_t));
+  fflush( NULL);
+
+  for( w = 0; w < nJobs; w++) {
+    workers[w] = fork();
+    if( workers[w] < 0) {
+      fprintf( stderr, "RunSweep: unable to start worker %d\n", w);
+      exit(1);
+    }
+    if( workers[w] == 0) {
+      // records are far smaller than PIPE_BUF, so workers can share the pipe
+      close( fds[0]);
+      for( k = w; k < nConds; k += nJobs) {
+        rec.index = k;
+        rec.cond = conds[k];
+        evaluateCondition( seqNum, seqLen, complexity, permSymmetry,
+                           &rec.cond);
+        if( write( fds[1], &rec, sizeof( rec)) != (ssize_t) sizeof( rec)) {
+          _exit(1);
+        }
+      }
+      close( fds[1]);
+      _exit(0);
+    }
+  }
+
+  close( fds[1]);
+  while( read( fds[0], &rec, sizeof( rec)) == (ssize_t) sizeof( rec)) {
+    conds[ rec.index] = rec.cond;
+    nDone++;
+  }
+  close( fds[0]);
+
+  for( w = 0; w < nJobs; w++) {
+    waitpid( workers[w], &status, 0);
+  }
+  free( workers);
+
+  if( nDone != nConds) {
+    fprintf( stderr, "RunSweep: only %d of %d conditions completed\n",
+             nDone, nConds);
+    exit(1);
+  }
+}
+
+/* ******************** */
+void PrintSweepTable( FILE *out, const sweepCondition *conds, int nConds) {
+  int k;
+
+  fprintf( out, "%s T (C)\t[Na+] (M)\tG (kcal/mol)\tH (kcal/mol)\t"
+           "S (kcal/mol/K)\tMFE (kcal/mol)\n", COMMENT_STRING);
+  for( k = 0; k < nConds; k++) {
+    if( !NUPACK_VALIDATE) {
+      fprintf( out, "%.2f\t%.4f\t%.8Le\t%.8Le\t%.8Le\t%.3Lf\n",
+               (double) conds[k].temperature, (double) conds[k].sodium,
+               (long double) conds[k].freeEnergy,
+               (long double) conds[k].enthalpy,
+               (long double) conds[k].entropy, (long double) conds[k].mfe);
+    }
+    else {
+      fprintf( out, "%.2f\t%.4f\t%.14Le\t%.14Le\t%.14Le\t%.14Le\n",
+               (double) conds[k].temperature, (double) conds[k].sodium,
+               (long double) conds[k].freeEnergy,
+               (long double) conds[k].enthalpy,
+               (long double) conds[k].entropy, (long double) conds[k].mfe);
+    }
+  }
+}
+
+/* ******************** */
+void PrintSweepProvenance( FILE *out, const sweepCondition *conds,
+                           int nConds) {
+  int k;
+  const char *fmt = NUPACK_VALIDATE ?
+    "{\"temperature (C)\": %.2f, \"concentration Na (M)\": %.4f, "
+    "\"free energy (Kcal/mol)\": %.14Le, \"enthalpy (Kcal/mol)\": %.14Le, "
+    "\"entropy (Kcal/mol/K)\": %.14Le, "
+    "\"minimum free energy (Kcal/mol)\": %.14Le}" :
+    "{\"temperature (C)\": %.2f, \"concentration Na (M)\": %.4f, "
+    "\"free energy (Kcal/mol)\": %.8Le, \"enthalpy (Kcal/mol)\": %.8Le, "
+    "\"entropy (Kcal/mol/K)\": %.8Le, "
+    "\"minimum free energy (Kcal/mol)\": %.3Lf}";
+
+  fprintf( out, "\"sweep\": [");
+  for( k = 0; k < nConds; k++) {
+    fprintf( out, k == 0 ? "" : ", ");
+    fprintf( out, fmt,
+             (double) conds[k].temperature, (double) conds[k].sodium,
+             (long double) conds[k].freeEnergy,
+             (long double) conds[k].enthalpy,
+             (long double) conds[k].entropy, (long double) conds[k].mfe);
+  }
+  fprintf( out, "] }\n");
+}
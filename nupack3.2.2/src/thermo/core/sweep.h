@@ -0,0 +1,50 @@
+#ifndef __SWEEP_H__
+#define __SWEEP_H__
+
+#include "pfuncUtils.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Temperature / salt sweeps (pfunc and mfe -Tsweep, -saltsweep).  All
+   conditions of a sweep are evaluated by one process: the parameter
+   files are read once, and the conditions are split among -sweepjobs
+   forked workers (the energy model lives in globals, so workers are
+   processes rather than threads). */
+
+typedef struct {
+  DBL_TYPE temperature; //C
+  DBL_TYPE sodium; //M
+  DBL_TYPE freeEnergy; //ensemble free energy, kcal/mol
+  DBL_TYPE enthalpy; //ensemble enthalpy, kcal/mol
+  DBL_TYPE entropy; //ensemble entropy, kcal/mol/K
+  DBL_TYPE mfe; //kcal/mol
+} sweepCondition;
+
+//half width (K) of the central difference used for the ensemble entropy
+#define SWEEP_DT 0.1
+
+//returns 1 if -Tsweep or -saltsweep was given
+int SweepRequested( void);
+
+//allocates *conds with the requested (temperature x sodium) grid and
+//returns its size.  Unswept quantities are taken from -T and -sodium.
+int MakeSweepConditions( sweepCondition **conds);
+
+//fills the energies of conds[0..nConds-1] for the sequence seqNum
+//(seqLen as passed to mfeFullWithSym), using up to nJobs processes
+void RunSweep( int seqNum[], int seqLen, int complexity, int permSymmetry,
+               sweepCondition *conds, int nConds, int nJobs);
+
+//one line per condition, columns T, [Na+], G, H, S, MFE
+void PrintSweepTable( FILE *out, const sweepCondition *conds, int nConds);
+
+//the same table as a "sweep" array closing the mfe provenance object
+void PrintSweepProvenance( FILE *out, const sweepCondition *conds, int nConds);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif
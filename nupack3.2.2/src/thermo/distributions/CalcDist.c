@@ -12,11 +12,12 @@
 
   The set $\Lambda$ is the set of all possible populations in a box
   containing a solution of complexes such that mass is conserved.
-  This program enumerates all entries in $\Lambda$ and calculates
-  their probabilty of occuring at equilibrium.  From this calculation,
-  the partition function for the box, the probability distributions
-  for the counts for each complex species, and the expectation value
-  for the counts of each complex species.
+  This program calculates the partition function for the box, the
+  probability distributions for the counts for each complex species,
+  and the expectation value for the counts of each complex species.
+  These are sums over $\Lambda$, evaluated by convolution over the
+  strand counts without listing its entries (see BoxDistributions);
+  $\Lambda$ is only enumerated when it is to be written out.
 
   The inputs are as follows:
   A: A 2-D array; A[i][j] is the number of monomers of type i in complex j
@@ -26,7 +27,10 @@
   M: The number of solvent molecules in the box.
   numSS: The number of single-species (monomers) in the system.
   numTotal: The total number of complexes.
-  MaxSizeLambda: The maximum number of elements in the set $\Lambda$.
+  MaxSizeLambda: The maximum number of elements in the set $\Lambda$
+                 (only used when it is written out).
+  StatesJobs: The number of processes writing out $\Lambda$, 0 for one
+              per online cpu.
   eqFile: The file to which the expectation values for the counts of the complexes
           is written.
   probFile: The file to which the probability distributions for each complex
@@ -40,406 +44,846 @@
   For formats of the input and output files, etc., see the associated README file.
 */
 
+/* fork, waitpid, sysconf, mmap (the build uses -std=c99) */
+#define _DEFAULT_SOURCE
+
 #include "CalcDist.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>  // Must compile with -lm option
+#include <limits.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 #include "constants.h"
 
 
 /* ******************************************************************************** */
-/*                                BEGIN CALCDIST                                    */
+/*                           BEGIN BOX PARTITION FUNCTION                           */
 /* ******************************************************************************** */
-void CalcDist(double *mEq, double **Pmn, int **A, double *G, int *m0, double M, 
-          int numSS, int numTotal, double MaxSizeLambda, char *LambdaFile, 
-          double kT, int WriteLambda, int *CompIDArray, int *PermIDArray,
-          int quiet, char *logFile, int WriteLogFile, int NoPermID) {
-
-  int i,j,k,n; // Counters, i: single-species, j: complexes, k: comb. of complexes
-  int numComplex; // Number of complexes that are not single-species
-  int LastInc; // Last entry in mComplex that was incremented
-  int *mMax; // the maximal allowed count of each species
-  int *mComplex; // Temporary array storing the counts of complexes excl. single-spec.
-  int **Lambda; // Populations that satisfy conservation of mass
-  double *logP; // Log of the probabilities for each element in Lambda
-  double *P; // Probability for each element in Lambda
-  long double Qbox; // The partition function (Q_box) 
-  long double addQbox; // One term in the sum of Q_box 
-  double FreeEnergy; // The free energy of the system.
-  int SizeLambda; // The length of lambda
-  double logM; // log of total numbers of particles
-  double RefSum; // Term added to partition function to define reference state
-  int maxm0; // Maximal entry in m0
-  FILE *fpLam; // The file to which the elements of Lambda are written
-  FILE *fplog; // file handle for log file
+/*
+  Q_{box} is a sum over populations of a product over complexes, so it
+  is the coefficient of y^{m0} in prod_j F_j(y), where
+  F_j(y) = sum_n (M e^{-G_j})^n / n! y^{A_j n} and y^{A_j n} stands for
+  prod_i y_i^{A[i][j] n}.  The product is built one complex at a time
+  on the box of strand counts 0 <= r_i <= m0_i, in log space, without
+  enumerating Lambda.  The distribution of m_j is read off the product
+  of all the other factors, and those leave-one-out products are
+  formed by halving the list of complexes, so all of them together
+  cost O(numTotal log numTotal) convolutions.
+*/
 
-  // Preliminaries: get constants
-  numComplex = numTotal - numSS;
-  logM = log(M);
-  RefSum = 0;
-  for (i = 0; i < numSS; i++) {
-    RefSum += m0[i]*(G[i] - logM)+ log(factorial(m0[i]));
-  }
-  maxm0 = maxint(m0,numSS);
+typedef struct {
+  int numSS;
+  int numTotal;
+  int *m0;
+  int **A;
+  size_t nStates; // prod_i (m0_i + 1)
+  size_t *stride; // position of r is sum_i r_i*stride[i]
+  size_t *offset; // position of A_j, i.e. the shift made by one copy of complex j
+  double *logW; // logW[j] = log M - G_j, the log weight of one copy of complex j
+  double **logTerm; // logTerm[j][n] = n*logW[j] - log(n!)
+  double **stack; // one table per level of DistLeaves
+  double *invFact; // invFact[n] = 1/n!, 0 past the range of a double
+  int *r; // scratch strand counts
+  double *chainLog; // scratch chain of ConvolveComplex, in log space
+  double *chain; // and scaled to linear
+} DistBox;
 
-  /* **************** Allocate memory for arrays ************* */
-  Lambda = (int **) malloc(((int)(MaxSizeLambda)) * sizeof(int *));
-  mMax = (int *) malloc(numComplex * sizeof(int));
-  mComplex = (int *) malloc(numComplex * sizeof(int));
-  /* ********************************************************* */
 
+/* ******************************************************************************** */
+static double LogSumExp2(double a, double b) {
+  /*
+    log(e^a + e^b), with -INFINITY standing for log(0).
+  */
 
-  // Calculate maximal counts based on exhausting limiting monomer
-  for (j = 0; j < numComplex; j++) {
-    mMax[j] = 0;
-    for (i = 0; i < numSS; i++) {
-      if (A[i][numSS+j] > 0) {
-        mMax[j] = max2(floor(m0[i]/A[i][numSS+j]),mMax[j]);
-      }
-    }
+  if (a < b) {
+    double t = a;
+    a = b;
+    b = t;
   }
-
-  // Initialialize mComplex
-  for (j = 0; j < numComplex; j++) {
-    mComplex[j] = 0;
+  if (b == -INFINITY) {
+    return a;
   }
+  return a + log1p(exp(b - a));
+}
+/* ******************************************************************************** */
 
-  // Get the list of populations  
-  // First write the trivial population (all single-stranded)
-  UpdateLambda(&Lambda,0,mComplex,m0,A,numSS,numTotal);
 
-  LastInc = numComplex - 1;
-  SizeLambda = 1;
-  while (LastInc >= 0) {
-    LastInc = next(mComplex,m0,A,numSS,numComplex,numTotal,mMax,LastInc);
-    if (LastInc == numComplex-1) {
-      UpdateLambda(&Lambda,SizeLambda,mComplex,m0,A,numSS,numTotal);
-      SizeLambda++;
-    }
+/* ******************************************************************************** */
+static int MaxCopies(DistBox *box, int j, int *r) {
+  /*
+    The largest n such that r - n A_j stays nonnegative.
+  */
 
-    if (SizeLambda >= MaxSizeLambda) {
-      if (quiet == 0) {
-        printf("Exceeded maximum number of %g combinations!\n",MaxSizeLambda);
-        printf("Try increasing the maximal size of Lambda or\n");
-        printf("try using NUPACK's concentrations program to analyze\n");
-        printf("larger systems.\n\nExiting...\n");
-      }
-      exit(ERR_LAMBDATOOBIG);
-    }
-  }
+  int i;
+  int n = INT_MAX;
 
-  // Write out  the number of populations in Lambda
-  if (WriteLogFile) {
-    if ((fplog = fopen(logFile,"a")) == NULL) {
-      if (quiet == 0) {
-        printf("Error opening %s.\n\nExiting....\n",logFile);
-      }
-      exit(ERR_LOG);
+  for (i = 0; i < box->numSS; i++) {
+    if (box->A[i][j] > 0 && r[i] / box->A[i][j] < n) {
+      n = r[i] / box->A[i][j];
     }
-    fprintf(fplog,"   --Number of populations in Lambda: %d\n",SizeLambda);
-    fclose(fplog);
   }
 
-  if (quiet == 0) {
-    printf("There are %d populations in Lambda.\n",SizeLambda);
-  }
+  return n;
+}
+/* ******************************************************************************** */
 
-  // Allocate memory for probabilities
-  logP = (double *) malloc(SizeLambda * sizeof(double));
-  P = (double *) malloc(SizeLambda * sizeof(double));
 
-  // Calculate terms in the partition function
-  Qbox = 0.0;
-  for (k = 0; k < SizeLambda; k++) {
-    logP[k] = 0;
-    
-    j = 1;
-    while (j < 2*Lambda[k][0]) {
-      logP[k] += Lambda[k][j+1]*(logM - G[Lambda[k][j]]) 
-      - log(factorial(Lambda[k][j+1]));
-      j = j + 2;
-    }
+/* ******************************************************************************** */
+static void ConvolveComplex(DistBox *box, int j, double *logQ) {
+  /*
+    Multiplies the table logQ (log of the coefficients of a product of
+    generating functions) by F_j in place.  F_j only couples positions
+    along a chain r, r + A_j, r + 2 A_j, ...; each chain is convolved
+    with the terms of F_j in linear arithmetic, after dividing the
+    m-th entry by (M e^{-G_j})^m and the whole chain by its largest
+    entry, so the kernel is 1/n! and nothing overflows.  Sums too small
+    to be free of underflowed entries are taken again in log space.
+  */
 
-    logP[k] += RefSum;
-    if ((addQbox = expl((long double) logP[k])) == HUGE_VAL) {
-      if (quiet == 0) {
-        printf("Overflow error in calculation of Q_{box}!\n");
-        printf("Free energies of complexes is too high or the box is too big.\n");
-        printf("Either adjust these or run the calculation on a large.\n");
-        printf("system using the program concentrations.\n");
-        printf("Exiting....\n\n");
-      }
-      exit(ERR_QBOXTOOBIG);
-    }
-    else {
-      Qbox += addQbox;
-    }
+  int i, m, n, len, start;
+  size_t k, pos;
+  double logScale, s, best;
+  int *r = box->r;
+  size_t off = box->offset[j];
+  double logW = box->logW[j];
+  double *logTerm = box->logTerm[j];
+  double *chainLog = box->chainLog;
+  double *chain = box->chain;
+  double *invFact = box->invFact;
+
+  for (i = 0; i < box->numSS; i++) {
+    r[i] = 0;
   }
 
-  FreeEnergy = -log(Qbox);
+  for (k = 0; k < box->nStates; k++) {
 
-  // Compute the probabilities of each element in Lambda
-  for (k = 0; k < SizeLambda; k++) {
-    logP[k] += FreeEnergy;
-    P[k] = exp(logP[k]);
-  }
+    // chains start where one fewer copy of complex j does not fit
+    start = 0;
+    for (i = 0; i < box->numSS; i++) {
+      if (r[i] < box->A[i][j]) {
+        start = 1;
+      }
+    }
 
+    if (start) {
+      // the chain runs until r + m A_j leaves the box
+      len = INT_MAX;
+      for (i = 0; i < box->numSS; i++) {
+        if (box->A[i][j] > 0 && (box->m0[i] - r[i]) / box->A[i][j] < len) {
+          len = (box->m0[i] - r[i]) / box->A[i][j];
+        }
+      }
+      len++;
 
-  // Write out Lambda if necessary
-  if (WriteLambda) {
-    if ((fpLam = fopen(LambdaFile,"a")) == NULL) {
-      if (quiet == 0) {
-        printf("Error in opening %s!\n\n",LambdaFile);
-        printf("Exiting...\n");
+      logScale = -INFINITY;
+      for (m = 0, pos = k; m < len; m++, pos += off) {
+        chainLog[m] = logQ[pos];
+        if (logQ[pos] - m*logW > logScale) {
+          logScale = logQ[pos] - m*logW;
+        }
       }
-      exit(ERR_LAMBDA);
-    }
-    else {
-      for (k = 0; k < SizeLambda; k++) {
-        // The probability of the population occuring
-        fprintf(fpLam,"%8.6e\t",P[k]);
-        j = 1;
-        if (NoPermID == 1) {
-          while (j < 2*Lambda[k][0]) {
-            fprintf(fpLam,"%d\t",CompIDArray[Lambda[k][j++]]);
-            fprintf(fpLam,"%d\t",Lambda[k][j++]);
-          }
+
+      if (logScale != -INFINITY) {
+        for (m = 0; m < len; m++) {
+          chain[m] = exp(chainLog[m] - m*logW - logScale);
         }
-        else {
-          while (j < 2*Lambda[k][0]) {
-            fprintf(fpLam,"%d\t",CompIDArray[Lambda[k][j]]);
-            fprintf(fpLam,"%d\t",PermIDArray[Lambda[k][j++]]);
-            fprintf(fpLam,"%d\t",Lambda[k][j++]);
+
+        for (m = 0, pos = k; m < len; m++, pos += off) {
+          s = 0.0;
+          for (n = 0; n <= m; n++) {
+            s += chain[m-n]*invFact[n];
+          }
+          if (s > DIST_MIN_LINEAR_SUM) {
+            logQ[pos] = log(s) + logScale + m*logW;
+          }
+          else {
+            best = -INFINITY;
+            for (n = 0; n <= m; n++) {
+              if (chainLog[m-n] + logTerm[n] > best) {
+                best = chainLog[m-n] + logTerm[n];
+              }
+            }
+            s = 0.0;
+            for (n = 0; n <= m && best != -INFINITY; n++) {
+              s += exp(chainLog[m-n] + logTerm[n] - best);
+            }
+            logQ[pos] = best + log(s);
           }
         }
-        fprintf(fpLam,"\n");
       }
-      fclose(fpLam);
+    }
+
+    // step r up to the next position
+    for (i = 0; i < box->numSS && r[i] == box->m0[i]; i++) {
+      r[i] = 0;
+    }
+    if (i < box->numSS) {
+      r[i]++;
     }
   }
+}
+/* ******************************************************************************** */
 
 
-  // Initialize Pmn
-  for (j = 0; j < numTotal; j++) {
+/* ******************************************************************************** */
+static void DistLeaves(DistBox *box, int lo, int hi, double *logQ, int depth,
+                       double **Pmn, int maxm0, double *logQbox) {
+  /*
+    logQ holds the product of F_j over every complex outside [lo,hi).
+    Fills Pmn for the complexes in [lo,hi); logQbox (without the
+    reference term) is taken from the first complex.
+  */
+
+  int j, n, nMax, mid;
+  size_t k, top;
+  double *half;
+  double logZ;
+
+  if (hi - lo == 1) {
+    // logQ is now the product of all factors but F_lo
+    for (j = 0; j < box->numSS; j++) {
+      box->r[j] = box->m0[j];
+    }
+    nMax = MaxCopies(box, lo, box->r);
+    top = box->nStates - 1;
+
+    logZ = -INFINITY;
+    for (n = 0; n <= nMax; n++) {
+      logZ = LogSumExp2(logZ, logQ[top - n*box->offset[lo]]
+                        + box->logTerm[lo][n]);
+    }
     for (n = 0; n <= maxm0; n++) {
-      Pmn[j][n] = 0.0;
+      Pmn[lo][n] = n > nMax ? 0.0 :
+        exp(logQ[top - n*box->offset[lo]] + box->logTerm[lo][n] - logZ);
     }
+    if (lo == 0) {
+      *logQbox = logZ;
+    }
+    return;
+  }
+
+  mid = (lo + hi) / 2;
+  half = box->stack[depth];
+
+  for (k = 0; k < box->nStates; k++) {
+    half[k] = logQ[k];
+  }
+  for (j = mid; j < hi; j++) {
+    ConvolveComplex(box, j, half);
   }
+  DistLeaves(box, lo, mid, half, depth + 1, Pmn, maxm0, logQbox);
 
-  // Put the elements in Pmn
-  for (k = 0; k < SizeLambda; k++) {
-    j = 1;
-    while (j < 2*Lambda[k][0]) {
-      Pmn[Lambda[k][j]][Lambda[k][j+1]] += P[k];
-      j = j + 2;
+  for (k = 0; k < box->nStates; k++) {
+    half[k] = logQ[k];
+  }
+  for (j = lo; j < mid; j++) {
+    ConvolveComplex(box, j, half);
+  }
+  DistLeaves(box, mid, hi, half, depth + 1, Pmn, maxm0, logQbox);
+}
+/* ******************************************************************************** */
+
+
+/* ******************************************************************************** */
+static double BoxDistributions(double **Pmn, int **A, double *G, int *m0,
+                               double logM, int numSS, int numTotal, int maxm0,
+                               int quiet) {
+  /*
+    Computes Pmn[j][n] = P(m_j = n) for every complex and returns the
+    log of the coefficient of y^{m0} in prod_j F_j(y).
+  */
+
+  int i, j, n, depth;
+  size_t k;
+  double logQbox = 0.0;
+  double *root;
+  DistBox box;
+
+  box.numSS = numSS;
+  box.numTotal = numTotal;
+  box.m0 = m0;
+  box.A = A;
+
+  box.stride = (size_t *) malloc(numSS * sizeof(size_t));
+  box.nStates = 1;
+  for (i = 0; i < numSS; i++) {
+    box.stride[i] = box.nStates;
+    if (box.nStates > ((size_t) -1) / sizeof(double) / (m0[i] + 1)) {
+      box.nStates = 0;
+      break;
     }
+    box.nStates *= m0[i] + 1;
   }
 
-  // The probability that the count is zero
-  for (j = 0; j < numTotal; j++) {
-    Pmn[j][0] = 1.0 - sum(Pmn[j],maxm0+1);
-    // Fix in case of precision error
-    if (Pmn[j][0] < 0.0) {
-      if (fabs(Pmn[j][0]) > NUM_PRECISION) {
-	printf("Error: negative probability encountered.\n\nExiting....\n");
-	exit(ERR_NEGATIVEPROB);
-      }
-      else {
-	Pmn[j][0] = 0.0;
-      }
+  for (depth = 1; (1 << (depth - 1)) < numTotal; depth++) ;
+  box.stack = (double **) malloc(depth * sizeof(double *));
+  for (i = 0; i < depth; i++) {
+    box.stack[i] = box.nStates == 0 ? NULL :
+      (double *) malloc(box.nStates * sizeof(double));
+  }
+  root = box.nStates == 0 ? NULL :
+    (double *) malloc(box.nStates * sizeof(double));
+
+  if (root == NULL || box.stack[depth-1] == NULL) {
+    if (quiet == 0) {
+      printf("Unable to allocate the table of strand counts for this box!\n");
+      printf("Try using NUPACK's concentrations program to analyze\n");
+      printf("larger systems.\n\nExiting...\n");
     }
+    exit(ERR_QBOXTOOBIG);
   }
 
-  // Calculate the equilibrium counts
+  box.offset = (size_t *) malloc(numTotal * sizeof(size_t));
+  box.logW = (double *) malloc(numTotal * sizeof(double));
+  box.logTerm = (double **) malloc(numTotal * sizeof(double *));
   for (j = 0; j < numTotal; j++) {
-    mEq[j] = 0;
+    box.offset[j] = 0;
+    for (i = 0; i < numSS; i++) {
+      box.offset[j] += A[i][j]*box.stride[i];
+    }
+    box.logW[j] = logM - G[j];
+    box.logTerm[j] = (double *) malloc((maxm0+1) * sizeof(double));
     for (n = 0; n <= maxm0; n++) {
-      mEq[j] += n*Pmn[j][n];
+      box.logTerm[j][n] = n*box.logW[j] - lgamma(n + 1.0);
     }
   }
+  box.r = (int *) malloc(numSS * sizeof(int));
+  box.chainLog = (double *) malloc((maxm0+1) * sizeof(double));
+  box.chain = (double *) malloc((maxm0+1) * sizeof(double));
+  box.invFact = (double *) malloc((maxm0+1) * sizeof(double));
+  box.invFact[0] = 1.0;
+  for (n = 1; n <= maxm0; n++) {
+    box.invFact[n] = box.invFact[n-1] > 1e-300 ? box.invFact[n-1] / n : 0.0;
+  }
 
-  // Write out free energy
-  if (WriteLogFile) {
-    if ((fplog = fopen(logFile,"a")) == NULL) {
-      if (quiet == 0) {
-        printf("Error opening %s.\n\nExiting....\n",logFile);
-      }
-      exit(ERR_LOG);
-    }
-    fprintf(fplog,"   --Free energy of the box: %8.6e kT, or %8.6e kcal\n",
-            FreeEnergy,FreeEnergy*kT/AVOGADRO);
-    fclose(fplog);
+  // The empty product: 1 at r = 0
+  root[0] = 0.0;
+  for (k = 1; k < box.nStates; k++) {
+    root[k] = -INFINITY;
   }
-  if (quiet == 0) {
-    printf("Free energy of the box: %8.6e kT, or %8.6e kcal\n",
-      FreeEnergy,FreeEnergy*kT/AVOGADRO);
+  DistLeaves(&box, 0, numTotal, root, 0, Pmn, maxm0, &logQbox);
+
+  for (j = 0; j < numTotal; j++) {
+    free(box.logTerm[j]);
+  }
+  for (i = 0; i < depth; i++) {
+    free(box.stack[i]);
   }
+  free(box.logTerm);
+  free(box.logW);
+  free(box.offset);
+  free(box.stride);
+  free(box.stack);
+  free(box.r);
+  free(box.chainLog);
+  free(box.chain);
+  free(box.invFact);
+  free(root);
+
+  return logQbox;
+}
+/* ******************************************************************************** */
+/*                            END BOX PARTITION FUNCTION                            */
+/* ******************************************************************************** */
+
+
+/* ******************************************************************************** */
+/*                               BEGIN POPULATIONS                                  */
+/* ******************************************************************************** */
+/*
+  With -writestates every population in Lambda is written out with its
+  probability.  The populations are generated one at a time in
+  lexicographic order of the complex counts (monomer counts follow
+  from conservation of mass), scored as they are generated and written
+  through a buffered stream, so nothing but the current population is
+  held in memory.  The populations are split by the counts of the
+  first complexes among forked workers, each writing its share to a
+  scratch file; the shares are then copied out in order.
+*/
+
+typedef struct {
+  int numSS;
+  int numTotal;
+  int **A;
+  int *m; // counts of every species; monomer entries hold what is left of m0
+  double *logW; // logW[j] = log M - G_j
+  double *logFact; // logFact[n] = log(n!)
+  int *CompIDArray;
+  int *PermIDArray;
+  int NoPermID;
+  char *line; // the population being written
+  FILE *fp;
+  long count; // populations written so far
+  double MaxSizeLambda;
+} StatesWriter;
 
 
-  // Free memory
-  free(mMax);
-  for (k = 0; k < SizeLambda; k++) {
-    free(Lambda[k]);
+/* ******************************************************************************** */
+static char *PutCount(char *s, int v) {
+  /*
+    Writes v and a tab at s (as "%d\t" would) and returns the end.
+  */
+
+  char digits[12];
+  int n = 0;
+  unsigned int u = v < 0 ? -(unsigned int) v : (unsigned int) v;
+
+  do {
+    digits[n++] = '0' + u % 10;
+    u /= 10;
+  } while (u > 0);
+  if (v < 0) {
+    *s++ = '-';
   }
-  free(Lambda);
-  free(logP);
-  free(P);
-  free(mComplex);
+  while (n > 0) {
+    *s++ = digits[--n];
+  }
+  *s++ = '\t';
 
+  return s;
 }
 /* ******************************************************************************** */
-/*                                  END CALCDIST                                    */
+
+
 /* ******************************************************************************** */
+static void WritePopulation(StatesWriter *sw, double logP) {
+  /*
+    Writes the population in sw->m; logP holds all but the monomer terms.
+  */
 
+  int i, j;
+  char *s = sw->line;
 
+  for (i = 0; i < sw->numSS; i++) {
+    logP += sw->m[i]*sw->logW[i] - sw->logFact[sw->m[i]];
+  }
+
+  s += sprintf(s,"%8.6e\t",exp(logP));
+  for (j = 0; j < sw->numTotal; j++) {
+    if (sw->m[j] > 0) {
+      s = PutCount(s,sw->CompIDArray[j]);
+      if (sw->NoPermID == 0) {
+        s = PutCount(s,sw->PermIDArray[j]);
+      }
+      s = PutCount(s,sw->m[j]);
+    }
+  }
+  *s++ = '\n';
+  fwrite(sw->line,1,s - sw->line,sw->fp);
+  sw->count++;
+}
 /* ******************************************************************************** */
-int next(int *mComplex, int *m0, int **A, int numSS, int numComplex, int numTotal,
-	 int *mMax, int LastInc) {
 
+
+/* ******************************************************************************** */
+static void WriteStatesFrom(StatesWriter *sw, int j, double logP) {
   /*
-    Given the previous entries in Lambda, computes the next one.
-
-    An example of what Lambda looks like for a system with two
-    single-species and a maximal complex size of 3 is below:
-    A     B         AA     AB    BB
-    3     3         0      0     0
-    3     1         0      0     1
-    2     2         0      1     0
-    2     0         0      1     1
-    1     1         0      2     0
-    0     0         0      3     0
-    1     3         1      0     0
-    1     2         1      0     1
-    0     2         1      1     0
-    0     0         1      1     1
-
-    The single stranded counts are known from the multistranded by
-    conservation of mass.  This function looks at the previous entry
-    in Lambda and computes the next one.  For example, assume the
-    previous entry is the top on in the table above.  The count of BB
-    is advanced one and the resulting counts of the single species are
-    checked.  There are both nonnegative, so the entry (0 0 1) for the
-    complexes is accepted.  The last complex to be incremented is
-    stored and returned as LastInc.  On the next call, BB is
-    incremented again.  This time, the single strand count on strand B
-    is -1, which is illegal, so the entry (0 0 2) is rejected.
-    Therefore, BB is set to zero, and LastInc is incremented to
-    correspond to AB.  The rejected entry is not inclulded in Lambda,
-    and the next call to this function increments AB.  A check is
-    again performed, and so on....
+    Writes every population extending the counts already set for the
+    complexes before j.  logP holds the terms of those complexes.
   */
 
-  int i; // Counter
+  int i, n;
 
-  (mComplex[numComplex-1])++;
+  if (j == sw->numTotal) {
+    if (sw->count < sw->MaxSizeLambda) {
+      WritePopulation(sw,logP);
+    }
+    return;
+  }
 
-  if (mComplex[numComplex-1] <= mMax[numComplex-1] 
-      && NegCheck(mComplex,m0,A,numSS,numTotal) ) {
-    LastInc = numComplex-1;
+  for (n = 0; ; n++) {
+    sw->m[j] = n;
+    WriteStatesFrom(sw,j+1,logP + n*sw->logW[j] - sw->logFact[n]);
+    for (i = 0; i < sw->numSS && sw->m[i] >= sw->A[i][j]; i++) ;
+    if (i < sw->numSS || sw->count >= sw->MaxSizeLambda) {
+      break;
+    }
+    for (i = 0; i < sw->numSS; i++) {
+      sw->m[i] -= sw->A[i][j];
+    }
   }
-  else {
-    if (LastInc > 0) {
-      (mComplex[LastInc-1])++;
-      for (i = LastInc; i < numComplex-1; i++) {
-	mComplex[i] = 0;
+
+  for (i = 0; i < sw->numSS; i++) {
+    sw->m[i] += n*sw->A[i][j];
+  }
+  sw->m[j] = 0;
+}
+/* ******************************************************************************** */
+
+
+/* ******************************************************************************** */
+static int *StatesPrefixes(int **A, int *m0, int numSS, int numTotal,
+                           int target, int *nPrefix, int *depth) {
+  /*
+    Lists, in lexicographic order, the counts of the first complexes in
+    every population, taking as many complexes as it needs to reach
+    target lists (or DIST_STATES_MAX_PREFIX, or all of them).  Returns
+    *nPrefix lists of *depth counts each.
+  */
+
+  int i, j, k, n, nMax, nNew, d = 0;
+  int *prefix, *grown, *r;
+
+  r = (int *) malloc(numSS * sizeof(int));
+  prefix = (int *) malloc(sizeof(int));
+  *nPrefix = 1;
+
+  while (*nPrefix < target && numSS + d < numTotal) {
+    j = numSS + d;
+
+    // count the extensions by the next complex
+    nNew = 0;
+    for (k = 0; k < *nPrefix && nNew <= DIST_STATES_MAX_PREFIX; k++) {
+      for (i = 0; i < numSS; i++) {
+        r[i] = m0[i];
+        for (n = 0; n < d; n++) {
+          r[i] -= A[i][numSS+n]*prefix[k*d+n];
+        }
       }
-      mComplex[numComplex-1] = -1;
-      LastInc--;
+      nMax = INT_MAX;
+      for (i = 0; i < numSS; i++) {
+        if (A[i][j] > 0 && r[i] / A[i][j] < nMax) {
+          nMax = r[i] / A[i][j];
+        }
+      }
+      nNew += nMax + 1;
     }
-    else { // LastInc == 0
-      LastInc = -1;
+    if (nNew > DIST_STATES_MAX_PREFIX) {
+      break;
     }
-  }
 
-  return LastInc;
+    grown = (int *) malloc(nNew * (d+1) * sizeof(int));
+    nNew = 0;
+    for (k = 0; k < *nPrefix; k++) {
+      for (i = 0; i < numSS; i++) {
+        r[i] = m0[i];
+        for (n = 0; n < d; n++) {
+          r[i] -= A[i][numSS+n]*prefix[k*d+n];
+        }
+      }
+      for (n = 0; ; n++) {
+        for (i = 0; i < d; i++) {
+          grown[nNew*(d+1)+i] = prefix[k*d+i];
+        }
+        grown[nNew*(d+1)+d] = n;
+        nNew++;
+        for (i = 0; i < numSS && r[i] >= A[i][j]; i++) {
+          r[i] -= A[i][j];
+        }
+        if (i < numSS) {
+          break;
+        }
+      }
+    }
+    free(prefix);
+    prefix = grown;
+    *nPrefix = nNew;
+    d++;
+  }
 
+  free(r);
+  *depth = d;
+  return prefix;
 }
 /* ******************************************************************************** */
 
 
 /* ******************************************************************************** */
-void UpdateLambda(int ***Lambda, int LambdaIndex, int *mComplex, int *m0, int **A, 
-		  int numSS, int numTotal) {
+static void WriteStatesPrefix(StatesWriter *sw, int *m0, int *prefix, int d,
+                              double logP) {
+  /*
+    Writes the populations whose first d complex counts are prefix.
+  */
+
+  int i, j;
+
+  for (i = 0; i < sw->numSS; i++) {
+    sw->m[i] = m0[i];
+  }
+  for (j = sw->numSS; j < sw->numSS + d; j++) {
+    sw->m[j] = prefix[j - sw->numSS];
+    for (i = 0; i < sw->numSS; i++) {
+      sw->m[i] -= sw->A[i][j]*sw->m[j];
+    }
+    logP = logP + sw->m[j]*sw->logW[j] - sw->logFact[sw->m[j]];
+  }
+  WriteStatesFrom(sw,sw->numSS + d,logP);
+}
+/* ******************************************************************************** */
 
+
+/* ******************************************************************************** */
+static long WriteStates(FILE *fpLam, int **A, double *G, int *m0, double logM,
+                        int numSS, int numTotal, int maxm0, double logP0,
+                        int *CompIDArray, int *PermIDArray, int NoPermID,
+                        double MaxSizeLambda, int nJobs, int quiet) {
   /*
-    Adds the entry strored in mComplex to Lambda.
+    Writes Lambda to fpLam using up to nJobs processes and returns the
+    number of populations, stopping at MaxSizeLambda of them.  logP0 is
+    the log probability of a population before its complex terms.
   */
 
-  int i,j,k; // Counters
-  int n; // number of nonzero entries in this row of lambda
-  int *mss;
-  int dotprod; // Dot product
+  int j, k, n, w, status, failed = 0;
+  int nPrefix, depth;
+  int *prefix;
+  long before;
+  long *shared = NULL; // start, end and count of the output of each prefix
+  size_t nBytes = 0, got;
+  char *buf;
+  pid_t *workers;
+  FILE **parts;
+  StatesWriter sw;
+
+  sw.numSS = numSS;
+  sw.numTotal = numTotal;
+  sw.A = A;
+  sw.CompIDArray = CompIDArray;
+  sw.PermIDArray = PermIDArray;
+  sw.NoPermID = NoPermID;
+  sw.count = 0;
+  sw.MaxSizeLambda = MaxSizeLambda;
+  sw.m = (int *) calloc(numTotal,sizeof(int));
+  sw.line = (char *) malloc((32 + 36*numTotal) * sizeof(char));
+  sw.logW = (double *) malloc(numTotal * sizeof(double));
+  sw.logFact = (double *) malloc((maxm0+1) * sizeof(double));
+  for (j = 0; j < numTotal; j++) {
+    sw.logW[j] = logM - G[j];
+  }
+  for (n = 0; n <= maxm0; n++) {
+    sw.logFact[n] = lgamma(n + 1.0);
+  }
 
-  mss = (int *) malloc(numSS * sizeof(int));
+  if (nJobs <= 0) nJobs = (int) sysconf(_SC_NPROCESSORS_ONLN);
 
-  // Get the counts for a single-strand
-  for (i = 0; i < numSS; i++) {
-    dotprod = 0;
-    for (j = numSS; j < numTotal; j++) {
-      dotprod += A[i][j]*mComplex[j-numSS];
+  nPrefix = 1;
+  depth = 0;
+  prefix = NULL;
+  if (nJobs > 1) {
+    prefix = StatesPrefixes(A,m0,numSS,numTotal,DIST_STATES_SPLIT*nJobs,
+                            &nPrefix,&depth);
+  }
+  if (nJobs > nPrefix) nJobs = nPrefix;
+
+  if (nJobs > 1) {
+    nBytes = 3 * nPrefix * sizeof(long);
+    shared = mmap(NULL,nBytes,PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_ANONYMOUS,-1,0);
+    if (shared == MAP_FAILED) {
+      nJobs = 1;
     }
-    mss[i] = m0[i] - dotprod;
   }
 
-  // Find out how many nonzero entries we have
-  n = nnz(mss,numSS);
-  n += nnz(mComplex,numTotal-numSS);
+  if (nJobs <= 1) {
+    sw.fp = fpLam;
+    WriteStatesPrefix(&sw,m0,NULL,0,logP0);
+  }
+  else {
+    parts = (FILE **) malloc(nJobs * sizeof(FILE *));
+    workers = (pid_t *) malloc(nJobs * sizeof(pid_t));
+    for (w = 0; w < nJobs; w++) {
+      if ((parts[w] = tmpfile()) == NULL) {
+        if (quiet == 0) {
+          printf("Unable to open a scratch file for Lambda!\n\nExiting...\n");
+        }
+        exit(ERR_LAMBDA);
+      }
+    }
+    fflush(NULL);
 
-  // Allocate memory for this new row
-  (*Lambda)[LambdaIndex] = (int *) malloc((2*n+1) * sizeof(int));
+    for (w = 0; w < nJobs; w++) {
+      workers[w] = fork();
+      if (workers[w] < 0) {
+        fprintf(stderr,"WriteStates: unable to start worker %d\n",w);
+        exit(ERR_LAMBDA);
+      }
+      if (workers[w] == 0) {
+        sw.fp = parts[w];
+        setvbuf(sw.fp,NULL,_IOFBF,DIST_STATES_BUFSIZE);
+        for (k = w; k < nPrefix && sw.count < MaxSizeLambda; k += nJobs) {
+          shared[3*k] = ftell(sw.fp);
+          before = sw.count;
+          WriteStatesPrefix(&sw,m0,&prefix[k*depth],depth,logP0);
+          shared[3*k+1] = ftell(sw.fp);
+          shared[3*k+2] = sw.count - before;
+        }
+        if (fflush(sw.fp) != 0) {
+          _exit(ERR_LAMBDA);
+        }
+        _exit(sw.count < MaxSizeLambda ? 0 : ERR_LAMBDATOOBIG);
+      }
+    }
 
-  // Enter the number of entries there are
-  (*Lambda)[LambdaIndex][0] = n;
+    for (w = 0; w < nJobs; w++) {
+      waitpid(workers[w],&status,0);
+      if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        failed = WIFEXITED(status) ? WEXITSTATUS(status) : ERR_LAMBDA;
+      }
+    }
+    free(workers);
 
-  // Enter the non-zero entries
-  k = 1;
-  for (i = 0; i < numSS; i++) {
-    if (mss[i] > 0) {
-      (*Lambda)[LambdaIndex][k++] = i;
-      (*Lambda)[LambdaIndex][k++] = mss[i];
+    if (failed == 0) {
+      for (k = 0; k < nPrefix; k++) {
+        sw.count += shared[3*k+2];
+      }
     }
-  }
-  for (j = numSS; j < numTotal; j++) {
-    if (mComplex[j-numSS] > 0) {
-      (*Lambda)[LambdaIndex][k++] = j;
-      (*Lambda)[LambdaIndex][k++] = mComplex[j-numSS];
+    if (failed == 0 && sw.count < MaxSizeLambda) {
+      buf = (char *) malloc(DIST_STATES_BUFSIZE * sizeof(char));
+      for (k = 0; k < nPrefix; k++) {
+        fseek(parts[k % nJobs],shared[3*k],SEEK_SET);
+        for (nBytes = shared[3*k+1] - shared[3*k]; nBytes > 0; nBytes -= got) {
+          got = fread(buf,1,nBytes < DIST_STATES_BUFSIZE ? nBytes :
+                      DIST_STATES_BUFSIZE,parts[k % nJobs]);
+          if (got == 0) {
+            failed = ERR_LAMBDA;
+            break;
+          }
+          fwrite(buf,1,got,fpLam);
+        }
+      }
+      free(buf);
+    }
+    else if (failed == 0) {
+      failed = ERR_LAMBDATOOBIG;
+    }
+
+    for (w = 0; w < nJobs; w++) {
+      fclose(parts[w]);
+    }
+    free(parts);
+    munmap(shared,3 * nPrefix * sizeof(long));
+
+    if (failed == ERR_LAMBDATOOBIG) {
+      sw.count = (long) MaxSizeLambda;
+    }
+    else if (failed) {
+      if (quiet == 0) {
+        printf("Error in writing out Lambda!\n\nExiting...\n");
+      }
+      exit(failed);
     }
   }
 
-  free(mss);
+  free(prefix);
+  free(sw.m);
+  free(sw.line);
+  free(sw.logW);
+  free(sw.logFact);
 
+  return sw.count;
 }
 /* ******************************************************************************** */
+/* ******************************************************************************** */
+/*                                END POPULATIONS                                   */
+/* ******************************************************************************** */
 
 
 /* ******************************************************************************** */
-int NegCheck(int *mComplex, int *m0,int **A,int numSS,int numTotal) {
+/*                                BEGIN CALCDIST                                    */
+/* ******************************************************************************** */
+void CalcDist(double *mEq, double **Pmn, int **A, double *G, int *m0, double M, 
+          int numSS, int numTotal, double MaxSizeLambda, char *LambdaFile, 
+          double kT, int WriteLambda, int StatesJobs, int *CompIDArray,
+          int *PermIDArray, int quiet, char *logFile, int WriteLogFile,
+          int NoPermID) {
 
-  /*
-    Check to see if a given set of complexes in the solutions results in
-    having a negative number of single-strand species.  This is illegal.
+  int i,j,n; // Counters, i: single-species, j: complexes
+  double FreeEnergy; // The free energy of the system.
+  long SizeLambda; // The length of lambda
+  double logM; // log of total numbers of particles
+  double RefSum; // Term added to partition function to define reference state
+  int maxm0; // Maximal entry in m0
+  FILE *fpLam; // The file to which the elements of Lambda are written
+  FILE *fplog; // file handle for log file
 
-    Returns 0 if negative (illegal) and 1 if not (legal).
-  */
+  // Preliminaries: get constants
+  logM = log(M);
+  RefSum = 0;
+  for (i = 0; i < numSS; i++) {
+    RefSum += m0[i]*(G[i] - logM) + lgamma(m0[i] + 1.0);
+  }
+  maxm0 = maxint(m0,numSS);
 
-  int i,j; // Counters
-  double dotprod; // Dot product of row of A with m.
+  // Q_box and the count distributions, without enumerating Lambda
+  FreeEnergy = -(BoxDistributions(Pmn,A,G,m0,logM,numSS,numTotal,maxm0,quiet)
+                 + RefSum);
 
-  for (i = 0; i < numSS; i++) {
-    dotprod = 0;
-    for (j = numSS; j < numTotal; j++) {
-      dotprod += A[i][j]*mComplex[j-numSS];
+  // Calculate the equilibrium counts
+  for (j = 0; j < numTotal; j++) {
+    mEq[j] = 0;
+    for (n = 0; n <= maxm0; n++) {
+      mEq[j] += n*Pmn[j][n];
+    }
+  }
+
+  // Write out Lambda if necessary; only then are the populations enumerated
+  if (WriteLambda) {
+
+    if ((fpLam = fopen(LambdaFile,"a")) == NULL) {
+      if (quiet == 0) {
+        printf("Error in opening %s!\n\n",LambdaFile);
+        printf("Exiting...\n");
+      }
+      exit(ERR_LAMBDA);
     }
-    if (m0[i] - dotprod < 0) {
-      return 0;
+    setvbuf(fpLam,NULL,_IOFBF,DIST_STATES_BUFSIZE);
+
+    SizeLambda = WriteStates(fpLam,A,G,m0,logM,numSS,numTotal,maxm0,
+                             RefSum + FreeEnergy,CompIDArray,PermIDArray,
+                             NoPermID,MaxSizeLambda,StatesJobs,quiet);
+    fclose(fpLam);
+
+    if (SizeLambda >= MaxSizeLambda) {
+      // a single process stops part way through Lambda and several stop
+      // before copying any of it out, so neither leaves a states file
+      remove(LambdaFile);
+      if (quiet == 0) {
+        printf("Exceeded maximum number of %g combinations!\n",MaxSizeLambda);
+        printf("Try increasing the maximal size of Lambda or\n");
+        printf("run without -writestates.\n\nExiting...\n");
+      }
+      exit(ERR_LAMBDATOOBIG);
+    }
+
+    // Write out  the number of populations in Lambda
+    if (WriteLogFile) {
+      if ((fplog = fopen(logFile,"a")) == NULL) {
+        if (quiet == 0) {
+          printf("Error opening %s.\n\nExiting....\n",logFile);
+        }
+        exit(ERR_LOG);
+      }
+      fprintf(fplog,"   --Number of populations in Lambda: %ld\n",SizeLambda);
+      fclose(fplog);
+    }
+
+    if (quiet == 0) {
+      printf("There are %ld populations in Lambda.\n",SizeLambda);
     }
   }
 
-  return 1;
+  // Write out free energy
+  if (WriteLogFile) {
+    if ((fplog = fopen(logFile,"a")) == NULL) {
+      if (quiet == 0) {
+        printf("Error opening %s.\n\nExiting....\n",logFile);
+      }
+      exit(ERR_LOG);
+    }
+    fprintf(fplog,"   --Free energy of the box: %8.6e kT, or %8.6e kcal\n",
+            FreeEnergy,FreeEnergy*kT/AVOGADRO);
+    fclose(fplog);
+  }
+  if (quiet == 0) {
+    printf("Free energy of the box: %8.6e kT, or %8.6e kcal\n",
+      FreeEnergy,FreeEnergy*kT/AVOGADRO);
+  }
 
 }
 /* ******************************************************************************** */
-
-
+/*                                  END CALCDIST                                    */
+/* ******************************************************************************** */
@@ -25,7 +25,7 @@
 void ReadCommandLine(int nargs, char **args, char *cxFile, char *countFile, 
                      char *logFile, char *distFile, char *LambdaFile, 
                      int *SortOutput, int *WriteLambda, double *MaxSizeLambda,
-                     double *kT, int *quiet, int *WriteLogFile, int *Toverride,
+                     int *StatesJobs, double *kT, int *quiet, int *WriteLogFile, int *Toverride,
                      int *NoPermID, int *NUPACK_VALIDATE, int *v3) {
 
   int options;  // Counters used in getting flags
@@ -45,6 +45,7 @@ void ReadCommandLine(int nargs, char **args, char *cxFile, char *countFile,
   *WriteLogFile = 0; // Default is not to write log file
   *WriteLambda = 0; // Default is not to write out Lambda
   *MaxSizeLambda = 1e6; // Default maximum lambda size
+  *StatesJobs = 0; // Default is one process per cpu for writing Lambda
   *kT = kB*(37.0 + ZERO_C_IN_KELVIN); // Default temperature is 37 deg. C
   *quiet = 0; // Default is to show messages on the screen
   *Toverride = 0; // Default is to either use T = 37 or that specified in input file
@@ -71,6 +72,7 @@ void ReadCommandLine(int nargs, char **args, char *cxFile, char *countFile,
         {"writelogfile",  no_argument,        0, 'g'},
         {"ordered",       no_argument,        0, 'h'},
         {"validate",      no_argument,        0, 'i'},
+        {"statesjobs",    required_argument,  0, 'j'},
         {"v3.0",          no_argument,        0, 'z'},
         {0, 0, 0, 0}
       };
@@ -78,7 +80,7 @@ void ReadCommandLine(int nargs, char **args, char *cxFile, char *countFile,
       int option_index = 0;
 
       options = getopt_long_only (nargs, args,
-                "a:b:c:defghi", long_options,&option_index);
+                "a:b:c:defghij:", long_options,&option_index);
 
       // Detect the end of the options.
       if (options == -1)
@@ -128,6 +130,11 @@ void ReadCommandLine(int nargs, char **args, char *cxFile, char *countFile,
           *SortOutput = 3;
           break;
 
+        case 'j':
+          strcpy(InputStr,optarg);
+          *StatesJobs = atoi(InputStr);
+          break;
+
         case 'z':
           *v3 = 1;
           *NoPermID = prev_ordered;
@@ -230,9 +237,12 @@ void DisplayDistributionsHelp(int DummyArgument) {
   printf("Calculate concentrations for each complex specified\n");
   printf("Options:\n");
   printf(" -ordered             perform the calculation on ordered complexes\n");
-  printf(" -maxstates BIG       maximum number of states to enumerate\n");
+  printf(" -maxstates BIG       maximum number of states to enumerate; beyond it\n");
+  printf("                      no states file is written\n");
   printf(" -writestates         write an output file describing properties for\n");
   printf("                      all population states of the system\n");
+  printf(" -statesjobs N        number of processes writing the states file;\n");
+  printf("                      0 (the default) uses one per cpu\n");
   printf(" -sort METHOD         change the sort method for the .eq output file\n");
   printf("                      0: same as input\n");
   printf("                      1: sort by concentration of complex; if -ordered\n");
@@ -10,7 +10,7 @@ extern "C" {
 void ReadCommandLine(int nargs, char **args, char *cxFile, char *countFile, 
          char *logFile, char *distFile, char *LambdaFile, 
          int *SortOutput, int *WriteLambda, double *MaxSizeLambda,
-         double *kT, int *quiet, int *WriteLogFile, int *Toverride,
+         int *StatesJobs, double *kT, int *quiet, int *WriteLogFile, int *Toverride,
          int *NoPermID, int * NUPACK_VALIDATE, int *v3);
 
 void DisplayDistributionsHelp(int DummyArgument);
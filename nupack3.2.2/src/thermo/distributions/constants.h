@@ -22,6 +22,18 @@
 // Where the help file to print is
 #define DISTRIBUTIONS_HELP_FILE "src/thermo/distributions/distributions.help"
 
+// Linear sums of a distributions convolution below this are redone in log space
+// (entries lost to underflow can add up to about 1e-300 to them)
+#define DIST_MIN_LINEAR_SUM 1e-200
+
+// Buffer size (bytes) of the streams Lambda is written through
+#define DIST_STATES_BUFSIZE (1 << 20)
+
+// Lambda is split among the processes writing it into about this many
+// pieces each, but never more than DIST_STATES_MAX_PREFIX pieces in all
+#define DIST_STATES_SPLIT 16
+#define DIST_STATES_MAX_PREFIX 65536
+
 // Error codes
 #define ERR_NOINPUT 2 // No prefix for a filename given
 #define ERR_HELP 3 // User chose to display help
@@ -59,6 +59,7 @@ int main(int argc, char *argv[]) {
   int WriteLogFile; // = 1 if information is to be written to a log file
   double kT; // The thermal energy in kcal/mol.
   double MaxSizeLambda; // Maximum number of populations to consider
+  int StatesJobs; // Processes writing out Lambda, 0 for one per cpu
   int Toverride; // = 1 if the user has enforced a temperature in the command line
   int **A; // A[i][j] is the number of monomers of type i in complex j
   double *G; // Free energies of complexes
@@ -80,7 +81,7 @@ int main(int argc, char *argv[]) {
   
   // Read command line arguments
   ReadCommandLine(argc,argv,cxFile,countFile,logFile,distFile,LambdaFile,&SortOutput,
-                  &WriteLambda,&MaxSizeLambda,&kT,&quiet,&WriteLogFile,&Toverride,
+                  &WriteLambda,&MaxSizeLambda,&StatesJobs,&kT,&quiet,&WriteLogFile,&Toverride,
                   &NoPermID,&NUPACK_VALIDATE, &v3);
 
   
@@ -202,7 +203,8 @@ int main(int argc, char *argv[]) {
     
     // Do the calculation
     CalcDist(mEq,Pmn,A,G,m0,M,numSS,newnTotal,MaxSizeLambda,LambdaFile,kT,
-             WriteLambda,CompIDArray,PermIDArray,quiet,logFile,WriteLogFile,
+             WriteLambda,StatesJobs,CompIDArray,PermIDArray,quiet,logFile,
+             WriteLogFile,
              NoPermID);
     
     // Write output
@@ -219,7 +221,8 @@ int main(int argc, char *argv[]) {
     
     // Do the calculation
     CalcDist(mEq,Pmn,A,G,m0,M,numSS,numTotal,MaxSizeLambda,LambdaFile,kT,
-             WriteLambda,CompIDArray,PermIDArray,quiet,logFile,WriteLogFile,
+             WriteLambda,StatesJobs,CompIDArray,PermIDArray,quiet,logFile,
+             WriteLogFile,
              NoPermID);
     
     // Write output